@@ -0,0 +1,58 @@
+#include "alt_tab_cache.hpp"
+
+
+bool AltTabCache::isAltTab(const HWND hwnd) {
+  const auto it = _entries.find(hwnd);
+  if (it != _entries.end()) {
+    _hits++;
+    return it->second.traits.altTab();
+  }
+
+  _misses++;
+  WindowTraits traits;
+  if (!_backend.traits(hwnd, traits)) return false;
+
+  _entries.emplace(hwnd, _Entry{ traits, _generation });
+  return traits.altTab();
+}
+
+
+bool AltTabCache::refresh(const HWND hwnd) {
+  _refreshes++;
+  WindowTraits traits;
+  if (!_backend.traits(hwnd, traits)) {
+    _entries.erase(hwnd);
+    return false;
+  }
+
+  _entries.insert_or_assign(hwnd, _Entry{ traits, _generation });
+  return traits.altTab();
+}
+
+
+void AltTabCache::update(const WindowEvent& event) {
+  if (event.type == WindowEvent::DESTROY) {
+    _entries.erase(event.hwnd);
+    return;
+  }
+
+  const auto it = _entries.find(event.hwnd);
+  if (it == _entries.end()) return;
+
+  WindowTraits& traits = it->second.traits;
+  switch (event.type) {
+    case WindowEvent::SHOW:    traits.visible = true;  break;
+    case WindowEvent::HIDE:    traits.visible = false; break;
+    case WindowEvent::CLOAK:   traits.cloaked = true;  break;
+    case WindowEvent::UNCLOAK: traits.cloaked = false; break;
+    default: break;
+  }
+}
+
+
+void AltTabCache::prune() {
+  for (auto it = _entries.begin(); it != _entries.end();) {
+    if (it->second.sweep == _generation) ++it;
+    else                                  it = _entries.erase(it);
+  }
+}
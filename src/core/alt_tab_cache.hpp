@@ -0,0 +1,114 @@
+#ifndef ALT_TAB_CACHE_HPP
+#define ALT_TAB_CACHE_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "window_handle.hpp"
+#include "window_backend.hpp"
+#include "window_events.hpp"
+
+
+/**
+ * @brief Alt-tab classification of every window seen, keyed by handle.
+ *
+ * Every create, show and hide event used to re-read a window's styles, owner and cloak
+ * state. Windows get shown and hidden over and over (menus, tooltips, popups), so the
+ * traits are read once and then kept up to date by the events themselves: a show or a
+ * hide only flips the visibility, a cloak change only the cloak state, and none of them
+ * ask the window system anything. A destroy drops the entry.
+ *
+ * Styles and owners have no event, reconciliation sweeps refresh() every top-level
+ * window instead, and prune() drops whatever a whole sweep didn't see.
+ *
+ * NOTE: Lives on the event thread, not thread-safe.
+ */
+class AltTabCache {
+  private:
+    /**
+     * @brief One window
+     */
+    struct _Entry {
+      WindowTraits traits;
+      std::uint32_t sweep; // Generation of the sweep it was last read in
+    };
+
+    WindowBackend& _backend;
+    std::unordered_map<HWND, _Entry> _entries;
+    std::uint32_t _generation = 0;
+    std::uint64_t _hits = 0;
+    std::uint64_t _misses = 0;
+    std::uint64_t _refreshes = 0;
+
+  public:
+    /**
+     * @brief Creates an empty cache
+     * @param backend: Source of the traits
+     */
+    explicit AltTabCache(WindowBackend& backend)
+      : _backend(backend) {}
+
+
+    /**
+     * @brief Checks if a window is an alt-tab window, reading it only if it's not cached
+     * @param hwnd: Handle of a window
+     * @returns bool: True/False of visibility, false if the window is gone
+     */
+    bool isAltTab(const HWND hwnd);
+
+
+    /**
+     * @brief Reads a window again, cached or not
+     * @param hwnd: Handle of a window
+     * @returns bool: True/False of visibility, false if the window is gone
+     */
+    bool refresh(const HWND hwnd);
+
+
+    /**
+     * @brief Updates a cached window with what an event says changed
+     *
+     * NOTE: Windows that aren't cached are left for the next query.
+     * @param event: Any event, only show, hide, cloak and destroy events change something
+     */
+    void update(const WindowEvent& event);
+
+
+    /**
+     * @brief Starts a sweep, windows read from now on belong to it
+     */
+    void beginSweep() {
+      _generation++;
+    }
+
+
+    /**
+     * @brief Drops every window the sweep since beginSweep() didn't read
+     *
+     * NOTE: Child windows never show up in a sweep, they're read again the next time they're asked.
+     */
+    void prune();
+
+
+    /**
+     * @brief Gets the amount of isAltTab() answered from the cache and read from the window system,
+     *        and the amount of refresh()
+     */
+    std::uint64_t hits() const { return _hits; }
+    std::uint64_t misses() const { return _misses; }
+    std::uint64_t refreshes() const { return _refreshes; }
+
+
+    /**
+     * @brief Gets the amount of windows cached
+     * @returns std::size_t: Window count
+     */
+    std::size_t size() const {
+      return _entries.size();
+    }
+};
+
+
+#endif // ALT_TAB_CACHE_HPP
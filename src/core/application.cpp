@@ -6,6 +6,7 @@ ID3D11Device*           Application::_pd3d_device = nullptr;
 ID3D11DeviceContext*    Application::_pd3d_device_context = nullptr;
 IDXGISwapChain*         Application::_p_swap_chain = nullptr;
 ID3D11RenderTargetView* Application::_main_render_target_view = nullptr;
+ID3D11SamplerState*     Application::_mip_sampler = nullptr;
 
 
 // ---------------- Tray variables ----------------
@@ -14,16 +15,43 @@ WNDCLASSEX     Application::_wc = {};
 NOTIFYICONDATA Application::_nid = {};
 HWND           Application::_hwnd = nullptr;
 HICON          Application::_h_icon = LoadIcon(NULL, IDI_APPLICATION); // Default to a generic application icon.
-HWINEVENTHOOK  Application::_hook = nullptr;
+
+
+// ---------------- Event thread variables ----------------
+
+std::thread                  Application::_event_thread{};
+DWORD                        Application::_event_thread_id = 0;
+std::array<HWINEVENTHOOK, 4> Application::_hooks{};
+WindowEventQueue             Application::_window_events{};
+EventRecorder                Application::_event_recorder{};
+Win32WindowBackend           Application::_window_backend{};
+ProcessCache                 Application::_process_cache{_window_backend};
+WindowDeltaBuilder           Application::_delta_builder{_window_backend, &_process_cache};
+WindowDeltaChannel           Application::_window_deltas{};
+WindowDeltaBatch             Application::_applied_deltas{};
 
 
 // ---------------- Misc variables ----------------
 
-bool               Application::_overlay_visible = false;
-FpsTimer           Application::_fps_timer{};
-TabGroupMap        Application::_tab_groups{};
-TabGroupOrderList  Application::_tab_groups_order{};
-TabGroupLayoutList Application::_tab_groups_layouts{};
+bool                       Application::_overlay_visible = false;
+FpsTimer                   Application::_fps_timer{};
+SnapshotPublisher          Application::_snapshots{releaseTexture}; // Defined before the registry so it's destroyed after it, the registry retires into it
+WindowRegistry             Application::_window_registry{};
+ProcessIconTextures        Application::_process_icons{_process_cache};
+CapturePool                Application::_capture_pool{_window_backend, CapturePool::DEFAULT_WORKERS, _jumpstartUI};
+std::vector<CaptureResult> Application::_captures{};
+ThumbnailCache             Application::_thumbnails{};
+D3D11TextureUploader       Application::_texture_uploader{};
+std::vector<TileRect>      Application::_dirty_rects{};
+ThumbnailAtlas             Application::_atlas{_texture_uploader, _retireTexture}; // Defined after the uploader and the snapshots, its pages retire into them
+std::vector<WindowId>      Application::_moved_thumbnails{};
+std::vector<WindowId>      Application::_focus_order{};
+TabGroupMap                Application::_tab_groups{};
+std::uint64_t              Application::_published_registry_version = 0;
+bool                       Application::_tab_groups_changed = false;
+TabGroupId                 Application::_next_tab_group_id = 0;
+TabGroupOrderList          Application::_tab_groups_order{};
+TabGroupLayoutList         Application::_tab_groups_layouts{};
 
 
 // ---------------- DirectX functions ----------------
@@ -68,12 +96,19 @@ bool Application::_createDeviceD3D(HWND hwnd) {
   }
 
   _createRenderTarget();
+  _mip_sampler = createMipSampler(_pd3d_device);
+  _texture_uploader.setDevice(_pd3d_device, _pd3d_device_context);
   return true;
 }
 
 
 void Application::_cleanupDeviceD3D() {
   _cleanupRenderTarget();
+  _texture_uploader.setDevice(nullptr, nullptr);
+  if (_mip_sampler) {
+    _mip_sampler->Release();
+    _mip_sampler = nullptr;
+  }
   if (_p_swap_chain) {
     _p_swap_chain->Release();
     _p_swap_chain = nullptr;
@@ -145,7 +180,16 @@ void Application::_showTrayMenu() {
       const bool NOT_VIS = !ImGuiUI::isTabGroupsVisible();
       if (NOT_VIS) {
         if (!_overlay_visible) _toggleOverlayVisible();
-        updateWindowInfoListTextures(_tab_groups.at(StaticTabGroups::OPEN_TABS), _pd3d_device);
+
+        // Rows are in no particular order after erases, the grid draws in MRU order
+        _focus_order.clear();
+        for (WindowId id = _window_registry.mruFront(); id != INVALID_WINDOW_ID; id = _window_registry.mruNext(id)) {
+          _focus_order.push_back(id);
+        }
+        _requestThumbnails(_focus_order);
+      }
+      else if (!ImGuiUI::isHotkeyPanelVisible()) {
+        _capture_pool.cancelAll(); // Nothing shows thumbnails anymore
       }
       ImGuiUI::setTabGroupsVisibility(NOT_VIS);
       ImGuiUI::setNeedsMovingRedraw(true);
@@ -155,7 +199,10 @@ void Application::_showTrayMenu() {
       const bool NOT_VIS = !ImGuiUI::isHotkeyPanelVisible();
       if (NOT_VIS) {
         if (!_overlay_visible) _toggleOverlayVisible();
-        updateWindowInfoListTextures(_tab_groups.at(StaticTabGroups::HOTKEYS), _pd3d_device);
+        _requestThumbnails(_tab_groups.at(StaticTabGroups::HOTKEYS).slots);
+      }
+      else if (!ImGuiUI::isTabGroupsVisible()) {
+        _capture_pool.cancelAll(); // Nothing shows thumbnails anymore
       }
       ImGuiUI::setHotkeyPanelVisibility(NOT_VIS);
       ImGuiUI::setNeedsMovingRedraw(true);
@@ -177,6 +224,232 @@ void Application::_showTrayMenu() {
 }
 
 
+void Application::_recordEvent(const WindowEvent::Type type, const HWND hwnd, const DWORD time_ms, const std::uint8_t flags) {
+  RecordedEvent record{ WindowEvent{ type, hwnd, static_cast<std::uint32_t>(time_ms) }, flags, 0, 0, {} };
+
+  // Gone windows are recorded too, with an empty state
+  if (IsWindow(hwnd)) {
+    record.style = static_cast<std::uint32_t>(GetWindowLongA(hwnd, GWL_STYLE));
+    record.ex_style = static_cast<std::uint32_t>(GetWindowLongA(hwnd, GWL_EXSTYLE));
+    record.title = getWindowTitle(hwnd);
+    if (isAltTabWindow(hwnd)) record.flags |= RECORDED_FLAG_ALT_TAB;
+  }
+  _event_recorder.write(record);
+}
+
+
+void Application::_runEventThread(std::promise<bool> ready) {
+  _event_thread_id = GetCurrentThreadId();
+
+  // Creates the thread's message queue, so nothing posted to it is lost
+  MSG msg;
+  PeekMessage(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+
+  // Only the handled ranges, everything else never leaves the system
+  bool hooked = true;
+  for (std::size_t i = 0; i < _HOOKED_EVENTS.size(); i++) {
+    _hooks[i] = SetWinEventHook(
+      _HOOKED_EVENTS[i].first, _HOOKED_EVENTS[i].second,
+      NULL,
+      _WinEventProc,
+      0, 0,                   //  --> all processes/threads
+      WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS // Own windows are never listed
+    );
+    hooked = hooked && _hooks[i];
+  }
+
+  if (hooked) {
+    // Startup windows, events that arrive meanwhile are queued and handled after
+    WindowDeltaBatch batch;
+    _delta_builder.addAll(batch);
+    if (_event_recorder.isOpen()) {
+      const DWORD NOW = GetTickCount();
+      for (const WindowDelta& delta : batch) {
+        _recordEvent(WindowEvent::CREATE, delta.hwnd, NOW, RECORDED_FLAG_ENUMERATED);
+      }
+    }
+    _window_deltas.publish(batch);
+    ready.set_value(true);
+
+    // Thread timer, for what the hooks never report (windows shown, hidden or cloaked)
+    const UINT_PTR reconcile_timer = SetTimer(NULL, 0, _RECONCILE_INTERVAL_MS, NULL);
+
+    while (GetMessage(&msg, NULL, 0, 0) > 0) {
+      if (msg.message == WM_TIMER && msg.wParam == reconcile_timer) {
+        _delta_builder.reconcile(_RECONCILE_BUDGET, batch);
+        if (_event_recorder.isOpen()) {
+          const DWORD NOW = GetTickCount();
+          for (const WindowDelta& delta : batch) {
+            const WindowEvent::Type type = delta.type == WindowDelta::ADDED ? WindowEvent::CREATE : WindowEvent::DESTROY;
+            _recordEvent(type, delta.hwnd, NOW, RECORDED_FLAG_RECONCILED);
+          }
+        }
+        if (_window_deltas.publish(batch)) _jumpstartUI();
+        continue;
+      }
+      if (msg.message != _WM_WINDOW_EVENTS) continue;
+
+      // Hook callbacks run before posted messages are returned, so this is the whole batch
+      _delta_builder.build(_window_events, batch);
+      if (_window_deltas.publish(batch)) _jumpstartUI();
+    }
+
+    if (reconcile_timer) KillTimer(NULL, reconcile_timer);
+  }
+  else {
+    ready.set_value(false);
+  }
+
+  for (HWINEVENTHOOK& hook : _hooks) {
+    if (hook) UnhookWinEvent(hook);
+    hook = nullptr;
+  }
+}
+
+
+void Application::_stopEventThread() {
+  if (!_event_thread.joinable()) return;
+
+  PostThreadMessage(_event_thread_id, WM_QUIT, 0, 0); // Unhooks on its way out
+  _event_thread.join();
+}
+
+
+void Application::_applyWindowDeltas() {
+  _window_deltas.take(_applied_deltas);
+  applyWindowDeltas(_window_registry, _applied_deltas);
+  if (!_applied_deltas.empty()) _thumbnails.prune(_window_registry); // Closed windows took their thumbnails with them
+}
+
+
+void Application::_applyCaptures() {
+  const std::size_t budget = static_cast<std::size_t>(Config::thumbnail_budget_mb) << 20;
+  if (budget != _thumbnails.budget()) _thumbnails.setBudget(_window_registry, budget);
+
+  _capture_pool.take(_captures);
+  if (_captures.empty()) return;
+
+  bool uploaded = false;
+  for (const CaptureResult& capture : _captures) {
+    // Closed while it was captured, or its row was reused by another window
+    const std::optional<WindowView> info = _window_registry.get(capture.id);
+    if (!info || info->hwnd != capture.hwnd) continue;
+
+    // Same size as the texture it has, only the tiles that changed are sent into it
+    const ThumbnailSize size{ capture.width, capture.height };
+    const bool in_atlas = (info->flags & WINDOW_FLAG_SHARED_TEXTURE) != 0;
+    if ((!in_atlas || Config::thumbnail_atlas) &&
+        _thumbnails.dirtyRects(_window_registry, capture.id, capture.hashes, capture.mip_levels, _dirty_rects)) {
+      std::size_t sent = 0;
+      const bool updated = in_atlas
+        ? _atlas.update(capture.id, capture.bgra.data(), _dirty_rects, sent)
+        : uploadDirtyRects(_texture_uploader, info->tex, capture.bgra.data(), size, capture.mip_levels, _dirty_rects, sent);
+      if (updated) {
+        _thumbnails.patch(capture.id, capture.hashes, sent, capture.bgra.size());
+        uploaded = uploaded || sent != 0;
+        continue;
+      }
+    }
+
+    // Packed into the atlas if it fits
+    AtlasSlot slot;
+    if (Config::thumbnail_atlas && _atlas.place(capture.id, capture.bgra.data(), size, capture.mip_levels, slot)) {
+      _thumbnails.insert(_window_registry, capture.id, slot.page, slot.size, capture.bgra.size(), capture.mip_levels,
+        capture.hashes, slot.region);
+      uploaded = true;
+      continue;
+    }
+
+    // A texture of its own, the registry releases the old one
+    const ImTextureID tex = _texture_uploader.create(capture.bgra.data(), capture.width, capture.height, capture.mip_levels);
+    if (tex != ImTextureID_Invalid) {
+      const ImVec2 tex_size = ImVec2(static_cast<float>(capture.width), static_cast<float>(capture.height));
+      _thumbnails.insert(_window_registry, capture.id, tex, tex_size, capture.bgra.size(), capture.mip_levels, capture.hashes);
+      uploaded = true;
+    }
+  }
+  _capture_pool.recycle(_captures);
+  if (uploaded) ImGuiUI::setNeedsMovingRedraw(true);
+}
+
+
+void Application::_maintainAtlas() {
+  // Slots of evicted windows first, a repack would move them back in
+  _atlas.prune(_window_registry);
+  if (_atlas.defragment(_moved_thumbnails, _ATLAS_MOVES_PER_FRAME) == 0) return;
+
+  AtlasSlot slot;
+  for (const WindowId id : _moved_thumbnails) {
+    if (_atlas.slot(id, slot)) _window_registry.setTexture(id, slot.page, slot.size, slot.region);
+  }
+  ImGuiUI::setNeedsMovingRedraw(true);
+}
+
+
+void Application::_requestThumbnails(const std::vector<WindowId>& list) {
+  // Captured at the size of a cell, a smaller cell draws from the smaller levels until the next refresh
+  _capture_pool.setTargetSize(ThumbnailSize{
+    static_cast<int>(Config::tab_groups_tab_width), static_cast<int>(Config::tab_groups_tab_height)
+  });
+
+  const std::uint32_t REFRESH_PRIORITY = static_cast<std::uint32_t>(list.size());
+  for (std::uint32_t i = 0; i < list.size(); i++) {
+    const std::optional<WindowView> info = _window_registry.get(list[i]);
+    if (!info) continue;
+
+    // Missing and evicted thumbnails first, then refresh the cached ones
+    const bool cached = _thumbnails.lookup(_window_registry, list[i]);
+    _capture_pool.request(list[i], info->hwnd, cached ? REFRESH_PRIORITY + i : i);
+    updateWindowIcon(_window_registry, list[i], _pd3d_device, _process_icons);
+  }
+}
+
+
+void Application::_applyTabGroupEdits() {
+  for (const TabGroupEdit& edit : ImGuiUI::takeTabGroupEdits()) {
+    const auto it = _tab_groups.find(edit.group);
+    if (it == _tab_groups.end()) continue;
+    TabGroup& group = it->second;
+
+    // Membership changes bump the registry version, so they get published too
+    switch (edit.type) {
+      case TabGroupEdit::SET_SLOT: {
+        if (edit.slot >= group.slots.size()) break;
+
+        const WindowId old_id = group.slots[edit.slot];
+        group.slots[edit.slot] = edit.id;
+        _tab_groups_changed = true;
+
+        // The replaced window stays a member only if it still holds another slot
+        if (std::find(group.slots.begin(), group.slots.end(), old_id) == group.slots.end()) {
+          _window_registry.removeFromGroup(old_id, group.id);
+        }
+        _window_registry.addToGroup(edit.id, group.id);
+        break;
+      }
+      case TabGroupEdit::ADD_WINDOW: {
+        _window_registry.addToGroup(edit.id, group.id);
+        break;
+      }
+      case TabGroupEdit::REMOVE_WINDOW: {
+        _window_registry.removeFromGroup(edit.id, group.id);
+        break;
+      }
+    }
+  }
+}
+
+
+void Application::_publishSnapshot() {
+  // Nothing changed since the latest snapshot
+  if (_window_registry.version() == _published_registry_version && !_tab_groups_changed) return;
+
+  _snapshots.publish(_window_registry, _tab_groups);
+  _published_registry_version = _window_registry.version();
+  _tab_groups_changed = false;
+}
+
+
 void Application::_toggleOverlayVisible() {
   _overlay_visible = !_overlay_visible;
 
@@ -229,57 +502,34 @@ LRESULT CALLBACK Application::_WndProc(HWND hwnd, UINT msg, WPARAM w_param, LPAR
 
 void CALLBACK Application::_WinEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG id_object,
   LONG id_child, DWORD event_thread, DWORD event_time) {
-  // MUST be a window event
-  if (id_object != OBJID_WINDOW) return; // Only window events are needed
-  if (hwnd == _hwnd) return; // Ignore events for the "BetterAltTab.exe" program.
-
-  // std::string title = getWindowTitle(hwnd);
-  
-  // auto p = [](const std::string type) {
-  //   std::cout << "\n[" << type << "] Printing updated list: \n";
-  //   for (const auto& info : _open_windows) {
-  //     std::cout << info.title << "\n";
-  //   }
-  //   std::cout << std::endl;
-  // };
+  // MUST be an event of a window itself, not one of its UI objects
+  if (id_object != OBJID_WINDOW || id_child != CHILDID_SELF || hwnd == NULL) {
+    _window_events.reject();
+    return;
+  }
 
+  WindowEvent::Type type;
   switch (event) {
-    case EVENT_OBJECT_NAMECHANGE:
-      // Change title
-      updateWindowInfoListItemTitle(_tab_groups[StaticTabGroups::OPEN_TABS], hwnd);
-      //p("NAMECHANGE");
-      break;
-
-    case EVENT_OBJECT_CREATE:
-      // Add to list
-      addWindowToAltTabList(_tab_groups[StaticTabGroups::OPEN_TABS], hwnd);
-      //p("CREATE");
-      break;
-
-    case EVENT_OBJECT_DESTROY:
-      // Remove from list
-      removeWindowFromWindowInfoList(_tab_groups[StaticTabGroups::OPEN_TABS], hwnd);
-      //p("DESTROY");
-      break;
+    case EVENT_OBJECT_NAMECHANGE: type = WindowEvent::NAMECHANGE; break;
+    case EVENT_OBJECT_CREATE:     type = WindowEvent::CREATE;     break;
+    case EVENT_OBJECT_DESTROY:    type = WindowEvent::DESTROY;    break;
+    case EVENT_OBJECT_SHOW:       type = WindowEvent::SHOW;       break;
+    case EVENT_OBJECT_HIDE:       type = WindowEvent::HIDE;       break;
+    case EVENT_OBJECT_CLOAKED:    type = WindowEvent::CLOAK;      break;
+    case EVENT_OBJECT_UNCLOAKED:  type = WindowEvent::UNCLOAK;    break;
+    case EVENT_SYSTEM_FOREGROUND: type = WindowEvent::FOREGROUND; break;
+    default:
+      // Inside a hooked range, but not handled
+      _window_events.reject();
+      return;
+  }
 
-    case EVENT_SYSTEM_FOREGROUND:
-      // Update last focused time
-      updateWindowInfoFocusTime(_tab_groups[StaticTabGroups::OPEN_TABS], hwnd);
-      //p("FOREGROUND");
-      break;
+  if (_event_recorder.isOpen()) _recordEvent(type, hwnd, event_time, RECORDED_FLAG_NONE);
 
-    // case EVENT_OBJECT_SHOW:
-    //   // Update last focused time
-    //   updateWindowInfoFocusTime(_tab_groups[StaticTabGroups::OPEN_TABS], hwnd);
-    //   //p("SHOW");
-    //   break;
-
-    // case EVENT_OBJECT_HIDE:
-    //   // Remove from list
-    //   removeWindowFromWindowInfoList(_tab_groups[StaticTabGroups::OPEN_TABS], hwnd);
-    //   p("HIDE");
-    //   break;
-  }
+  // Wake up the event thread's message loop so the batch gets built
+  const bool WAS_EMPTY = _window_events.empty();
+  _window_events.push(WindowEvent{ type, hwnd, static_cast<std::uint32_t>(event_time) });
+  if (WAS_EMPTY && !_window_events.empty()) PostThreadMessage(_event_thread_id, _WM_WINDOW_EVENTS, 0, 0);
 }
 
 
@@ -334,17 +584,23 @@ bool Application::createApplication(HINSTANCE& h_instance) {
 
   // ------ Windows event callback binding ------
 
-  _hook = SetWinEventHook(
-    EVENT_MIN, EVENT_MAX,
-    NULL, 
-    _WinEventProc,
-    0, 0,                   //  --> all processes/threads
-    WINEVENT_OUTOFCONTEXT
-  );
+  // Processes of the startup windows are loaded while the UI comes up
+  _process_cache.start();
+  _capture_pool.start();
+  ImGuiUI::setProcessCache(&_process_cache);
+  ImGuiUI::setThumbnailCache(&_thumbnails);
+
+  // Hooks are set on the event thread, their callbacks run there
+  std::promise<bool> hooks_ready;
+  std::future<bool> hooked = hooks_ready.get_future();
+  _event_thread = std::thread(_runEventThread, std::move(hooks_ready));
 
   // Error when setting the hook
-  if (!_hook) {
+  if (!hooked.get()) {
     std::cout << "Failed to set hook" << std::endl;
+    _event_thread.join();
+    _capture_pool.stop();
+    _process_cache.stop();
     return false;
   }
 
@@ -360,6 +616,9 @@ bool Application::createApplication(HINSTANCE& h_instance) {
 
   if (!_createDeviceD3D(_hwnd)) {
     _cleanupDeviceD3D();
+    _stopEventThread();
+    _capture_pool.stop();
+    _process_cache.stop();
     UnregisterClass(_wc.lpszClassName, _wc.hInstance);
     return false;
   }
@@ -377,6 +636,9 @@ bool Application::createApplication(HINSTANCE& h_instance) {
 
   ImGui_ImplWin32_Init(_hwnd);
   ImGui_ImplDX11_Init(_pd3d_device, _pd3d_device_context);
+  ImGuiUI::setMipSampler(_mip_sampler);
+  ImGuiUI::setCapturePool(&_capture_pool);
+  ImGuiUI::setThumbnailAtlas(&_atlas);
 
 
   // -------------------------------------------------
@@ -384,13 +646,17 @@ bool Application::createApplication(HINSTANCE& h_instance) {
   // -------------------------------------------------
   
   // Tab groups
-  _tab_groups[StaticTabGroups::OPEN_TABS] = getAllAltTabWindows();
+  _window_registry.setTextureReleaser(_retireTexture);
+  _applyWindowDeltas(); // Startup windows, already published by the event thread
+  _tab_groups[StaticTabGroups::OPEN_TABS] = TabGroup{ _next_tab_group_id++, {} }; // Never has members, open tabs are every window in the registry
   _tab_groups_order.push_back(StaticTabGroups::OPEN_TABS); // Insert to list
   _tab_groups_layouts[StaticTabGroups::OPEN_TABS] = TabGroupLayout::GRID;
-  _tab_groups[StaticTabGroups::HOTKEYS] = TabGroup(10, nullptr); // Create 10-element vector.
+  _tab_groups[StaticTabGroups::HOTKEYS] = TabGroup{ _next_tab_group_id++, std::vector<WindowId>(10, INVALID_WINDOW_ID) }; // Create 10 empty slots.
   _tab_groups_order.insert(_tab_groups_order.begin(), StaticTabGroups::HOTKEYS); // Insert at position 0, never change it's spot ==> This means it's always on top
   _tab_groups_layouts[StaticTabGroups::HOTKEYS] = TabGroupLayout::GRID;
   // TODO: Render tab groups from config.json
+  _tab_groups_changed = true;
+  _publishSnapshot();
 
   // ImGui Widgets
   ImGuiUI::setupImGuiStyles();
@@ -428,6 +694,19 @@ void Application::runApplication() {
     }
 
 
+    // ------------------------ Snapshot ------------------------
+
+    // Every pending message was handled above, apply and publish the batch once
+    _applyWindowDeltas();
+    _applyCaptures();
+    _maintainAtlas();
+    _applyTabGroupEdits();
+    _publishSnapshot();
+
+    // Pinned for the whole frame, later publishes never touch it
+    const std::shared_ptr<const WindowSnapshot> snapshot = _snapshots.acquire();
+
+
     // ------------------------ Render ------------------------
 
     // Pre-frame setup
@@ -438,7 +717,7 @@ void Application::runApplication() {
     // Draw UI onto buffer
     _fps_timer.update();
     if (_overlay_visible) {
-      ImGuiUI::drawUI(_fps_timer.getFps(), _fps_timer.getDelta(), _tab_groups, _tab_groups_order, _tab_groups_layouts);
+      ImGuiUI::drawUI(_fps_timer.getFps(), _fps_timer.getDelta(), *snapshot, _tab_groups_order, _tab_groups_layouts);
     }
 
     // If a window was just focused, then set all items to not visible
@@ -470,6 +749,7 @@ void Application::runApplication() {
     // Render
     if (ImGuiUI::needsMovingRedraw()) {
       ImGui::Render();
+      ImGuiUI::recordDrawData(ImGui::GetDrawData());
 
       float clear[4] = {0,0,0,0};
       _pd3d_device_context->OMSetRenderTargets(1, &_main_render_target_view, nullptr);
@@ -483,6 +763,7 @@ void Application::runApplication() {
     }
     else if (io_counter >= IO_COUNTER_MAX) {
       ImGui::Render();
+      ImGuiUI::recordDrawData(ImGui::GetDrawData());
 
       float clear[4] = {0,0,0,0};
       _pd3d_device_context->OMSetRenderTargets(1, &_main_render_target_view, nullptr);
@@ -511,9 +792,13 @@ void Application::destroyApplication() {
   ImGui_ImplDX11_Shutdown();
   ImGui_ImplWin32_Shutdown();
   ImGui::DestroyContext();
+  _capture_pool.stop(); // Before the device goes, nothing gets uploaded after this
+  _process_icons.clear();
   _cleanupDeviceD3D();
   _removeTrayIcon();
-  UnhookWinEvent(_hook);
+  _stopEventThread();
+  _process_cache.stop();
+  _event_recorder.close();
   DestroyWindow(_hwnd);
   UnregisterClass(_wc.lpszClassName, _wc.hInstance);
 }
@@ -7,8 +7,13 @@
 #endif // NOMINMAX
 
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <array>
+#include <future>
+#include <thread>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -25,6 +30,16 @@
 #include "imgui_ui.hpp"
 #include "config.hpp"
 #include "win_utils.hpp"
+#include "window_registry.hpp"
+#include "window_snapshot.hpp"
+#include "window_events.hpp"
+#include "window_deltas.hpp"
+#include "event_recording.hpp"
+#include "process_cache.hpp"
+#include "capture_pool.hpp"
+#include "thumbnail_cache.hpp"
+#include "thumbnail_atlas.hpp"
+#include "tab_groups.hpp"
 #include "resources.h"
 #include "timers.hpp"
 
@@ -55,6 +70,7 @@ class Application {
     static ID3D11DeviceContext*    _pd3d_device_context;
     static IDXGISwapChain*         _p_swap_chain;
     static ID3D11RenderTargetView* _main_render_target_view;
+    static ID3D11SamplerState*     _mip_sampler; // Lets thumbnails draw from their smaller levels
 
 
     // ---------------- Tray variables ----------------
@@ -62,7 +78,6 @@ class Application {
     static NOTIFYICONDATA _nid;
     static HWND _hwnd;
     static HICON _h_icon;
-    static HWINEVENTHOOK _hook;
     enum TrayItems {
       SEPARATOR,
       SHOW_OVERLAY,
@@ -73,10 +88,47 @@ class Application {
     };
 
 
+    // ---------------- Event thread variables ----------------
+    static std::thread _event_thread;
+    static DWORD _event_thread_id;
+    static std::array<HWINEVENTHOOK, 4> _hooks; // One per event range that's handled, see _HOOKED_EVENTS
+    static constexpr std::array<std::pair<DWORD, DWORD>, 4> _HOOKED_EVENTS = {{
+      { EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND },
+      { EVENT_OBJECT_CREATE, EVENT_OBJECT_HIDE }, // CREATE, DESTROY, SHOW, HIDE
+      { EVENT_OBJECT_NAMECHANGE, EVENT_OBJECT_NAMECHANGE },
+      { EVENT_OBJECT_CLOAKED, EVENT_OBJECT_UNCLOAKED }
+    }};
+    static constexpr UINT _WM_WINDOW_EVENTS = WM_APP + 2; // Posted to the event thread when its queue stops being empty
+    static constexpr UINT _RECONCILE_INTERVAL_MS = 100; // Between two slices of the reconciliation sweep
+    static constexpr std::chrono::microseconds _RECONCILE_BUDGET{500}; // Per slice, a whole sweep takes a few of them
+    static WindowEventQueue _window_events; // Filled by _WinEventProc
+    static EventRecorder _event_recorder; // Only open with --record-events
+    static Win32WindowBackend _window_backend;
+    static ProcessCache _process_cache; // Exe path and icon per process, loaded on its own worker thread
+    static WindowDeltaBuilder _delta_builder; // Turns _window_events into deltas, does every window query
+    static WindowDeltaChannel _window_deltas; // Event thread -> UI thread, applied once per frame
+    static WindowDeltaBatch _applied_deltas; // UI thread's buffer, reused every frame
+
+
     // ---------------- Misc variables ----------------
     static bool _overlay_visible;
     static FpsTimer _fps_timer;
+    static SnapshotPublisher _snapshots; // What the UI reads, republished after every batch of window events
+    static WindowRegistry _window_registry; // Owns every tracked window, tab groups hold WindowIds into it.
+    static ProcessIconTextures _process_icons; // One icon texture per process, shared by its windows
+    static CapturePool _capture_pool; // Thumbnails, captured on its own workers and uploaded by the UI thread
+    static std::vector<CaptureResult> _captures; // UI thread's buffer, reused every frame
+    static ThumbnailCache _thumbnails; // Keeps the registry's thumbnails under Config::thumbnail_budget_mb
+    static D3D11TextureUploader _texture_uploader; // Creates thumbnail textures, and updates the tiles of them that changed
+    static std::vector<TileRect> _dirty_rects; // UI thread's buffer, reused for every capture
+    static constexpr std::size_t _ATLAS_MOVES_PER_FRAME = 8; // Slots repacked per frame, copies that stay on the GPU
+    static ThumbnailAtlas _atlas; // Packs thumbnails into a few textures, a panel draws them in a draw call per page
+    static std::vector<WindowId> _moved_thumbnails; // UI thread's buffer, slots the atlas repacked this frame
+    static std::vector<WindowId> _focus_order; // UI thread's buffer, windows in the order the Open Tabs grid draws them
     static TabGroupMap _tab_groups; // { {Name of Tab Group : {Items}} , {Name of Tab Group : {Items}} , ... }
+    static std::uint64_t _published_registry_version; // Registry version in the latest snapshot
+    static bool _tab_groups_changed; // Tab groups changed since the latest snapshot
+    static TabGroupId _next_tab_group_id; // Ids are bit indices in the registry's membership bitsets, keep them dense
     static TabGroupOrderList _tab_groups_order; // { {Name of Tab Group : <draw priority>} , {Name of Tab Group : <draw priority>} , ... }
     static TabGroupLayoutList _tab_groups_layouts;
 
@@ -140,6 +192,84 @@ class Application {
     static void _checkInputs();
 
 
+    /**
+     * @brief Registry texture releaser, defers the release until no snapshot can show the texture
+     * @param tex: Texture the registry no longer uses
+     */
+    static void _retireTexture(ImTextureID tex) {
+      _snapshots.retire(tex);
+    }
+
+
+    /**
+     * @brief Records an event along with the window's current title and style
+     * @param type: Type of event
+     * @param hwnd: Window of the event
+     * @param time_ms: Tick count the event was generated at
+     * @param flags: Extra RecordedEventFlags
+     */
+    static void _recordEvent(const WindowEvent::Type type, const HWND hwnd, const DWORD time_ms, const std::uint8_t flags);
+
+
+    /**
+     * @brief Event thread: sets the hooks, lists the startup windows, then turns events into deltas until WM_QUIT
+     *
+     * NOTE: Every window query (titles, alt-tab checks) happens here, never on the UI thread.
+     * @param ready: Set once the hooks are set and the startup windows are published, false if a hook failed
+     */
+    static void _runEventThread(std::promise<bool> ready);
+
+
+    /**
+     * @brief Stops the event thread and waits for it, does nothing if it isn't running
+     */
+    static void _stopEventThread();
+
+
+    /**
+     * @brief Applies the deltas published by the event thread to the registry
+     */
+    static void _applyWindowDeltas();
+
+
+    /**
+     * @brief Turns the captures the pool finished into thumbnails, dropping those of windows gone since
+     *
+     * NOTE: Thumbnails go through _thumbnails, which evicts others to stay within the budget.
+     */
+    static void _applyCaptures();
+
+
+    /**
+     * @brief Frees the atlas slots of windows gone or evicted, and repacks a few slots of its most wasteful page
+     *
+     * NOTE: The registry is pointed at the slots that moved.
+     */
+    static void _maintainAtlas();
+
+
+    /**
+     * @brief Requests thumbnails for a list of windows, the first ones first, and sets their icons
+     *
+     * NOTE: Never waits on a capture, windows without a thumbnail yet are drawn as placeholders.
+     * Cached thumbnails are refreshed only after every missing or evicted one was captured.
+     * @param list: Windows in the order they're shown, stale handles are skipped
+     */
+    static void _requestThumbnails(const std::vector<WindowId>& list);
+
+
+    /**
+     * @brief Applies the tab group edits queued by the UI
+     */
+    static void _applyTabGroupEdits();
+
+
+    /**
+     * @brief Publishes a new snapshot if the registry or tab groups changed since the last one
+     */
+    static void _publishSnapshot();
+
+
     /**
      * @brief Wakes up the UI by sending a NULL message
      * 
@@ -162,7 +292,9 @@ class Application {
 
 
     /**
-     * @brief Callback for Windows events
+     * @brief Callback for Windows events, prefilters and queues them
+     *
+     * NOTE: Runs on the event thread, which set the hooks.
      * @param hook: Hook which triggered this callback
      * @param event: Type of event
      * @param hwnd: The window handle associated with the event
@@ -182,6 +314,18 @@ class Application {
     Application() = delete;
 
 
+    /**
+     * @brief Records every window event to a file, for replaying with BetterAltTabReplay
+     *
+     * NOTE: Call before createApplication() so the startup windows are recorded too.
+     * @param path: File to write to
+     * @returns bool: True/False of success
+     */
+    static bool startEventRecording(const std::string& path) {
+      return _event_recorder.open(path);
+    }
+
+
     /**
      * @brief Setup application
      * @param h_instance: Handle of the process
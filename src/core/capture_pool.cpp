@@ -0,0 +1,219 @@
+#include "capture_pool.hpp"
+
+
+CapturePool::~CapturePool() {
+  stop();
+}
+
+
+void CapturePool::start() {
+  if (!_workers.empty()) return;
+
+  _stopping = false;
+  _running.reserve(_worker_count);
+  _workers.reserve(_worker_count);
+  for (std::size_t i = 0; i < _worker_count; i++) {
+    _workers.emplace_back(&CapturePool::_run, this);
+  }
+}
+
+
+void CapturePool::stop() {
+  if (_workers.empty()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+    _jobs.clear();
+    _queue = {};
+  }
+  _wake.notify_all();
+  for (std::thread& worker : _workers) worker.join();
+  _workers.clear();
+}
+
+
+CapturePool::_Running* CapturePool::_findRunning(const WindowId id) {
+  for (_Running& running : _running) {
+    if (running.id == id && !running.cancelled) return &running;
+  }
+  return nullptr;
+}
+
+
+void CapturePool::_run() {
+  std::vector<std::uint8_t> window; // Full size capture before it's fitted, kept for the next one
+  ScaleOptions fit;
+  fit.linear_light = true;
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _wake.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+    if (_stopping) return;
+
+    const _Queued next = _queue.top();
+    _queue.pop();
+
+    // Cancelled, or re-queued with another priority
+    const auto it = _jobs.find(next.id);
+    if (it == _jobs.end() || it->second.ticket != next.ticket) continue;
+    const HWND hwnd = it->second.hwnd;
+    _jobs.erase(it);
+    _running.push_back(_Running{ next.id, next.ticket, false });
+
+    CaptureResult result;
+    result.id = next.id;
+    result.hwnd = hwnd;
+    if (!_spare.empty()) {
+      result.bgra = std::move(_spare.back());
+      _spare.pop_back();
+    }
+    const ThumbnailSize target = _target;
+
+    // The backend may take a while on a big window, never hold the lock meanwhile
+    lock.unlock();
+    bool captured;
+    if (target.width <= 0 || target.height <= 0) {
+      captured = _backend.capture(hwnd, result.bgra, result.width, result.height);
+      result.source_bytes = result.bgra.size();
+    }
+    else {
+      int width = 0;
+      int height = 0;
+      captured = _backend.capture(hwnd, window, width, height);
+      if (captured) {
+        const ThumbnailSize size = fitThumbnail(width, height, target.width, target.height);
+        result.width = size.width;
+        result.height = size.height;
+        result.source_bytes = window.size();
+
+        // Already fits, handed over as is. Mips would make it bigger than the window
+        if (size.width == width && size.height == height) {
+          result.bgra.swap(window);
+        }
+        else {
+          result.mip_levels = mipLevelCount(size.width, size.height, THUMBNAIL_MIP_LEVELS);
+          captured = buildMipChain(window.data(), static_cast<std::ptrdiff_t>(width) * 4, width, height,
+            size, result.mip_levels, result.bgra, fit);
+        }
+      }
+    }
+    if (captured) {
+      hashTiles(result.bgra.data(), static_cast<std::ptrdiff_t>(result.width) * 4, result.width, result.height, result.hashes);
+    }
+    lock.lock();
+
+    bool cancelled = false;
+    for (std::size_t i = 0; i < _running.size(); i++) {
+      if (_running[i].ticket != next.ticket) continue;
+      cancelled = _running[i].cancelled;
+      _running[i] = _running.back();
+      _running.pop_back();
+      break;
+    }
+
+    if (!captured || cancelled) {
+      if (!captured) _failed.fetch_add(1, std::memory_order_relaxed);
+      if (_spare.size() < _MAX_SPARE_BUFFERS) _spare.push_back(std::move(result.bgra));
+      continue;
+    }
+
+    const bool was_empty = _done.empty();
+    _source_bytes.fetch_add(result.source_bytes, std::memory_order_relaxed);
+    _thumbnail_bytes.fetch_add(result.bgra.size(), std::memory_order_relaxed);
+    _done.push_back(std::move(result));
+    _captured.fetch_add(1, std::memory_order_relaxed);
+    if (was_empty && _on_ready) {
+      lock.unlock();
+      _on_ready();
+      lock.lock();
+    }
+  }
+}
+
+
+void CapturePool::setTargetSize(const ThumbnailSize target) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _target = target;
+}
+
+
+void CapturePool::request(const WindowId id, const HWND hwnd, const std::uint32_t priority) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Its result is on the way already
+    if (_findRunning(id)) return;
+
+    const auto it = _jobs.find(id);
+    if (it != _jobs.end()) {
+      // Already queued ahead of this
+      if (it->second.priority <= priority) return;
+      it->second.priority = priority;
+      it->second.ticket = _next_ticket++;
+      _queue.push(_Queued{ priority, it->second.ticket, id });
+    }
+    else {
+      const std::uint64_t ticket = _next_ticket++;
+      _jobs.emplace(id, _Job{ hwnd, priority, ticket });
+      _queue.push(_Queued{ priority, ticket, id });
+    }
+  }
+  _wake.notify_one();
+}
+
+
+void CapturePool::cancel(const WindowId id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_jobs.erase(id) != 0) _cancelled.fetch_add(1, std::memory_order_relaxed);
+
+  if (_Running* running = _findRunning(id)) {
+    running->cancelled = true;
+    _cancelled.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+
+void CapturePool::cancelAll() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::uint64_t cancelled = _jobs.size();
+  _jobs.clear();
+  _queue = {};
+
+  for (_Running& running : _running) {
+    if (running.cancelled) continue;
+    running.cancelled = true;
+    cancelled++;
+  }
+  _cancelled.fetch_add(cancelled, std::memory_order_relaxed);
+}
+
+
+void CapturePool::take(std::vector<CaptureResult>& out) {
+  out.clear();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _done.swap(out);
+}
+
+
+void CapturePool::recycle(std::vector<CaptureResult>& results) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (CaptureResult& result : results) {
+      if (_spare.size() == _MAX_SPARE_BUFFERS) break;
+      _spare.push_back(std::move(result.bgra));
+    }
+  }
+  results.clear();
+}
+
+
+std::size_t CapturePool::pending() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::size_t running = 0;
+  for (const _Running& r : _running) {
+    if (!r.cancelled) running++;
+  }
+  return _jobs.size() + running;
+}
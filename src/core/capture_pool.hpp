@@ -0,0 +1,236 @@
+#ifndef CAPTURE_POOL_HPP
+#define CAPTURE_POOL_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "window_handle.hpp"
+#include "window_backend.hpp"
+#include "thumbnail_mips.hpp"
+#include "tile_hash.hpp"
+
+
+/**
+ * @brief A finished window capture
+ */
+struct CaptureResult {
+  WindowId id = INVALID_WINDOW_ID;
+  HWND hwnd = nullptr;
+  std::vector<std::uint8_t> bgra; // Opaque BGRA pixels, top-down, every mip level back to back
+  int width = 0;                  // Of the first level
+  int height = 0;
+  int mip_levels = 1;
+  std::size_t source_bytes = 0;   // Size of the window's pixels before it was fitted
+  TileHashes hashes;              // Of the first level, tells an unchanged thumbnail from a repainted one
+};
+
+
+/**
+ * @brief Captures windows on a pool of worker threads, so opening a panel never waits on them.
+ *
+ * Captures are requested per window with a priority, the lowest value is captured
+ * first (the first rows of a panel). A window is queued once: requesting it again
+ * only raises its priority, and a window being captured right now isn't queued
+ * again. Cancelled jobs are dropped if they haven't started, and their result is
+ * thrown away if they have. Finished captures wait until the UI takes them, which
+ * is woken up by the ready callback whenever results stop being empty.
+ *
+ * With a target size, captures are fitted into it keeping their aspect ratio and
+ * come with THUMBNAIL_MIP_LEVELS levels, so they're scaled on the workers and a
+ * smaller cell draws from a smaller level instead of needing a new capture. Windows
+ * that already fit are delivered as captured, without mips.
+ *
+ * The first level of every capture is hashed in tiles on the worker, so the UI can skip
+ * uploading a thumbnail that didn't change since the last one.
+ *
+ * Pixel buffers are handed back with recycle() and reused, so steady state captures
+ * don't allocate.
+ *
+ * NOTE: request(), cancel(), take() and recycle() come from the UI thread.
+ */
+class CapturePool {
+  public:
+    static constexpr std::size_t DEFAULT_WORKERS = 2;
+    using ReadyCallback = std::function<void()>;
+
+  private:
+    static constexpr std::size_t _MAX_SPARE_BUFFERS = 8;
+
+    /**
+     * @brief A capture waiting for a worker
+     */
+    struct _Job {
+      HWND hwnd;
+      std::uint32_t priority;
+      std::uint64_t ticket; // Tells a re-prioritized job apart from its stale queue entries
+    };
+
+    /**
+     * @brief Queue entry of a job, ordered so the lowest priority value, then the oldest, comes out first
+     */
+    struct _Queued {
+      std::uint32_t priority;
+      std::uint64_t ticket;
+      WindowId id;
+
+      bool operator<(const _Queued& other) const {
+        if (priority != other.priority) return priority > other.priority;
+        return ticket > other.ticket;
+      }
+    };
+
+    /**
+     * @brief A capture a worker is busy with
+     */
+    struct _Running {
+      WindowId id;
+      std::uint64_t ticket;
+      bool cancelled;
+    };
+
+    WindowBackend& _backend;
+    const std::size_t _worker_count;
+    ReadyCallback _on_ready;
+
+    std::mutex _mutex; // Guards everything but the counters
+    std::condition_variable _wake;
+    std::unordered_map<WindowId, _Job> _jobs; // Queued, not started
+    std::priority_queue<_Queued> _queue;      // Holds stale entries of re-prioritized and cancelled jobs
+    std::vector<_Running> _running;           // One per busy worker
+    std::vector<CaptureResult> _done;
+    std::vector<std::vector<std::uint8_t>> _spare; // Recycled pixel buffers
+    std::vector<std::thread> _workers;
+    std::uint64_t _next_ticket = 1;
+    ThumbnailSize _target;    // 0x0 keeps captures at full size
+    bool _stopping = false;
+
+    std::atomic<std::uint64_t> _captured{0};
+    std::atomic<std::uint64_t> _source_bytes{0};
+    std::atomic<std::uint64_t> _thumbnail_bytes{0};
+    std::atomic<std::uint64_t> _failed{0};
+    std::atomic<std::uint64_t> _cancelled{0};
+
+
+    /**
+     * @brief Worker loop, captures queued windows until stopped
+     */
+    void _run();
+
+
+    /**
+     * @brief Gets the capture in progress of a window
+     * @returns _Running*: Capture, null if none or if it was cancelled
+     */
+    _Running* _findRunning(const WindowId id);
+
+  public:
+    /**
+     * @brief Creates an idle pool, the workers aren't started yet
+     * @param backend: Source of the captures, called from every worker
+     * @param workers: Amount of worker threads
+     * @param on_ready: Called from a worker when results stop being empty, optional
+     */
+    explicit CapturePool(WindowBackend& backend, const std::size_t workers = DEFAULT_WORKERS, ReadyCallback on_ready = nullptr)
+      : _backend(backend)
+      , _worker_count(workers == 0 ? 1 : workers)
+      , _on_ready(std::move(on_ready)) {}
+
+
+    /**
+     * @brief Stops the workers.
+     */
+    ~CapturePool();
+
+
+    CapturePool(const CapturePool&) = delete;
+    CapturePool& operator=(const CapturePool&) = delete;
+
+
+    /**
+     * @brief Starts the workers, requests made before are captured right away
+     */
+    void start();
+
+
+    /**
+     * @brief Stops the workers, waiting for the captures in progress. Queued ones are dropped
+     */
+    void stop();
+
+
+    /**
+     * @brief Sets the size captures started from now on are fitted into
+     * @param target: Box the first mip level fits in, 0x0 for full size captures without mips
+     */
+    void setTargetSize(const ThumbnailSize target);
+
+
+    /**
+     * @brief Queues a capture of a window, or raises the priority of the one already queued
+     * @param id: Registry row the capture is for
+     * @param hwnd: Handle of the window
+     * @param priority: Lower values are captured first
+     */
+    void request(const WindowId id, const HWND hwnd, const std::uint32_t priority);
+
+
+    /**
+     * @brief Drops the queued capture of a window, and throws away the one in progress
+     * @param id: Registry row the capture is for
+     */
+    void cancel(const WindowId id);
+
+
+    /**
+     * @brief Drops every queued capture, and throws away the ones in progress
+     */
+    void cancelAll();
+
+
+    /**
+     * @brief Takes every finished capture
+     * @param out: Cleared, then receives the captures, in the order they finished
+     */
+    void take(std::vector<CaptureResult>& out);
+
+
+    /**
+     * @brief Hands pixel buffers back for reuse
+     * @param results: Captures done with, left empty
+     */
+    void recycle(std::vector<CaptureResult>& results);
+
+
+    /**
+     * @brief Gets the amount of captures queued or in progress
+     * @returns std::size_t: Capture count
+     */
+    std::size_t pending();
+
+
+    /**
+     * @brief Gets the amount of captures delivered, failed (window gone or hung) and cancelled so far
+     */
+    std::uint64_t captured() const { return _captured.load(std::memory_order_relaxed); }
+    std::uint64_t failed() const { return _failed.load(std::memory_order_relaxed); }
+    std::uint64_t cancelled() const { return _cancelled.load(std::memory_order_relaxed); }
+
+
+    /**
+     * @brief Gets the bytes of every delivered capture, at the window's size and as delivered (mips included)
+     */
+    std::uint64_t sourceBytes() const { return _source_bytes.load(std::memory_order_relaxed); }
+    std::uint64_t thumbnailBytes() const { return _thumbnail_bytes.load(std::memory_order_relaxed); }
+};
+
+
+#endif // CAPTURE_POOL_HPP
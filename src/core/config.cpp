@@ -40,6 +40,8 @@ float Config::settings_panel_height_percent = 100.0f; // Full screen height
 
 // Graphics
 bool Config::vsync = true;
+int Config::thumbnail_budget_mb = 256;
+bool Config::thumbnail_atlas = true;
 
 
 // ---------------- init & save ----------------
@@ -96,6 +98,8 @@ bool Config::save() {
 
     // Graphics
     _json_reader.setBool(_VSYNC, vsync);
+    _json_reader.setInt(_THUMBNAIL_BUDGET_MB, thumbnail_budget_mb);
+    _json_reader.setBool(_THUMBNAIL_ATLAS, thumbnail_atlas);
   }
 
   return _json_reader.saveToFile(CONFIG_SAVE_PATH);
@@ -128,6 +132,9 @@ void Config::resetToSaved() {
 
   // Graphics
   vsync = _json_reader.getBool(_VSYNC);
+  thumbnail_budget_mb = std::clamp(_json_reader.getInt(_THUMBNAIL_BUDGET_MB, _THUMBNAIL_BUDGET_MB_DEFAULT),
+    THUMBNAIL_BUDGET_MIN_MB, THUMBNAIL_BUDGET_MAX_MB); // Same range as the settings panel, 0 would evict everything
+  thumbnail_atlas = _json_reader.getBool(_THUMBNAIL_ATLAS, _THUMBNAIL_ATLAS_DEFAULT);
 }
 
 
@@ -155,6 +162,8 @@ void Config::resetToDefault() {
 
   // Graphics
   vsync = _VSYNC_DEFAULT;
+  thumbnail_budget_mb = _THUMBNAIL_BUDGET_MB_DEFAULT;
+  thumbnail_atlas = _THUMBNAIL_ATLAS_DEFAULT;
 
   // Save default settings
   save();
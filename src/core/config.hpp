@@ -7,6 +7,7 @@
 #endif // NOMINMAX
 
 
+#include <algorithm>
 #include <string_view>
 #include <array>
 #include <vector>
@@ -139,6 +140,10 @@ class Config {
     inline static const std::string _GRAPHICS_SETTINGS = "Graphics Settings";
     inline static const std::string _VSYNC = (_GRAPHICS_SETTINGS + "." + "V-Sync");
     inline static const bool _VSYNC_DEFAULT = true;
+    inline static const std::string _THUMBNAIL_BUDGET_MB = (_GRAPHICS_SETTINGS + "." + "Thumbnail Memory MB");
+    inline static const int _THUMBNAIL_BUDGET_MB_DEFAULT = 256;
+    inline static const std::string _THUMBNAIL_ATLAS = (_GRAPHICS_SETTINGS + "." + "Thumbnail Atlas");
+    inline static const bool _THUMBNAIL_ATLAS_DEFAULT = true;
 
     // ---------
     
@@ -197,6 +202,10 @@ class Config {
 
     // Graphics
     static bool vsync;
+    static int thumbnail_budget_mb; // Most memory held by window thumbnails, least used ones are evicted
+    static constexpr int THUMBNAIL_BUDGET_MIN_MB = 16;
+    static constexpr int THUMBNAIL_BUDGET_MAX_MB = 4096;
+    static bool thumbnail_atlas;    // Packs thumbnails into a few shared textures, drawn in a draw call per texture
 };
 
 
@@ -0,0 +1,46 @@
+#ifndef CPU_FEATURES_HPP
+#define CPU_FEATURES_HPP
+
+
+// SSE2 is always there on x64, wider vectors are picked at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+  #define CPU_FEATURES_X86 1
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+    #define CPU_FEATURES_AVX2_TARGET
+  #else
+    #define CPU_FEATURES_AVX2_TARGET __attribute__((target("avx2")))
+  #endif
+#endif
+
+
+#ifdef CPU_FEATURES_X86
+/**
+ * @brief Checks if the CPU and the OS both support AVX2
+ *
+ * NOTE: Safe to call from static initializers.
+ * @returns bool: True/False of AVX2 code being runnable
+ */
+inline bool cpuHasAvx2() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false; // YMM state saved by the OS
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init(); // May run before the runtime's own constructors
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif // CPU_FEATURES_X86
+
+
+#endif // CPU_FEATURES_HPP
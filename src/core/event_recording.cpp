@@ -0,0 +1,231 @@
+#include "event_recording.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+// ----------------- Encoding -----------------
+
+namespace {
+  constexpr std::size_t RECORD_HEADER_SIZE = 1 + 1 + 2 + 4 + 8 + 4 + 4;
+  constexpr std::size_t FLUSH_SIZE = 64 * 1024;
+  constexpr std::size_t MAX_TITLE = UINT16_MAX;
+
+
+  /**
+   * @brief Appends an unsigned value, little-endian
+   */
+  template <typename T>
+  void putLE(std::vector<char>& out, const T value) {
+    for (std::size_t i = 0; i < sizeof(T); i++) {
+      out.push_back(static_cast<char>((static_cast<std::uint64_t>(value) >> (i * 8)) & 0xFF));
+    }
+  }
+
+
+  /**
+   * @brief Reads an unsigned value, little-endian
+   */
+  template <typename T>
+  T getLE(const char* in) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < sizeof(T); i++) {
+      value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i])) << (i * 8);
+    }
+    return static_cast<T>(value);
+  }
+}
+
+
+// ----------------- EventRecorder -----------------
+
+bool EventRecorder::open(const std::string& path) {
+  close();
+
+  _out.open(path, std::ios::binary | std::ios::trunc);
+  if (!_out.is_open()) return false;
+
+  _buffer.clear();
+  _buffer.reserve(FLUSH_SIZE + RECORD_HEADER_SIZE + MAX_TITLE);
+  _buffer.insert(_buffer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+  putLE(_buffer, VERSION);
+  _count = 0;
+  return true;
+}
+
+
+void EventRecorder::close() {
+  if (!_out.is_open()) return;
+
+  _out.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+  _buffer.clear();
+  _out.close();
+}
+
+
+void EventRecorder::write(const RecordedEvent& event) {
+  if (!_out.is_open()) return;
+
+  const std::size_t title_len = std::min(event.title.size(), MAX_TITLE);
+  putLE(_buffer, static_cast<std::uint8_t>(event.event.type));
+  putLE(_buffer, event.flags);
+  putLE(_buffer, static_cast<std::uint16_t>(title_len));
+  putLE(_buffer, event.event.time_ms);
+  putLE(_buffer, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(event.event.hwnd)));
+  putLE(_buffer, event.style);
+  putLE(_buffer, event.ex_style);
+  _buffer.insert(_buffer.end(), event.title.data(), event.title.data() + title_len);
+  _count++;
+
+  if (_buffer.size() >= FLUSH_SIZE) {
+    _out.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+    _buffer.clear();
+  }
+}
+
+
+bool loadEventRecording(const std::string& path, std::vector<RecordedEvent>& events) {
+  events.clear();
+
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) return false;
+  const std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  // Header
+  constexpr std::size_t FILE_HEADER_SIZE = sizeof(EventRecorder::MAGIC) + 4;
+  if (data.size() < FILE_HEADER_SIZE) return false;
+  if (std::memcmp(data.data(), EventRecorder::MAGIC, sizeof(EventRecorder::MAGIC)) != 0) return false;
+  if (getLE<std::uint32_t>(data.data() + sizeof(EventRecorder::MAGIC)) != EventRecorder::VERSION) return false;
+
+  // Records
+  std::size_t pos = FILE_HEADER_SIZE;
+  while (pos < data.size()) {
+    if (data.size() - pos < RECORD_HEADER_SIZE) return false;
+    const char* rec = data.data() + pos;
+
+    const std::uint8_t type = getLE<std::uint8_t>(rec);
+    if (type > WindowEvent::UNCLOAK) return false;
+    const std::uint16_t title_len = getLE<std::uint16_t>(rec + 2);
+    if (data.size() - pos - RECORD_HEADER_SIZE < title_len) return false;
+
+    RecordedEvent& e = events.emplace_back();
+    e.event.type = static_cast<WindowEvent::Type>(type);
+    e.flags = getLE<std::uint8_t>(rec + 1);
+    e.event.time_ms = getLE<std::uint32_t>(rec + 4);
+    e.event.hwnd = reinterpret_cast<HWND>(static_cast<std::uintptr_t>(getLE<std::uint64_t>(rec + 8)));
+    e.style = getLE<std::uint32_t>(rec + 16);
+    e.ex_style = getLE<std::uint32_t>(rec + 20);
+    e.title.assign(rec + RECORD_HEADER_SIZE, title_len);
+
+    pos += RECORD_HEADER_SIZE + title_len;
+  }
+  return true;
+}
+
+
+// ----------------- EventReplayer -----------------
+
+void EventReplayer::_RecordedBackend::enumerateAltTab(std::vector<EnumeratedWindow>& out) {
+  out.clear();
+  for (const auto& [hwnd, state] : _windows) {
+    if (state.alt_tab) out.push_back(EnumeratedWindow{ hwnd, state.title, 0 });
+  }
+}
+
+
+bool EventReplayer::_RecordedBackend::topLevelWindows(std::vector<HWND>& out) {
+  out.clear();
+  for (const auto& [hwnd, state] : _windows) out.push_back(hwnd);
+  return true;
+}
+
+
+bool EventReplayer::_RecordedBackend::title(const HWND hwnd, std::string& title) {
+  const auto it = _windows.find(hwnd);
+  if (it == _windows.end()) return false;
+
+  title = it->second.title;
+  return true;
+}
+
+
+bool EventReplayer::_RecordedBackend::traits(const HWND hwnd, WindowTraits& traits) {
+  const auto it = _windows.find(hwnd);
+  if (it == _windows.end()) return false;
+
+  // Style bits of <windows.h>, recordings are replayed headless too
+  constexpr std::uint32_t VISIBLE = 0x10000000;     // WS_VISIBLE
+  constexpr std::uint32_t CHILD = 0x40000000;       // WS_CHILD
+  constexpr std::uint32_t TOOL_WINDOW = 0x00000080; // WS_EX_TOOLWINDOW
+  constexpr std::uint32_t APP_WINDOW = 0x00040000;  // WS_EX_APPWINDOW
+
+  const _WindowState& state = it->second;
+  traits = WindowTraits{};
+  traits.visible = (state.style & VISIBLE) != 0;
+  traits.child = (state.style & CHILD) != 0;
+  traits.tool_window = (state.ex_style & TOOL_WINDOW) != 0;
+  traits.app_window = (state.ex_style & APP_WINDOW) != 0;
+
+  // Owner and cloak weren't recorded, only the outcome, which always wins. Styles that
+  // let it in but it wasn't listed, so it was cloaked
+  if (state.alt_tab && !traits.altTab()) {
+    traits = WindowTraits{};
+    traits.visible = true;
+  }
+  traits.cloaked = traits.altTab() && !state.alt_tab;
+  return true;
+}
+
+
+std::uint32_t EventReplayer::_RecordedBackend::processId(const HWND) {
+  return 0;
+}
+
+
+bool EventReplayer::_RecordedBackend::processInfo(const HWND, ProcessInfo&, const std::uint32_t) {
+  return false;
+}
+
+
+bool EventReplayer::_RecordedBackend::capture(const HWND, std::vector<std::uint8_t>&, int&, int&) {
+  return false;
+}
+
+
+void EventReplayer::_flush(const BatchSink& sink) {
+  _builder.build(_queue, _batch);
+  if (_batch.empty()) return;
+
+  sink(_batch);
+  _batch.clear();
+  _batches++;
+}
+
+
+void EventReplayer::replay(const std::vector<RecordedEvent>& events, const std::uint32_t frame_ms, const BatchSink& sink) {
+  std::uint32_t batch_start = events.empty() ? 0 : events.front().event.time_ms;
+
+  for (const RecordedEvent& e : events) {
+    // The frame this event arrives in is over, hand over what queued up during it
+    if (!_queue.empty() && e.event.time_ms - batch_start >= frame_ms) {
+      _flush(sink);
+      batch_start = e.event.time_ms;
+    }
+
+    // Live, windows are queried when the batch is built, so that's the latest state
+    _backend.update(e);
+
+    // Startup windows were enumerated, never queued
+    if (e.flags & RECORDED_FLAG_ENUMERATED) {
+      if (!(e.flags & RECORDED_FLAG_ALT_TAB)) continue;
+      _builder.track(e.event.hwnd);
+      _batch.push(WindowDelta::ADDED, e.event.hwnd, e.title);
+      continue;
+    }
+
+    if (_queue.empty()) batch_start = e.event.time_ms;
+    _queue.push(e.event);
+    if (frame_ms == 0) _flush(sink);
+  }
+  _flush(sink);
+}
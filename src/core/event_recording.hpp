@@ -0,0 +1,209 @@
+#ifndef EVENT_RECORDING_HPP
+#define EVENT_RECORDING_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "window_handle.hpp"
+#include "window_events.hpp"
+#include "window_deltas.hpp"
+
+
+/**
+ * @brief Window state bits captured along with a recorded event
+ */
+enum RecordedEventFlags : std::uint8_t {
+  RECORDED_FLAG_NONE       = 0,
+  RECORDED_FLAG_ALT_TAB    = 1u << 0, // Window passed isAltTabWindow() when the event arrived
+  RECORDED_FLAG_ENUMERATED = 1u << 1, // Startup enumeration, not a hook event
+  RECORDED_FLAG_RECONCILED = 1u << 2, // Correction of a reconciliation sweep, replayed like a hook event
+};
+
+
+/**
+ * @brief One event that reached the hook, plus the window state at that time
+ */
+struct RecordedEvent {
+  WindowEvent event;
+  std::uint8_t flags;
+  std::uint32_t style;
+  std::uint32_t ex_style;
+  std::string title;
+};
+
+
+/**
+ * @brief Writes events to a compact binary recording.
+ *
+ * Layout (little-endian): an 8-byte magic, a u32 version, then one record per event
+ *   u8 type, u8 flags, u16 title length, u32 time_ms, u64 hwnd, u32 style, u32 ex_style, title bytes
+ *
+ * NOTE: Handles are only used as keys, they're stored as plain 64-bit values.
+ */
+class EventRecorder {
+  public:
+    static constexpr char MAGIC[8] = { 'B', 'A', 'T', 'E', 'V', 'T', '\0', '\0' };
+    static constexpr std::uint32_t VERSION = 1;
+
+  private:
+    std::ofstream _out;
+    std::vector<char> _buffer; // Records are flushed in chunks
+    std::size_t _count = 0;
+
+  public:
+    ~EventRecorder() {
+      close();
+    }
+
+
+    /**
+     * @brief Starts a new recording, replacing the file
+     * @param path: File to write to
+     * @returns bool: True/False of success
+     */
+    bool open(const std::string& path);
+
+
+    /**
+     * @brief Flushes and closes the recording
+     */
+    void close();
+
+
+    /**
+     * @brief Checks if a recording is in progress
+     * @returns bool: True/False of being open
+     */
+    bool isOpen() const {
+      return _out.is_open();
+    }
+
+
+    /**
+     * @brief Appends an event
+     * @param event: Event to append, titles longer than 65535 bytes are cut
+     */
+    void write(const RecordedEvent& event);
+
+
+    /**
+     * @brief Gets the amount of events written
+     * @returns std::size_t: Event count
+     */
+    std::size_t count() const {
+      return _count;
+    }
+};
+
+
+/**
+ * @brief Reads a whole recording into memory
+ * @param path: File to read
+ * @param events: Output list, cleared first
+ * @returns bool: False if the file is missing, has a different version or is truncated
+ */
+bool loadEventRecording(const std::string& path, std::vector<RecordedEvent>& events);
+
+
+/**
+ * @brief Feeds a recording through the event queue and delta builder, without Win32.
+ *
+ * Events are queued at their recorded times and turned into one delta batch per
+ * frame interval of recorded time, so merging behaves like it does live. Windows
+ * are answered from the latest recorded state instead of being queried.
+ */
+class EventReplayer {
+  public:
+    using BatchSink = std::function<void(WindowDeltaBatch& batch)>;
+
+  private:
+    /**
+     * @brief Answers window queries from the recorded state
+     */
+    class _RecordedBackend : public WindowBackend {
+      private:
+        /**
+         * @brief Latest recorded state of a window
+         */
+        struct _WindowState {
+          std::string title;
+          std::uint32_t style;
+          std::uint32_t ex_style;
+          bool alt_tab;
+        };
+
+        std::unordered_map<HWND, _WindowState> _windows;
+
+      public:
+        /**
+         * @brief Stores the window state a recorded event carries
+         * @param e: Recorded event
+         */
+        void update(const RecordedEvent& e) {
+          _WindowState& state = _windows[e.event.hwnd];
+          state.title = e.title;
+          state.style = e.style;
+          state.ex_style = e.ex_style;
+          state.alt_tab = (e.flags & RECORDED_FLAG_ALT_TAB) != 0;
+        }
+
+        void enumerateAltTab(std::vector<EnumeratedWindow>& out) override;
+        bool topLevelWindows(std::vector<HWND>& out) override;
+        bool title(const HWND hwnd, std::string& title) override;
+        bool traits(const HWND hwnd, WindowTraits& traits) override;
+        std::uint32_t processId(const HWND hwnd) override; // Recordings carry no processes
+        bool processInfo(const HWND hwnd, ProcessInfo& info, const std::uint32_t timeout_ms) override;
+        bool capture(const HWND hwnd, std::vector<std::uint8_t>& bgra, int& width, int& height) override; // Recordings carry no pixels
+    };
+
+    WindowEventQueue& _queue;
+    _RecordedBackend _backend;
+    WindowDeltaBuilder _builder;
+    WindowDeltaBatch _batch;
+    std::size_t _batches = 0;
+
+
+    /**
+     * @brief Turns every queued event into deltas and hands them to the sink
+     */
+    void _flush(const BatchSink& sink);
+
+  public:
+    /**
+     * @brief Creates a replayer
+     * @param queue: Queue events go through
+     */
+    explicit EventReplayer(WindowEventQueue& queue)
+      : _queue(queue)
+      , _builder(_backend) {}
+
+
+    /**
+     * @brief Replays a recording as fast as possible
+     *
+     * Usage  ->   replayer.replay(events, 16, [&](WindowDeltaBatch& batch) { applyWindowDeltas(registry, batch); });
+     * @param events: Recorded events, in order
+     * @param frame_ms: Recorded time between two batches, 0 makes a batch of every event
+     * @param sink: Receives every batch, may leave it non-empty
+     */
+    void replay(const std::vector<RecordedEvent>& events, const std::uint32_t frame_ms, const BatchSink& sink);
+
+
+    /**
+     * @brief Gets the amount of batches handed to the sink
+     * @returns std::size_t: Batch count
+     */
+    std::size_t batches() const {
+      return _batches;
+    }
+};
+
+
+#endif // EVENT_RECORDING_HPP
@@ -0,0 +1,558 @@
+#include "image_scaler.hpp"
+#include "cpu_features.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+
+namespace {
+  constexpr int WEIGHT_BITS = 14;
+  constexpr std::int32_t WEIGHT_ONE = 1 << WEIGHT_BITS;
+  constexpr std::int32_t WEIGHT_ROUND = 1 << (WEIGHT_BITS - 1);
+  constexpr std::int32_t VALUE_MAX = (1 << 14) - 1; // Channels are 14-bit fixed point between the passes
+  constexpr int VALUE_SHIFT = 6;                   // 8-bit to 14-bit
+  constexpr int MIN_BAND_ROWS = 8;                 // Fewer output rows per band aren't worth a thread
+
+
+  /**
+   * @brief Which source pixels make up every destination pixel along one axis, and how much
+   */
+  struct Contributions {
+    std::vector<std::int32_t> start;
+    std::vector<std::int32_t> count;
+    std::vector<std::int16_t> weights; // `stride` per destination pixel, zero past its count
+    std::size_t stride = 0;            // Most taps of any pixel, rounded up to 4
+  };
+
+
+  double boxFilter(const double x) {
+    return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+  }
+
+
+  double bilinearFilter(const double x) {
+    return std::max(0.0, 1.0 - std::fabs(x));
+  }
+
+
+  double sinc(const double x) {
+    if (x == 0.0) return 1.0;
+    const double px = x * 3.14159265358979323846;
+    return std::sin(px) / px;
+  }
+
+
+  double lanczos3Filter(const double x) {
+    return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+  }
+
+
+  /**
+   * @brief Computes the fixed-point weights of every destination pixel along one axis
+   */
+  Contributions buildContributions(const int in_size, const int out_size, const ScaleFilter filter) {
+    double (*f)(double) = boxFilter;
+    double base_support = 0.5;
+    if (filter == ScaleFilter::BILINEAR) { f = bilinearFilter; base_support = 1.0; }
+    if (filter == ScaleFilter::LANCZOS3) { f = lanczos3Filter; base_support = 3.0; }
+
+    // Downscaling widens the filter over every source pixel a destination pixel covers
+    const double scale = static_cast<double>(in_size) / out_size;
+    const double filter_scale = std::max(scale, 1.0);
+    const double support = base_support * filter_scale;
+
+    Contributions c;
+    c.start.resize(out_size);
+    c.count.resize(out_size);
+    std::vector<std::vector<std::int16_t>> taps(out_size);
+    std::vector<double> w;
+    for (int x = 0; x < out_size; x++) {
+      const double center = (x + 0.5) * scale;
+      int first = std::max(static_cast<int>(center - support + 0.5), 0);
+      int last = std::min(static_cast<int>(center + support + 0.5), in_size);
+      if (last <= first) last = std::min(first + 1, in_size), first = last - 1;
+
+      w.assign(last - first, 0.0);
+      double total = 0.0;
+      for (int i = first; i < last; i++) {
+        w[i - first] = f((i - center + 0.5) / filter_scale);
+        total += w[i - first];
+      }
+
+      // Quantized, then the rounding error goes to the biggest tap so they sum to exactly one
+      std::vector<std::int16_t>& q = taps[x];
+      q.resize(w.size());
+      std::int32_t sum = 0;
+      std::size_t biggest = 0;
+      for (std::size_t i = 0; i < w.size(); i++) {
+        q[i] = static_cast<std::int16_t>(std::lround(total != 0.0 ? w[i] / total * WEIGHT_ONE : 0.0));
+        sum += q[i];
+        if (std::abs(q[i]) > std::abs(q[biggest])) biggest = i;
+      }
+      q[biggest] = static_cast<std::int16_t>(q[biggest] + WEIGHT_ONE - sum);
+
+      // Box edges weigh nothing, drop them
+      std::size_t lead = 0;
+      std::size_t trail = q.size();
+      while (lead + 1 < trail && q[lead] == 0) lead++;
+      while (trail - 1 > lead && q[trail - 1] == 0) trail--;
+      q.erase(q.begin() + trail, q.end());
+      q.erase(q.begin(), q.begin() + lead);
+
+      c.start[x] = first + static_cast<std::int32_t>(lead);
+      c.count[x] = static_cast<std::int32_t>(q.size());
+      c.stride = std::max(c.stride, q.size());
+    }
+
+    c.stride = (c.stride + 3) & ~std::size_t(3);
+    c.weights.assign(c.stride * out_size, 0);
+    for (int x = 0; x < out_size; x++) {
+      std::copy(taps[x].begin(), taps[x].end(), c.weights.begin() + x * c.stride);
+    }
+    return c;
+  }
+
+
+  /**
+   * @brief Rounds a weighted sum back to the 14-bit range, Lanczos lobes can overshoot either way
+   */
+  inline std::uint16_t narrow(const std::int32_t acc) {
+    return static_cast<std::uint16_t>(std::clamp((acc + WEIGHT_ROUND) >> WEIGHT_BITS, 0, VALUE_MAX));
+  }
+
+
+  // ----------------- Scalar -----------------
+
+  void horizontalScalar(const std::uint16_t* row, std::uint16_t* out, const std::size_t out_width,
+    const std::int32_t* start, const std::int32_t* count, const std::int16_t* weights, const std::size_t stride) {
+    for (std::size_t x = 0; x < out_width; x++) {
+      const std::uint16_t* p = row + static_cast<std::size_t>(start[x]) * 4;
+      const std::int16_t* w = weights + x * stride;
+      std::int32_t acc[4] = { 0, 0, 0, 0 };
+      for (std::int32_t k = 0; k < count[x]; k++) {
+        for (int c = 0; c < 4; c++) acc[c] += p[k * 4 + c] * w[k];
+      }
+      for (int c = 0; c < 4; c++) out[x * 4 + c] = narrow(acc[c]);
+    }
+  }
+
+
+  /**
+   * @brief Filters one channel down, for the scalar set and the tails of the vector ones
+   */
+  inline void verticalChannels(const std::uint16_t* const* rows, const std::int16_t* weights, const std::size_t taps,
+    std::uint16_t* out, const std::size_t first, const std::size_t end) {
+    for (std::size_t c = first; c < end; c++) {
+      std::int32_t acc = 0;
+      for (std::size_t k = 0; k < taps; k++) acc += rows[k][c] * weights[k];
+      out[c] = narrow(acc);
+    }
+  }
+
+
+  void verticalScalar(const std::uint16_t* const* rows, const std::int16_t* weights, const std::size_t taps,
+    std::uint16_t* out, const std::size_t channels) {
+    verticalChannels(rows, weights, taps, out, 0, channels);
+  }
+
+
+  void expandScalar(const std::uint8_t* src, std::uint16_t* out, const std::size_t pixels) {
+    for (std::size_t i = 0; i < pixels * 4; i++) out[i] = static_cast<std::uint16_t>(src[i] << VALUE_SHIFT);
+  }
+
+
+  void compressScalar(const std::uint16_t* src, std::uint8_t* out, const std::size_t pixels) {
+    for (std::size_t i = 0; i < pixels * 4; i++) {
+      out[i] = static_cast<std::uint8_t>(std::min((src[i] + (1 << (VALUE_SHIFT - 1))) >> VALUE_SHIFT, 255));
+    }
+  }
+
+
+#ifdef CPU_FEATURES_X86
+  // ----------------- SSE2 -----------------
+
+  /**
+   * @brief Rounds 4 weighted sums and stores them as 14-bit channels
+   */
+  inline void storeNarrowed4(std::uint16_t* out, __m128i acc) {
+    acc = _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(WEIGHT_ROUND)), WEIGHT_BITS);
+    __m128i v = _mm_packs_epi32(acc, acc);
+    v = _mm_min_epi16(_mm_max_epi16(v, _mm_setzero_si128()), _mm_set1_epi16(VALUE_MAX));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), v);
+  }
+
+
+  /**
+   * @brief Loads two adjacent weights as one 32-bit lane
+   */
+  inline std::int32_t weightPair(const std::int16_t* w) {
+    std::int32_t pair;
+    std::memcpy(&pair, w, 4);
+    return pair;
+  }
+
+
+  void horizontalSse2(const std::uint16_t* row, std::uint16_t* out, const std::size_t out_width,
+    const std::int32_t* start, const std::int32_t* count, const std::int16_t* weights, const std::size_t stride) {
+    for (std::size_t x = 0; x < out_width; x++) {
+      const std::uint16_t* p = row + static_cast<std::size_t>(start[x]) * 4;
+      const std::int16_t* w = weights + x * stride;
+
+      // Two taps per madd: channels of both pixels interleaved against their two weights
+      __m128i acc = _mm_setzero_si128();
+      for (std::int32_t k = 0; k < count[x]; k += 2) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k * 4));
+        const __m128i pairs = _mm_unpacklo_epi16(v, _mm_srli_si128(v, 8));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(pairs, _mm_set1_epi32(weightPair(w + k))));
+      }
+      storeNarrowed4(out + x * 4, acc);
+    }
+  }
+
+
+  /**
+   * @brief Rounds 8 weighted sums and stores them as 14-bit channels
+   */
+  inline void storeNarrowed8(std::uint16_t* out, __m128i lo, __m128i hi) {
+    const __m128i round = _mm_set1_epi32(WEIGHT_ROUND);
+    lo = _mm_srai_epi32(_mm_add_epi32(lo, round), WEIGHT_BITS);
+    hi = _mm_srai_epi32(_mm_add_epi32(hi, round), WEIGHT_BITS);
+    __m128i v = _mm_packs_epi32(lo, hi);
+    v = _mm_min_epi16(_mm_max_epi16(v, _mm_setzero_si128()), _mm_set1_epi16(VALUE_MAX));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+  }
+
+
+  void verticalSse2(const std::uint16_t* const* rows, const std::int16_t* weights, const std::size_t taps,
+    std::uint16_t* out, const std::size_t channels) {
+    std::size_t c = 0;
+    for (; c + 8 <= channels; c += 8) {
+      __m128i lo = _mm_setzero_si128();
+      __m128i hi = _mm_setzero_si128();
+      std::size_t k = 0;
+      for (; k + 2 <= taps; k += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + c));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k + 1] + c));
+        const __m128i w = _mm_set1_epi32(weightPair(weights + k));
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+        hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+      }
+      if (k < taps) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + c));
+        const __m128i w = _mm_set1_epi32(static_cast<std::uint16_t>(weights[k]));
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, _mm_setzero_si128()), w));
+        hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, _mm_setzero_si128()), w));
+      }
+      storeNarrowed8(out + c, lo, hi);
+    }
+    verticalChannels(rows, weights, taps, out, c, channels);
+  }
+
+
+  void expandSse2(const std::uint8_t* src, std::uint16_t* out, const std::size_t pixels) {
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), _mm_slli_epi16(_mm_unpacklo_epi8(v, zero), VALUE_SHIFT));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4 + 8), _mm_slli_epi16(_mm_unpackhi_epi8(v, zero), VALUE_SHIFT));
+    }
+    expandScalar(src + i * 4, out + i * 4, pixels - i);
+  }
+
+
+  void compressSse2(const std::uint16_t* src, std::uint8_t* out, const std::size_t pixels) {
+    const __m128i round = _mm_set1_epi16(1 << (VALUE_SHIFT - 1));
+    std::size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+      const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+      const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 8));
+      const __m128i v = _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(lo, round), VALUE_SHIFT),
+                                         _mm_srli_epi16(_mm_add_epi16(hi, round), VALUE_SHIFT));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), v);
+    }
+    compressScalar(src + i * 4, out + i * 4, pixels - i);
+  }
+
+
+  // ----------------- AVX2 -----------------
+  // Tails go through the scalar loops, calling the SSE2 ones with dirty upper halves would stall
+
+  CPU_FEATURES_AVX2_TARGET
+  void horizontalAvx2(const std::uint16_t* row, std::uint16_t* out, const std::size_t out_width,
+    const std::int32_t* start, const std::int32_t* count, const std::int16_t* weights, const std::size_t stride) {
+    // Per 128-bit lane: two pixels, channels interleaved so each 32-bit lane is one channel of both
+    const __m256i interleave = _mm256_setr_epi8(
+      0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15,
+      0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15
+    );
+    const __m256i spread = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1); // Weight pair 0 to the low lane, pair 1 to the high one
+    const __m128i round = _mm_set1_epi32(WEIGHT_ROUND);
+    for (std::size_t x = 0; x < out_width; x++) {
+      const std::uint16_t* p = row + static_cast<std::size_t>(start[x]) * 4;
+      const std::int16_t* w = weights + x * stride;
+
+      // Four taps per madd
+      __m256i acc = _mm256_setzero_si256();
+      for (std::int32_t k = 0; k < count[x]; k += 4) {
+        const __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + k * 4)), interleave);
+        const __m256i wk = _mm256_permutevar8x32_epi32(
+          _mm256_castsi128_si256(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(w + k))), spread);
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(v, wk));
+      }
+
+      __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+      sum = _mm_srai_epi32(_mm_add_epi32(sum, round), WEIGHT_BITS);
+      __m128i v = _mm_packs_epi32(sum, sum);
+      v = _mm_min_epi16(_mm_max_epi16(v, _mm_setzero_si128()), _mm_set1_epi16(VALUE_MAX));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), v);
+    }
+    _mm256_zeroupper();
+  }
+
+
+  CPU_FEATURES_AVX2_TARGET
+  void verticalAvx2(const std::uint16_t* const* rows, const std::int16_t* weights, const std::size_t taps,
+    std::uint16_t* out, const std::size_t channels) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(WEIGHT_ROUND);
+    std::size_t c = 0;
+    for (; c + 16 <= channels; c += 16) {
+      // Unpacking works per 128-bit lane and packing undoes it, no lane crossing needed
+      __m256i lo = zero;
+      __m256i hi = zero;
+      std::size_t k = 0;
+      for (; k + 2 <= taps; k += 2) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + c));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k + 1] + c));
+        const __m256i w = _mm256_set1_epi32(weightPair(weights + k));
+        lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+        hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+      }
+      if (k < taps) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + c));
+        const __m256i w = _mm256_set1_epi32(static_cast<std::uint16_t>(weights[k]));
+        lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, zero), w));
+        hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, zero), w));
+      }
+      lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), WEIGHT_BITS);
+      hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), WEIGHT_BITS);
+      __m256i v = _mm256_packs_epi32(lo, hi);
+      v = _mm256_min_epi16(_mm256_max_epi16(v, zero), _mm256_set1_epi16(VALUE_MAX));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + c), v);
+    }
+    _mm256_zeroupper();
+    verticalChannels(rows, weights, taps, out, c, channels);
+  }
+
+
+  CPU_FEATURES_AVX2_TARGET
+  void expandAvx2(const std::uint8_t* src, std::uint16_t* out, const std::size_t pixels) {
+    std::size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+      const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4), _mm256_slli_epi16(v, VALUE_SHIFT));
+    }
+    _mm256_zeroupper();
+    expandScalar(src + i * 4, out + i * 4, pixels - i);
+  }
+
+
+  CPU_FEATURES_AVX2_TARGET
+  void compressAvx2(const std::uint16_t* src, std::uint8_t* out, const std::size_t pixels) {
+    const __m256i round = _mm256_set1_epi16(1 << (VALUE_SHIFT - 1));
+    std::size_t i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+      const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+      const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4 + 16));
+      const __m256i v = _mm256_packus_epi16(_mm256_srli_epi16(_mm256_add_epi16(lo, round), VALUE_SHIFT),
+                                            _mm256_srli_epi16(_mm256_add_epi16(hi, round), VALUE_SHIFT));
+      // Packing interleaves the lanes, put the quarters back in order
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4), _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    _mm256_zeroupper();
+    compressScalar(src + i * 4, out + i * 4, pixels - i);
+  }
+#endif // CPU_FEATURES_X86
+
+
+  std::vector<ScalerKernels> buildSupported() {
+    std::vector<ScalerKernels> sets;
+    sets.push_back(ScalerKernels{ "scalar", horizontalScalar, verticalScalar, expandScalar, compressScalar });
+#ifdef CPU_FEATURES_X86
+    sets.push_back(ScalerKernels{ "sse2", horizontalSse2, verticalSse2, expandSse2, compressSse2 });
+    if (cpuHasAvx2()) {
+      sets.push_back(ScalerKernels{ "avx2", horizontalAvx2, verticalAvx2, expandAvx2, compressAvx2 });
+    }
+#endif
+    return sets;
+  }
+
+
+  // ----------------- Linear light -----------------
+
+  /**
+   * @brief sRGB <-> 14-bit linear light, alpha stays linear
+   */
+  struct GammaTables {
+    std::array<std::uint16_t, 256> to_linear;
+    std::vector<std::uint8_t> to_srgb; // VALUE_MAX + 1 entries
+
+    GammaTables() : to_srgb(VALUE_MAX + 1) {
+      for (int v = 0; v < 256; v++) {
+        const double s = v / 255.0;
+        const double l = s <= 0.04045 ? s / 12.92 : std::pow((s + 0.055) / 1.055, 2.4);
+        to_linear[v] = static_cast<std::uint16_t>(std::lround(l * VALUE_MAX));
+      }
+      for (int v = 0; v <= VALUE_MAX; v++) {
+        const double l = static_cast<double>(v) / VALUE_MAX;
+        const double s = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+        to_srgb[v] = static_cast<std::uint8_t>(std::lround(std::clamp(s, 0.0, 1.0) * 255.0));
+      }
+    }
+  };
+
+
+  const GammaTables& gammaTables() {
+    static const GammaTables TABLES;
+    return TABLES;
+  }
+
+
+  void expandLinear(const std::uint8_t* src, std::uint16_t* out, const std::size_t pixels) {
+    const GammaTables& g = gammaTables();
+    for (std::size_t i = 0; i < pixels; i++, src += 4, out += 4) {
+      out[0] = g.to_linear[src[0]];
+      out[1] = g.to_linear[src[1]];
+      out[2] = g.to_linear[src[2]];
+      out[3] = static_cast<std::uint16_t>(src[3] << VALUE_SHIFT);
+    }
+  }
+
+
+  void compressLinear(const std::uint16_t* src, std::uint8_t* out, const std::size_t pixels) {
+    const GammaTables& g = gammaTables();
+    for (std::size_t i = 0; i < pixels; i++, src += 4, out += 4) {
+      out[0] = g.to_srgb[src[0]];
+      out[1] = g.to_srgb[src[1]];
+      out[2] = g.to_srgb[src[2]];
+      out[3] = static_cast<std::uint8_t>(std::min((src[3] + (1 << (VALUE_SHIFT - 1))) >> VALUE_SHIFT, 255));
+    }
+  }
+
+
+  /**
+   * @brief Everything one scaleImage() call shares between its bands
+   */
+  struct ScaleJob {
+    const std::uint8_t* src;
+    std::ptrdiff_t src_stride;
+    int src_width;
+    std::uint8_t* dst;
+    std::ptrdiff_t dst_stride;
+    int dst_width;
+    const Contributions* across;
+    const Contributions* down;
+    const ScalerKernels* kernels;
+    bool linear_light;
+  };
+
+
+  /**
+   * @brief Scales the output rows [y0, y1), filtering across only the source rows they need
+   */
+  void scaleBand(const ScaleJob& job, const int y0, const int y1) {
+    const Contributions& down = *job.down;
+    const ScalerKernels& k = *job.kernels;
+    int first = down.start[y0];
+    int last = first;
+    for (int y = y0; y < y1; y++) {
+      first = std::min(first, down.start[y]);
+      last = std::max(last, down.start[y] + down.count[y]);
+    }
+
+    // Source rows are read past their end by up to a stride of taps, those weigh nothing
+    const std::size_t out_channels = static_cast<std::size_t>(job.dst_width) * 4;
+    std::vector<std::uint16_t> row((static_cast<std::size_t>(job.src_width) + job.across->stride) * 4, 0);
+    std::vector<std::uint16_t> across(static_cast<std::size_t>(last - first) * out_channels);
+    for (int sy = first; sy < last; sy++) {
+      const std::uint8_t* src_row = job.src + sy * job.src_stride;
+      if (job.linear_light) expandLinear(src_row, row.data(), job.src_width);
+      else                  k.expand(src_row, row.data(), job.src_width);
+      k.horizontal(row.data(), across.data() + (sy - first) * out_channels, job.dst_width,
+        job.across->start.data(), job.across->count.data(), job.across->weights.data(), job.across->stride);
+    }
+
+    std::vector<const std::uint16_t*> rows(down.stride);
+    std::vector<std::uint16_t> out(out_channels);
+    for (int y = y0; y < y1; y++) {
+      const std::int32_t taps = down.count[y];
+      for (std::int32_t t = 0; t < taps; t++) rows[t] = across.data() + (down.start[y] + t - first) * out_channels;
+      k.vertical(rows.data(), down.weights.data() + y * down.stride, taps, out.data(), out_channels);
+
+      std::uint8_t* dst_row = job.dst + y * job.dst_stride;
+      if (job.linear_light) compressLinear(out.data(), dst_row, job.dst_width);
+      else                  k.compress(out.data(), dst_row, job.dst_width);
+    }
+  }
+}
+
+
+const std::vector<ScalerKernels>& supportedScalerKernels() {
+  static const std::vector<ScalerKernels> SUPPORTED = buildSupported();
+  return SUPPORTED;
+}
+
+
+bool scaleImage(const std::uint8_t* src, const std::ptrdiff_t src_stride, const int src_width, const int src_height,
+  std::uint8_t* dst, const std::ptrdiff_t dst_stride, const int dst_width, const int dst_height,
+  const ScaleOptions& options) {
+  if (src_width <= 0 || src_height <= 0 || dst_width <= 0 || dst_height <= 0) return false;
+
+  const Contributions across = buildContributions(src_width, dst_width, options.filter);
+  const Contributions down = buildContributions(src_height, dst_height, options.filter);
+  const ScaleJob job{
+    src, src_stride, src_width, dst, dst_stride, dst_width, &across, &down,
+    options.kernels ? options.kernels : &supportedScalerKernels().back(), options.linear_light
+  };
+
+  // Bands of output rows, each filters the source rows it needs itself. Neighbours share a few
+  unsigned threads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min<unsigned>(threads, std::max(1, dst_height / MIN_BAND_ROWS));
+  if (threads <= 1) {
+    scaleBand(job, 0, dst_height);
+    return true;
+  }
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (unsigned b = 1; b < threads; b++) {
+    workers.emplace_back(scaleBand, std::cref(job), dst_height * b / threads, dst_height * (b + 1) / threads);
+  }
+  scaleBand(job, 0, dst_height / threads);
+  for (std::thread& worker : workers) worker.join();
+  return true;
+}
+
+
+bool scaleImage(const std::vector<std::uint8_t>& src, const int src_width, const int src_height,
+  std::vector<std::uint8_t>& dst, const int dst_width, const int dst_height, const ScaleOptions& options) {
+  if (dst_width <= 0 || dst_height <= 0) return false;
+
+  dst.resize(static_cast<std::size_t>(dst_width) * dst_height * 4);
+  return scaleImage(src.data(), static_cast<std::ptrdiff_t>(src_width) * 4, src_width, src_height,
+    dst.data(), static_cast<std::ptrdiff_t>(dst_width) * 4, dst_width, dst_height, options);
+}
+
+
+const char* scaleFilterName(const ScaleFilter filter) {
+  switch (filter) {
+    case ScaleFilter::BOX:      return "box";
+    case ScaleFilter::BILINEAR: return "bilinear";
+    case ScaleFilter::LANCZOS3: return "lanczos3";
+  }
+  return "unknown";
+}
@@ -0,0 +1,105 @@
+#ifndef IMAGE_SCALER_HPP
+#define IMAGE_SCALER_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * @brief Resampling filter of scaleImage()
+ */
+enum class ScaleFilter : std::uint8_t {
+  BOX,      // Area average, cheapest, soft
+  BILINEAR, // Tent over two source pixels per destination pixel
+  LANCZOS3  // Windowed sinc over three lobes, sharpest, slight ringing on hard edges
+};
+
+
+/**
+ * @brief One implementation of the scaler's inner loops, for one vector width
+ *
+ * Pixels are worked on as 4 channels of 14-bit fixed point, weights sum to 1 << 14.
+ * Every set gives the same output as the scalar one.
+ */
+struct ScalerKernels {
+  const char* name; // "avx2", "sse2" or "scalar"
+
+  // Filters one row across: out[x] = sum of row[start[x] + k] * weights[x][k], count[x] taps
+  // weights holds `stride` int16 per output pixel, zero past count, row is readable for `stride` pixels past every start
+  void (*horizontal)(const std::uint16_t* row, std::uint16_t* out, const std::size_t out_width,
+    const std::int32_t* start, const std::int32_t* count, const std::int16_t* weights, const std::size_t stride);
+
+  // Filters one output row down: out[c] = sum of rows[k][c] * weights[k], over `channels` 16-bit channels
+  void (*vertical)(const std::uint16_t* const* rows, const std::int16_t* weights, const std::size_t taps,
+    std::uint16_t* out, const std::size_t channels);
+
+  // Widens 8-bit BGRA to 14 bits per channel, out is shifted left by 6
+  void (*expand)(const std::uint8_t* src, std::uint16_t* out, const std::size_t pixels);
+
+  // Narrows 14 bits per channel back to 8-bit BGRA, rounded
+  void (*compress)(const std::uint16_t* src, std::uint8_t* out, const std::size_t pixels);
+};
+
+
+/**
+ * @brief How scaleImage() resamples
+ */
+struct ScaleOptions {
+  ScaleFilter filter = ScaleFilter::BOX;
+  bool linear_light = false;             // Filters linear light instead of sRGB values, darkens less on fine detail, costs table lookups
+  unsigned threads = 1;                  // Bands of output rows scaled in parallel, 0 for one per core
+  const ScalerKernels* kernels = nullptr; // Null for the best set of this CPU, see supportedScalerKernels()
+};
+
+
+/**
+ * @brief Gets every kernel set this CPU can run, for benchmarks and checks
+ * @returns const std::vector<ScalerKernels>&: Scalar first, then narrowest to widest
+ */
+const std::vector<ScalerKernels>& supportedScalerKernels();
+
+
+/**
+ * @brief Resamples a BGRA image to another size
+ *
+ * Separable: every source row needed is filtered across into 14-bit fixed point, then
+ * every output row is filtered down from those. Filters widen with the scale factor
+ * when downscaling, so every source pixel contributes and fine detail doesn't alias.
+ *
+ * NOTE: Alpha is filtered like the other channels, not weighted, thumbnails are opaque.
+ * @param src: First pixel of the source, top-down
+ * @param src_stride: Bytes from one source row to the next
+ * @param src_width: Width of the source in pixels
+ * @param src_height: Height of the source in pixels
+ * @param dst: First pixel of the destination, top-down
+ * @param dst_stride: Bytes from one destination row to the next
+ * @param dst_width: Width of the destination in pixels
+ * @param dst_height: Height of the destination in pixels
+ * @param options: Filter, light space, threads
+ * @returns bool: False if a size is zero or negative
+ */
+bool scaleImage(const std::uint8_t* src, const std::ptrdiff_t src_stride, const int src_width, const int src_height,
+  std::uint8_t* dst, const std::ptrdiff_t dst_stride, const int dst_width, const int dst_height,
+  const ScaleOptions& options = {});
+
+
+/**
+ * @brief Resamples a tightly packed BGRA image into a buffer, reusing its capacity
+ * @param src: width * height * 4 source pixels
+ * @param dst: Resized to dst_width * dst_height * 4, receives the pixels
+ * @returns bool: False if a size is zero or negative
+ */
+bool scaleImage(const std::vector<std::uint8_t>& src, const int src_width, const int src_height,
+  std::vector<std::uint8_t>& dst, const int dst_width, const int dst_height, const ScaleOptions& options = {});
+
+
+/**
+ * @brief Gets the name of a filter
+ * @returns const char*: "box", "bilinear" or "lanczos3"
+ */
+const char* scaleFilterName(const ScaleFilter filter);
+
+
+#endif // IMAGE_SCALER_HPP
@@ -14,6 +14,17 @@ bool ImGuiUI::_settings_panel_visible = false;
 double ImGuiUI::_fps_display_accumulator = 0.0;
 bool ImGuiUI::_request_saved_config_reset = false;
 int ImGuiUI::_tab_marker_pos = 0;
+TitleDisplayCache ImGuiUI::_display_titles;
+TabGroupEditList ImGuiUI::_tab_group_edits;
+const ProcessCache* ImGuiUI::_process_cache = nullptr;
+const ThumbnailCache* ImGuiUI::_thumbnails = nullptr;
+const CapturePool* ImGuiUI::_capture_pool = nullptr;
+ID3D11SamplerState* ImGuiUI::_mip_sampler = nullptr;
+const ThumbnailAtlas* ImGuiUI::_atlas = nullptr;
+int ImGuiUI::_draw_calls = 0;
+std::vector<ImGuiUI::_DeferredImage> ImGuiUI::_deferred_images;
+std::array<ImVec2, 2> ImGuiUI::_deferred_marker{};
+bool ImGuiUI::_has_deferred_marker = false;
 
 
 // ----------------- Private Functions -----------------
@@ -38,71 +49,66 @@ void ImGuiUI::_ImGuiRightAlignedText(const char* fmt, ...) {
 }
 
 
-std::string ImGuiUI::_fitStringToWidth(const std::string& str, const float max_width, const bool ellipses) {
-  // Don't check empty strings
-  if (str.empty()) return "";
+std::size_t ImGuiUI::_fitStringToWidth(const std::string_view str, const float max_width, float& text_width) {
+  const char* BEGIN = str.data();
 
   // Already fits
-  if (ImGui::CalcTextSize(str.c_str()).x <= max_width) {
-    return str;
+  text_width = ImGui::CalcTextSize(BEGIN, BEGIN + str.size()).x;
+  if (text_width <= max_width) {
+    return str.size();
   }
 
-  const int LEN = static_cast<int>(str.size());
-  int left = 0;
-  int right = LEN;
-  int fit = 0; // end idx
+  const float ELLIPSES_WIDTH = ImGui::CalcTextSize("...").x;
+  const float AVAILABLE_WIDTH = max_width - ELLIPSES_WIDTH;
+  std::size_t left = 0;
+  std::size_t right = str.size();
+  std::size_t fit = 0; // end idx
+  float fit_width = 0.0f;
 
-  float available_width = max_width;
-  if (ellipses) {
-    available_width -= ImGui::CalcTextSize("...").x;
-  }
-
-  // Binary search method
-  while (left <= right) {
-    const int mid = left + (left + right) / 2;
-    const std::string sub = str.substr(0, mid);
-    const ImVec2 size = ImGui::CalcTextSize(sub.c_str());
-    //std::cout << "str: " << sub << " | len: " << size.x << "\n";
+  // Binary search method, measures prefixes in place
+  while (left < right) {
+    const std::size_t mid = left + (right - left + 1) / 2;
+    const float width = ImGui::CalcTextSize(BEGIN, BEGIN + mid).x;
 
-    if (size.x <= available_width) {
+    if (width <= AVAILABLE_WIDTH) {
       fit = mid;       // this length fits
-      left = mid + 1;  // try longer
+      fit_width = width;
+      left = mid;      // try longer
     }
     else {
       right = mid - 1; // try shorter
     }
   }
 
-  // Build string
-  std::string result = str.substr(0, fit);
-
-  // Add ellipsis if truncated
-  if (ellipses) {
-    result += "...";
+  // Don't cut a multi-byte character in half
+  while (fit > 0 && (static_cast<unsigned char>(str[fit]) & 0xC0) == 0x80) {
+    fit--;
+    fit_width = ImGui::CalcTextSize(BEGIN, BEGIN + fit).x;
   }
 
-  return result;
+  text_width = fit_width + ELLIPSES_WIDTH;
+  return fit;
 }
 
 
 // -------------------------------- UI Rendering --------------------------------
 
 
-void ImGuiUI::_renderTabCell(TabGroupMap& tabs, const std::string& group_title, const std::shared_ptr<WindowInfo>& info, const TabGroupLayout layout, const ImVec2 cell_size, const int cell_idx) {
+void ImGuiUI::_renderTabCell(const WindowSnapshot& snapshot, const TabGroupOrderList& tab_groups_order, const std::string& group_title, const WindowView& info, const TabGroupLayout layout, const ImVec2 cell_size, const int cell_idx) {
   // Total size: image + text
   ImGuiStyle& style = ImGui::GetStyle();
   const float LINE_HEIGHT = ImGui::GetTextLineHeight();
   const ImVec2 CELL_POS = ImGui::GetCursorScreenPos();
   const ImVec2 PADDING = style.FramePadding;
   const ImVec2 TOTAL_SIZE = ImVec2((cell_size.x + PADDING.x), (cell_size.y + (LINE_HEIGHT * 2.0f) + PADDING.y));
-  const std::string LABEL_ID = info->title + "_" + group_title;
 
-  // Get text substr
-  const std::string TEXT_SUBSTR = _fitStringToWidth(info->title, cell_size.x, true);
-  const ImVec2 TEXT_SIZE = ImGui::CalcTextSize(TEXT_SUBSTR.c_str());
+  // Get text substr, cached until the title or cell width changes
+  const TitleDisplayCache::Entry& DISPLAY_TITLE = _display_titles.get(info.id, info.title, info.title_hash, cell_size.x, _fitStringToWidth);
+  const char* TEXT_SUBSTR = _display_titles.text(DISPLAY_TITLE).data();
+  const ImVec2 TEXT_SIZE = ImVec2(DISPLAY_TITLE.text_width, LINE_HEIGHT);
   
   // Push ID
-  ImGui::PushID(info.get());
+  ImGui::PushID(static_cast<int>(info.id));
   
   // Create selectable area --> Acts as a button.
   bool selected = false;
@@ -135,39 +141,51 @@ void ImGuiUI::_renderTabCell(TabGroupMap& tabs, const std::string& group_title,
       // TODO: Implement.
     }
     if (ImGui::BeginMenu("Add to tab group")) {
-      // TODO: Disable menu items if the current value already exists in the group
-      if (ImGui::MenuItem("Group 1")) { std::cout << "Added to Group 1\n"; }
-      if (ImGui::MenuItem("Group 2")) { std::cout << "Added to Group 2\n"; }
-      if (ImGui::MenuItem("Group 3")) { std::cout << "Added to Group 3\n"; }
+      // Groups that already contain the window are disabled
+      bool has_groups = false;
+      for (const std::string& name : tab_groups_order) {
+        if (name == StaticTabGroups::OPEN_TABS || name == StaticTabGroups::HOTKEYS) continue;
+        has_groups = true;
+
+        const bool IS_MEMBER = info.inGroup(snapshot.tabGroups().at(name).id);
+        if (ImGui::MenuItem(name.c_str(), nullptr, false, !IS_MEMBER)) {
+          _addToTabGroup(name, info.id);
+        }
+      }
+      if (!has_groups) ImGui::MenuItem("No tab groups", nullptr, false, false);
       ImGui::EndMenu();
     }
 
-    // Remove from the current tab group
-    const bool remove_allowed = (info->title == StaticTabGroups::OPEN_TABS);
+    // Remove from the current tab group ("Open Tabs" always holds every window)
+    const auto GROUP = snapshot.tabGroups().find(group_title);
+    const bool remove_allowed = group_title != StaticTabGroups::OPEN_TABS
+      && GROUP != snapshot.tabGroups().end() && info.inGroup(GROUP->second.id);
     if (ImGui::MenuItem("Remove from tab group", nullptr, false, remove_allowed)) {
-      // TODO: Implement
+      _removeFromTabGroup(group_title, info.id);
     }
 
     // Add hotkey for item
     if (ImGui::BeginMenu("Add hotkey")) {
-      TabGroup& hotkeys = tabs.at(StaticTabGroups::HOTKEYS);
-      if (ImGui::MenuItem("Slot 1"))  { hotkeys[0] = info; }
-      if (ImGui::MenuItem("Slot 2"))  { hotkeys[1] = info; }
-      if (ImGui::MenuItem("Slot 3"))  { hotkeys[2] = info; }
-      if (ImGui::MenuItem("Slot 4"))  { hotkeys[3] = info; }
-      if (ImGui::MenuItem("Slot 5"))  { hotkeys[4] = info; }
-      if (ImGui::MenuItem("Slot 6"))  { hotkeys[5] = info; }
-      if (ImGui::MenuItem("Slot 7"))  { hotkeys[6] = info; }
-      if (ImGui::MenuItem("Slot 8"))  { hotkeys[7] = info; }
-      if (ImGui::MenuItem("Slot 9"))  { hotkeys[8] = info; }
-      if (ImGui::MenuItem("Slot 10")) { hotkeys[9] = info; }
+      if (ImGui::MenuItem("Slot 1"))  { _setHotkeySlot(0, info.id); }
+      if (ImGui::MenuItem("Slot 2"))  { _setHotkeySlot(1, info.id); }
+      if (ImGui::MenuItem("Slot 3"))  { _setHotkeySlot(2, info.id); }
+      if (ImGui::MenuItem("Slot 4"))  { _setHotkeySlot(3, info.id); }
+      if (ImGui::MenuItem("Slot 5"))  { _setHotkeySlot(4, info.id); }
+      if (ImGui::MenuItem("Slot 6"))  { _setHotkeySlot(5, info.id); }
+      if (ImGui::MenuItem("Slot 7"))  { _setHotkeySlot(6, info.id); }
+      if (ImGui::MenuItem("Slot 8"))  { _setHotkeySlot(7, info.id); }
+      if (ImGui::MenuItem("Slot 9"))  { _setHotkeySlot(8, info.id); }
+      if (ImGui::MenuItem("Slot 10")) { _setHotkeySlot(9, info.id); }
       ImGui::EndMenu();
     }
 
     // Open in file explorer
     if (ImGui::MenuItem("Open in file explorer")) {
+      // Usually known already, every window of the process shares it
       std::wstring path;
-      getWindowExecutablePath(info->hwnd, path);
+      const std::shared_ptr<const ProcessInfo> process = _process_cache ? _process_cache->find(info.pid) : nullptr;
+      if (process && !process->exe_path.empty()) path = process->exe_path;
+      else getWindowExecutablePath(info.hwnd, path);
       openWindowsExplorerAtPath(path);
     }
     ImGui::EndPopup();
@@ -191,12 +209,26 @@ void ImGuiUI::_renderTabCell(TabGroupMap& tabs, const std::string& group_title,
   
   // Draw
   ImDrawList* dl = ImGui::GetWindowDrawList();
-  dl->AddText(TEXT_POS, IM_COL32_WHITE, TEXT_SUBSTR.c_str());
-  dl->AddImage(reinterpret_cast<ImTextureID>(info->tex), IMAGE_POS_0, IMAGE_POS_1);
+  dl->AddText(TEXT_POS, IM_COL32_WHITE, TEXT_SUBSTR);
+  dl->AddRectFilled(IMAGE_POS_0, IMAGE_POS_1, IM_COL32(40, 40, 40, 255)); // Placeholder until its capture comes in, letterbox after
+  if (info.flags & WINDOW_FLAG_HAS_THUMBNAIL) {
+    // Centered at the thumbnail's aspect ratio, stretched if its size isn't known
+    ImVec2 fitted = cell_size;
+    if (info.tex_size.x > 0.0f && info.tex_size.y > 0.0f) {
+      const float SCALE = std::min(cell_size.x / info.tex_size.x, cell_size.y / info.tex_size.y);
+      fitted = ImVec2(info.tex_size.x * SCALE, info.tex_size.y * SCALE);
+    }
+    const ImVec2 FITTED_POS = ImVec2(
+      IMAGE_POS_0.x + (cell_size.x - fitted.x) * 0.5f,
+      IMAGE_POS_0.y + (cell_size.y - fitted.y) * 0.5f
+    );
+    _deferred_images.push_back(_DeferredImage{
+      info.tex, FITTED_POS, ImVec2(FITTED_POS.x + fitted.x, FITTED_POS.y + fitted.y), info.tex_uv0, info.tex_uv1
+    });
+  }
 
   if (cell_idx == _tab_marker_pos) {
     // Sizes for the outline (include both text and image)
-    const float BORDER_SIZE = 2.0f;
     ImVec2 border_min = ImVec2(
       CELL_POS.x, 
       CELL_POS.y
@@ -207,18 +239,13 @@ void ImGuiUI::_renderTabCell(TabGroupMap& tabs, const std::string& group_title,
       CELL_POS.y + TOTAL_SIZE.y
     );
 
-    dl->AddRect(
-      border_min,
-      border_max,
-      IM_COL32(255, 255, 255, 255),
-      0.0f,   // no rounding
-      0,      // no specific flags
-      BORDER_SIZE
-    );
+    // Drawn over the thumbnails, after the table
+    _deferred_marker = { border_min, border_max };
+    _has_deferred_marker = true;
   }
   
   if (activated) {
-    focusWindow(info->hwnd);
+    focusWindow(info.hwnd);
     setWindowJustFocused(true);
   }
 
@@ -227,25 +254,23 @@ void ImGuiUI::_renderTabCell(TabGroupMap& tabs, const std::string& group_title,
 }
 
 
-void ImGuiUI::_renderTabGroup(TabGroupMap& tab_groups, const std::string& title, const TabGroup tabs, const TabGroupLayout layout) {
+void ImGuiUI::_renderTabGroup(const WindowSnapshot& snapshot, const TabGroupOrderList& tab_groups_order, const std::string& title, const TabGroupLayout layout) {
   // Constants
   static constexpr ImGuiTableFlags TABLE_FLAGS = ImGuiTableFlags_NoPadOuterX | ImGuiWindowFlags_AlwaysVerticalScrollbar;
   const ImVec2 CELL_SIZE = ImVec2(Config::tab_groups_tab_width, Config::tab_groups_tab_height);
   const float PADDING = ImGui::GetStyle().ItemSpacing.x;
   const float AVAIL_X = ImGui::GetContentRegionAvail().x - ImGui::GetStyle().ScrollbarSize;
   const int COLUMNS = std::max(static_cast<int>(AVAIL_X / (CELL_SIZE.x + PADDING)), 1); // Must have AT LEAST 1 column
-  const std::string TABLE_NAME = std::string(title + " - Tab Grid");
+
+  // Thumbnails come with mips, sampled from the level closest to the cell size
+  // NOTE: Set outside the table, its cells draw into channels merged after this
+  if (_mip_sampler) ImGui::GetWindowDrawList()->AddCallback(bindMipSampler, _mip_sampler);
 
   // Draw table
-  if (ImGui::BeginTable(TABLE_NAME.c_str(), COLUMNS, TABLE_FLAGS)) {
+  // NOTE: Table IDs are scoped to the tab group's window, so the name doesn't need to be unique.
+  if (ImGui::BeginTable("Tab Grid", COLUMNS, TABLE_FLAGS)) {
     int cell_idx = 0;
-    for (const auto& tab : tabs) {
-      // Skip broken tabs
-      if (tab == nullptr) {
-        std::cout << "NULL tab detected in: '" << title << "'\n";
-        continue;
-      };
-
+    const auto renderCell = [&](const WindowView& tab) {
       // Render cell
       ImGui::TableNextColumn();
 
@@ -255,51 +280,82 @@ void ImGuiUI::_renderTabGroup(TabGroupMap& tab_groups, const std::string& title,
         ImGui::SetCursorPosX(ImGui::GetCursorPosX() + ImGui::GetStyle().WindowPadding.x);
       }
 
-      _renderTabCell(tab_groups, title, tab, layout, CELL_SIZE, cell_idx);
+      _renderTabCell(snapshot, tab_groups_order, title, tab, layout, CELL_SIZE, cell_idx);
       cell_idx++;
+    };
+
+    // Rows are already in last focused order
+    const std::uint32_t ROWS = static_cast<std::uint32_t>(snapshot.size());
+    if (title == StaticTabGroups::OPEN_TABS) {
+      // Every tracked window
+      for (std::uint32_t row = 0; row < ROWS; row++) {
+        renderCell(snapshot.view(row));
+      }
+    }
+    else {
+      // Only members of the group
+      const TabGroupId GROUP_ID = snapshot.tabGroups().at(title).id;
+      if (snapshot.groupSize(GROUP_ID) > 0) {
+        for (std::uint32_t row = 0; row < ROWS; row++) {
+          if (snapshot.inGroup(row, GROUP_ID)) renderCell(snapshot.view(row));
+        }
+      }
     }
     ImGui::EndTable();
   }
+  _drawDeferredImages(ImGui::GetWindowDrawList());
+  if (_mip_sampler) ImGui::GetWindowDrawList()->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+}
+
+
+void ImGuiUI::_drawDeferredImages(ImDrawList* dl) {
+  // Same texture back to back, ImGui merges them into one draw call
+  std::stable_sort(_deferred_images.begin(), _deferred_images.end(), [](const _DeferredImage& a, const _DeferredImage& b) {
+    return a.tex < b.tex;
+  });
+  for (const _DeferredImage& image : _deferred_images) {
+    dl->AddImage(image.tex, image.p0, image.p1, image.uv0, image.uv1);
+  }
+  _deferred_images.clear();
+
+  if (_has_deferred_marker) {
+    constexpr float BORDER_SIZE = 2.0f;
+    dl->AddRect(
+      _deferred_marker[0],
+      _deferred_marker[1],
+      IM_COL32(255, 255, 255, 255),
+      0.0f,   // no rounding
+      0,      // no specific flags
+      BORDER_SIZE
+    );
+    _has_deferred_marker = false;
+  }
 }
 
 
-void ImGuiUI::_renderTabGroupsUI(TabGroupMap& tab_groups, TabGroupOrderList& tab_groups_order, const TabGroupLayoutList& tab_groups_layouts) {
+void ImGuiUI::_renderTabGroupsUI(const WindowSnapshot& snapshot, TabGroupOrderList& tab_groups_order, const TabGroupLayoutList& tab_groups_layouts) {
   static constexpr ImGuiWindowFlags WINDOW_FLAGS = ImGuiCond_None;
 
   // Static maps to store last position and size per window
   static std::unordered_map<std::string, ImVec2> last_pos;
   static std::unordered_map<std::string, ImVec2> last_size;
 
-  TabGroupOrderList new_order = tab_groups_order;
+  int clicked_idx = -1; // Tab group to move to the top once every group is drawn
   
   // NOTE: Render starting at index 1 since HOTKEYS will always be index 1.
   const int TOTAL_TAB_GROUPS = tab_groups_order.size();
   for (int i = 1; i < TOTAL_TAB_GROUPS; i++) {
     const std::string& title = tab_groups_order[i];
-    auto& tabs = tab_groups[title];
-
-    // Sort by last focused time
-    std::sort(tabs.begin(), tabs.end(),
-      [](const std::shared_ptr<WindowInfo>& a, const std::shared_ptr<WindowInfo>& b) {
-        if (a == nullptr) return false;
-        if (b == nullptr) return true;
-        return a->last_focused > b->last_focused;
-      }
-    );
 
     // Create window
     const TabGroupLayout LAYOUT = tab_groups_layouts.at(title);
     if (ImGui::Begin(title.c_str(), nullptr, WINDOW_FLAGS)) {
       // Render the tab group
-      _renderTabGroup(tab_groups, title, tabs, LAYOUT);
+      _renderTabGroup(snapshot, tab_groups_order, title, LAYOUT);
 
       // Window was clicked, set to index 1 in the order list
       if (ImGui::IsWindowHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
-        const auto it = std::find(new_order.begin(), new_order.end(), title);
-        if (it != new_order.end() && it != new_order.begin() + 1) {
-          new_order.erase(it);
-          new_order.insert(new_order.begin() + 1, title);
-        }
+        clicked_idx = i;
       }
 
       // --- Check if it needs a redraw ---
@@ -319,11 +375,14 @@ void ImGuiUI::_renderTabGroupsUI(TabGroupMap& tab_groups, TabGroupOrderList& tab
     ImGui::End();
   }
 
-  tab_groups_order = std::move(new_order);;
+  // Move the clicked group to index 1 in place, keeping the order of the others
+  if (clicked_idx > 1) {
+    std::rotate(tab_groups_order.begin() + 1, tab_groups_order.begin() + clicked_idx, tab_groups_order.begin() + clicked_idx + 1);
+  }
 }
 
 
-void ImGuiUI::_renderHotkeyUI(const TabGroup& hotkeys, const TabGroupLayout hotkey_layout) {
+void ImGuiUI::_renderHotkeyUI(const WindowSnapshot& snapshot, const TabGroup& hotkeys, const TabGroupLayout hotkey_layout) {
   static constexpr ImGuiWindowFlags HOTKEY_PANEL_FLAGS = ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove;
 
   if (Config::hotkey_panel_horizontal_layout) { // horizontal Layout
@@ -340,8 +399,10 @@ void ImGuiUI::_renderHotkeyUI(const TabGroup& hotkeys, const TabGroupLayout hotk
       // --- Main Content Area ---
       if (ImGui::BeginChild("Main Content Area")) {
         for (int i = 0; i < 10; i++) {
-          if (hotkeys[i] == nullptr) continue;
-          ImGui::Text("[%d] %s", i + 1, hotkeys[i]->title.c_str());
+          // Empty slot, or the window is gone
+          const std::optional<WindowView> info = snapshot.get(hotkeys.slots[i]);
+          if (!info) continue;
+          ImGui::Text("[%d] %s", i + 1, info->title.data());
         }
       }
       ImGui::EndChild();
@@ -374,8 +435,10 @@ void ImGuiUI::_renderHotkeyUI(const TabGroup& hotkeys, const TabGroupLayout hotk
       // --- Main Content Area ---
       if (ImGui::BeginChild("Main Content Area")) {
         for (int i = 0; i < 10; i++) {
-          if (hotkeys[i] == nullptr) continue;
-          ImGui::Text("[%d] %s", i + 1, hotkeys[i]->title.c_str());
+          // Empty slot, or the window is gone
+          const std::optional<WindowView> info = snapshot.get(hotkeys.slots[i]);
+          if (!info) continue;
+          ImGui::Text("[%d] %s", i + 1, info->title.data());
         }
       }
       ImGui::EndChild();
@@ -572,6 +635,52 @@ void ImGuiUI::_renderSettingsUI(const double fps, const double delta) {
 
       if (ImGui::CollapsingHeader("Graphics Options")) {
         (ImGui::Checkbox("VSync (Recommended)", &Config::vsync));
+        ImGui::SameLine();
+        ImGui::Checkbox("Thumbnail Atlas", &Config::thumbnail_atlas);
+        if (_atlas) {
+          ImGui::Text("%d draw calls, %zu thumbnails in %zu atlas pages (%.0f MB, %.0f%% taken), %llu moved by repacks",
+            _draw_calls, _atlas->size(), _atlas->pages(), _atlas->pageBytes() / (1024.0 * 1024.0), 100.0 * _atlas->occupancy(),
+            static_cast<unsigned long long>(_atlas->moves()));
+        }
+
+        // Thumbnail memory
+        {
+          static const float INPUT_WIDTH = ImGui::GetFontSize() * 0.80f * 6.0f; // Boxes are the size of 6 characters
+          static int budget_tmp = Config::thumbnail_budget_mb;
+
+          _syncTemp(budget_tmp, Config::thumbnail_budget_mb);
+
+          ImGui::PushItemWidth(INPUT_WIDTH);
+          if (ImGui::InputInt("Thumbnail Memory (MB)", &budget_tmp, 0, 0)) {
+            budget_tmp = std::clamp(budget_tmp, Config::THUMBNAIL_BUDGET_MIN_MB, Config::THUMBNAIL_BUDGET_MAX_MB);
+          }
+          if (!ImGui::IsItemActive() && (budget_tmp != Config::thumbnail_budget_mb)) {
+            Config::thumbnail_budget_mb = budget_tmp;
+          }
+          ImGui::PopItemWidth();
+
+          if (_thumbnails) {
+            ImGui::Text("%.0f MB in %zu thumbnails, %llu hits, %llu misses, %llu evicted",
+              _thumbnails->used() / (1024.0 * 1024.0), _thumbnails->size(),
+              static_cast<unsigned long long>(_thumbnails->hits()),
+              static_cast<unsigned long long>(_thumbnails->misses()),
+              static_cast<unsigned long long>(_thumbnails->evictions()));
+
+            const std::uint64_t REFRESHES = _thumbnails->uploads() + _thumbnails->patches() + _thumbnails->skippedUploads();
+            if (REFRESHES != 0) {
+              ImGui::Text("%.0f%% of %llu captures unchanged, %.0f%% updated by tiles, %.1f MB of uploads skipped",
+                100.0 * _thumbnails->skippedUploads() / REFRESHES, static_cast<unsigned long long>(REFRESHES),
+                100.0 * _thumbnails->patches() / REFRESHES, _thumbnails->skippedBytes() / (1024.0 * 1024.0));
+            }
+          }
+          if (_capture_pool && _capture_pool->captured() != 0) {
+            const double CAPTURES = static_cast<double>(_capture_pool->captured());
+            const double FULL_KB = _capture_pool->sourceBytes() / CAPTURES / 1024.0;
+            const double FITTED_KB = _capture_pool->thumbnailBytes() / CAPTURES / 1024.0;
+            ImGui::Text("%.0f KB per thumbnail with mips, %.0f KB saved per window over a full size capture",
+              FITTED_KB, FULL_KB - FITTED_KB);
+          }
+        }
       }
     }
     ImGui::EndChild();
@@ -723,8 +832,8 @@ void ImGuiUI::setupImGuiStyles() {
 
 // -------------------------------- Draw UI --------------------------------
 
-void ImGuiUI::drawUI(const double fps, const double delta,
-    TabGroupMap& tab_groups, TabGroupOrderList& tab_groups_order, const TabGroupLayoutList& tab_groups_layouts) {
+void ImGuiUI::drawUI(const double fps, const double delta, const WindowSnapshot& snapshot,
+    TabGroupOrderList& tab_groups_order, const TabGroupLayoutList& tab_groups_layouts) {
   // Apply settings resets
   if (_request_saved_config_reset) {
     Config::resetToSaved();
@@ -736,7 +845,12 @@ void ImGuiUI::drawUI(const double fps, const double delta,
   bool userInteracted = io.WantCaptureMouse || io.WantCaptureKeyboard;
   if (userInteracted) {setNeedsIoRedraw(true); }
 
-  if (_tab_groups_visible)      { _renderTabGroupsUI(tab_groups, tab_groups_order, tab_groups_layouts); }
-  if (_hotkey_panel_visible)    { _renderHotkeyUI(tab_groups.at(StaticTabGroups::HOTKEYS), tab_groups_layouts.at(StaticTabGroups::HOTKEYS)); }
+  // Drop cached titles of closed windows once they pile up
+  if (_display_titles.size() > snapshot.size() * 2 + 64) {
+    _display_titles.prune([&snapshot](const WindowId id) { return snapshot.row(id) != WindowRegistry::NO_ROW; });
+  }
+
+  if (_tab_groups_visible)      { _renderTabGroupsUI(snapshot, tab_groups_order, tab_groups_layouts); }
+  if (_hotkey_panel_visible)    { _renderHotkeyUI(snapshot, snapshot.tabGroups().at(StaticTabGroups::HOTKEYS), tab_groups_layouts.at(StaticTabGroups::HOTKEYS)); }
   if (_settings_panel_visible)  { _renderSettingsUI(fps, delta); }
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include <array>
 #include <memory>
 #include <algorithm>
+#include <utility>
 #include <windows.h>
 
 #include "imgui.h"
@@ -19,39 +20,14 @@
 #include "config.hpp"
 #include "timers.hpp"
 #include "win_utils.hpp"
-
-
-/**
- * @brief Layout used to define the style of rendering a tab group should render with.
- */
-enum TabGroupLayout {
-  GRID,
-  VERTICAL_LIST
-};
-
-
-/**
- * @brief Predefined tab groups that will ALWAYS exist
- */
-struct StaticTabGroups {
-  static inline const std::string OPEN_TABS = "Open Tabs"; // Special instance of a tab group
-  static inline const std::string HOTKEYS = "Hotkeys"; // Special instance of a tab group
-};
-
-
-// Types
-using TabGroup = std::vector<std::shared_ptr<WindowInfo>>;
-using TabGroupMap =
-  std::unordered_map<
-    std::string,
-    TabGroup
-  >;
-using TabGroupOrderList = std::vector<std::string>;
-using TabGroupLayoutList =
-  std::unordered_map<
-    std::string,
-    TabGroupLayout
-  >;
+#include "window_registry.hpp"
+#include "window_snapshot.hpp"
+#include "tab_groups.hpp"
+#include "title_arena.hpp"
+#include "process_cache.hpp"
+#include "thumbnail_cache.hpp"
+#include "thumbnail_atlas.hpp"
+#include "capture_pool.hpp"
 
 
 /**
@@ -83,6 +59,30 @@ class ImGuiUI {
     static bool _request_saved_config_reset;
     static std::string _last_clicked_tab_group;
     static int _tab_marker_pos; // Marks the selected tab via cycling by pressing tab
+    static TitleDisplayCache _display_titles; // Shortened cell titles, rebuilt only when a title or the cell width changes
+    static TabGroupEditList _tab_group_edits; // Edits made this frame, applied by the owner of the tab groups
+    static const ProcessCache* _process_cache; // Exe paths for "Open in file explorer", optional
+    static const ThumbnailCache* _thumbnails; // Memory use shown in the settings, optional
+    static const CapturePool* _capture_pool; // Memory saved by fitting captures, shown in the settings, optional
+    static ID3D11SamplerState* _mip_sampler; // Thumbnails are drawn with it when set
+    static const ThumbnailAtlas* _atlas; // Pages shown in the settings, optional
+    static int _draw_calls; // Draw commands of the last frame rendered
+
+
+    /**
+     * @brief Thumbnail of a cell, drawn after its table
+     */
+    struct _DeferredImage {
+      ImTextureID tex;
+      ImVec2 p0;
+      ImVec2 p1;
+      ImVec2 uv0;
+      ImVec2 uv1;
+    };
+
+    static std::vector<_DeferredImage> _deferred_images; // Cells of the table being drawn, reused every table
+    static std::array<ImVec2, 2> _deferred_marker;      // Outline of the marked cell, drawn over the thumbnails
+    static bool _has_deferred_marker;
 
 
     // Render Helpers
@@ -96,52 +96,101 @@ class ImGuiUI {
 
 
     /**
-     * @brief Fits a string to a given width
+     * @brief Fits a string to a given width, leaving room for "..." if it has to be truncated
+     *
+     * NOTE: Matches TitleDisplayCache::TitleFitter, doesn't allocate.
      * @param str: String to fit
      * @param max_width: Maximum width allowed for the string
-     * @param ellipses: Should ellipses be appended to the string if it is truncated?
-     * @returns std::string: New string made to fit the given size
+     * @param text_width: Filled in with the width of the fitted string (including "...")
+     * @returns std::size_t: Amount of bytes of str that fit
+     */
+    static std::size_t _fitStringToWidth(const std::string_view str, const float max_width, float& text_width);
+
+
+    /**
+     * @brief Queues putting a window in a hotkey slot
+     * @param slot: Hotkey slot, 0-9
+     * @param id: Handle of the window
+     */
+    static void _setHotkeySlot(const std::size_t slot, const WindowId id) {
+      _tab_group_edits.push_back(TabGroupEdit{ TabGroupEdit::SET_SLOT, StaticTabGroups::HOTKEYS, slot, id });
+    }
+
+
+    /**
+     * @brief Queues adding a window to a tab group
+     * @param group: Title of the tab group
+     * @param id: Handle of the window
+     */
+    static void _addToTabGroup(const std::string& group, const WindowId id) {
+      _tab_group_edits.push_back(TabGroupEdit{ TabGroupEdit::ADD_WINDOW, group, 0, id });
+    }
+
+
+    /**
+     * @brief Queues removing a window from a tab group
+     * @param group: Title of the tab group
+     * @param id: Handle of the window
      */
-    static std::string _fitStringToWidth(const std::string& str, const float max_width, const bool ellipses = false);
+    static void _removeFromTabGroup(const std::string& group, const WindowId id) {
+      _tab_group_edits.push_back(TabGroupEdit{ TabGroupEdit::REMOVE_WINDOW, group, 0, id });
+    }
 
 
     /**
      * @brief Renders a tab's cell in a tab group
-     * @param tabs: List of tab groups. NOTE: Only used for context-menu actions.
+     *
+     * NOTE: Context-menu actions are queued as TabGroupEdits, never applied directly.
+     * @param snapshot: Snapshot pinned for this frame. NOTE: Only used for context-menu actions.
+     * @param tab_groups_order: List of the ordering of tab groups. NOTE: Only used for context-menu actions.
      * @param group_title: Title of the tab group its rendering in
      * @param info: Window info to draw
      * @param layout: Layout to render with
      * @param cell_size: Size of the cell to render
      * @param cell_idx: Index of the cell being rendered
      */
-    static void _renderTabCell(TabGroupMap& tabs, const std::string& group_title, const std::shared_ptr<WindowInfo>& info, const TabGroupLayout layout, const ImVec2 cell_size, const int cell_idx);
+    static void _renderTabCell(const WindowSnapshot& snapshot, const TabGroupOrderList& tab_groups_order, const std::string& group_title, const WindowView& info, const TabGroupLayout layout, const ImVec2 cell_size, const int cell_idx);
 
 
     /**
      * @brief Renders a tab group with the proper layout
-     * @param tab_groups: Map of tab groups.
+     *
+     * NOTE: Rows are already in MRU order, "Open Tabs" draws all of them and other groups
+     *       only the rows whose membership bit is set.
+     * @param snapshot: Snapshot pinned for this frame
+     * @param tab_groups_order: List of the ordering of tab groups
      * @param title: Title to give the tab group
-     * @param tabs: Tabs to render
      * @param layout: Layout to render with
      */
-    static void _renderTabGroup(TabGroupMap& tab_groups, const std::string& title, const TabGroup tabs, const TabGroupLayout layout);
+    static void _renderTabGroup(const WindowSnapshot& snapshot, const TabGroupOrderList& tab_groups_order, const std::string& title, const TabGroupLayout layout);
+
+
+    /**
+     * @brief Draws the thumbnails the cells of a table queued, sorted by texture, then the marked cell's outline
+     *
+     * NOTE: Cells draw text between their thumbnails, so each one would be a draw call of its
+     *       own. Sorted after the table, the thumbnails of an atlas page merge into one.
+     * @param dl: Draw list of the table's window
+     */
+    static void _drawDeferredImages(ImDrawList* dl);
 
 
     /**
      * @brief Render each tab group on the screen
-     * @param tab_groups: Map of tab groups to render
+     * @param snapshot: Snapshot pinned for this frame
      * @param tab_groups_order: List of the ordering of tab groups
      * @param tab_groups_layouts: Map of the layout for each tab group
      */
-    static void _renderTabGroupsUI(TabGroupMap& tab_groups, TabGroupOrderList& tab_groups_order, const TabGroupLayoutList& tab_group_layouts);
+    static void _renderTabGroupsUI(const WindowSnapshot& snapshot, TabGroupOrderList& tab_groups_order, const TabGroupLayoutList& tab_group_layouts);
 
 
     /**
      * @brief Render the hotkey UI onto the screen
+     * @param snapshot: Snapshot pinned for this frame
      * @param hotkeys: Hotkey windows to render
      * @param hotkey_layout: Layout to render with
      */
-    static void _renderHotkeyUI(const TabGroup& hotkeys, const TabGroupLayout hotkey_layout);
+    static void _renderHotkeyUI(const WindowSnapshot& snapshot, const TabGroup& hotkeys, const TabGroupLayout hotkey_layout);
 
 
     /**
@@ -175,15 +224,26 @@ class ImGuiUI {
 
     /**
      * @brief Draws all UI elements that should be drawn (must be visible)
-     * @param tab_groups: Tab groups to render
+     *
+     * NOTE: Only reads the snapshot, changes to the tab groups are queued (see takeTabGroupEdits).
+     * @param snapshot: Windows and tab groups to render, pinned for the whole frame
      * @param tab_groups_order: List of the order to render tab groups
      * @param tab_groups_layouts: Layout to render the tab groups with
      */
-    static void drawUI(const double fps, const double delta,
-      TabGroupMap& tab_groups, TabGroupOrderList& tab_groups_order, const TabGroupLayoutList& tab_groups_layouts
+    static void drawUI(const double fps, const double delta, const WindowSnapshot& snapshot,
+      TabGroupOrderList& tab_groups_order, const TabGroupLayoutList& tab_groups_layouts
     );
 
 
+    /**
+     * @brief Takes the tab group edits queued since the last call
+     * @returns TabGroupEditList: Edits, in the order they were made
+     */
+    static TabGroupEditList takeTabGroupEdits() {
+      return std::exchange(_tab_group_edits, TabGroupEditList());
+    }
+
+
     // Inline funcs
 
     static void setWindowJustFocused(const bool v) { _window_just_focused = v; }
@@ -203,6 +263,22 @@ class ImGuiUI {
     static const bool isHotkeyPanelVisible() { return _hotkey_panel_visible; }
     static void setSettingsPanelVisibility(const bool v) { _settings_panel_visible = v; }
     static const bool isSettingsPanelVisible() { return _settings_panel_visible; }
+
+    static void setProcessCache(const ProcessCache* processes) { _process_cache = processes; }
+    static void setThumbnailCache(const ThumbnailCache* thumbnails) { _thumbnails = thumbnails; }
+    static void setCapturePool(const CapturePool* capture_pool) { _capture_pool = capture_pool; }
+    static void setMipSampler(ID3D11SamplerState* sampler) { _mip_sampler = sampler; }
+    static void setThumbnailAtlas(const ThumbnailAtlas* atlas) { _atlas = atlas; }
+
+
+    /**
+     * @brief Records the draw commands of a frame, shown in the settings
+     * @param data: Draw data of the frame, after ImGui::Render()
+     */
+    static void recordDrawData(const ImDrawData* data) {
+      _draw_calls = 0;
+      for (const ImDrawList* list : data->CmdLists) _draw_calls += list->CmdBuffer.Size;
+    }
 };
 
 
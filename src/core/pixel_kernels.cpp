@@ -0,0 +1,245 @@
+#include "pixel_kernels.hpp"
+#include "cpu_features.hpp"
+
+#include <cstring>
+
+
+namespace {
+  constexpr std::uint32_t ALPHA_MASK = 0xFF000000u;
+
+
+  // ----------------- Scalar -----------------
+
+  /**
+   * @brief Loads a pixel, sources may be unaligned
+   */
+  inline std::uint32_t loadPixel(const std::uint8_t* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+  }
+
+
+  inline void storePixel(std::uint8_t* p, const std::uint32_t v) {
+    std::memcpy(p, &v, 4);
+  }
+
+
+  /**
+   * @brief c * a / 255, rounded to nearest, exact for every 8-bit c and a
+   */
+  inline std::uint32_t mulDiv255(const std::uint32_t c, const std::uint32_t a) {
+    const std::uint32_t m = c * a + 128;
+    return (m + (m >> 8)) >> 8;
+  }
+
+
+  inline std::uint32_t premultiplyPixel(const std::uint32_t p) {
+    const std::uint32_t a = p >> 24;
+    return (a << 24)
+      | (mulDiv255((p >> 16) & 0xFF, a) << 16)
+      | (mulDiv255((p >> 8) & 0xFF, a) << 8)
+      | mulDiv255(p & 0xFF, a);
+  }
+
+
+  inline std::uint32_t swizzlePixel(const std::uint32_t p) {
+    return (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+  }
+
+
+  void fillAlphaScalar(std::uint8_t* bgra, const std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) storePixel(bgra + i * 4, loadPixel(bgra + i * 4) | ALPHA_MASK);
+  }
+
+
+  void copyOpaqueScalar(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) storePixel(dst + i * 4, loadPixel(src + i * 4) | ALPHA_MASK);
+  }
+
+
+  void swizzleScalar(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) storePixel(dst + i * 4, swizzlePixel(loadPixel(src + i * 4)));
+  }
+
+
+  void premultiplyScalar(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) storePixel(dst + i * 4, premultiplyPixel(loadPixel(src + i * 4)));
+  }
+
+
+#ifdef CPU_FEATURES_X86
+  // ----------------- SSE2, 4 pixels per vector -----------------
+
+  void copyOpaqueSse2(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(ALPHA_MASK));
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(v, alpha));
+    }
+    copyOpaqueScalar(src + i * 4, dst + i * 4, count - i);
+  }
+
+
+  void fillAlphaSse2(std::uint8_t* bgra, const std::size_t count) {
+    copyOpaqueSse2(bgra, bgra, count);
+  }
+
+
+  void swizzleSse2(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+    // No byte shuffle before SSSE3, shift the two bytes into each other's place instead
+    const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+    const __m128i low = _mm_set1_epi32(0xFF);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+      const __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+      const __m128i b = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_or_si128(_mm_and_si128(v, keep), _mm_or_si128(r, b)));
+    }
+    swizzleScalar(src + i * 4, dst + i * 4, count - i);
+  }
+
+
+  /**
+   * @brief Premultiplies 2 pixels widened to 16 bits per channel
+   * @param alpha_lanes: 0xFFFF in the alpha lanes, those are multiplied by 255 and stay as they are
+   */
+  inline __m128i premultiply2Sse2(const __m128i px, const __m128i alpha_lanes, const __m128i full) {
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_or_si128(_mm_andnot_si128(alpha_lanes, a), _mm_and_si128(alpha_lanes, full));
+
+    // c * a / 255 the same way as mulDiv255, fits in 16 bits
+    const __m128i m = _mm_add_epi16(_mm_mullo_epi16(px, a), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(m, _mm_srli_epi16(m, 8)), 8);
+  }
+
+
+  void premultiplySse2(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i full = _mm_set1_epi16(255);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+      const __m128i lo = premultiply2Sse2(_mm_unpacklo_epi8(v, zero), alpha_lanes, full);
+      const __m128i hi = premultiply2Sse2(_mm_unpackhi_epi8(v, zero), alpha_lanes, full);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+    }
+    premultiplyScalar(src + i * 4, dst + i * 4, count - i);
+  }
+
+
+  // ----------------- AVX2, 8 pixels per vector -----------------
+  // Tails go through the scalar loops, calling the SSE2 ones with dirty upper halves would stall
+
+  CPU_FEATURES_AVX2_TARGET
+  void copyOpaqueAvx2(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(ALPHA_MASK));
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_or_si256(v, alpha));
+    }
+    _mm256_zeroupper();
+    copyOpaqueScalar(src + i * 4, dst + i * 4, count - i);
+  }
+
+
+  CPU_FEATURES_AVX2_TARGET
+  void fillAlphaAvx2(std::uint8_t* bgra, const std::size_t count) {
+    copyOpaqueAvx2(bgra, bgra, count);
+  }
+
+
+  CPU_FEATURES_AVX2_TARGET
+  void swizzleAvx2(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+    const __m256i order = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+    );
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_shuffle_epi8(v, order));
+    }
+    _mm256_zeroupper();
+    swizzleScalar(src + i * 4, dst + i * 4, count - i);
+  }
+
+
+  CPU_FEATURES_AVX2_TARGET
+  void premultiplyAvx2(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+    // Alpha of every pixel spread over its 4 lanes, 0x80 zeroes the high byte of each 16-bit lane
+    const __m256i spread = _mm256_setr_epi8(
+      3, -128, 3, -128, 3, -128, 3, -128, 7, -128, 7, -128, 7, -128, 7, -128,
+      3, -128, 3, -128, 3, -128, 3, -128, 7, -128, 7, -128, 7, -128, 7, -128
+    );
+    const __m256i alpha_lanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+    const __m256i full = _mm256_set1_epi16(255);
+    const __m256i round = _mm256_set1_epi16(128);
+    const __m256i zero = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+
+      // Pixels 0, 1 | 4, 5 and 2, 3 | 6, 7, unpacking works per 128-bit lane and packing undoes it
+      const __m256i lo = _mm256_unpacklo_epi8(v, zero);
+      const __m256i hi = _mm256_unpackhi_epi8(v, zero);
+      __m256i a_lo = _mm256_shuffle_epi8(_mm256_unpacklo_epi64(v, v), spread);
+      __m256i a_hi = _mm256_shuffle_epi8(_mm256_unpackhi_epi64(v, v), spread);
+      a_lo = _mm256_blendv_epi8(a_lo, full, alpha_lanes);
+      a_hi = _mm256_blendv_epi8(a_hi, full, alpha_lanes);
+
+      const __m256i m_lo = _mm256_add_epi16(_mm256_mullo_epi16(lo, a_lo), round);
+      const __m256i m_hi = _mm256_add_epi16(_mm256_mullo_epi16(hi, a_hi), round);
+      const __m256i r_lo = _mm256_srli_epi16(_mm256_add_epi16(m_lo, _mm256_srli_epi16(m_lo, 8)), 8);
+      const __m256i r_hi = _mm256_srli_epi16(_mm256_add_epi16(m_hi, _mm256_srli_epi16(m_hi, 8)), 8);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_packus_epi16(r_lo, r_hi));
+    }
+    _mm256_zeroupper();
+    premultiplyScalar(src + i * 4, dst + i * 4, count - i);
+  }
+#endif // CPU_FEATURES_X86
+
+
+  /**
+   * @brief Every set this CPU can run, scalar first
+   */
+  std::vector<PixelKernels> buildSupported() {
+    std::vector<PixelKernels> sets;
+    sets.push_back(PixelKernels{ "scalar", fillAlphaScalar, copyOpaqueScalar, swizzleScalar, premultiplyScalar });
+#ifdef CPU_FEATURES_X86
+    sets.push_back(PixelKernels{ "sse2", fillAlphaSse2, copyOpaqueSse2, swizzleSse2, premultiplySse2 });
+    if (cpuHasAvx2()) {
+      sets.push_back(PixelKernels{ "avx2", fillAlphaAvx2, copyOpaqueAvx2, swizzleAvx2, premultiplyAvx2 });
+    }
+#endif
+    return sets;
+  }
+}
+
+
+const std::vector<PixelKernels>& supportedPixelKernels() {
+  static const std::vector<PixelKernels> SUPPORTED = buildSupported();
+  return SUPPORTED;
+}
+
+
+const PixelKernels& pixelKernels() {
+  static const PixelKernels& BEST = supportedPixelKernels().back();
+  return BEST;
+}
+
+
+void copyRows(const std::uint8_t* src, const std::ptrdiff_t src_stride, std::uint8_t* dst, const std::ptrdiff_t dst_stride,
+  const std::size_t width, const std::size_t height, const bool opaque) {
+  const PixelKernels& kernels = pixelKernels();
+  for (std::size_t y = 0; y < height; y++) {
+    if (opaque) kernels.copy_opaque(src, dst, width);
+    else        std::memcpy(dst, src, width * 4);
+    src += src_stride;
+    dst += dst_stride;
+  }
+}
@@ -0,0 +1,97 @@
+#ifndef PIXEL_KERNELS_HPP
+#define PIXEL_KERNELS_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * @brief One implementation of every pixel kernel, for one vector width
+ *
+ * Pixels are 4 bytes, counts are in pixels. Sources and destinations may be
+ * unaligned and may be the same buffer, but must not overlap otherwise.
+ */
+struct PixelKernels {
+  const char* name; // "avx2", "sse2" or "scalar"
+
+  // Sets every alpha byte to 255, GDI leaves them 0
+  void (*fill_alpha)(std::uint8_t* bgra, const std::size_t count);
+
+  // Copies pixels and sets every alpha byte to 255 on the way
+  void (*copy_opaque)(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count);
+
+  // Swaps the first and third byte of every pixel, BGRA <-> RGBA
+  void (*swizzle)(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count);
+
+  // Multiplies the color bytes of every pixel by its alpha, rounded: c * a / 255
+  void (*premultiply)(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count);
+};
+
+
+/**
+ * @brief Gets the kernels picked for this CPU
+ *
+ * Uses AVX2 if the CPU has it, SSE2 otherwise, scalar loops off x64.
+ * @returns const PixelKernels&: Kernels, the same for the whole run
+ */
+const PixelKernels& pixelKernels();
+
+
+/**
+ * @brief Gets every kernel set this CPU can run, for benchmarks and checks
+ *
+ * NOTE: Every set gives the same output as the scalar one.
+ * @returns const std::vector<PixelKernels>&: Scalar first, then narrowest to widest
+ */
+const std::vector<PixelKernels>& supportedPixelKernels();
+
+
+/**
+ * @brief Sets every alpha byte to 255
+ * @param bgra: Pixels to change in place
+ * @param count: Amount of pixels
+ */
+inline void fillAlpha(std::uint8_t* bgra, const std::size_t count) {
+  pixelKernels().fill_alpha(bgra, count);
+}
+
+
+/**
+ * @brief Swaps BGRA to RGBA or back
+ * @param src: Source pixels
+ * @param dst: Destination pixels, may be src
+ * @param count: Amount of pixels
+ */
+inline void swizzleRedBlue(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+  pixelKernels().swizzle(src, dst, count);
+}
+
+
+/**
+ * @brief Multiplies color by alpha, for straight-alpha sources drawn with premultiplied blending
+ * @param src: Source pixels
+ * @param dst: Destination pixels, may be src
+ * @param count: Amount of pixels
+ */
+inline void premultiplyAlpha(const std::uint8_t* src, std::uint8_t* dst, const std::size_t count) {
+  pixelKernels().premultiply(src, dst, count);
+}
+
+
+/**
+ * @brief Copies a rectangle of pixels between buffers of different strides
+ * @param src: First pixel of the source
+ * @param src_stride: Bytes from one source row to the next, negative for bottom-up buffers
+ * @param dst: First pixel of the destination
+ * @param dst_stride: Bytes from one destination row to the next
+ * @param width: Pixels per row
+ * @param height: Amount of rows
+ * @param opaque: Sets every alpha byte to 255 on the way
+ */
+void copyRows(const std::uint8_t* src, const std::ptrdiff_t src_stride, std::uint8_t* dst, const std::ptrdiff_t dst_stride,
+  const std::size_t width, const std::size_t height, const bool opaque);
+
+
+#endif // PIXEL_KERNELS_HPP
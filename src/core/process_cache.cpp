@@ -0,0 +1,146 @@
+#include "process_cache.hpp"
+
+#include <algorithm>
+
+
+ProcessCache::~ProcessCache() {
+  stop();
+}
+
+
+void ProcessCache::start() {
+  if (_worker.joinable()) return;
+
+  _stopping = false;
+  _worker = std::thread(&ProcessCache::_run, this);
+}
+
+
+void ProcessCache::stop() {
+  if (!_worker.joinable()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _wake.notify_one();
+  _worker.join();
+}
+
+
+ProcessCache::_Clock::time_point ProcessCache::_promoteRetries(const _Clock::time_point now) {
+  _Clock::time_point next = _Clock::time_point::max();
+  for (std::size_t i = 0; i < _retries.size();) {
+    if (_retries[i].due <= now) {
+      _requests.push_back(_retries[i].request);
+      _retries[i] = _retries.back();
+      _retries.pop_back();
+      continue;
+    }
+    next = std::min(next, _retries[i].due);
+    i++;
+  }
+  return next;
+}
+
+
+void ProcessCache::_run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    // Sleep until a request comes in or a quarantine ends
+    const _Clock::time_point next_retry = _promoteRetries(_Clock::now());
+    if (_requests.empty() && !_stopping) {
+      if (next_retry == _Clock::time_point::max()) _wake.wait(lock);
+      else                                         _wake.wait_until(lock, next_retry);
+      continue;
+    }
+    if (_stopping) return;
+
+    const _Request request = _requests.front();
+    _requests.pop_front();
+
+    // Dropped while it waited
+    const auto queued = _entries.find(request.pid);
+    if (queued == _entries.end() || queued->second.generation != request.generation) continue;
+    const HWND hwnd = queued->second.hwnd;
+
+    // The backend may block on the window, never hold the lock meanwhile
+    lock.unlock();
+    auto info = std::make_shared<ProcessInfo>();
+    info->pid = request.pid;
+    _backend.processInfo(hwnd, *info, _timeout_ms);
+    _loads.fetch_add(1, std::memory_order_relaxed);
+    lock.lock();
+
+    const auto it = _entries.find(request.pid);
+    if (it == _entries.end() || it->second.generation != request.generation) continue;
+    _Entry& entry = it->second;
+
+    // Last known icon, if this load didn't get one
+    if (info->icon_bgra.empty() && entry.info && !entry.info->icon_bgra.empty()) {
+      info->icon_bgra = entry.info->icon_bgra;
+      info->icon_size = entry.info->icon_size;
+    }
+
+    if (info->icon_timed_out) {
+      _timeouts.fetch_add(1, std::memory_order_relaxed);
+
+      // Quarantine, doubling every time in a row
+      const std::uint32_t shift = std::min<std::uint32_t>(entry.timeouts++, 16);
+      const std::uint32_t backoff_ms = std::min<std::uint32_t>(_RETRY_BASE_MS << shift, _RETRY_MAX_MS);
+      _retries.push_back(_Retry{ _Clock::now() + std::chrono::milliseconds(backoff_ms), request });
+    }
+    else {
+      entry.timeouts = 0;
+    }
+
+    // Kept even if nothing loaded, a process that can't be opened isn't retried for every window
+    entry.info = std::move(info);
+    _version.fetch_add(1, std::memory_order_release);
+  }
+}
+
+
+void ProcessCache::acquire(const std::uint32_t pid, const HWND hwnd) {
+  if (pid == 0) return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _Entry& entry = _entries[pid];
+    entry.hwnd = hwnd; // Newest window is the likeliest to answer a retry
+    if (entry.windows++ != 0) return;
+
+    // First listed window of the process
+    entry.generation = _next_generation++;
+    _requests.push_back(_Request{ pid, entry.generation });
+  }
+  _wake.notify_one();
+}
+
+
+void ProcessCache::release(const std::uint32_t pid) {
+  if (pid == 0) return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _entries.find(pid);
+  if (it == _entries.end() || --it->second.windows != 0) return;
+
+  // Pending retries of it are skipped once due, the generation won't match anymore
+  const bool loaded = it->second.info != nullptr;
+  _entries.erase(it);
+  if (loaded) _version.fetch_add(1, std::memory_order_release);
+}
+
+
+std::shared_ptr<const ProcessInfo> ProcessCache::find(const std::uint32_t pid) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _entries.find(pid);
+  if (it == _entries.end()) return nullptr;
+  return it->second.info;
+}
+
+
+std::size_t ProcessCache::size() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _entries.size();
+}
@@ -0,0 +1,197 @@
+#ifndef PROCESS_CACHE_HPP
+#define PROCESS_CACHE_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "window_handle.hpp"
+#include "window_backend.hpp"
+
+
+/**
+ * @brief Exe path, name and icon of every process with a listed window, keyed by PID.
+ *
+ * A browser or an IDE has dozens of windows from the same process, they all share
+ * one entry instead of opening the process and decoding the icon once per window.
+ * Entries are loaded lazily on the cache's own worker thread the first time a window
+ * of the process is listed, readers never wait on a load.
+ *
+ * Entries count the listed windows of their process and are dropped with the last
+ * one. A process's windows are all destroyed before it exits, so an entry never
+ * outlives its process and a reused PID always starts from a fresh load.
+ *
+ * Icons are asked from a window of the process, which a hung app never answers.
+ * Every load is bounded by a timeout, and a process whose window timed out is
+ * quarantined: asked again, through its most recently listed window, only after a
+ * backoff that doubles with every timeout. Meanwhile the entry keeps whatever was
+ * loaded, and the last icon that was ever loaded for it.
+ *
+ * NOTE: acquire() and release() come from the event thread, find() from any thread.
+ */
+class ProcessCache {
+  public:
+    static constexpr std::uint32_t DEFAULT_TIMEOUT_MS = 200;
+
+  private:
+    using _Clock = std::chrono::steady_clock;
+
+    static constexpr std::uint32_t _RETRY_BASE_MS = 1000;  // Quarantine after the first timeout
+    static constexpr std::uint32_t _RETRY_MAX_MS = 60000;  // Backoff stops doubling here
+
+    /**
+     * @brief One process
+     */
+    struct _Entry {
+      std::uint32_t windows = 0;   // Listed windows of the process
+      std::uint64_t generation;    // Tells a reused PID apart from the process a load was for
+      HWND hwnd;                   // Most recently listed window, asked on retries
+      std::uint32_t timeouts = 0;  // Loads in a row that timed out
+      std::shared_ptr<const ProcessInfo> info; // Null until loaded
+    };
+
+    /**
+     * @brief A load waiting for the worker
+     */
+    struct _Request {
+      std::uint32_t pid;
+      std::uint64_t generation;
+    };
+
+    /**
+     * @brief A load waiting for its quarantine to end
+     */
+    struct _Retry {
+      _Clock::time_point due;
+      _Request request;
+    };
+
+    WindowBackend& _backend;
+    const std::uint32_t _timeout_ms;
+    mutable std::mutex _mutex; // Guards everything but the counters
+    std::condition_variable _wake;
+    std::unordered_map<std::uint32_t, _Entry> _entries;
+    std::deque<_Request> _requests;
+    std::vector<_Retry> _retries; // Unordered, only ever a handful
+    std::uint64_t _next_generation = 1;
+    bool _stopping = false;
+    std::thread _worker;
+
+    std::atomic<std::uint64_t> _version{0}; // Bumped whenever an entry is loaded or dropped
+    std::atomic<std::uint64_t> _loads{0};
+    std::atomic<std::uint64_t> _timeouts{0};
+
+
+    /**
+     * @brief Worker loop, loads requested entries until stopped
+     */
+    void _run();
+
+
+    /**
+     * @brief Moves every retry that is due to the requests
+     * @returns _Clock::time_point: When the next one is due, max() if none is left
+     */
+    _Clock::time_point _promoteRetries(const _Clock::time_point now);
+
+  public:
+    /**
+     * @brief Creates an empty cache, the worker isn't started yet
+     * @param backend: Source of the process data
+     * @param timeout_ms: Longest a load waits on a window
+     */
+    explicit ProcessCache(WindowBackend& backend, const std::uint32_t timeout_ms = DEFAULT_TIMEOUT_MS)
+      : _backend(backend)
+      , _timeout_ms(timeout_ms) {}
+
+
+    /**
+     * @brief Stops the worker.
+     */
+    ~ProcessCache();
+
+
+    ProcessCache(const ProcessCache&) = delete;
+    ProcessCache& operator=(const ProcessCache&) = delete;
+
+
+    /**
+     * @brief Starts the worker, requests made before are loaded right away
+     */
+    void start();
+
+
+    /**
+     * @brief Stops the worker, waiting for the load in progress
+     */
+    void stop();
+
+
+    /**
+     * @brief Counts a newly listed window, queueing a load for its process if it's the first
+     * @param pid: Process of the window, 0 is ignored
+     * @param hwnd: Handle of the window, the icon is asked from it
+     */
+    void acquire(const std::uint32_t pid, const HWND hwnd);
+
+
+    /**
+     * @brief Uncounts a window that stopped being listed, dropping the entry with the last one
+     * @param pid: Process of the window, 0 is ignored
+     */
+    void release(const std::uint32_t pid);
+
+
+    /**
+     * @brief Gets the entry of a process
+     * @param pid: Process id
+     * @returns std::shared_ptr<const ProcessInfo>: Entry, or null if not listed or not loaded yet
+     */
+    std::shared_ptr<const ProcessInfo> find(const std::uint32_t pid) const;
+
+
+    /**
+     * @brief Gets the change counter of the cache
+     * @returns std::uint64_t: Version, bumped whenever an entry is loaded or dropped
+     */
+    std::uint64_t version() const {
+      return _version.load(std::memory_order_acquire);
+    }
+
+
+    /**
+     * @brief Gets the amount of processes loaded from the backend so far
+     * @returns std::uint64_t: Load count
+     */
+    std::uint64_t loads() const {
+      return _loads.load(std::memory_order_relaxed);
+    }
+
+
+    /**
+     * @brief Gets the amount of loads that hit the timeout so far
+     * @returns std::uint64_t: Timeout count
+     */
+    std::uint64_t timeouts() const {
+      return _timeouts.load(std::memory_order_relaxed);
+    }
+
+
+    /**
+     * @brief Gets the amount of processes with a listed window
+     * @returns std::size_t: Process count
+     */
+    std::size_t size() const;
+};
+
+
+#endif // PROCESS_CACHE_HPP
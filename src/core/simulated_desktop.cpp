@@ -0,0 +1,376 @@
+#include "simulated_desktop.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+
+namespace {
+  /**
+   * @brief Removes an element by swapping the last one into its place
+   */
+  void swapRemove(std::vector<HWND>& list, const HWND hwnd) {
+    const auto it = std::find(list.begin(), list.end(), hwnd);
+    if (it == list.end()) return;
+
+    *it = list.back();
+    list.pop_back();
+  }
+}
+
+
+SimulatedDesktop::SimulatedDesktop(const SimulatedDesktopConfig& config)
+  : _config(config)
+  , _rng(config.seed) {
+  _windows.reserve(config.window_count + config.background_count);
+
+  for (std::uint32_t i = 0; i < config.window_count; i++) {
+    _open(true, i < config.storm_windows);
+  }
+  for (std::uint32_t i = 0; i < config.background_count; i++) {
+    _open(false, false);
+  }
+}
+
+
+void SimulatedDesktop::_spin(const std::uint32_t us) {
+  if (us == 0) return;
+
+  const auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+  while (std::chrono::steady_clock::now() < end) {}
+}
+
+
+HWND SimulatedDesktop::_open(const bool alt_tab, const bool storm) {
+  const HWND hwnd = reinterpret_cast<HWND>(_next_handle);
+  _next_handle += 0x10; // Looks like a real handle, never null
+
+  _Window& w = _windows[hwnd];
+  w.title = (alt_tab ? "Window " : "Background ") + std::to_string(reinterpret_cast<std::uintptr_t>(hwnd) >> 4);
+  w.traits.visible = true;
+  w.traits.tool_window = !alt_tab;
+  w.storm = storm;
+  w.hung = alt_tab && _opened < _config.hung_windows;
+  w.pid = alt_tab ? 1000 + 4 * (_opened++ % std::max<std::uint32_t>(_config.process_count, 1)) : 4; // Background ones all live in "System"
+
+  if (alt_tab) _listed.push_back(hwnd);
+  else         _background.push_back(hwnd);
+  if (storm) _storming.push_back(hwnd);
+  return hwnd;
+}
+
+
+void SimulatedDesktop::_retitle(const HWND hwnd, WindowEventQueue& queue) {
+  _Window& w = _windows[hwnd];
+  w.title_changes++;
+
+  // Storms cycle through a few values, like a loading spinner or a ticking clock
+  const std::uint32_t value = w.storm ? (w.title_changes % 8) : w.title_changes;
+  w.title = "Window " + std::to_string(reinterpret_cast<std::uintptr_t>(hwnd) >> 4) + " - " + std::to_string(value);
+  queue.push(WindowEvent{ WindowEvent::NAMECHANGE, hwnd, _now_ms });
+}
+
+
+void SimulatedDesktop::_changeSilently() {
+  switch (std::uniform_int_distribution<int>(0, 2)(_rng)) {
+    case 0: {
+      // Turned into an app window, it has been there all along
+      if (_background.empty()) return;
+      const HWND hwnd = _pick(_background);
+      _Window& w = _windows[hwnd];
+      if (!w.traits.tool_window) return;
+      w.traits = WindowTraits{};
+      w.traits.visible = true;
+      w.title = "Window " + std::to_string(reinterpret_cast<std::uintptr_t>(hwnd) >> 4);
+      swapRemove(_background, hwnd);
+      _listed.push_back(hwnd);
+      return;
+    }
+    case 1: {
+      // Hidden or cloaked, storms keep storming
+      if (_listed.empty()) return;
+      const HWND hwnd = _pick(_listed);
+      if (_windows[hwnd].storm) return;
+      _windows[hwnd].traits.visible = false;
+      swapRemove(_listed, hwnd);
+      _background.push_back(hwnd);
+      return;
+    }
+    default: {
+      // Closed, the DESTROY got lost
+      if (_listed.empty()) return;
+      const HWND hwnd = _pick(_listed);
+      if (_windows[hwnd].storm) return;
+      swapRemove(_listed, hwnd);
+      _windows.erase(hwnd);
+      return;
+    }
+  }
+}
+
+
+bool SimulatedDesktop::_flicker(WindowEventQueue& queue) {
+  if (_background.empty()) return false;
+  const HWND hwnd = _pick(_background);
+  _Window& w = _windows[hwnd];
+  if (!w.traits.tool_window) return false;
+
+  w.traits.visible = !w.traits.visible;
+  queue.push(WindowEvent{ w.traits.visible ? WindowEvent::SHOW : WindowEvent::HIDE, hwnd, _now_ms });
+  return true;
+}
+
+
+bool SimulatedDesktop::_toggleCloak(WindowEventQueue& queue) {
+  // As many cloaked as uncloaked over time, storms keep storming
+  if (!_cloaked.empty() && (_listed.empty() || std::uniform_int_distribution<int>(0, 1)(_rng) == 0)) {
+    const HWND hwnd = _pick(_cloaked);
+    _windows[hwnd].traits.cloaked = false;
+    swapRemove(_cloaked, hwnd);
+    swapRemove(_background, hwnd);
+    _listed.push_back(hwnd);
+    queue.push(WindowEvent{ WindowEvent::UNCLOAK, hwnd, _now_ms });
+    return true;
+  }
+
+  if (_listed.empty()) return false;
+  const HWND hwnd = _pick(_listed);
+  if (_windows[hwnd].storm) return false;
+  _windows[hwnd].traits.cloaked = true;
+  swapRemove(_listed, hwnd);
+  _background.push_back(hwnd);
+  _cloaked.push_back(hwnd);
+  queue.push(WindowEvent{ WindowEvent::CLOAK, hwnd, _now_ms });
+  return true;
+}
+
+
+std::size_t SimulatedDesktop::step(const std::uint32_t dt_ms, WindowEventQueue& queue) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _now_ms += dt_ms;
+
+  const double dt_s = dt_ms / 1000.0;
+  _churn_debt      += _config.churn_per_s * dt_s;
+  _title_debt      += _config.title_changes_per_s * dt_s;
+  _focus_debt      += _config.focus_changes_per_s * dt_s;
+  _storm_debt      += _config.storm_changes_per_s * _storming.size() * dt_s;
+  _background_debt += _config.background_events_per_s * dt_s;
+  _silent_debt     += _config.silent_changes_per_s * dt_s;
+  _flicker_debt    += _config.flicker_per_s * dt_s;
+  _cloak_debt      += _config.cloak_changes_per_s * dt_s;
+
+  std::size_t events = 0;
+
+  // Churn: one window opens, another one (never a storm) closes
+  for (; _churn_debt >= 1.0; _churn_debt -= 1.0) {
+    const HWND opened = _open(true, false);
+    queue.push(WindowEvent{ WindowEvent::CREATE, opened, _now_ms });
+    events++;
+
+    for (int attempt = 0; attempt < 4 && _listed.size() > 1; attempt++) {
+      const HWND closed = _pick(_listed);
+      if (closed == opened || _windows[closed].storm) continue;
+
+      swapRemove(_listed, closed);
+      _windows.erase(closed);
+      queue.push(WindowEvent{ WindowEvent::DESTROY, closed, _now_ms });
+      events++;
+      break;
+    }
+  }
+
+  for (; _focus_debt >= 1.0; _focus_debt -= 1.0) {
+    if (_listed.empty()) break;
+    queue.push(WindowEvent{ WindowEvent::FOREGROUND, _pick(_listed), _now_ms });
+    events++;
+  }
+
+  for (; _title_debt >= 1.0; _title_debt -= 1.0) {
+    if (_listed.empty()) break;
+    _retitle(_pick(_listed), queue);
+    events++;
+  }
+
+  for (; _storm_debt >= 1.0; _storm_debt -= 1.0) {
+    if (_storming.empty()) break;
+    _retitle(_pick(_storming), queue);
+    events++;
+  }
+
+  for (; _background_debt >= 1.0; _background_debt -= 1.0) {
+    if (_background.empty()) break;
+    queue.push(WindowEvent{ WindowEvent::NAMECHANGE, _pick(_background), _now_ms });
+    events++;
+  }
+
+  for (; _silent_debt >= 1.0; _silent_debt -= 1.0) {
+    _changeSilently();
+  }
+
+  for (; _flicker_debt >= 1.0; _flicker_debt -= 1.0) {
+    if (_flicker(queue)) events++;
+  }
+
+  for (; _cloak_debt >= 1.0; _cloak_debt -= 1.0) {
+    if (_toggleCloak(queue)) events++;
+  }
+
+  // Leftover debt of empty lists would pile up forever
+  _focus_debt = std::min(_focus_debt, 1.0);
+  _title_debt = std::min(_title_debt, 1.0);
+  _storm_debt = std::min(_storm_debt, 1.0);
+  _background_debt = std::min(_background_debt, 1.0);
+  return events;
+}
+
+
+std::size_t SimulatedDesktop::altTabCount() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _listed.size();
+}
+
+
+bool SimulatedDesktop::topLevelWindows(std::vector<HWND>& out) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  out.clear();
+  out.insert(out.end(), _listed.begin(), _listed.end());
+  out.insert(out.end(), _background.begin(), _background.end());
+  return true;
+}
+
+
+void SimulatedDesktop::enumerateAltTab(std::vector<EnumeratedWindow>& out) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  out.clear();
+  out.reserve(_listed.size());
+
+  // Every window gets classified, like a real enumeration, but only alt-tab ones pay for a title
+  const std::size_t total = _listed.size() + _background.size();
+  _spin(static_cast<std::uint32_t>(_config.alt_tab_latency_us * total));
+  _spin(static_cast<std::uint32_t>(_config.title_latency_us * _listed.size()));
+  _alt_tab_queries.fetch_add(total, std::memory_order_relaxed);
+  _title_queries.fetch_add(_listed.size(), std::memory_order_relaxed);
+
+  for (const HWND hwnd : _listed) {
+    const _Window& w = _windows.find(hwnd)->second;
+    out.push_back(EnumeratedWindow{ hwnd, w.title, w.pid });
+  }
+}
+
+
+bool SimulatedDesktop::title(const HWND hwnd, std::string& title) {
+  _spin(_config.title_latency_us);
+  _title_queries.fetch_add(1, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _windows.find(hwnd);
+  if (it == _windows.end()) return false;
+
+  title = it->second.title;
+  return true;
+}
+
+
+bool SimulatedDesktop::traits(const HWND hwnd, WindowTraits& traits) {
+  _spin(_config.alt_tab_latency_us);
+  _alt_tab_queries.fetch_add(1, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _windows.find(hwnd);
+  if (it == _windows.end()) return false;
+
+  traits = it->second.traits;
+  return true;
+}
+
+
+std::uint32_t SimulatedDesktop::processId(const HWND hwnd) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _windows.find(hwnd);
+  return it != _windows.end() ? it->second.pid : 0;
+}
+
+
+bool SimulatedDesktop::processInfo(const HWND hwnd, ProcessInfo& info, const std::uint32_t timeout_ms) {
+  _spin(_config.process_latency_us);
+
+  bool hung;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _windows.find(hwnd);
+    hung = it != _windows.end() && it->second.hung;
+  }
+
+  const std::string id = std::to_string(info.pid);
+  info.exe_path = L"C:\\Program Files\\Simulated\\app" + std::wstring(id.begin(), id.end()) + L".exe";
+  info.name = "app" + id + ".exe";
+
+  // WM_GETICON never gets an answer
+  if (hung) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeout_ms, _config.hang_ms)));
+    info.icon_timed_out = true;
+    return true;
+  }
+
+  // Flat per-process color
+  info.icon_size = 32;
+  info.icon_bgra.resize(static_cast<std::size_t>(info.icon_size) * info.icon_size * 4);
+  const std::uint32_t color = info.pid * 2654435761u;
+  for (std::size_t i = 0; i < info.icon_bgra.size(); i += 4) {
+    info.icon_bgra[i + 0] = static_cast<std::uint8_t>(color);
+    info.icon_bgra[i + 1] = static_cast<std::uint8_t>(color >> 8);
+    info.icon_bgra[i + 2] = static_cast<std::uint8_t>(color >> 16);
+    info.icon_bgra[i + 3] = 255;
+  }
+  return true;
+}
+
+
+bool SimulatedDesktop::capture(const HWND hwnd, std::vector<std::uint8_t>& bgra, int& width, int& height) {
+  // Every window repaints, ticks or stays still for its whole life
+  const std::uint32_t handle_hash = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(hwnd) >> 4) * 2654435761u;
+  const double kind = (handle_hash >> 16) / 65536.0;
+  const bool repaints = kind < _config.repaint_ratio;
+  const bool ticks = !repaints && kind < _config.repaint_ratio + _config.ticking_ratio;
+
+  std::uint32_t seed;
+  std::uint32_t now_ms;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _windows.find(hwnd);
+    if (it == _windows.end()) return false;
+
+    // Content moves with the title, and with the clock if it repaints
+    now_ms = _now_ms;
+    seed = handle_hash + it->second.title_changes * 97u + (repaints ? now_ms / 16 : 0);
+  }
+  _spin(_config.capture_latency_us);
+
+  width = _config.capture_width;
+  height = _config.capture_height;
+  bgra.resize(static_cast<std::size_t>(width) * height * 4);
+
+  // Diagonal gradient on a per-window tint
+  std::uint8_t* px = bgra.data();
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      px[0] = static_cast<std::uint8_t>(x + seed);
+      px[1] = static_cast<std::uint8_t>(y + (seed >> 8));
+      px[2] = static_cast<std::uint8_t>(x + y + (seed >> 16));
+      px[3] = 255;
+      px += 4;
+    }
+  }
+
+  // Clock in the top-right corner, a new value every second
+  if (ticks) {
+    const std::uint8_t value = static_cast<std::uint8_t>((now_ms / 1000) * 37u);
+    for (int y = 0; y < std::min(height, 16); y++) {
+      for (int x = std::max(width - 48, 0); x < width; x++) {
+        std::uint8_t* clock = bgra.data() + (static_cast<std::size_t>(y) * width + x) * 4;
+        clock[0] = clock[1] = clock[2] = static_cast<std::uint8_t>(value + x * 5);
+      }
+    }
+  }
+  return true;
+}
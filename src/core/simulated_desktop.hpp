@@ -0,0 +1,203 @@
+#ifndef SIMULATED_DESKTOP_HPP
+#define SIMULATED_DESKTOP_HPP
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "window_handle.hpp"
+#include "window_backend.hpp"
+#include "window_events.hpp"
+
+
+/**
+ * @brief Shape of the load a SimulatedDesktop generates
+ */
+struct SimulatedDesktopConfig {
+  std::uint32_t window_count = 40;       // Alt-tab windows open at the start
+  std::uint32_t background_count = 200;  // Windows that never show up in alt-tab (tool windows, hidden, ...)
+  double churn_per_s = 2.0;              // Alt-tab windows opened, and as many closed, per second
+  double title_changes_per_s = 20.0;     // Title changes spread over every alt-tab window
+  double focus_changes_per_s = 1.0;      // Foreground switches
+  std::uint32_t process_count = 12;      // Processes the alt-tab windows are spread over
+  std::uint32_t hung_windows = 0;        // Alt-tab windows that never answer a message (the first ones opened)
+  std::uint32_t hang_ms = 5000;          // How long a query to a hung window blocks without a timeout
+  std::uint32_t storm_windows = 2;       // Windows flooding title changes (browsers, IDEs, ...)
+  double storm_changes_per_s = 500.0;    // Title changes per storm window
+  double background_events_per_s = 200.0; // Name changes of windows that aren't listed
+  double silent_changes_per_s = 0.0;     // Windows shown, hidden or closed without an event, like the hooks miss
+  double flicker_per_s = 0.0;            // Background tool windows (menus, tooltips) shown or hidden, with an event
+  double cloak_changes_per_s = 0.0;      // Alt-tab windows cloaked or uncloaked, with an event (virtual desktops)
+
+  int capture_width = 1280;              // Size of captured content
+  int capture_height = 720;
+  double repaint_ratio = 1.0;            // Share of windows whose whole content moves with the clock (video, scrolling)
+  double ticking_ratio = 0.0;            // Share with only a clock in a corner changing every second, the rest change with their title
+
+  std::uint32_t title_latency_us = 0;    // Added to every title query
+  std::uint32_t alt_tab_latency_us = 0;  // Added to every alt-tab check
+  std::uint32_t capture_latency_us = 0;  // Added to every capture
+  std::uint32_t process_latency_us = 0;  // Added to every process load
+
+  std::uint32_t seed = 1;
+};
+
+
+/**
+ * @brief Window system without a desktop, for load-testing the window pipeline headlessly.
+ *
+ * step() advances a simulated clock and queues the events the real hooks would have
+ * delivered meanwhile: windows opening and closing, focus switches, title changes and
+ * title storms, tool windows flickering, cloak changes, and the changes the hooks never
+ * see. Queries are answered from the simulated state, after an optional injected
+ * latency, and captures are synthetic patterns: repainting windows change every frame,
+ * ticking ones only in a corner every second, the others with their title.
+ * Hung windows make the queries a real window would answer with a message (icons)
+ * block until their timeout, or for hang_ms.
+ *
+ * NOTE: Safe to query and capture from other threads while step() runs.
+ */
+class SimulatedDesktop : public WindowBackend {
+  private:
+    /**
+     * @brief One simulated window
+     */
+    struct _Window {
+      std::string title;
+      WindowTraits traits; // Background windows are tool windows
+      bool storm;
+      bool hung;
+      std::uint32_t pid;
+      std::uint32_t title_changes = 0;
+    };
+
+    SimulatedDesktopConfig _config;
+    mutable std::mutex _mutex; // Guards _windows, _listed, _storming, _background and _cloaked
+    std::unordered_map<HWND, _Window> _windows;
+    std::vector<HWND> _listed;   // Alt-tab windows, for picking one at random
+    std::vector<HWND> _storming; // Subset of _listed
+    std::vector<HWND> _background;
+    std::vector<HWND> _cloaked; // Subset of _background
+    std::mt19937 _rng;
+    std::uintptr_t _next_handle = 0x10;
+    std::uint32_t _now_ms = 0;
+    std::uint32_t _opened = 0; // Windows opened so far, spreads them over the processes
+    std::atomic<std::uint64_t> _title_queries{0};
+    std::atomic<std::uint64_t> _alt_tab_queries{0};
+
+    // Fractional events carried over to the next step
+    double _churn_debt = 0.0;
+    double _title_debt = 0.0;
+    double _focus_debt = 0.0;
+    double _storm_debt = 0.0;
+    double _background_debt = 0.0;
+    double _silent_debt = 0.0;
+    double _flicker_debt = 0.0;
+    double _cloak_debt = 0.0;
+
+
+    /**
+     * @brief Opens a window
+     * @param alt_tab: Shows up in alt-tab
+     * @param storm: Floods title changes
+     * @returns HWND: Handle of the window
+     */
+    HWND _open(const bool alt_tab, const bool storm);
+
+
+    /**
+     * @brief Picks a random element
+     */
+    HWND _pick(const std::vector<HWND>& list) {
+      return list[std::uniform_int_distribution<std::size_t>(0, list.size() - 1)(_rng)];
+    }
+
+
+    /**
+     * @brief Changes the title of a window and queues the event
+     */
+    void _retitle(const HWND hwnd, WindowEventQueue& queue);
+
+
+    /**
+     * @brief Shows a background window, hides an alt-tab one or closes one, without an event
+     */
+    void _changeSilently();
+
+
+    /**
+     * @brief Shows or hides a background tool window
+     * @returns bool: False if it picked a window that isn't a tool window, no event queued
+     */
+    bool _flicker(WindowEventQueue& queue);
+
+
+    /**
+     * @brief Cloaks an alt-tab window or uncloaks a cloaked one
+     * @returns bool: False if there was nothing to cloak or it picked a storm, no event queued
+     */
+    bool _toggleCloak(WindowEventQueue& queue);
+
+
+    /**
+     * @brief Busy-waits, sleeping is too coarse for microsecond latencies
+     */
+    static void _spin(const std::uint32_t us);
+
+  public:
+    /**
+     * @brief Creates a desktop with its starting windows already open
+     * @param config: Shape of the load
+     */
+    explicit SimulatedDesktop(const SimulatedDesktopConfig& config);
+
+
+    /**
+     * @brief Advances the simulated clock, queueing every event that happened meanwhile
+     * @param dt_ms: Simulated milliseconds to advance
+     * @param queue: Events are pushed here, like the hooks would
+     * @returns std::size_t: Amount of events queued
+     */
+    std::size_t step(const std::uint32_t dt_ms, WindowEventQueue& queue);
+
+
+    /**
+     * @brief Gets the simulated clock
+     * @returns std::uint32_t: Milliseconds since the desktop was created
+     */
+    std::uint32_t now() const {
+      return _now_ms;
+    }
+
+
+    /**
+     * @brief Gets the amount of alt-tab windows open right now
+     * @returns std::size_t: Window count
+     */
+    std::size_t altTabCount() const;
+
+
+    /**
+     * @brief Gets the amount of title and alt-tab queries (trait reads) answered so far
+     */
+    std::uint64_t titleQueries() const { return _title_queries.load(std::memory_order_relaxed); }
+    std::uint64_t altTabQueries() const { return _alt_tab_queries.load(std::memory_order_relaxed); }
+
+
+    void enumerateAltTab(std::vector<EnumeratedWindow>& out) override;
+    bool topLevelWindows(std::vector<HWND>& out) override; // No latency, handles are cheap to list
+    bool title(const HWND hwnd, std::string& title) override;
+    bool traits(const HWND hwnd, WindowTraits& traits) override;
+    std::uint32_t processId(const HWND hwnd) override;
+    bool processInfo(const HWND hwnd, ProcessInfo& info, const std::uint32_t timeout_ms) override;
+    bool capture(const HWND hwnd, std::vector<std::uint8_t>& bgra, int& width, int& height) override;
+};
+
+
+#endif // SIMULATED_DESKTOP_HPP
@@ -0,0 +1,79 @@
+#ifndef TAB_GROUPS_HPP
+#define TAB_GROUPS_HPP
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "window_handle.hpp"
+
+
+/**
+ * @brief Layout used to define the style of rendering a tab group should render with.
+ */
+enum TabGroupLayout {
+  GRID,
+  VERTICAL_LIST
+};
+
+
+/**
+ * @brief Predefined tab groups that will ALWAYS exist
+ */
+struct StaticTabGroups {
+  static inline const std::string OPEN_TABS = "Open Tabs"; // Special instance of a tab group
+  static inline const std::string HOTKEYS = "Hotkeys"; // Special instance of a tab group
+};
+
+
+/**
+ * @brief A tab group.
+ *
+ * Which windows belong to a group is tracked by the membership bitsets of the
+ * registry rows, so a group itself only needs its id. Groups with fixed positions
+ * (hotkeys) also keep the window in each slot.
+ */
+struct TabGroup {
+  TabGroupId id = 0;
+  std::vector<WindowId> slots; // Handles into the WindowRegistry, INVALID_WINDOW_ID for empty slots
+};
+
+
+// Types
+using TabGroupMap =
+  std::unordered_map<
+    std::string,
+    TabGroup
+  >;
+using TabGroupOrderList = std::vector<std::string>;
+using TabGroupLayoutList =
+  std::unordered_map<
+    std::string,
+    TabGroupLayout
+  >;
+
+
+/**
+ * @brief Change to a tab group requested by the UI.
+ *
+ * The UI only ever reads published snapshots, so instead of writing to the tab
+ * groups it queues edits that the owner of the tab groups applies between frames.
+ */
+struct TabGroupEdit {
+  enum Type {
+    SET_SLOT,     // Put a window in a fixed slot of a group (hotkeys)
+    ADD_WINDOW,   // Make a window a member of a group
+    REMOVE_WINDOW // Drop a window from a group
+  };
+
+  Type type;
+  std::string group;
+  std::size_t slot; // SET_SLOT only
+  WindowId id;
+};
+using TabGroupEditList = std::vector<TabGroupEdit>;
+
+
+#endif // TAB_GROUPS_HPP
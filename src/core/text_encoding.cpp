@@ -0,0 +1,272 @@
+#include "text_encoding.hpp"
+#include "cpu_features.hpp"
+
+
+namespace {
+  /**
+   * @brief Encodes the character starting at src[i]
+   * @returns std::size_t: Code units consumed, 1 or 2
+   */
+  inline std::size_t encodeOne(const char16_t* src, const std::size_t i, const std::size_t length, char*& dst) {
+    std::uint32_t c = src[i];
+
+    if (c < 0x80) {
+      *dst++ = static_cast<char>(c);
+      return 1;
+    }
+    if (c < 0x800) {
+      *dst++ = static_cast<char>(0xC0 | (c >> 6));
+      *dst++ = static_cast<char>(0x80 | (c & 0x3F));
+      return 1;
+    }
+
+    if (c >= 0xD800 && c <= 0xDFFF) {
+      // High surrogate followed by a low one
+      const bool paired = c <= 0xDBFF && i + 1 < length && src[i + 1] >= 0xDC00 && src[i + 1] <= 0xDFFF;
+      if (paired) {
+        c = 0x10000 + ((c - 0xD800) << 10) + (src[i + 1] - 0xDC00);
+        *dst++ = static_cast<char>(0xF0 | (c >> 18));
+        *dst++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | (c & 0x3F));
+        return 2;
+      }
+      c = 0xFFFD;
+    }
+
+    *dst++ = static_cast<char>(0xE0 | (c >> 12));
+    *dst++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    *dst++ = static_cast<char>(0x80 | (c & 0x3F));
+    return 1;
+  }
+
+
+#ifdef CPU_FEATURES_X86
+  /**
+   * @brief Encodes 8 units at a time while 8 are left, stops at the first mixed block
+   *
+   * Titles that mix scripts or have surrogates mostly stay mixed, checking every later block
+   * costs more than the scalar loop it falls back to. The caller finishes them with it.
+   *
+   * NOTE: Inlined into both kernels, so the AVX2 one gets it as VEX code. Calling legacy SSE code
+   * with the upper halves of the registers dirty stalls on every instruction.
+   * @returns std::size_t: Index of the first unit left
+   */
+  inline std::size_t encodeBlocks8(const char16_t* src, std::size_t i, const std::size_t length, char*& dst) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ascii_mask = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i two_byte_mask = _mm_set1_epi16(static_cast<short>(0xF800));
+    const __m128i low6 = _mm_set1_epi16(0x3F);
+    const __m128i lead = _mm_set1_epi16(static_cast<short>(0x80C0)); // Lead byte marker, continuation marker in the high byte
+
+    while (i + 8 <= length) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+      const int ascii = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, ascii_mask), zero));
+
+      // All ASCII, narrow every unit to its byte
+      if (ascii == 0xFFFF) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(v, v));
+        dst += 8;
+        i += 8;
+        continue;
+      }
+
+      // All 2-byte (Latin, Greek, Cyrillic, Hebrew, Arabic, ...), every unit becomes the same 2 bytes in place
+      const int two_byte = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, two_byte_mask), zero));
+      if (two_byte == 0xFFFF && ascii == 0) {
+        const __m128i high = _mm_srli_epi16(v, 6);
+        const __m128i low = _mm_slli_epi16(_mm_and_si128(v, low6), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_or_si128(_mm_or_si128(high, low), lead));
+        dst += 16;
+        i += 8;
+        continue;
+      }
+
+      // Mixed, the rest goes through the scalar loop
+      break;
+    }
+    return i;
+  }
+
+
+  std::size_t utf16ToUtf8Sse2(const char16_t* src, const std::size_t length, char* dst) {
+    char* const begin = dst;
+    std::size_t i = encodeBlocks8(src, 0, length, dst);
+    while (i < length) i += encodeOne(src, i, length, dst);
+    return static_cast<std::size_t>(dst - begin);
+  }
+
+
+  /**
+   * @brief pshufb masks for the byte-shuffling paths, 0x80 zeroes a byte
+   */
+  struct ShuffleTables {
+    // Indexed by which of 8 units are ASCII, keeps both bytes of a 2-byte unit and the first of an ASCII one
+    alignas(16) std::uint8_t compact[256][16];
+    // 8 3-byte units, first from the lead and middle bytes then from the last bytes, for 16 bytes then 8 more
+    alignas(16) std::uint8_t three_lead[2][16];
+    alignas(16) std::uint8_t three_last[2][16];
+
+    ShuffleTables() {
+      for (int mask = 0; mask < 256; mask++) {
+        int n = 0;
+        for (int k = 0; k < 8; k++) {
+          compact[mask][n++] = static_cast<std::uint8_t>(2 * k);
+          if ((mask & (1 << k)) == 0) compact[mask][n++] = static_cast<std::uint8_t>(2 * k + 1);
+        }
+        while (n < 16) compact[mask][n++] = 0x80;
+      }
+
+      for (int p = 0; p < 32; p++) {
+        const int k = p / 3;
+        const int r = p % 3;
+        const bool used = p < 24;
+        three_lead[p / 16][p % 16] = used && r < 2 ? static_cast<std::uint8_t>(2 * k + r) : 0x80;
+        three_last[p / 16][p % 16] = used && r == 2 ? static_cast<std::uint8_t>(2 * k) : 0x80;
+      }
+    }
+  };
+  const ShuffleTables SHUFFLES;
+
+
+  /**
+   * @brief Encodes 8 units with byte shuffles, when they mix ASCII and 2-byte units or are all 3-byte (CJK, ...)
+   * @returns bool: False if the block has surrogates or mixes 3-byte units with others, nothing is written then
+   */
+  CPU_FEATURES_AVX2_TARGET
+  inline bool encodeBlock8Shuffled(const __m128i v, char*& dst) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ascii_units = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80))), zero);
+    const __m128i two_byte_units = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xF800))), zero);
+    const __m128i surrogates = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xF800))), _mm_set1_epi16(static_cast<short>(0xD800)));
+    if (_mm_movemask_epi8(surrogates) != 0) return false;
+
+    // One bit per unit
+    const int ascii = _mm_movemask_epi8(_mm_packs_epi16(ascii_units, zero));
+    const int two_byte = _mm_movemask_epi8(_mm_packs_epi16(two_byte_units, zero));
+    const __m128i low6 = _mm_set1_epi16(0x3F);
+
+    if (two_byte == 0xFF) {
+      // Every unit as 2 bytes, ASCII ones keep their value, then the shuffle squeezes out their empty high byte
+      const __m128i pair = _mm_or_si128(_mm_or_si128(_mm_srli_epi16(v, 6), _mm_slli_epi16(_mm_and_si128(v, low6), 8)),
+        _mm_set1_epi16(static_cast<short>(0x80C0)));
+      const __m128i units = _mm_or_si128(_mm_and_si128(ascii_units, v), _mm_andnot_si128(ascii_units, pair));
+      const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(SHUFFLES.compact[ascii]));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(units, shuffle));
+      dst += 16 - _mm_popcnt_u32(static_cast<unsigned>(ascii));
+      return true;
+    }
+
+    if (two_byte == 0) {
+      // Lead and middle bytes paired in one vector, last bytes in another, interleaved by the shuffles
+      const __m128i lead = _mm_or_si128(_mm_srli_epi16(v, 12), _mm_set1_epi16(0xE0));
+      const __m128i middle = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 6), low6), _mm_set1_epi16(0x80));
+      const __m128i last = _mm_or_si128(_mm_and_si128(v, low6), _mm_set1_epi16(0x80));
+      const __m128i lead_middle = _mm_or_si128(lead, _mm_slli_epi16(middle, 8));
+
+      const __m128i first = _mm_or_si128(
+        _mm_shuffle_epi8(lead_middle, _mm_load_si128(reinterpret_cast<const __m128i*>(SHUFFLES.three_lead[0]))),
+        _mm_shuffle_epi8(last, _mm_load_si128(reinterpret_cast<const __m128i*>(SHUFFLES.three_last[0]))));
+      const __m128i second = _mm_or_si128(
+        _mm_shuffle_epi8(lead_middle, _mm_load_si128(reinterpret_cast<const __m128i*>(SHUFFLES.three_lead[1]))),
+        _mm_shuffle_epi8(last, _mm_load_si128(reinterpret_cast<const __m128i*>(SHUFFLES.three_last[1]))));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), first);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 16), second);
+      dst += 24;
+      return true;
+    }
+    return false;
+  }
+
+
+  /**
+   * @brief 16 units at a time, same paths as the 8-unit blocks plus the shuffles for mixed halves
+   *
+   * NOTE: The first half the shuffles can't take (surrogates, 3-byte units mixed with others)
+   * sends the rest of the string through the scalar loop, see encodeBlocks8().
+   */
+  CPU_FEATURES_AVX2_TARGET
+  std::size_t utf16ToUtf8Avx2(const char16_t* src, const std::size_t length, char* dst) {
+    char* const begin = dst;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ascii_mask = _mm256_set1_epi16(static_cast<short>(0xFF80));
+    const __m256i two_byte_mask = _mm256_set1_epi16(static_cast<short>(0xF800));
+    const __m256i low6 = _mm256_set1_epi16(0x3F);
+    const __m256i lead = _mm256_set1_epi16(static_cast<short>(0x80C0));
+
+    std::size_t i = 0;
+    while (i + 16 <= length) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+      const std::uint32_t ascii = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_and_si256(v, ascii_mask), zero)));
+
+      if (ascii == 0xFFFFFFFFu) {
+        // packus works per 128-bit lane, pack the two halves together instead
+        const __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), packed);
+        dst += 16;
+        i += 16;
+        continue;
+      }
+
+      const std::uint32_t two_byte = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_and_si256(v, two_byte_mask), zero)));
+      if (two_byte == 0xFFFFFFFFu && ascii == 0) {
+        const __m256i high = _mm256_srli_epi16(v, 6);
+        const __m256i low = _mm256_slli_epi16(_mm256_and_si256(v, low6), 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_or_si256(_mm256_or_si256(high, low), lead));
+        dst += 32;
+        i += 16;
+        continue;
+      }
+
+      // Mixed, each half through the shuffles if it can
+      if (!encodeBlock8Shuffled(_mm256_castsi256_si128(v), dst)) break;
+      i += 8;
+      if (!encodeBlock8Shuffled(_mm256_extracti128_si256(v, 1), dst)) break;
+      i += 8;
+    }
+
+    // Tail goes through the narrower vectors, unless a mixed block already sent it to the scalar loop
+    if (i + 16 > length) i = encodeBlocks8(src, i, length, dst);
+    while (i < length) i += encodeOne(src, i, length, dst);
+    return static_cast<std::size_t>(dst - begin);
+  }
+
+
+  using Transcoder = std::size_t (*)(const char16_t*, const std::size_t, char*);
+  const Transcoder TRANSCODER = cpuHasAvx2() ? utf16ToUtf8Avx2 : utf16ToUtf8Sse2;
+#endif // CPU_FEATURES_X86
+}
+
+
+std::size_t utf16ToUtf8Scalar(const char16_t* src, const std::size_t length, char* dst) {
+  char* const begin = dst;
+  for (std::size_t i = 0; i < length;) {
+    i += encodeOne(src, i, length, dst);
+  }
+  return static_cast<std::size_t>(dst - begin);
+}
+
+
+std::size_t utf16ToUtf8(const char16_t* src, const std::size_t length, char* dst) {
+#ifdef CPU_FEATURES_X86
+  return TRANSCODER(src, length, dst);
+#else
+  return utf16ToUtf8Scalar(src, length, dst);
+#endif
+}
+
+
+void utf16ToUtf8(const std::u16string_view src, std::string& out) {
+  // Worst case first, then cut down, no allocation once the capacity is there
+  out.resize(src.size() * UTF8_BYTES_PER_UTF16_UNIT);
+  out.resize(utf16ToUtf8(src.data(), src.size(), out.data()));
+}
+
+
+const char* utf16ToUtf8Path() {
+#ifdef CPU_FEATURES_X86
+  return TRANSCODER == utf16ToUtf8Avx2 ? "avx2" : "sse2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,59 @@
+#ifndef TEXT_ENCODING_HPP
+#define TEXT_ENCODING_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+/**
+ * @brief Most UTF-8 bytes one UTF-16 code unit can turn into
+ *
+ * BMP characters take up to 3 bytes, surrogate pairs take 4 for 2 units.
+ */
+inline constexpr std::size_t UTF8_BYTES_PER_UTF16_UNIT = 3;
+
+
+/**
+ * @brief Transcodes UTF-16 to UTF-8, one code unit at a time
+ *
+ * NOTE: Unpaired surrogates become U+FFFD, like Windows does.
+ * @param src: UTF-16 code units
+ * @param length: Amount of code units
+ * @param dst: Receives the bytes, room for length * UTF8_BYTES_PER_UTF16_UNIT
+ * @returns std::size_t: Bytes written
+ */
+std::size_t utf16ToUtf8Scalar(const char16_t* src, const std::size_t length, char* dst);
+
+
+/**
+ * @brief Transcodes UTF-16 to UTF-8, whole vectors at a time where they're all ASCII or all 2-byte
+ *
+ * Uses AVX2 if the CPU has it, SSE2 otherwise, the scalar loop off x64.
+ * Output is identical to utf16ToUtf8Scalar().
+ * @param src: UTF-16 code units
+ * @param length: Amount of code units
+ * @param dst: Receives the bytes, room for length * UTF8_BYTES_PER_UTF16_UNIT
+ * @returns std::size_t: Bytes written
+ */
+std::size_t utf16ToUtf8(const char16_t* src, const std::size_t length, char* dst);
+
+
+/**
+ * @brief Transcodes UTF-16 to UTF-8 into a string, reusing its capacity
+ * @param src: UTF-16 code units
+ * @param out: Replaced with the UTF-8 text
+ */
+void utf16ToUtf8(const std::u16string_view src, std::string& out);
+
+
+/**
+ * @brief Gets the vector width utf16ToUtf8() picked for this CPU
+ * @returns const char*: "avx2", "sse2" or "scalar"
+ */
+const char* utf16ToUtf8Path();
+
+
+#endif // TEXT_ENCODING_HPP
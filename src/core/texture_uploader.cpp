@@ -0,0 +1,46 @@
+#include "texture_uploader.hpp"
+
+#include <algorithm>
+#include <utility>
+
+
+namespace {
+  /**
+   * @brief Maps a span of one level to the span of the next level it's filtered into
+   * @param first: First pixel of the span
+   * @param end: One past its last pixel
+   * @param from: Size of the level the span is in
+   * @param to: Size of the next level
+   * @returns std::pair<int, int>: First pixel and one past the last, grown by one on each side
+   */
+  std::pair<int, int> shrinkSpan(const int first, const int end, const int from, const int to) {
+    const std::int64_t lo = static_cast<std::int64_t>(first) * to / from;
+    const std::int64_t hi = (static_cast<std::int64_t>(end) * to + from - 1) / from;
+    return { static_cast<int>(std::max<std::int64_t>(lo - 1, 0)), static_cast<int>(std::min<std::int64_t>(hi + 1, to)) };
+  }
+}
+
+
+bool uploadDirtyRects(TextureUploader& uploader, const ImTextureID tex, const std::uint8_t* pixels,
+  const ThumbnailSize size, const int mip_levels, const std::vector<TileRect>& rects, std::size_t& sent) {
+  sent = 0;
+  for (const TileRect& dirty : rects) {
+    TileRect rect = dirty;
+    for (int level = 0; level < mip_levels; level++) {
+      const ThumbnailSize level_size = mipLevelSize(size, level);
+      if (level > 0) {
+        const ThumbnailSize above = mipLevelSize(size, level - 1);
+        const auto [x0, x1] = shrinkSpan(rect.x, rect.x + rect.width, above.width, level_size.width);
+        const auto [y0, y1] = shrinkSpan(rect.y, rect.y + rect.height, above.height, level_size.height);
+        rect = TileRect{ x0, y0, x1 - x0, y1 - y0 };
+      }
+      if (rect.width <= 0 || rect.height <= 0) break;
+
+      const std::ptrdiff_t stride = static_cast<std::ptrdiff_t>(level_size.width) * 4;
+      const std::uint8_t* first = pixels + mipLevelOffset(size, level) + rect.y * stride + static_cast<std::ptrdiff_t>(rect.x) * 4;
+      if (!uploader.update(tex, level, rect, first, stride)) return false;
+      sent += static_cast<std::size_t>(rect.width) * rect.height * 4;
+    }
+  }
+  return true;
+}
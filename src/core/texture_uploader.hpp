@@ -0,0 +1,84 @@
+#ifndef TEXTURE_UPLOADER_HPP
+#define TEXTURE_UPLOADER_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "imgui.h"
+
+#include "tile_diff.hpp"
+#include "thumbnail_mips.hpp"
+
+
+/**
+ * @brief Creates thumbnail textures and updates parts of them, whatever the renderer is.
+ *
+ * D3D11TextureUploader (win_utils) talks to the GPU, the headless tools keep the
+ * textures in memory to check what an update leaves in them.
+ *
+ * NOTE: Called from the UI thread only.
+ */
+class TextureUploader {
+  public:
+    virtual ~TextureUploader() = default;
+
+
+    /**
+     * @brief Creates a texture that can be updated afterwards
+     * @param pixels: width * height * 4 BGRA pixels, top-down, then the smaller mip levels back to back. Null for zeros
+     * @param width: Width of the first level
+     * @param height: Height of the first level
+     * @param mip_levels: Levels in pixels, see buildMipChain()
+     * @returns ImTextureID: Texture, ImTextureID_Invalid on failure. Released by the registry's releaser
+     */
+    virtual ImTextureID create(const std::uint8_t* pixels, const int width, const int height, const int mip_levels) = 0;
+
+
+    /**
+     * @brief Overwrites a rectangle of one level of a texture
+     * @param tex: Texture from create()
+     * @param level: Mip level, 0 is the first
+     * @param rect: Rectangle of the level, in its pixels
+     * @param first: BGRA pixel at the rectangle's top-left
+     * @param stride: Bytes from one row of the rectangle to the next
+     * @returns bool: False if the texture couldn't be updated
+     */
+    virtual bool update(const ImTextureID tex, const int level, const TileRect& rect, const std::uint8_t* first,
+      const std::ptrdiff_t stride) = 0;
+
+
+    /**
+     * @brief Copies a rectangle of one level from a texture to another, without going through memory
+     * @param from: Texture read
+     * @param to: Texture written, another one
+     * @param level: Mip level, the same in both
+     * @param rect: Rectangle read, in the level's pixels
+     * @param x: Left of where it lands
+     * @param y: Top of where it lands
+     * @returns bool: False if it couldn't be copied
+     */
+    virtual bool copy(const ImTextureID from, const ImTextureID to, const int level, const TileRect& rect, const int x, const int y) = 0;
+};
+
+
+/**
+ * @brief Sends the changed rectangles of a thumbnail, and what they cover in every smaller level
+ *
+ * A rectangle of a level covers the pixels of the next level the box filter reads it
+ * into, grown by a pixel for the odd sizes whose levels don't halve exactly.
+ * @param uploader: Renderer holding the texture
+ * @param tex: Texture holding the previous capture, same size and level count
+ * @param pixels: New capture, every level back to back
+ * @param size: Size of the first level
+ * @param mip_levels: Level count
+ * @param rects: Changed rectangles of the first level, see diffTiles()
+ * @param sent: Receives the bytes sent, every level
+ * @returns bool: False if an update failed, the texture has to be created again
+ */
+bool uploadDirtyRects(TextureUploader& uploader, const ImTextureID tex, const std::uint8_t* pixels,
+  const ThumbnailSize size, const int mip_levels, const std::vector<TileRect>& rects, std::size_t& sent);
+
+
+#endif // TEXTURE_UPLOADER_HPP
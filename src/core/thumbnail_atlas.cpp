@@ -0,0 +1,380 @@
+#include "thumbnail_atlas.hpp"
+
+#include <algorithm>
+
+// Compiled static here too, imgui_draw.cpp keeps its own copy private
+// NOTE: Static copies of the functions this file doesn't call are unused
+#if defined(_MSC_VER)
+  #pragma warning(push)
+  #pragma warning(disable: 4505) // unreferenced function with internal linkage has been removed
+#elif defined(__GNUC__) || defined(__clang__)
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#define STBRP_STATIC
+#define STBRP_ASSERT(x) do { IM_ASSERT(x); } while (0)
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imstb_rectpack.h"
+#if defined(_MSC_VER)
+  #pragma warning(pop)
+#elif defined(__GNUC__) || defined(__clang__)
+  #pragma GCC diagnostic pop
+#endif
+
+
+/**
+ * @brief One texture of the atlas and what's packed into it, in cells of ATLAS_ALIGN pixels
+ */
+struct ThumbnailAtlas::_Page {
+  ImTextureID tex = ImTextureID_Invalid;
+  stbrp_context packer{};
+  std::vector<stbrp_node> nodes; // One per column of cells, the packer's skyline
+  std::size_t allocated = 0;     // Cells handed out since it was made, freed ones included
+  std::size_t live = 0;          // Cells of the slots still in it
+  std::size_t slots = 0;
+};
+
+
+namespace {
+  /**
+   * @brief Gets how many cells a side of a slot takes, gutter included
+   * @param pixels: Side of the thumbnail
+   * @returns int: Cells
+   */
+  int cellsOf(const int pixels) {
+    return (pixels + ATLAS_GUTTER + ATLAS_ALIGN - 1) / ATLAS_ALIGN;
+  }
+
+
+  /**
+   * @brief Gets the cells a thumbnail takes
+   * @param size: Size of the thumbnail
+   * @returns std::size_t: Cells, gutter included
+   */
+  std::size_t areaOf(const ThumbnailSize size) {
+    return static_cast<std::size_t>(cellsOf(size.width)) * cellsOf(size.height);
+  }
+
+
+  /**
+   * @brief Sends updates of a thumbnail into its slot, moved by the slot's place on every level
+   */
+  class SlotUploader final : public TextureUploader {
+    private:
+      TextureUploader& _base;
+      int _x;
+      int _y;
+
+    public:
+      SlotUploader(TextureUploader& base, const int x, const int y)
+        : _base(base), _x(x), _y(y) {}
+
+      ImTextureID create(const std::uint8_t* pixels, const int width, const int height, const int mip_levels) override {
+        return _base.create(pixels, width, height, mip_levels);
+      }
+
+      bool update(const ImTextureID tex, const int level, const TileRect& rect, const std::uint8_t* first,
+        const std::ptrdiff_t stride) override {
+        const TileRect moved{ rect.x + (_x >> level), rect.y + (_y >> level), rect.width, rect.height };
+        return _base.update(tex, level, moved, first, stride);
+      }
+
+      bool copy(const ImTextureID from, const ImTextureID to, const int level, const TileRect& rect, const int x, const int y) override {
+        return _base.copy(from, to, level, rect, x, y);
+      }
+  };
+}
+
+
+// ----------------- Private functions -----------------
+
+bool ThumbnailAtlas::_allocate(const ThumbnailSize size, _Slot& out, const bool repacking) {
+  const int width = cellsOf(size.width);
+  const int height = cellsOf(size.height);
+  const auto tryPage = [&](const std::uint32_t p) {
+    _Page& page = *_pages[p];
+    stbrp_rect rect{};
+    rect.w = width;
+    rect.h = height;
+    stbrp_pack_rects(&page.packer, &rect, 1);
+    if (!rect.was_packed) return false;
+
+    out = _Slot{ p, rect.x * ATLAS_ALIGN, rect.y * ATLAS_ALIGN, size };
+    page.allocated += static_cast<std::size_t>(width) * height;
+    page.live += static_cast<std::size_t>(width) * height;
+    page.slots++;
+    return true;
+  };
+
+  // First page with room, never the one being emptied
+  for (std::uint32_t p = 0; p < _pages.size(); p++) {
+    if (_pages[p] && p != _evacuating && tryPage(p)) return true;
+  }
+
+  // One more while repacking, it takes what the emptied page held
+  const std::size_t limit = _max_pages + (repacking ? 1 : 0);
+  if (pages() >= limit) return false;
+
+  const ImTextureID tex = _uploader.create(nullptr, _page_size, _page_size, THUMBNAIL_MIP_LEVELS);
+  if (tex == ImTextureID_Invalid) return false;
+
+  auto page = std::make_unique<_Page>();
+  const int cells = _page_size / ATLAS_ALIGN;
+  page->tex = tex;
+  page->nodes.resize(static_cast<std::size_t>(cells));
+  stbrp_init_target(&page->packer, cells, cells, page->nodes.data(), cells);
+
+  // Takes the place of a released page, so indices don't grow forever
+  const auto free_it = std::find(_pages.begin(), _pages.end(), nullptr);
+  const std::uint32_t p = static_cast<std::uint32_t>(free_it - _pages.begin());
+  if (free_it != _pages.end()) *free_it = std::move(page);
+  else                         _pages.push_back(std::move(page));
+  return tryPage(p);
+}
+
+
+void ThumbnailAtlas::_free(const _Slot& slot) {
+  _Page* page = slot.page < _pages.size() ? _pages[slot.page].get() : nullptr;
+  if (!page) return;
+
+  page->live -= areaOf(slot.size);
+  page->slots--;
+  if (page->slots == 0) _releasePage(slot.page);
+}
+
+
+void ThumbnailAtlas::_releasePage(const std::uint32_t page) {
+  if (_release_texture) _release_texture(_pages[page]->tex);
+  _pages[page].reset();
+  if (page == _evacuating) {
+    _evacuating = NO_PAGE;
+    _evacuation.clear();
+  }
+}
+
+
+bool ThumbnailAtlas::_write(const _Slot& slot, const std::uint8_t* pixels, const int levels) {
+  const ImTextureID tex = _pages[slot.page]->tex;
+  for (int level = 0; level < levels; level++) {
+    const ThumbnailSize level_size = mipLevelSize(slot.size, level);
+    const TileRect rect{ slot.x >> level, slot.y >> level, level_size.width, level_size.height };
+    const std::ptrdiff_t stride = static_cast<std::ptrdiff_t>(level_size.width) * 4;
+    if (!_uploader.update(tex, level, rect, pixels + mipLevelOffset(slot.size, level), stride)) return false;
+  }
+  return true;
+}
+
+
+AtlasSlot ThumbnailAtlas::_view(const _Slot& slot) const {
+  const float page_size = static_cast<float>(_page_size);
+  AtlasSlot view;
+  view.page = _pages[slot.page]->tex;
+  view.size = ImVec2(static_cast<float>(slot.size.width), static_cast<float>(slot.size.height));
+  view.region.uv0 = ImVec2(slot.x / page_size, slot.y / page_size);
+  view.region.uv1 = ImVec2((slot.x + slot.size.width) / page_size, (slot.y + slot.size.height) / page_size);
+  view.region.shared = true;
+  return view;
+}
+
+
+// ----------------- Public functions -----------------
+
+ThumbnailAtlas::ThumbnailAtlas(TextureUploader& uploader, const WindowRegistry::TextureReleaser release_texture,
+  const int page_size, const std::size_t max_pages)
+  : _uploader(uploader), _release_texture(release_texture),
+    _page_size(std::max(page_size / ATLAS_ALIGN, 1) * ATLAS_ALIGN), _max_pages(std::max<std::size_t>(max_pages, 1)) {}
+
+
+ThumbnailAtlas::~ThumbnailAtlas() {
+  clear();
+}
+
+
+bool ThumbnailAtlas::fits(const ThumbnailSize size, const int levels) const {
+  const int max_side = _page_size / 2 - ATLAS_GUTTER;
+  return levels == THUMBNAIL_MIP_LEVELS &&
+    size.width > 0 && size.height > 0 &&
+    size.width <= max_side && size.height <= max_side;
+}
+
+
+bool ThumbnailAtlas::place(const WindowId id, const std::uint8_t* pixels, const ThumbnailSize size, const int levels, AtlasSlot& out) {
+  const auto it = _slots.find(id);
+  if (!fits(size, levels)) {
+    if (it != _slots.end()) remove(id);
+    return false;
+  }
+
+  // Same size, overwritten where it is
+  _Slot slot;
+  if (it != _slots.end() && it->second.size.width == size.width && it->second.size.height == size.height) {
+    slot = it->second;
+  }
+  else {
+    // Found before the old one is freed, so its page isn't released and made again
+    const bool found = _allocate(size, slot);
+    if (it != _slots.end()) {
+      _free(it->second);
+      _slots.erase(it);
+    }
+    if (!found) return false;
+    _slots[id] = slot;
+  }
+
+  if (!_write(slot, pixels, levels)) {
+    remove(id);
+    return false;
+  }
+  out = _view(slot);
+  return true;
+}
+
+
+bool ThumbnailAtlas::update(const WindowId id, const std::uint8_t* pixels, const std::vector<TileRect>& rects, std::size_t& sent) {
+  sent = 0;
+  const auto it = _slots.find(id);
+  if (it == _slots.end()) return false;
+
+  const _Slot& slot = it->second;
+  SlotUploader uploader(_uploader, slot.x, slot.y);
+  return uploadDirtyRects(uploader, _pages[slot.page]->tex, pixels, slot.size, THUMBNAIL_MIP_LEVELS, rects, sent);
+}
+
+
+bool ThumbnailAtlas::slot(const WindowId id, AtlasSlot& out) const {
+  const auto it = _slots.find(id);
+  if (it == _slots.end()) return false;
+
+  out = _view(it->second);
+  return true;
+}
+
+
+void ThumbnailAtlas::remove(const WindowId id) {
+  const auto it = _slots.find(id);
+  if (it == _slots.end()) return;
+
+  const _Slot slot = it->second;
+  _slots.erase(it);
+  _free(slot);
+}
+
+
+void ThumbnailAtlas::prune(const WindowRegistry& registry) {
+  for (auto it = _slots.begin(); it != _slots.end();) {
+    const std::optional<WindowView> info = registry.get(it->first);
+    const bool shown = info && (info->flags & WINDOW_FLAG_SHARED_TEXTURE) && info->tex == _pages[it->second.page]->tex;
+    if (shown) {
+      ++it;
+      continue;
+    }
+
+    const _Slot slot = it->second;
+    it = _slots.erase(it);
+    _free(slot);
+  }
+}
+
+
+std::size_t ThumbnailAtlas::defragment(std::vector<WindowId>& moved, const std::size_t max_moves) {
+  moved.clear();
+  if (max_moves == 0) return 0;
+
+  // Page that wasted the most, once it wasted enough
+  if (_evacuating == NO_PAGE) {
+    const std::size_t cells = static_cast<std::size_t>(_page_size / ATLAS_ALIGN);
+    std::size_t worst = static_cast<std::size_t>(ATLAS_REPACK_WASTE * cells * cells);
+    for (std::uint32_t p = 0; p < _pages.size(); p++) {
+      if (!_pages[p]) continue;
+      const std::size_t wasted = _pages[p]->allocated - _pages[p]->live;
+      if (wasted >= worst) {
+        worst = wasted;
+        _evacuating = p;
+      }
+    }
+    if (_evacuating == NO_PAGE) return 0;
+
+    // Tallest popped first, the skyline packs them the tightest
+    _evacuation.clear();
+    for (const auto& [id, slot] : _slots) {
+      if (slot.page == _evacuating) _evacuation.push_back(id);
+    }
+    std::sort(_evacuation.begin(), _evacuation.end(), [this](const WindowId a, const WindowId b) {
+      const ThumbnailSize& sa = _slots.at(a).size;
+      const ThumbnailSize& sb = _slots.at(b).size;
+      if (sa.height != sb.height) return sa.height < sb.height;
+      return sa.width < sb.width;
+    });
+    _repacks++;
+  }
+
+  while (moved.size() < max_moves && !_evacuation.empty()) {
+    const WindowId id = _evacuation.back();
+    _evacuation.pop_back();
+    const auto it = _slots.find(id);
+    if (it == _slots.end() || it->second.page != _evacuating) continue;
+
+    // Nowhere to go, left as it is until slots are freed
+    const _Slot from = it->second;
+    _Slot to;
+    if (!_allocate(from.size, to, true)) {
+      _evacuating = NO_PAGE;
+      _evacuation.clear();
+      break;
+    }
+
+    bool copied = true;
+    for (int level = 0; level < THUMBNAIL_MIP_LEVELS && copied; level++) {
+      const ThumbnailSize level_size = mipLevelSize(from.size, level);
+      const TileRect rect{ from.x >> level, from.y >> level, level_size.width, level_size.height };
+      copied = _uploader.copy(_pages[from.page]->tex, _pages[to.page]->tex, level, rect, to.x >> level, to.y >> level);
+    }
+    if (!copied) {
+      _free(to);
+      _evacuating = NO_PAGE;
+      _evacuation.clear();
+      break;
+    }
+
+    // Releases the page once its last slot is out
+    it->second = to;
+    _free(from);
+    moved.push_back(id);
+    _moves++;
+  }
+  return moved.size();
+}
+
+
+void ThumbnailAtlas::clear() {
+  _slots.clear();
+  for (std::uint32_t p = 0; p < _pages.size(); p++) {
+    if (_pages[p]) _releasePage(p);
+  }
+  _pages.clear();
+  _evacuating = NO_PAGE;
+  _evacuation.clear();
+}
+
+
+std::size_t ThumbnailAtlas::pages() const {
+  return static_cast<std::size_t>(std::count_if(_pages.begin(), _pages.end(), [](const auto& page) { return page != nullptr; }));
+}
+
+
+std::size_t ThumbnailAtlas::pageBytes() const {
+  return pages() * mipLevelOffset(ThumbnailSize{ _page_size, _page_size }, THUMBNAIL_MIP_LEVELS);
+}
+
+
+double ThumbnailAtlas::occupancy() const {
+  const std::size_t cells = static_cast<std::size_t>(_page_size / ATLAS_ALIGN);
+  std::size_t live = 0;
+  std::size_t total = 0;
+  for (const auto& page : _pages) {
+    if (!page) continue;
+    live += page->live;
+    total += cells * cells;
+  }
+  return total != 0 ? static_cast<double>(live) / total : 0.0;
+}
@@ -0,0 +1,238 @@
+#ifndef THUMBNAIL_ATLAS_HPP
+#define THUMBNAIL_ATLAS_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "imgui.h"
+
+#include "window_handle.hpp"
+#include "window_registry.hpp"
+#include "texture_uploader.hpp"
+#include "thumbnail_mips.hpp"
+#include "tile_diff.hpp"
+
+
+inline constexpr int ATLAS_PAGE_SIZE = 2048;                        // Pixels per side of a page, ~22 MB with its mips
+inline constexpr int ATLAS_ALIGN = 1 << (THUMBNAIL_MIP_LEVELS - 1); // Slots start on a pixel of every level
+inline constexpr int ATLAS_GUTTER = ATLAS_ALIGN;                    // Empty pixels right and below a slot, a pixel on the last level
+inline constexpr std::size_t ATLAS_MAX_PAGES = 4;
+inline constexpr float ATLAS_REPACK_WASTE = 0.25f;                  // Part of a page taken by freed slots before it gets repacked
+
+
+/**
+ * @brief Where a thumbnail lies in the atlas
+ */
+struct AtlasSlot {
+  ImTextureID page = ImTextureID_Invalid;
+  ImVec2 size = ImVec2(0.0f, 0.0f); // Pixels of the thumbnail's largest level
+  TextureRegion region;             // Shared, see WINDOW_FLAG_SHARED_TEXTURE
+};
+
+
+/**
+ * @brief Packs thumbnails into a few large textures, so a panel draws them in a draw call per page.
+ *
+ * Every page is a texture with THUMBNAIL_MIP_LEVELS levels, split in ATLAS_ALIGN pixel
+ * cells packed by imstb_rectpack. A slot is placed on the cell grid with a gutter, so it
+ * starts on a pixel of every level and bilinear taps never reach its neighbours.
+ *
+ * The packer never gives space back, a freed slot stays taken until its page is empty.
+ * defragment() repacks the page that wasted the most, a few slots per call: they're
+ * copied GPU-side into the other pages and the page is released once it's empty. The
+ * caller points the registry at the moved slots.
+ *
+ * The registry owns which window shows which slot. prune() frees the slots of windows
+ * that are gone or moved to a texture of their own, evicted ones included.
+ *
+ * NOTE: Called from the UI thread only. Pages are released with the registry's releaser.
+ */
+class ThumbnailAtlas {
+  public:
+    static constexpr std::uint32_t NO_PAGE = UINT32_MAX;
+
+  private:
+    struct _Page; // Texture and packer, see thumbnail_atlas.cpp
+
+    /**
+     * @brief Place of a thumbnail, in pixels of the first level
+     */
+    struct _Slot {
+      std::uint32_t page;
+      int x;
+      int y;
+      ThumbnailSize size;
+    };
+
+    TextureUploader& _uploader;
+    WindowRegistry::TextureReleaser _release_texture;
+    int _page_size;
+    std::size_t _max_pages;
+
+    std::vector<std::unique_ptr<_Page>> _pages; // Null once released, so page indices stay put
+    std::unordered_map<WindowId, _Slot> _slots;
+
+    std::uint32_t _evacuating = NO_PAGE;   // Page being repacked
+    std::vector<WindowId> _evacuation;     // Its slots left to move, tallest first
+    std::uint64_t _moves = 0;
+    std::uint64_t _repacks = 0;
+
+
+    /**
+     * @brief Finds room for a thumbnail, in a new page if none has it
+     * @param size: Size of the thumbnail
+     * @param out: Receives its place
+     * @param repacking: Moved out of the page being repacked, may take one page over the limit
+     * @returns bool: False if every page is full and no other can be made
+     */
+    bool _allocate(const ThumbnailSize size, _Slot& out, const bool repacking = false);
+
+
+    /**
+     * @brief Gives a slot back to its page, releasing the page once it's empty
+     * @param slot: Slot to free
+     */
+    void _free(const _Slot& slot);
+
+
+    /**
+     * @brief Releases a page, ending its repack if it was being repacked
+     * @param page: Index of the page, no slot left in it
+     */
+    void _releasePage(const std::uint32_t page);
+
+
+    /**
+     * @brief Writes every level of a thumbnail into its slot
+     * @param slot: Place of the thumbnail
+     * @param pixels: Every level back to back
+     * @param levels: Level count
+     * @returns bool: False if an update failed
+     */
+    bool _write(const _Slot& slot, const std::uint8_t* pixels, const int levels);
+
+
+    /**
+     * @brief Gets what the registry needs of a slot
+     * @param slot: Place of the thumbnail
+     * @returns AtlasSlot: Page and UVs
+     */
+    AtlasSlot _view(const _Slot& slot) const;
+
+  public:
+    /**
+     * @brief Creates an empty atlas, pages are made when the first thumbnails come in
+     * @param uploader: Renderer holding the pages
+     * @param release_texture: Releases a page that's no longer used
+     * @param page_size: Pixels per side of a page, a multiple of ATLAS_ALIGN
+     * @param max_pages: Most pages at once, one more while a page is repacked
+     */
+    ThumbnailAtlas(TextureUploader& uploader, const WindowRegistry::TextureReleaser release_texture,
+      const int page_size = ATLAS_PAGE_SIZE, const std::size_t max_pages = ATLAS_MAX_PAGES);
+    ~ThumbnailAtlas();
+
+    ThumbnailAtlas(const ThumbnailAtlas&) = delete;
+    ThumbnailAtlas& operator=(const ThumbnailAtlas&) = delete;
+
+
+    /**
+     * @brief Checks if a thumbnail can be packed at all
+     *
+     * NOTE: Only full mip chains, and at most half a page per side so one doesn't take a page alone.
+     * @param size: Size of the first level
+     * @param levels: Level count
+     * @returns bool: True if place() can take it
+     */
+    bool fits(const ThumbnailSize size, const int levels) const;
+
+
+    /**
+     * @brief Puts the thumbnail of a window in the atlas, where it was if it has the same size
+     * @param id: Handle of the window
+     * @param pixels: Every level back to back, see buildMipChain()
+     * @param size: Size of the first level
+     * @param levels: Level count
+     * @param out: Receives where it went
+     * @returns bool: False if it doesn't fit or the atlas is full, it needs a texture of its own
+     */
+    bool place(const WindowId id, const std::uint8_t* pixels, const ThumbnailSize size, const int levels, AtlasSlot& out);
+
+
+    /**
+     * @brief Sends the changed rectangles of a new capture into the slot of a window
+     * @param id: Handle of the window, placed with the same size and levels
+     * @param pixels: New capture, every level back to back
+     * @param rects: Changed rectangles of the first level, see diffTiles()
+     * @param sent: Receives the bytes sent, every level
+     * @returns bool: False if it has no slot or an update failed
+     */
+    bool update(const WindowId id, const std::uint8_t* pixels, const std::vector<TileRect>& rects, std::size_t& sent);
+
+
+    /**
+     * @brief Gets where the thumbnail of a window is
+     * @param id: Handle of the window
+     * @param out: Receives its page and UVs
+     * @returns bool: False if it isn't in the atlas
+     */
+    bool slot(const WindowId id, AtlasSlot& out) const;
+
+
+    /**
+     * @brief Frees the slot of a window, if it has one
+     * @param id: Handle of the window
+     */
+    void remove(const WindowId id);
+
+
+    /**
+     * @brief Frees the slots the registry no longer shows: windows gone, evicted or with a texture of their own
+     * @param registry: Registry holding the thumbnails
+     */
+    void prune(const WindowRegistry& registry);
+
+
+    /**
+     * @brief Repacks the page that wasted the most space, a few slots at a time
+     *
+     * NOTE: Call prune() first, a slot the registry no longer shows would be moved back into it.
+     * @param moved: Receives the windows whose slot moved, point the registry at slot()
+     * @param max_moves: Most slots moved by this call
+     * @returns std::size_t: Slots moved
+     */
+    std::size_t defragment(std::vector<WindowId>& moved, const std::size_t max_moves);
+
+
+    /**
+     * @brief Frees every slot and releases every page
+     */
+    void clear();
+
+
+    /**
+     * @brief Gets the pages and slots held right now
+     */
+    std::size_t pages() const;
+    std::size_t size() const { return _slots.size(); }
+
+
+    /**
+     * @brief Gets the bytes of every page, and the part of it taken by live slots and their gutters
+     */
+    std::size_t pageBytes() const;
+    double occupancy() const;
+
+
+    /**
+     * @brief Gets the slots moved and the pages repacked so far
+     */
+    std::uint64_t moves() const { return _moves; }
+    std::uint64_t repacks() const { return _repacks; }
+};
+
+
+#endif // THUMBNAIL_ATLAS_HPP
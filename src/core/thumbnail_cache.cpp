@@ -0,0 +1,132 @@
+#include "thumbnail_cache.hpp"
+
+#include <algorithm>
+
+
+bool ThumbnailCache::lookup(const WindowRegistry& registry, const WindowId id) {
+  const auto it = _entries.find(id);
+  const std::optional<WindowView> info = registry.get(id);
+  if (it == _entries.end() || !info || !(info->flags & WINDOW_FLAG_HAS_THUMBNAIL)) {
+    _misses++;
+    return false;
+  }
+
+  it->second.last_used = ++_clock;
+  _hits++;
+  return true;
+}
+
+
+bool ThumbnailCache::dirtyRects(const WindowRegistry& registry, const WindowId id, const TileHashes& hashes, const int mip_levels,
+  std::vector<TileRect>& out) {
+  out.clear();
+  const auto it = _entries.find(id);
+  if (it == _entries.end() || hashes.tiles.empty() || it->second.mip_levels != mip_levels) return false;
+  if (!diffTiles(it->second.hashes, hashes, out)) return false;
+
+  // Evicted meanwhile, or the window is gone
+  const std::optional<WindowView> info = registry.get(id);
+  if (!info || !(info->flags & WINDOW_FLAG_HAS_THUMBNAIL)) {
+    out.clear();
+    return false;
+  }
+
+  it->second.last_used = ++_clock;
+  return true;
+}
+
+
+void ThumbnailCache::patch(const WindowId id, const TileHashes& hashes, const std::size_t sent, const std::size_t bytes) {
+  const auto it = _entries.find(id);
+  if (it == _entries.end()) return;
+
+  it->second.hashes = hashes;
+  if (sent == 0) _skipped_uploads++;
+  else _patches++;
+  _uploaded_bytes += sent;
+  _skipped_bytes += bytes - std::min(sent, bytes);
+}
+
+
+bool ThumbnailCache::insert(WindowRegistry& registry, const WindowId id, const ImTextureID tex, const ImVec2 size, const std::size_t bytes,
+  const int mip_levels, const TileHashes& hashes, const TextureRegion& region) {
+  if (!registry.setTexture(id, tex, size, region)) return false;
+
+  // Replaces the thumbnail it had, if any
+  _Entry& entry = _entries[id];
+  _used = _used - entry.bytes + bytes;
+  entry.bytes = bytes;
+  entry.last_used = ++_clock;
+  entry.mip_levels = mip_levels;
+  entry.hashes = hashes;
+  _uploads++;
+  _uploaded_bytes += bytes;
+
+  if (_used > _budget) _evict(registry, id);
+  return true;
+}
+
+
+void ThumbnailCache::setBudget(WindowRegistry& registry, const std::size_t budget_bytes) {
+  _budget = budget_bytes;
+  if (_used > _budget) _evict(registry, INVALID_WINDOW_ID);
+}
+
+
+void ThumbnailCache::prune(const WindowRegistry& registry) {
+  for (auto it = _entries.begin(); it != _entries.end();) {
+    if (registry.row(it->first) != WindowRegistry::NO_ROW) {
+      ++it;
+      continue;
+    }
+    _used -= it->second.bytes;
+    it = _entries.erase(it);
+  }
+}
+
+
+void ThumbnailCache::_evict(WindowRegistry& registry, const WindowId keep) {
+  prune(registry);
+  if (_used <= _budget) return;
+
+  // MRU rank of every window, 0 is the focused one
+  _mru_ranks.clear();
+  std::uint32_t rank = 0;
+  for (WindowId id = registry.mruFront(); id != INVALID_WINDOW_ID; id = registry.mruNext(id)) {
+    _mru_ranks[id] = rank++;
+  }
+
+  // LRU rank, 0 is the last one used
+  _candidates.clear();
+  for (const auto& [id, entry] : _entries) {
+    if (id == keep) continue;
+    _candidates.push_back(_Candidate{ id, entry.last_used, _mru_ranks[id], entry.bytes });
+  }
+  std::sort(_candidates.begin(), _candidates.end(), [](const _Candidate& a, const _Candidate& b) {
+    return a.last_used > b.last_used;
+  });
+  for (std::uint32_t i = 0; i < _candidates.size(); i++) _candidates[i].score += i;
+
+  // Worst first, the biggest one of a tie frees the most
+  std::sort(_candidates.begin(), _candidates.end(), [](const _Candidate& a, const _Candidate& b) {
+    if (a.score != b.score) return a.score > b.score;
+    return a.bytes > b.bytes;
+  });
+
+  for (const _Candidate& victim : _candidates) {
+    if (_used <= _budget) return;
+    registry.setTexture(victim.id, ImTextureID_Invalid);
+    _used -= victim.bytes;
+    _entries.erase(victim.id);
+    _evictions++;
+  }
+
+  // Doesn't fit even alone
+  const auto it = _entries.find(keep);
+  if (_used > _budget && it != _entries.end()) {
+    registry.setTexture(keep, ImTextureID_Invalid);
+    _used -= it->second.bytes;
+    _entries.erase(it);
+    _evictions++;
+  }
+}
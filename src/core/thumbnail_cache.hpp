@@ -0,0 +1,205 @@
+#ifndef THUMBNAIL_CACHE_HPP
+#define THUMBNAIL_CACHE_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "imgui.h"
+
+#include "window_handle.hpp"
+#include "window_registry.hpp"
+#include "tile_hash.hpp"
+#include "tile_diff.hpp"
+
+
+/**
+ * @brief Keeps the thumbnails held by a WindowRegistry under a byte budget.
+ *
+ * Every thumbnail goes through insert(), which accounts its size and evicts others
+ * until the total fits the budget again. Victims are picked by the sum of two ranks:
+ * how long ago the thumbnail was last used (LRU) and how long ago its window was
+ * last focused (MRU). A window switched to a moment ago keeps its thumbnail even if
+ * its panel wasn't opened in a while, a window nobody touched goes first.
+ *
+ * Evicting clears the registry's texture, which releases it. The window is drawn
+ * as a placeholder and lookup() misses for it, so the next panel that shows it
+ * captures it again.
+ *
+ * Every entry keeps the tile hashes of its thumbnail. A new capture of the same size is
+ * diffed against them with dirtyRects(), only the tiles that changed are sent into the
+ * texture held and nothing at all if none did, then patch() records the new hashes.
+ *
+ * A thumbnail can be a region of a shared texture, an atlas page. Evicting it only
+ * clears the registry's texture, the atlas frees the region on its next prune.
+ *
+ * NOTE: Doesn't depend on Win32, the registry releases the textures.
+ */
+class ThumbnailCache {
+  public:
+    static constexpr std::size_t DEFAULT_BUDGET_BYTES = std::size_t(256) << 20;
+
+  private:
+    /**
+     * @brief Accounting of one cached thumbnail
+     */
+    struct _Entry {
+      std::size_t bytes;
+      std::uint64_t last_used; // Value of _clock when it was last looked up or inserted
+      int mip_levels;
+      TileHashes hashes;       // Of what the texture holds
+    };
+
+    /**
+     * @brief Eviction candidate, scratch of _evict()
+     */
+    struct _Candidate {
+      WindowId id;
+      std::uint64_t last_used;
+      std::uint32_t score; // LRU rank + MRU rank, highest goes first
+      std::size_t bytes;
+    };
+
+    std::unordered_map<WindowId, _Entry> _entries;
+    std::size_t _budget;
+    std::size_t _used = 0;
+    std::uint64_t _clock = 0;
+
+    std::uint64_t _hits = 0;
+    std::uint64_t _misses = 0;
+    std::uint64_t _evictions = 0;
+    std::uint64_t _uploads = 0;
+    std::uint64_t _patches = 0;
+    std::uint64_t _skipped_uploads = 0;
+    std::uint64_t _uploaded_bytes = 0;
+    std::uint64_t _skipped_bytes = 0;
+
+    // Scratch, reused every eviction pass
+    std::vector<_Candidate> _candidates;
+    std::unordered_map<WindowId, std::uint32_t> _mru_ranks;
+
+
+    /**
+     * @brief Evicts thumbnails until the used bytes fit the budget
+     * @param registry: Registry holding the textures
+     * @param keep: Window evicted only if nothing else is left, INVALID_WINDOW_ID for none
+     */
+    void _evict(WindowRegistry& registry, const WindowId keep);
+
+  public:
+    /**
+     * @brief Creates an empty cache
+     * @param budget_bytes: Most bytes of thumbnails held at once
+     */
+    explicit ThumbnailCache(const std::size_t budget_bytes = DEFAULT_BUDGET_BYTES)
+      : _budget(budget_bytes) {}
+
+
+    /**
+     * @brief Checks if a window's thumbnail is cached, and marks it used
+     * @param registry: Registry holding the textures
+     * @param id: Handle of the window
+     * @returns bool: True on a hit, false if it has to be captured
+     */
+    bool lookup(const WindowRegistry& registry, const WindowId id);
+
+
+    /**
+     * @brief Finds what changed between a new capture of a window and its cached thumbnail, and marks it used
+     * @param registry: Registry holding the textures
+     * @param id: Handle of the window
+     * @param hashes: Tile hashes of the new capture
+     * @param mip_levels: Levels of the new capture
+     * @param out: Receives the rectangles to send into the texture held, empty if it shows the capture already
+     * @returns bool: True if the texture held can be updated, false if the capture needs a new one
+     */
+    bool dirtyRects(const WindowRegistry& registry, const WindowId id, const TileHashes& hashes, const int mip_levels,
+      std::vector<TileRect>& out);
+
+
+    /**
+     * @brief Records that the texture of a window was updated in place to a new capture
+     * @param id: Handle of the window, see dirtyRects()
+     * @param hashes: Tile hashes of the new capture
+     * @param sent: Bytes sent into the texture, 0 if nothing changed
+     * @param bytes: Size of the whole capture, every level
+     */
+    void patch(const WindowId id, const TileHashes& hashes, const std::size_t sent, const std::size_t bytes);
+
+
+    /**
+     * @brief Sets the thumbnail of a window, then evicts others until the budget fits again
+     *
+     * NOTE: A thumbnail bigger than the whole budget is evicted right away.
+     * @param registry: Registry holding the textures
+     * @param id: Handle of the window, stale handles are skipped
+     * @param tex: New texture, the registry releases the old one
+     * @param size: Pixels of the texture's largest level
+     * @param bytes: Size of the texture, every level
+     * @param mip_levels: Levels of the texture
+     * @param hashes: Tile hashes of its first level, empty if it's never updated in place
+     * @param region: Part of the texture the thumbnail takes, see ThumbnailAtlas
+     * @returns bool: True if the window is alive
+     */
+    bool insert(WindowRegistry& registry, const WindowId id, const ImTextureID tex, const ImVec2 size, const std::size_t bytes,
+      const int mip_levels = 1, const TileHashes& hashes = {}, const TextureRegion& region = {});
+
+
+    /**
+     * @brief Changes the budget, evicting right away if it shrank
+     * @param registry: Registry holding the textures
+     * @param budget_bytes: Most bytes of thumbnails held at once
+     */
+    void setBudget(WindowRegistry& registry, const std::size_t budget_bytes);
+
+
+    /**
+     * @brief Forgets the thumbnails of windows that are gone, the registry released them already
+     * @param registry: Registry holding the textures
+     */
+    void prune(const WindowRegistry& registry);
+
+
+    /**
+     * @brief Gets the budget and the bytes held right now
+     */
+    std::size_t budget() const { return _budget; }
+    std::size_t used() const { return _used; }
+
+
+    /**
+     * @brief Gets the amount of cached thumbnails
+     * @returns std::size_t: Thumbnail count
+     */
+    std::size_t size() const {
+      return _entries.size();
+    }
+
+
+    /**
+     * @brief Gets the amount of lookups that hit, missed, and of thumbnails evicted so far
+     */
+    std::uint64_t hits() const { return _hits; }
+    std::uint64_t misses() const { return _misses; }
+    std::uint64_t evictions() const { return _evictions; }
+
+
+    /**
+     * @brief Gets the amount of thumbnails uploaded whole, updated in place and skipped as unchanged so far
+     */
+    std::uint64_t uploads() const { return _uploads; }
+    std::uint64_t patches() const { return _patches; }
+    std::uint64_t skippedUploads() const { return _skipped_uploads; }
+
+
+    /**
+     * @brief Gets the bytes sent to textures so far, and the bytes whole uploads would have sent on top
+     */
+    std::uint64_t uploadedBytes() const { return _uploaded_bytes; }
+    std::uint64_t skippedBytes() const { return _skipped_bytes; }
+};
+
+
+#endif // THUMBNAIL_CACHE_HPP
@@ -0,0 +1,62 @@
+#include "thumbnail_mips.hpp"
+
+#include <algorithm>
+
+
+ThumbnailSize fitThumbnail(const int src_width, const int src_height, const int box_width, const int box_height) {
+  if (src_width <= 0 || src_height <= 0) return {};
+  if (box_width <= 0 || box_height <= 0) return { src_width, src_height };
+
+  // Limited by whichever side hits the box first, cross-multiplied to stay exact
+  const int width = std::min(src_width, box_width);
+  const int height = std::min(src_height, box_height);
+  if (static_cast<std::int64_t>(width) * src_height <= static_cast<std::int64_t>(height) * src_width) {
+    const std::int64_t fitted = (static_cast<std::int64_t>(width) * src_height + src_width / 2) / src_width;
+    return { width, static_cast<int>(std::max<std::int64_t>(fitted, 1)) };
+  }
+  const std::int64_t fitted = (static_cast<std::int64_t>(height) * src_width + src_height / 2) / src_height;
+  return { static_cast<int>(std::max<std::int64_t>(fitted, 1)), height };
+}
+
+
+int mipLevelCount(const int width, const int height, const int max_levels) {
+  int levels = 1;
+  for (int size = std::max(width, height); size > 1 && levels < max_levels; size >>= 1) levels++;
+  return levels;
+}
+
+
+ThumbnailSize mipLevelSize(const ThumbnailSize size, const int level) {
+  return { std::max(size.width >> level, 1), std::max(size.height >> level, 1) };
+}
+
+
+std::size_t mipLevelOffset(const ThumbnailSize size, const int level) {
+  std::size_t offset = 0;
+  for (int i = 0; i < level; i++) {
+    const ThumbnailSize s = mipLevelSize(size, i);
+    offset += static_cast<std::size_t>(s.width) * s.height * 4;
+  }
+  return offset;
+}
+
+
+bool buildMipChain(const std::uint8_t* src, const std::ptrdiff_t src_stride, const int src_width, const int src_height,
+  const ThumbnailSize size, const int levels, std::vector<std::uint8_t>& out, const ScaleOptions& options) {
+  if (size.width <= 0 || size.height <= 0 || levels <= 0) return false;
+
+  out.resize(mipLevelOffset(size, levels));
+  if (!scaleImage(src, src_stride, src_width, src_height, out.data(), static_cast<std::ptrdiff_t>(size.width) * 4,
+    size.width, size.height, options)) return false;
+
+  // Same light space as the first level, so levels don't shift in brightness when the cell shrinks
+  ScaleOptions halve = options;
+  halve.filter = ScaleFilter::BOX;
+  for (int level = 1; level < levels; level++) {
+    const ThumbnailSize from = mipLevelSize(size, level - 1);
+    const ThumbnailSize to = mipLevelSize(size, level);
+    scaleImage(out.data() + mipLevelOffset(size, level - 1), static_cast<std::ptrdiff_t>(from.width) * 4, from.width, from.height,
+      out.data() + mipLevelOffset(size, level), static_cast<std::ptrdiff_t>(to.width) * 4, to.width, to.height, halve);
+  }
+  return true;
+}
@@ -0,0 +1,84 @@
+#ifndef THUMBNAIL_MIPS_HPP
+#define THUMBNAIL_MIPS_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image_scaler.hpp"
+
+
+/**
+ * @brief Size of a thumbnail, in pixels
+ */
+struct ThumbnailSize {
+  int width = 0;
+  int height = 0;
+};
+
+
+inline constexpr int THUMBNAIL_MIP_LEVELS = 3; // The cell size, half and quarter of it, +33% memory
+
+
+/**
+ * @brief Fits an image into a box, keeping its aspect ratio
+ *
+ * NOTE: Never larger than the source, small windows aren't blown up.
+ * @param src_width: Width of the image
+ * @param src_height: Height of the image
+ * @param box_width: Width of the box, 0 or less to keep the source size
+ * @param box_height: Height of the box, 0 or less to keep the source size
+ * @returns ThumbnailSize: Largest size that fits, at least 1x1
+ */
+ThumbnailSize fitThumbnail(const int src_width, const int src_height, const int box_width, const int box_height);
+
+
+/**
+ * @brief Gets how many mip levels an image gets, every level halves it down to 1 pixel
+ * @param width: Width of the first level
+ * @param height: Height of the first level
+ * @param max_levels: Most levels wanted
+ * @returns int: Level count, at least 1
+ */
+int mipLevelCount(const int width, const int height, const int max_levels);
+
+
+/**
+ * @brief Gets the size of one level of a mip chain
+ * @param size: Size of the first level
+ * @param level: Level, 0 is the first
+ * @returns ThumbnailSize: Halved per level, at least 1x1
+ */
+ThumbnailSize mipLevelSize(const ThumbnailSize size, const int level);
+
+
+/**
+ * @brief Gets where a level starts in a chain stored back to back, first level first
+ * @param size: Size of the first level
+ * @param level: Level, mipLevelCount() gives the size of the whole chain
+ * @returns std::size_t: Offset in bytes, BGRA
+ */
+std::size_t mipLevelOffset(const ThumbnailSize size, const int level);
+
+
+/**
+ * @brief Scales an image to a size and appends its smaller levels
+ *
+ * The first level is resampled from the source with `options`, every next one is a
+ * box filter of the one before.
+ * @param src: First pixel of the source, BGRA top-down
+ * @param src_stride: Bytes from one source row to the next
+ * @param src_width: Width of the source
+ * @param src_height: Height of the source
+ * @param size: Size of the first level
+ * @param levels: Level count, see mipLevelCount()
+ * @param out: Resized to the whole chain, receives every level back to back
+ * @param options: How the first level is resampled
+ * @returns bool: False if a size is zero or negative
+ */
+bool buildMipChain(const std::uint8_t* src, const std::ptrdiff_t src_stride, const int src_width, const int src_height,
+  const ThumbnailSize size, const int levels, std::vector<std::uint8_t>& out, const ScaleOptions& options = {});
+
+
+#endif // THUMBNAIL_MIPS_HPP
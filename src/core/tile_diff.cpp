@@ -0,0 +1,75 @@
+#include "tile_diff.hpp"
+
+#include <algorithm>
+
+
+bool diffTiles(const TileHashes& before, const TileHashes& after, std::vector<TileRect>& out, const std::size_t max_rects) {
+  out.clear();
+  if (!before.sameSize(after) || before.tiles.size() != after.tiles.size()) return false;
+
+  // In tiles first, a rectangle still grows while it ends on the row above
+  std::size_t row_start = 0; // First rectangle that may end on the row above
+  for (int ty = 0; ty < after.rows; ty++) {
+    const std::size_t row_end = out.size();
+    for (int tx = 0; tx < after.columns;) {
+      const std::size_t i = static_cast<std::size_t>(ty) * after.columns + tx;
+      if (before.tiles[i] == after.tiles[i]) {
+        tx++;
+        continue;
+      }
+
+      const int first = tx;
+      while (tx < after.columns && before.tiles[i + (tx - first)] != after.tiles[i + (tx - first)]) tx++;
+
+      // Same columns as a run of the row above, grows it down
+      bool grown = false;
+      for (std::size_t r = row_start; r < row_end; r++) {
+        TileRect& rect = out[r];
+        if (rect.x == first && rect.width == tx - first && rect.y + rect.height == ty) {
+          rect.height++;
+          grown = true;
+          break;
+        }
+      }
+      if (!grown) out.push_back(TileRect{ first, ty, tx - first, 1 });
+    }
+
+    // Rectangles that didn't grow are done, moved out of the way of the next row's search
+    std::stable_partition(out.begin() + row_start, out.end(), [ty](const TileRect& rect) {
+      return rect.y + rect.height <= ty;
+    });
+    while (row_start < out.size() && out[row_start].y + out[row_start].height <= ty) row_start++;
+  }
+
+  // Too scattered, one rectangle around all of it
+  if (out.size() > std::max<std::size_t>(max_rects, 1)) {
+    TileRect box = out.front();
+    for (const TileRect& rect : out) {
+      const int right = std::max(box.x + box.width, rect.x + rect.width);
+      const int bottom = std::max(box.y + box.height, rect.y + rect.height);
+      box.x = std::min(box.x, rect.x);
+      box.y = std::min(box.y, rect.y);
+      box.width = right - box.x;
+      box.height = bottom - box.y;
+    }
+    out.assign(1, box);
+  }
+
+  // Tiles to pixels, edge tiles are smaller
+  for (TileRect& rect : out) {
+    const int right = std::min((rect.x + rect.width) * HASH_TILE_SIZE, after.width);
+    const int bottom = std::min((rect.y + rect.height) * HASH_TILE_SIZE, after.height);
+    rect.x *= HASH_TILE_SIZE;
+    rect.y *= HASH_TILE_SIZE;
+    rect.width = right - rect.x;
+    rect.height = bottom - rect.y;
+  }
+  return true;
+}
+
+
+std::size_t rectsArea(const std::vector<TileRect>& rects) {
+  std::size_t area = 0;
+  for (const TileRect& rect : rects) area += static_cast<std::size_t>(rect.width) * rect.height;
+  return area;
+}
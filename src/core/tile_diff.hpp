@@ -0,0 +1,53 @@
+#ifndef TILE_DIFF_HPP
+#define TILE_DIFF_HPP
+
+
+#include <cstddef>
+#include <vector>
+
+#include "tile_hash.hpp"
+
+
+inline constexpr std::size_t MAX_DIRTY_RECTS = 16; // More and a single bounding rectangle is sent instead
+
+
+/**
+ * @brief Rectangle of an image, in pixels
+ */
+struct TileRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+
+
+  bool operator==(const TileRect& other) const {
+    return x == other.x && y == other.y && width == other.width && height == other.height;
+  }
+};
+
+
+/**
+ * @brief Finds what changed between two captures of the same size, from their tile hashes
+ *
+ * Runs of dirty tiles in a tile row become one rectangle, and rectangles covering the
+ * same columns in consecutive rows are merged. Past max_rects, the bounding box of every
+ * dirty tile is sent alone.
+ * @param before: Hashes of the capture the texture holds
+ * @param after: Hashes of the new capture
+ * @param out: Cleared, then receives the rectangles to update, clipped to the image. Empty if nothing changed
+ * @param max_rects: Most rectangles wanted, at least 1
+ * @returns bool: False if the sizes differ, the whole image has to be sent
+ */
+bool diffTiles(const TileHashes& before, const TileHashes& after, std::vector<TileRect>& out,
+  const std::size_t max_rects = MAX_DIRTY_RECTS);
+
+
+/**
+ * @brief Gets the pixels covered by rectangles that don't overlap, like diffTiles() gives
+ * @returns std::size_t: Pixel count
+ */
+std::size_t rectsArea(const std::vector<TileRect>& rects);
+
+
+#endif // TILE_DIFF_HPP
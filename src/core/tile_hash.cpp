@@ -0,0 +1,221 @@
+#include "tile_hash.hpp"
+#include "cpu_features.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+
+namespace {
+  constexpr std::size_t STRIPE_BYTES = 64;
+  constexpr std::uint64_t PRIME32_1 = 0x9E3779B1u;
+  constexpr std::uint64_t PRIME32_2 = 0x85EBCA77u;
+  constexpr std::uint64_t PRIME32_3 = 0xC2B2AE3Du;
+  constexpr std::uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+  constexpr std::uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+  constexpr std::uint64_t PRIME64_3 = 0x165667B19E3779F9ull;
+  constexpr std::uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+  constexpr std::uint64_t PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+
+  /**
+   * @brief Key words: 8 mixed into every stripe, 8 into every row and the final merge
+   */
+  constexpr std::array<std::uint64_t, 16> makeSecret() {
+    std::array<std::uint64_t, 16> secret{};
+    std::uint64_t state = PRIME64_1;
+    for (std::uint64_t& word : secret) {
+      // splitmix64
+      std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      word = z ^ (z >> 31);
+    }
+    return secret;
+  }
+
+
+  alignas(32) constexpr std::array<std::uint64_t, 16> SECRET = makeSecret();
+
+
+  inline std::uint64_t read64(const std::uint8_t* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+  }
+
+
+  /**
+   * @brief Full 64x64 -> 128 bit product, halves xored together
+   */
+  inline std::uint64_t mulFold64(const std::uint64_t a, const std::uint64_t b) {
+    const std::uint64_t lo_lo = (a & 0xFFFFFFFFu) * (b & 0xFFFFFFFFu);
+    const std::uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFFu);
+    const std::uint64_t lo_hi = (a & 0xFFFFFFFFu) * (b >> 32);
+    const std::uint64_t hi_hi = (a >> 32) * (b >> 32);
+    const std::uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+    const std::uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    const std::uint64_t lower = (cross << 32) | (lo_lo & 0xFFFFFFFFu);
+    return lower ^ upper;
+  }
+
+
+  /**
+   * @brief Spreads the high bits of every lane down, between rows
+   */
+  inline void scramble(std::uint64_t* lanes) {
+    for (int i = 0; i < 8; i++) {
+      lanes[i] = ((lanes[i] ^ (lanes[i] >> 47)) ^ SECRET[8 + i]) * PRIME32_1;
+    }
+  }
+
+
+  /**
+   * @brief Folds the lanes into one hash
+   */
+  inline std::uint64_t merge(const std::uint64_t* lanes, const std::uint64_t length) {
+    std::uint64_t h = length * PRIME64_1;
+    for (int i = 0; i < 4; i++) {
+      h += mulFold64(lanes[2 * i] ^ SECRET[8 + 2 * i], lanes[2 * i + 1] ^ SECRET[9 + 2 * i]);
+    }
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ull;
+    return h ^ (h >> 32);
+  }
+
+
+  // ----------------- Scalar -----------------
+
+  void accumulateScalar(std::uint64_t* lanes, const std::uint8_t* data, const std::size_t stripes) {
+    for (std::size_t s = 0; s < stripes; s++, data += STRIPE_BYTES) {
+      for (int i = 0; i < 8; i++) {
+        const std::uint64_t value = read64(data + i * 8);
+        const std::uint64_t keyed = value ^ SECRET[i];
+        lanes[i ^ 1] += value;
+        lanes[i] += (keyed & 0xFFFFFFFFu) * (keyed >> 32);
+      }
+    }
+  }
+
+
+#ifdef CPU_FEATURES_X86
+  // ----------------- SSE2 -----------------
+
+  void accumulateSse2(std::uint64_t* lanes, const std::uint8_t* data, const std::size_t stripes) {
+    __m128i acc[4];
+    __m128i key[4];
+    for (int j = 0; j < 4; j++) {
+      acc[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes + j * 2));
+      key[j] = _mm_load_si128(reinterpret_cast<const __m128i*>(SECRET.data() + j * 2));
+    }
+    for (std::size_t s = 0; s < stripes; s++, data += STRIPE_BYTES) {
+      for (int j = 0; j < 4; j++) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + j * 16));
+        const __m128i keyed = _mm_xor_si128(value, key[j]);
+        const __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1))); // Low half times high half
+        const __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));                       // Neighbouring word
+        acc[j] = _mm_add_epi64(acc[j], _mm_add_epi64(product, swapped));
+      }
+    }
+    for (int j = 0; j < 4; j++) _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + j * 2), acc[j]);
+  }
+
+
+  // ----------------- AVX2 -----------------
+
+  CPU_FEATURES_AVX2_TARGET
+  void accumulateAvx2(std::uint64_t* lanes, const std::uint8_t* data, const std::size_t stripes) {
+    __m256i acc[2];
+    __m256i key[2];
+    for (int j = 0; j < 2; j++) {
+      acc[j] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes + j * 4));
+      key[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(SECRET.data() + j * 4));
+    }
+    for (std::size_t s = 0; s < stripes; s++, data += STRIPE_BYTES) {
+      for (int j = 0; j < 2; j++) {
+        const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + j * 32));
+        const __m256i keyed = _mm256_xor_si256(value, key[j]);
+        const __m256i product = _mm256_mul_epu32(keyed, _mm256_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+        const __m256i swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+        acc[j] = _mm256_add_epi64(acc[j], _mm256_add_epi64(product, swapped));
+      }
+    }
+    for (int j = 0; j < 2; j++) _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes + j * 4), acc[j]);
+    _mm256_zeroupper();
+  }
+#endif // CPU_FEATURES_X86
+
+
+  std::vector<TileHashKernels> buildSupported() {
+    std::vector<TileHashKernels> sets;
+    sets.push_back(TileHashKernels{ "scalar", accumulateScalar });
+#ifdef CPU_FEATURES_X86
+    sets.push_back(TileHashKernels{ "sse2", accumulateSse2 });
+    if (cpuHasAvx2()) sets.push_back(TileHashKernels{ "avx2", accumulateAvx2 });
+#endif
+    return sets;
+  }
+
+
+  constexpr std::uint64_t LANES_INIT[8] = { PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1 };
+
+
+  /**
+   * @brief Adds one row of a tile to its lanes
+   */
+  inline void accumulateRow(const TileHashKernels& kernels, std::uint64_t* lanes, const std::uint8_t* row, const std::size_t row_bytes) {
+    const std::size_t stripes = row_bytes / STRIPE_BYTES;
+    const std::size_t tail = row_bytes % STRIPE_BYTES;
+    kernels.accumulate(lanes, row, stripes);
+    if (tail != 0) {
+      std::uint8_t last[STRIPE_BYTES] = {}; // Zero padded to a stripe
+      std::memcpy(last, row + stripes * STRIPE_BYTES, tail);
+      kernels.accumulate(lanes, last, 1);
+    }
+    scramble(lanes);
+  }
+}
+
+
+const std::vector<TileHashKernels>& supportedTileHashKernels() {
+  static const std::vector<TileHashKernels> SUPPORTED = buildSupported();
+  return SUPPORTED;
+}
+
+
+const TileHashKernels& tileHashKernels() {
+  return supportedTileHashKernels().back();
+}
+
+
+void hashTiles(const std::uint8_t* bgra, const std::ptrdiff_t stride, const int width, const int height,
+  TileHashes& out, const TileHashKernels* kernels) {
+  const TileHashKernels& k = kernels ? *kernels : tileHashKernels();
+  out.width = std::max(width, 0);
+  out.height = std::max(height, 0);
+  out.columns = (out.width + HASH_TILE_SIZE - 1) / HASH_TILE_SIZE;
+  out.rows = (out.height + HASH_TILE_SIZE - 1) / HASH_TILE_SIZE;
+  out.tiles.resize(static_cast<std::size_t>(out.columns) * out.rows);
+
+  // A band of tiles at a time, read row by row so memory streams in order
+  std::vector<std::uint64_t> lanes(static_cast<std::size_t>(out.columns) * 8);
+  for (int ty = 0; ty < out.rows; ty++) {
+    const int y = ty * HASH_TILE_SIZE;
+    const int rows = std::min(HASH_TILE_SIZE, out.height - y);
+    for (int tx = 0; tx < out.columns; tx++) std::copy(LANES_INIT, LANES_INIT + 8, lanes.data() + tx * 8);
+
+    for (int row = 0; row < rows; row++) {
+      const std::uint8_t* line = bgra + (y + row) * stride;
+      for (int tx = 0; tx < out.columns; tx++) {
+        const int x = tx * HASH_TILE_SIZE;
+        const std::size_t row_bytes = static_cast<std::size_t>(std::min(HASH_TILE_SIZE, out.width - x)) * 4;
+        accumulateRow(k, lanes.data() + tx * 8, line + static_cast<std::ptrdiff_t>(x) * 4, row_bytes);
+      }
+    }
+
+    for (int tx = 0; tx < out.columns; tx++) {
+      const std::size_t row_bytes = static_cast<std::size_t>(std::min(HASH_TILE_SIZE, out.width - tx * HASH_TILE_SIZE)) * 4;
+      out.tiles[static_cast<std::size_t>(ty) * out.columns + tx] = merge(lanes.data() + tx * 8, static_cast<std::uint64_t>(row_bytes) * rows);
+    }
+  }
+}
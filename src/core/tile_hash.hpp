@@ -0,0 +1,87 @@
+#ifndef TILE_HASH_HPP
+#define TILE_HASH_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+inline constexpr int HASH_TILE_SIZE = 64; // Pixels per side of a hashed tile, edge tiles are smaller
+
+
+/**
+ * @brief One implementation of the hash's inner loop, for one vector width
+ *
+ * The hash works like XXH3: 8 64-bit lanes take 64-byte stripes, each lane adds the
+ * neighbouring input word and the product of the two halves of its word xor a key.
+ * Every set gives the same lanes as the scalar one.
+ */
+struct TileHashKernels {
+  const char* name; // "avx2", "sse2" or "scalar"
+
+  // Adds `stripes` 64-byte stripes of data to the 8 lanes
+  void (*accumulate)(std::uint64_t* lanes, const std::uint8_t* data, const std::size_t stripes);
+};
+
+
+/**
+ * @brief Hashes of every tile of an image
+ */
+struct TileHashes {
+  int width = 0;  // Pixels hashed
+  int height = 0;
+  int columns = 0; // Tiles across
+  int rows = 0;    // Tiles down
+  std::vector<std::uint64_t> tiles; // Row-major
+
+
+  /**
+   * @brief Checks if two images were hashed at the same size, tiles only compare then
+   */
+  bool sameSize(const TileHashes& other) const {
+    return width == other.width && height == other.height;
+  }
+
+
+  bool operator==(const TileHashes& other) const {
+    return sameSize(other) && tiles == other.tiles;
+  }
+
+
+  bool operator!=(const TileHashes& other) const {
+    return !(*this == other);
+  }
+};
+
+
+/**
+ * @brief Gets the kernels picked for this CPU
+ * @returns const TileHashKernels&: Kernels, the same for the whole run
+ */
+const TileHashKernels& tileHashKernels();
+
+
+/**
+ * @brief Gets every kernel set this CPU can run, for benchmarks and checks
+ * @returns const std::vector<TileHashKernels>&: Scalar first, then narrowest to widest
+ */
+const std::vector<TileHashKernels>& supportedTileHashKernels();
+
+
+/**
+ * @brief Hashes an image in HASH_TILE_SIZE tiles
+ *
+ * NOTE: Not cryptographic, meant to tell a repainted tile from an unchanged one.
+ * @param bgra: First pixel, top-down
+ * @param stride: Bytes from one row to the next
+ * @param width: Width in pixels
+ * @param height: Height in pixels
+ * @param out: Receives the hashes, reusing its capacity
+ * @param kernels: Kernel set to use, null for tileHashKernels()
+ */
+void hashTiles(const std::uint8_t* bgra, const std::ptrdiff_t stride, const int width, const int height,
+  TileHashes& out, const TileHashKernels* kernels = nullptr);
+
+
+#endif // TILE_HASH_HPP
@@ -0,0 +1,152 @@
+#include "title_arena.hpp"
+
+#include <cstring>
+#include <functional>
+
+
+// ----------------- TitleArena -----------------
+
+std::uint64_t TitleArena::hash(const std::string_view str) {
+  std::uint64_t h = 14695981039346656037ull; // FNV offset basis
+  for (const char c : str) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull; // FNV prime
+  }
+  return h;
+}
+
+
+void TitleArena::_compact() {
+  std::vector<char> compacted;
+  compacted.reserve(_chars.size() - _garbage);
+
+  for (_Entry& e : _entries) {
+    if (e.refs == 0) continue;
+
+    const std::uint32_t offset = static_cast<std::uint32_t>(compacted.size());
+    const char* src = _chars.data() + e.offset;
+    compacted.insert(compacted.end(), src, src + e.length + 1); // Keep the NUL
+    e.offset = offset;
+  }
+
+  _chars = std::move(compacted);
+  _garbage = 0;
+}
+
+
+TitleRef TitleArena::intern(const std::string_view str) {
+  const std::uint64_t h = hash(str);
+
+  // Already stored?
+  const auto bucket = _buckets.find(h);
+  if (bucket != _buckets.end()) {
+    for (std::uint32_t i = bucket->second; i != _NO_ENTRY; i = _entries[i].next) {
+      if (view(i) == str) {
+        _entries[i].refs++;
+        return i;
+      }
+    }
+  }
+
+  // Take a free entry, or grow
+  std::uint32_t ref;
+  if (_free_head != _NO_ENTRY) {
+    ref = _free_head;
+    _free_head = _entries[ref].next;
+  }
+  else {
+    ref = static_cast<std::uint32_t>(_entries.size());
+    _entries.emplace_back();
+  }
+
+  // str may be a view of another entry, growing the buffer would free it before it's copied
+  const std::size_t end = _chars.size();
+  const std::less<const char*> before;
+  const bool aliased = !str.empty() && !before(str.data(), _chars.data()) && before(str.data(), _chars.data() + end);
+  const std::size_t from = aliased ? static_cast<std::size_t>(str.data() - _chars.data()) : 0;
+  _chars.resize(end + str.size() + 1);
+  if (!str.empty()) std::memcpy(_chars.data() + end, aliased ? _chars.data() + from : str.data(), str.size());
+  _chars[end + str.size()] = '\0';
+
+  _Entry& e = _entries[ref];
+  e.hash = h;
+  e.offset = static_cast<std::uint32_t>(end);
+  e.length = static_cast<std::uint32_t>(str.size());
+  e.refs = 1;
+
+  // Push onto the front of its hash chain
+  if (bucket != _buckets.end()) {
+    e.next = bucket->second;
+    bucket->second = ref;
+  }
+  else {
+    e.next = _NO_ENTRY;
+    _buckets.emplace(h, ref);
+  }
+
+  _live++;
+  return ref;
+}
+
+
+void TitleArena::release(const TitleRef ref) {
+  if (ref == INVALID_TITLE) return;
+
+  _Entry& e = _entries[ref];
+  if (--e.refs != 0) return;
+
+  // Unlink from its hash chain
+  const auto bucket = _buckets.find(e.hash);
+  if (bucket->second == ref) {
+    if (e.next == _NO_ENTRY) _buckets.erase(bucket);
+    else                     bucket->second = e.next;
+  }
+  else {
+    std::uint32_t prev = bucket->second;
+    while (_entries[prev].next != ref) prev = _entries[prev].next;
+    _entries[prev].next = e.next;
+  }
+
+  e.next = _free_head;
+  _free_head = ref;
+  _garbage += e.length + 1;
+  _live--;
+
+  if (_garbage > _COMPACT_MIN_GARBAGE && _garbage * 2 > _chars.size()) {
+    _compact();
+  }
+}
+
+
+// ----------------- TitleDisplayCache -----------------
+
+const TitleDisplayCache::Entry& TitleDisplayCache::get(const WindowId id, const std::string_view title, const std::uint64_t title_hash, const float max_width, const TitleFitter fit) {
+  auto [it, inserted] = _entries.try_emplace(id, Entry{ 0, 0.0f, 0.0f, INVALID_TITLE, INVALID_TITLE });
+  Entry& entry = it->second;
+
+  // Still matches, nothing to rebuild. The hash only rules out most changes, a collision has the same one
+  if (!inserted && entry.title_hash == title_hash && entry.max_width == max_width && _arena.view(entry.title) == title) {
+    return entry;
+  }
+
+  float text_width = 0.0f;
+  const std::size_t kept = fit(title, max_width, text_width);
+
+  _scratch.assign(title.data(), kept);
+  if (kept < title.size()) {
+    _scratch += "...";
+  }
+
+  // Intern first so an unchanged title or display string keeps its storage
+  const TitleRef source = _arena.intern(title);
+  const TitleRef display = _arena.intern(_scratch);
+  _arena.release(entry.title);
+  _arena.release(entry.display);
+
+  entry.title_hash = title_hash;
+  entry.max_width = max_width;
+  entry.text_width = text_width;
+  entry.title = source;
+  entry.display = display;
+  return entry;
+}
@@ -0,0 +1,222 @@
+#ifndef TITLE_ARENA_HPP
+#define TITLE_ARENA_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+#include "window_handle.hpp"
+
+
+/**
+ * @brief Handle of an interned string inside a TitleArena
+ */
+using TitleRef = std::uint32_t;
+inline constexpr TitleRef INVALID_TITLE = UINT32_MAX;
+
+
+/**
+ * @brief Reference-counted, interned storage for window titles.
+ *
+ * Every distinct string is stored once, NUL-terminated, in one shared character
+ * buffer along with its 64-bit hash. Interning a string that's already stored just
+ * bumps its reference count, so windows sharing a title ("New Tab", ...) and title
+ * storms flipping between the same few values never allocate.
+ *
+ * NOTE: Views returned by view() are invalidated by the next intern() or release(),
+ *       releasing a string may compact the buffer under every other one.
+ */
+class TitleArena {
+  private:
+    static constexpr std::uint32_t _NO_ENTRY = UINT32_MAX;
+    static constexpr std::size_t _COMPACT_MIN_GARBAGE = 4096; // Bytes of dead strings before compacting
+
+    /**
+     * @brief One interned string
+     */
+    struct _Entry {
+      std::uint64_t hash;
+      std::uint32_t offset;
+      std::uint32_t length; // Excludes the NUL terminator
+      std::uint32_t refs;   // 0 = free
+      std::uint32_t next;   // Next entry with the same hash while alive, next free entry otherwise
+    };
+
+    std::vector<char> _chars;
+    std::vector<_Entry> _entries;
+    std::unordered_map<std::uint64_t, std::uint32_t> _buckets; // Hash -> first entry with that hash
+    std::uint32_t _free_head = _NO_ENTRY;
+    std::size_t _garbage = 0; // Bytes of released strings still in _chars
+    std::size_t _live = 0;    // Amount of live entries
+
+
+    /**
+     * @brief Rewrites the character buffer without the released strings
+     */
+    void _compact();
+
+  public:
+    /**
+     * @brief Hashes a string the same way the arena does (64-bit FNV-1a)
+     * @param str: String to hash
+     * @returns std::uint64_t: Hash
+     */
+    static std::uint64_t hash(const std::string_view str);
+
+
+    /**
+     * @brief Stores a string, or adds a reference to it if it's already stored
+     *
+     * NOTE: str may be a view() of this arena.
+     * @param str: String to intern
+     * @returns TitleRef: Handle holding one reference
+     */
+    TitleRef intern(const std::string_view str);
+
+
+    /**
+     * @brief Adds a reference to a stored string
+     * @param ref: Handle of the string
+     */
+    void retain(const TitleRef ref) {
+      _entries[ref].refs++;
+    }
+
+
+    /**
+     * @brief Drops a reference, the string is freed when none are left
+     * @param ref: Handle of the string (INVALID_TITLE is ignored)
+     */
+    void release(const TitleRef ref);
+
+
+    /**
+     * @brief Gets a stored string
+     * @param ref: Handle of the string
+     * @returns std::string_view: NUL-terminated view, valid until the next intern() or release()
+     */
+    std::string_view view(const TitleRef ref) const {
+      const _Entry& e = _entries[ref];
+      return std::string_view(_chars.data() + e.offset, e.length);
+    }
+
+
+    /**
+     * @brief Gets the hash of a stored string
+     * @param ref: Handle of the string
+     * @returns std::uint64_t: Hash
+     */
+    std::uint64_t hashOf(const TitleRef ref) const {
+      return _entries[ref].hash;
+    }
+
+
+    /**
+     * @brief Gets the amount of distinct strings stored
+     * @returns std::size_t: String count
+     */
+    std::size_t size() const {
+      return _live;
+    }
+
+
+    /**
+     * @brief Gets the size of the character buffer
+     * @returns std::size_t: Bytes, including dead strings that haven't been compacted yet
+     */
+    std::size_t bytes() const {
+      return _chars.size();
+    }
+};
+
+
+/**
+ * @brief Caches the shortened, display-ready form of every window title.
+ *
+ * A display string is only rebuilt when the window's title or the width it has
+ * to fit in changes, every other frame reuses it (and its measured width) as is.
+ */
+class TitleDisplayCache {
+  public:
+    /**
+     * @brief Measures how much of a title fits in a width
+     * @param title: Full title
+     * @param max_width: Width the display string must fit in (including "...")
+     * @param text_width: Filled in with the width of the display string
+     * @returns std::size_t: Bytes of the title kept, "..." is appended if less than title.size()
+     */
+    using TitleFitter = std::size_t (*)(std::string_view title, float max_width, float& text_width);
+
+    /**
+     * @brief Display form of one window's title
+     */
+    struct Entry {
+      std::uint64_t title_hash; // Hash of the title it was built from
+      float max_width;          // Width it was built for
+      float text_width;         // Measured width of the display string
+      TitleRef title;           // Title it was built from inside the cache's arena, hashes can collide
+      TitleRef display;         // Display string inside the cache's arena
+    };
+
+  private:
+    TitleArena _arena;
+    std::unordered_map<WindowId, Entry> _entries;
+    std::string _scratch; // Reused while building display strings
+
+  public:
+    /**
+     * @brief Gets the display form of a title, rebuilding it only if the title or width changed
+     * @param id: Window the title belongs to
+     * @param title: Current title of the window
+     * @param title_hash: Hash of the current title (TitleArena::hash)
+     * @param max_width: Width the display string must fit in
+     * @param fit: Function used to measure the title
+     * @returns const Entry&: Display form
+     */
+    const Entry& get(const WindowId id, const std::string_view title, const std::uint64_t title_hash, const float max_width, const TitleFitter fit);
+
+
+    /**
+     * @brief Gets the text of a display form
+     * @param entry: Entry returned by get()
+     * @returns std::string_view: NUL-terminated display string, valid until the next get() or prune()
+     */
+    std::string_view text(const Entry& entry) const {
+      return _arena.view(entry.display);
+    }
+
+
+    /**
+     * @brief Drops the entries of windows that are gone
+     * @tparam IsAlive: Callable taking a WindowId and returning bool
+     */
+    template <typename IsAlive>
+    void prune(IsAlive is_alive) {
+      for (auto it = _entries.begin(); it != _entries.end();) {
+        if (is_alive(it->first)) {
+          ++it;
+          continue;
+        }
+
+        _arena.release(it->second.title);
+        _arena.release(it->second.display);
+        it = _entries.erase(it);
+      }
+    }
+
+
+    /**
+     * @brief Gets the amount of cached display strings
+     * @returns std::size_t: Entry count
+     */
+    std::size_t size() const {
+      return _entries.size();
+    }
+};
+
+
+#endif // TITLE_ARENA_HPP
@@ -1,4 +1,5 @@
 #include "win_utils.hpp"
+#include "window_registry.hpp"
 
 // ---------------------- Instance functions ----------------------
 
@@ -63,11 +64,17 @@ bool getWindowExecutablePath(HWND hwnd, std::wstring& path) {
   DWORD pid = 0;
   GetWindowThreadProcessId(hwnd, &pid);
 
+  return getProcessExecutablePath(pid, path);
+}
+
+
+bool getProcessExecutablePath(const std::uint32_t pid, std::wstring& path) {
   // Valid process id
   if (!pid) return false;
 
+  // Limited information is all the image name needs, and also opens elevated processes
   HANDLE h_process = OpenProcess(
-    PROCESS_QUERY_INFORMATION | PROCESS_VM_READ,
+    PROCESS_QUERY_LIMITED_INFORMATION,
     FALSE,
     pid
   );
@@ -94,29 +101,38 @@ bool getWindowExecutablePath(HWND hwnd, std::wstring& path) {
 }
 
 
-HICON getIconFromHwnd(HWND hwnd) {
-  // 1) Try big icon (taskbar / alt-tab)
-  HICON h_icon = (HICON)SendMessage(hwnd, WM_GETICON, ICON_BIG, 0);
-  if (h_icon) return h_icon;
+bool getIconFromHwnd(HWND hwnd, HICON& icon, const UINT timeout_ms) {
+  icon = nullptr;
 
-  // 2) Try small icon (title bar)
-  h_icon = (HICON)SendMessage(hwnd, WM_GETICON, ICON_SMALL, 0);
-  if (h_icon) return h_icon;
+  // Would only time out, don't queue anything on it
+  if (IsHungAppWindow(hwnd)) return false;
 
+  // 1) Try big icon (taskbar / alt-tab)
+  // 2) Try small icon (title bar)
   // 3) Try small icon (alternate)
-  h_icon = (HICON)SendMessage(hwnd, WM_GETICON, ICON_SMALL2, 0);
-  if (h_icon) return h_icon;
+  for (const WPARAM type : { ICON_BIG, ICON_SMALL, ICON_SMALL2 }) {
+    DWORD_PTR result = 0;
+    if (!SendMessageTimeout(hwnd, WM_GETICON, type, 0, SMTO_ABORTIFHUNG | SMTO_ERRORONEXIT, timeout_ms, &result)) {
+      if (GetLastError() == ERROR_TIMEOUT) return false;
+      break; // Gone or refused, the class icon needs no answer
+    }
+
+    icon = (HICON)result;
+    if (icon) return true;
+  }
 
   // 4) Fallback to class icon
-  h_icon = (HICON)GetClassLongPtr(hwnd, GCLP_HICON);
-  if (h_icon) return h_icon;
+  icon = (HICON)GetClassLongPtr(hwnd, GCLP_HICON);
+  if (icon) return true;
 
-  h_icon = (HICON)GetClassLongPtr(hwnd, GCLP_HICONSM);
-  return h_icon;
+  icon = (HICON)GetClassLongPtr(hwnd, GCLP_HICONSM);
+  return true;
 }
 
 
-ID3D11ShaderResourceView* createTextureFromIcon(ID3D11Device* device, HICON icon, const int size) {
+bool iconToBGRA(HICON icon, const int size, std::vector<uint8_t>& pixels) {
+  if (!icon) return false;
+
   // Create DIB (32-bit BGRA)
   BITMAPV5HEADER bi{};
   bi.bV5Size        = sizeof(bi);
@@ -137,65 +153,193 @@ ID3D11ShaderResourceView* createTextureFromIcon(ID3D11Device* device, HICON icon
     DIB_RGB_COLORS, &bits, nullptr, 0
   );
 
-  HDC memDC = CreateCompatibleDC(hdc);
-  SelectObject(memDC, bmp);
+  bool ok = false;
+  if (bmp) {
+    HDC memDC = CreateCompatibleDC(hdc);
+    HGDIOBJ old = SelectObject(memDC, bmp);
+
+    ok = DrawIconEx(memDC, 0, 0, icon, size, size, 0, nullptr, DI_NORMAL);
+    GdiFlush();
+    if (ok) {
+      const std::uint8_t* src = static_cast<const std::uint8_t*>(bits);
+      pixels.assign(src, src + static_cast<std::size_t>(size) * size * 4);
+    }
+
+    SelectObject(memDC, old);
+    DeleteDC(memDC);
+    DeleteObject(bmp);
+  }
+  ReleaseDC(nullptr, hdc);
+
+  return ok;
+}
+
 
-  DrawIconEx(memDC, 0, 0, icon, size, size, 0, nullptr, DI_NORMAL);
+ID3D11ShaderResourceView* createTextureFromBGRA(ID3D11Device* device, const std::uint8_t* pixels, const int width, const int height,
+  const int mip_levels, const bool updatable) {
+  if (mip_levels < 1 || mip_levels > D3D11_REQ_MIP_LEVELS) return nullptr;
 
-  // Create D3D texture directly from DIB memory
   D3D11_TEXTURE2D_DESC desc{};
-  desc.Width = size;
-  desc.Height = size;
-  desc.MipLevels = 1;
+  desc.Width = width;
+  desc.Height = height;
+  desc.MipLevels = mip_levels;
   desc.ArraySize = 1;
   desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
   desc.SampleDesc.Count = 1;
-  desc.Usage = D3D11_USAGE_IMMUTABLE;
+  desc.Usage = updatable ? D3D11_USAGE_DEFAULT : D3D11_USAGE_IMMUTABLE;
   desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 
-  D3D11_SUBRESOURCE_DATA data{};
-  data.pSysMem = bits;
-  data.SysMemPitch = size * 4;
+  // Left undefined by D3D11 without initial data
+  std::vector<std::uint8_t> zeros;
+  if (!pixels) {
+    zeros.resize(mipLevelOffset(ThumbnailSize{ width, height }, mip_levels));
+    pixels = zeros.data();
+  }
+
+  // One subresource per level, stored back to back
+  D3D11_SUBRESOURCE_DATA data[D3D11_REQ_MIP_LEVELS]{};
+  for (int level = 0; level < mip_levels; level++) {
+    const ThumbnailSize size = mipLevelSize(ThumbnailSize{ width, height }, level);
+    data[level].pSysMem = pixels + mipLevelOffset(ThumbnailSize{ width, height }, level);
+    data[level].SysMemPitch = size.width * 4;
+  }
 
   ID3D11Texture2D* tex = nullptr;
   ID3D11ShaderResourceView* srv = nullptr;
 
-  device->CreateTexture2D(&desc, &data, &tex);
+  if (FAILED(device->CreateTexture2D(&desc, data, &tex))) return nullptr;
   device->CreateShaderResourceView(tex, nullptr, &srv);
 
   tex->Release();
+  return srv;
+}
 
-  DeleteDC(memDC);
-  DeleteObject(bmp);
-  ReleaseDC(nullptr, hdc);
 
-  return srv;
+ImTextureID D3D11TextureUploader::create(const std::uint8_t* pixels, const int width, const int height, const int mip_levels) {
+  if (!_device) return ImTextureID_Invalid;
+  ID3D11ShaderResourceView* srv = createTextureFromBGRA(_device, pixels, width, height, mip_levels, true);
+  return srv ? reinterpret_cast<ImTextureID>(srv) : ImTextureID_Invalid;
+}
+
+
+bool D3D11TextureUploader::update(const ImTextureID tex, const int level, const TileRect& rect, const std::uint8_t* first,
+  const std::ptrdiff_t stride) {
+  if (!_context || tex == ImTextureID_Invalid) return false;
+
+  ID3D11Resource* resource = nullptr;
+  reinterpret_cast<ID3D11ShaderResourceView*>(tex)->GetResource(&resource);
+  if (!resource) return false;
+
+  // Copied into the driver's staging memory right away, the GPU picks it up in order with the draws
+  const D3D11_BOX box{
+    static_cast<UINT>(rect.x), static_cast<UINT>(rect.y), 0,
+    static_cast<UINT>(rect.x + rect.width), static_cast<UINT>(rect.y + rect.height), 1
+  };
+  _context->UpdateSubresource(resource, D3D11CalcSubresource(level, 0, 0), &box, first, static_cast<UINT>(stride), 0);
+  resource->Release();
+  return true;
+}
+
+
+bool D3D11TextureUploader::copy(const ImTextureID from, const ImTextureID to, const int level, const TileRect& rect, const int x, const int y) {
+  if (!_context || from == ImTextureID_Invalid || to == ImTextureID_Invalid) return false;
+
+  ID3D11Resource* src = nullptr;
+  ID3D11Resource* dst = nullptr;
+  reinterpret_cast<ID3D11ShaderResourceView*>(from)->GetResource(&src);
+  reinterpret_cast<ID3D11ShaderResourceView*>(to)->GetResource(&dst);
+  if (src && dst) {
+    const D3D11_BOX box{
+      static_cast<UINT>(rect.x), static_cast<UINT>(rect.y), 0,
+      static_cast<UINT>(rect.x + rect.width), static_cast<UINT>(rect.y + rect.height), 1
+    };
+    _context->CopySubresourceRegion(dst, D3D11CalcSubresource(level, 0, 0), static_cast<UINT>(x), static_cast<UINT>(y), 0,
+      src, D3D11CalcSubresource(level, 0, 0), &box);
+  }
+  if (src) src->Release();
+  if (dst) dst->Release();
+  return src && dst;
+}
+
+
+ID3D11SamplerState* createMipSampler(ID3D11Device* device) {
+  D3D11_SAMPLER_DESC desc{};
+  desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+  desc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+  desc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+  desc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+  desc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+  desc.MinLOD = 0.0f;
+  desc.MaxLOD = D3D11_FLOAT32_MAX;
+
+  ID3D11SamplerState* sampler = nullptr;
+  if (FAILED(device->CreateSamplerState(&desc, &sampler))) return nullptr;
+  return sampler;
+}
+
+
+void bindMipSampler(const ImDrawList*, const ImDrawCmd* cmd) {
+  const auto* state = static_cast<ImGui_ImplDX11_RenderState*>(ImGui::GetPlatformIO().Renderer_RenderState);
+  ID3D11SamplerState* sampler = static_cast<ID3D11SamplerState*>(cmd->UserCallbackData);
+  if (state && sampler) state->DeviceContext->PSSetSamplers(0, 1, &sampler);
+}
+
+
+ID3D11ShaderResourceView* createTextureFromIcon(ID3D11Device* device, HICON icon, const int size) {
+  std::vector<uint8_t> pixels;
+  if (!iconToBGRA(icon, size, pixels)) return nullptr;
+
+  return createTextureFromBGRA(device, pixels.data(), size, size);
 }
 
 
 std::string getWindowTitle(HWND hwnd) {
-  // Check if window still exists
-  if (!IsWindow(hwnd)) return "";
-  
-  const int len = GetWindowTextLengthA(hwnd);
-  std::string title(len, '\0');
-  GetWindowTextA(hwnd, title.data(), len + 1);
+  std::string title;
+  getWindowTitle(hwnd, title);
   return title;
 }
 
 
+bool getWindowTitle(HWND hwnd, std::string& title) {
+  // Check if window still exists
+  if (!IsWindow(hwnd)) {
+    title.clear();
+    return false;
+  }
+
+  // No GetWindowTextLength, it may ask the window. GetWindowText reads the stored caption
+  // of other processes' windows instead of sending WM_GETTEXT, so a title that fills the
+  // buffer may have been cut and is read again into one twice as large
+  static constexpr int MAX_TITLE_UNITS = 1 << 16;
+  wchar_t stack_buffer[512];
+  std::vector<wchar_t> heap_buffer;
+  wchar_t* buffer = stack_buffer;
+  int size = static_cast<int>(std::size(stack_buffer));
+  int len = std::max(GetWindowTextW(hwnd, buffer, size), 0);
+  while (len >= size - 1 && size < MAX_TITLE_UNITS) {
+    size *= 2;
+    heap_buffer.resize(static_cast<std::size_t>(size));
+    buffer = heap_buffer.data();
+    len = std::max(GetWindowTextW(hwnd, buffer, size), 0);
+  }
+
+  // wchar_t is UTF-16 on Windows
+  std::u16string_view text(reinterpret_cast<const char16_t*>(buffer), static_cast<std::size_t>(len));
+
+  // Still cut past MAX_TITLE_UNITS, a high surrogate whose low half was cut off would become U+FFFD
+  if (len >= size - 1 && !text.empty() && (text.back() & 0xFC00) == 0xD800) text.remove_suffix(1);
+  utf16ToUtf8(text, title);
+  return true;
+}
+
+
 bool isAltTabWindow(HWND hwnd) {
+  // Cheapest checks first, most windows on a desktop fail one of them
   if (!IsWindowVisible(hwnd)) return false;
 
-  // Exclude cloaked (hidden by Windows) windows
-  DWORD cloaked = 0;
-  if (SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked)))) {
-    if (cloaked != 0) return false;
-  }
+  // Controls inside another window, their CREATE events come through the hook too
+  if (GetWindowLongA(hwnd, GWL_STYLE) & WS_CHILD) return false;
 
-  // Must have a title
-  std::string title = getWindowTitle(hwnd);
-  
   // Exclude tool windows (small floating utility windows)
   LONG ex_style = GetWindowLongA(hwnd, GWL_EXSTYLE);
   if (ex_style & WS_EX_TOOLWINDOW) return false;
@@ -207,111 +351,172 @@ bool isAltTabWindow(HWND hwnd) {
   // If NO owner, must NOT be marked as a tool window (already checked)
   // Program Manager / shell windows usually get filtered here
 
+  // Exclude cloaked (hidden by Windows) windows, asks DWM so it goes last
+  DWORD cloaked = 0;
+  if (SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked)))) {
+    if (cloaked != 0) return false;
+  }
+
   return true;
 }
 
 
-void addWindowToAltTabList(std::vector<std::shared_ptr<WindowInfo>>& list, HWND hwnd) {
-  // Check if window still exists
-  if (!IsWindow(hwnd)) return;
-  
-  if (isAltTabWindow(hwnd) && (std::none_of(list.begin(), list.end(), [hwnd](const std::shared_ptr<WindowInfo>& w) {
-      return w->hwnd == hwnd;
-    }))) {
-    
-    list.emplace_back(std::make_shared<WindowInfo>(hwnd));
+bool getWindowTraits(HWND hwnd, WindowTraits& traits) {
+  if (!IsWindow(hwnd)) return false;
+
+  const LONG style = GetWindowLongA(hwnd, GWL_STYLE);
+  const LONG ex_style = GetWindowLongA(hwnd, GWL_EXSTYLE);
+  traits.visible = (style & WS_VISIBLE) != 0;
+  traits.child = (style & WS_CHILD) != 0;
+  traits.tool_window = (ex_style & WS_EX_TOOLWINDOW) != 0;
+  traits.app_window = (ex_style & WS_EX_APPWINDOW) != 0;
+  traits.owned = GetWindow(hwnd, GW_OWNER) != NULL;
+  traits.cloaked = false;
+
+  // Showing or uncloaking it never lets those in, only a style change would, and sweeps read it again then
+  const bool kept_out = traits.child || traits.tool_window || (traits.owned && !traits.app_window);
+  if (!kept_out) {
+    DWORD cloaked = 0;
+    traits.cloaked = SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked != 0;
   }
+  return true;
 }
 
 
-void removeWindowFromWindowInfoList(std::vector<std::shared_ptr<WindowInfo>>& list, const HWND hwnd) {
-  auto it = std::find_if(list.begin(), list.end(), [hwnd](const std::shared_ptr<WindowInfo>& w){
-    return w->hwnd == hwnd; // check if hwnd matches
-  });
-  
-  if (it != list.end()) {
-    list.erase(it);
-  }
+void updateWindowIcon(WindowRegistry& registry, const WindowId id, ID3D11Device* pd3d_device, ProcessIconTextures& icons) {
+  // Window is gone, the slot is empty, or it has one already
+  const std::optional<WindowView> info = registry.get(id);
+  if (!info || (info->flags & WINDOW_FLAG_HAS_ICON)) return;
+
+  // Shared with every window of the process. Never asked from the window here, a hung one
+  // would freeze the overlay, the icon shows up once the process cache has it
+  ID3D11ShaderResourceView* icon = icons.acquire(info->pid, pd3d_device);
+  if (icon) registry.setIcon(id, reinterpret_cast<ImTextureID>(icon));
 }
 
 
-bool updateWindowInfoListItemTitle(std::vector<std::shared_ptr<WindowInfo>>& list, const HWND hwnd) {
-  // Check if window still exists
-  if (!IsWindow(hwnd)) return false;
-  
-  auto it = std::find_if(list.begin(), list.end(), [hwnd](const std::shared_ptr<WindowInfo>& w){
-    return w->hwnd == hwnd; // check if hwnd matches
-  });
-  
-  if (it != list.end()) {
-    std::shared_ptr<WindowInfo> w = *it;
-    w->title = getWindowTitle(hwnd);
-    return true;
+ID3D11ShaderResourceView* ProcessIconTextures::acquire(const std::uint32_t pid, ID3D11Device* device) {
+  // Let go of processes the cache dropped since the last call
+  const std::uint64_t version = _processes.version();
+  if (version != _pruned_version) {
+    _pruned_version = version;
+    for (auto it = _textures.begin(); it != _textures.end();) {
+      if (_processes.find(it->first) == it->second.info) {
+        ++it;
+        continue;
+      }
+      if (it->second.srv) it->second.srv->Release();
+      it = _textures.erase(it);
+    }
   }
-  
-  // Value not found, so return false.
-  return false;
+
+  const std::shared_ptr<const ProcessInfo> info = _processes.find(pid);
+  if (!info || info->icon_bgra.empty()) return nullptr;
+
+  auto it = _textures.find(pid);
+  if (it != _textures.end() && it->second.info != info) {
+    // Reloaded since the prune
+    if (it->second.srv) it->second.srv->Release();
+    _textures.erase(it);
+    it = _textures.end();
+  }
+  if (it == _textures.end()) {
+    ID3D11ShaderResourceView* srv = createTextureFromBGRA(device, info->icon_bgra.data(), info->icon_size, info->icon_size);
+    if (!srv) return nullptr;
+    it = _textures.emplace(pid, _Texture{ info, srv }).first;
+  }
+
+  it->second.srv->AddRef();
+  return it->second.srv;
 }
 
 
-void updateWindowInfoListTextures(std::vector<std::shared_ptr<WindowInfo>>& list, ID3D11Device* pd3d_device) {
-  for (const auto& ptr : list) {
-    if (ptr == nullptr) continue;
-    
-    ID3D11ShaderResourceView* tmp = nullptr;
-    if (!buildWindowTextureFromHwnd(ptr->hwnd, tmp, pd3d_device)) continue;
+void ProcessIconTextures::clear() {
+  for (auto& [pid, texture] : _textures) {
+    if (texture.srv) texture.srv->Release();
+  }
+  _textures.clear();
+}
 
-    // Delete old texture if it exists
-    if (ptr->tex != nullptr) {
-      ptr->tex->Release();
-    }
 
-    // Only set a new texture if its valid
-    if (tmp != nullptr) {
-      ptr->tex = tmp;
-    }
+BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM l_param) {
+  auto* out = reinterpret_cast<std::vector<HWND>*>(l_param);
 
-    // If icon is null, set it.
-    if (ptr->icon == nullptr) {
-      // TODO: Find a clean way to do this only once since it only needs
-      // to happen once when you create the WindowInfo object for it.
-      ptr->icon = createTextureFromIcon(pd3d_device, getIconFromHwnd(ptr->hwnd), 128);
-    }
+  if (out) {
+    out->push_back(hwnd);
   }
+
+  return TRUE;
 }
 
 
-bool updateWindowInfoFocusTime(std::vector<std::shared_ptr<WindowInfo>>& list, const HWND hwnd) {
-  // Check if window still exists
-  if (!IsWindow(hwnd)) return false;
+void Win32WindowBackend::enumerateAltTab(std::vector<EnumeratedWindow>& out) {
+  out.clear();
+  _handles.clear();
+  EnumWindows(EnumWindowsProc, (LPARAM)&_handles);
 
-  for (const auto& ptr : list) {
-    if (ptr->hwnd == hwnd) {
-      ptr->last_focused = std::chrono::steady_clock::now();
-      return true;
-    }
+  // Classify everything first, only the survivors get their title fetched
+  for (const HWND hwnd : _handles) {
+    if (!isAltTabWindow(hwnd)) continue;
+
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+    out.push_back(EnumeratedWindow{ hwnd, getWindowTitle(hwnd), static_cast<std::uint32_t>(pid) });
   }
+}
 
-  // HWND did not exist in the list
-  return false;
+
+bool Win32WindowBackend::topLevelWindows(std::vector<HWND>& out) {
+  out.clear();
+  return EnumWindows(EnumWindowsProc, (LPARAM)&out) != FALSE;
 }
 
 
-BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM l_param) {
-  auto* list = reinterpret_cast<std::vector<std::shared_ptr<WindowInfo>>*>(l_param);
+bool Win32WindowBackend::title(const HWND hwnd, std::string& title) {
+  return getWindowTitle(hwnd, title);
+}
+
+
+bool Win32WindowBackend::traits(const HWND hwnd, WindowTraits& traits) {
+  return getWindowTraits(hwnd, traits);
+}
+
 
-  if (list) {
-    addWindowToAltTabList(*list, hwnd);
+std::uint32_t Win32WindowBackend::processId(const HWND hwnd) {
+  DWORD pid = 0;
+  if (!GetWindowThreadProcessId(hwnd, &pid)) return 0;
+  return static_cast<std::uint32_t>(pid);
+}
+
+
+bool Win32WindowBackend::processInfo(const HWND hwnd, ProcessInfo& info, const std::uint32_t timeout_ms) {
+  if (getProcessExecutablePath(info.pid, info.exe_path)) {
+    const std::wstring file_name = std::filesystem::path(info.exe_path).filename().wstring();
+    const int len = WideCharToMultiByte(CP_UTF8, 0, file_name.data(), static_cast<int>(file_name.size()), nullptr, 0, nullptr, nullptr);
+    info.name.resize(len);
+    WideCharToMultiByte(CP_UTF8, 0, file_name.data(), static_cast<int>(file_name.size()), info.name.data(), len, nullptr, nullptr);
   }
 
-  return TRUE;
+  HICON icon = nullptr;
+  info.icon_timed_out = !getIconFromHwnd(hwnd, icon, timeout_ms);
+  if (iconToBGRA(icon, 128, info.icon_bgra)) {
+    info.icon_size = 128;
+  }
+
+  return !info.exe_path.empty() || info.icon_size != 0 || info.icon_timed_out;
 }
 
 
-std::vector<std::shared_ptr<WindowInfo>> getAllAltTabWindows() {
-  std::vector<std::shared_ptr<WindowInfo>> results;
-  EnumWindows(EnumWindowsProc, (LPARAM)&results);
-  return results;
+bool Win32WindowBackend::capture(const HWND hwnd, std::vector<std::uint8_t>& bgra, int& width, int& height) {
+  // PrintWindow waits on a hung window, it would keep a capture worker busy until it answers
+  if (!IsWindow(hwnd) || IsHungAppWindow(hwnd)) return false;
+
+  HBITMAP bmp = captureWindow(hwnd);
+  if (!bmp) return false;
+
+  bitmapToBGRA(bmp, bgra, width, height);
+  DeleteObject(bmp);
+  return true;
 }
 
 
@@ -326,6 +531,12 @@ void focusWindow(HWND hwnd) {
 
 // --------------------- Window Capturing ---------------------
 
+void releaseTexture(ImTextureID tex) {
+  if (tex == ImTextureID_Invalid) return;
+  reinterpret_cast<ID3D11ShaderResourceView*>(tex)->Release();
+}
+
+
 std::pair<UINT, UINT> getTexture2DDim(ID3D11ShaderResourceView* tex) {
   if (!tex) return {0, 0};
 
@@ -361,6 +572,25 @@ void bitmapToBGRA(HBITMAP bmp, std::vector<uint8_t>& pixels) {
 
 
 void bitmapToBGRA(HBITMAP bmp, std::vector<uint8_t>& pixels, int& width, int& height) {
+  // DIB sections (captureWindow) are read straight from their memory, alpha filled on the way
+  DIBSECTION dib;
+  if (GetObject(bmp, sizeof(dib), &dib) == sizeof(dib) && dib.dsBm.bmBits && dib.dsBm.bmBitsPixel == 32) {
+    width = dib.dsBm.bmWidth;
+    height = dib.dsBm.bmHeight;
+    pixels.resize(static_cast<std::size_t>(width) * height * 4);
+    GdiFlush(); // GDI may still be drawing into it
+
+    // Bottom-up DIBs start at their last row
+    const std::uint8_t* bits = static_cast<const std::uint8_t*>(dib.dsBm.bmBits);
+    std::ptrdiff_t stride = dib.dsBm.bmWidthBytes;
+    if (dib.dsBmih.biHeight > 0) {
+      bits += static_cast<std::ptrdiff_t>(height - 1) * stride;
+      stride = -stride;
+    }
+    copyRows(bits, stride, pixels.data(), static_cast<std::ptrdiff_t>(width) * 4, width, height, true);
+    return;
+  }
+
   BITMAP info;
   GetObject(bmp, sizeof(BITMAP), &info);
   width = info.bmWidth;
@@ -375,15 +605,13 @@ void bitmapToBGRA(HBITMAP bmp, std::vector<uint8_t>& pixels, int& width, int& he
   bi.bmiHeader.biBitCount = 32;
   bi.bmiHeader.biCompression = BI_RGB;
 
-  pixels.resize(width * height * 4);
+  pixels.resize(static_cast<std::size_t>(width) * height * 4);
   HDC hdc = CreateCompatibleDC(NULL);
   GetDIBits(hdc, bmp, 0, height, pixels.data(), &bi, DIB_RGB_COLORS);
   DeleteDC(hdc);
 
-  // Alpha shall be 255 for all places.
-  for (size_t i = 0; i < pixels.size(); i += 4) {
-    pixels[i + 3] = 255; // set alpha to opaque
-  }
+  // GDI leaves alpha at 0, the texture is opaque
+  fillAlpha(pixels.data(), static_cast<std::size_t>(width) * height);
 }
 
 
@@ -420,39 +648,37 @@ ID3D11ShaderResourceView* bitmapToShaderResourceView(HBITMAP h_bmp, ID3D11Device
 
 
 HBITMAP scaleBitmap(HBITMAP src_bitmap, const int new_width, const int new_height) {
-  // Get source bitmap info
-  BITMAP bmp;
-  GetObject(src_bitmap, sizeof(BITMAP), &bmp);
-
-  const int src_width  = bmp.bmWidth;
-  const int src_height = bmp.bmHeight;
+  if (new_width <= 0 || new_height <= 0) return nullptr;
 
-  // Create compatible DCs
-  HDC src_hdc = CreateCompatibleDC(NULL);
-  HDC dest_hdc = CreateCompatibleDC(NULL);
-
-  HBITMAP h_old_src = (HBITMAP)SelectObject(src_hdc, src_bitmap);
-
-  // Create destination bitmap
-  HBITMAP dest_bitmap = CreateCompatibleBitmap(src_hdc, new_width, new_height);
-  HBITMAP h_old_dest = (HBITMAP)SelectObject(dest_hdc, dest_bitmap);
+  std::vector<uint8_t> pixels;
+  int src_width;
+  int src_height;
+  bitmapToBGRA(src_bitmap, pixels, src_width, src_height);
 
-  // High-quality scaling
-  SetStretchBltMode(dest_hdc, HALFTONE); // better than COLORONCOLOR
+  // Area average in linear light, like HALFTONE but without darkening text and thin lines
+  ScaleOptions options;
+  options.filter = ScaleFilter::BOX;
+  options.linear_light = true;
 
-  // Copy & scale
-  StretchBlt(
-    dest_hdc, 0, 0, new_width, new_height,
-    src_hdc, 0, 0, src_width, src_height,
-    SRCCOPY
-  );
+  // Scaled straight into a top-down DIB section, bitmapToBGRA() reads it back without GDI
+  BITMAPINFO bi;
+  ZeroMemory(&bi, sizeof(bi));
+  bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bi.bmiHeader.biWidth = new_width;
+  bi.bmiHeader.biHeight = -new_height; // top-down
+  bi.bmiHeader.biPlanes = 1;
+  bi.bmiHeader.biBitCount = 32;
+  bi.bmiHeader.biCompression = BI_RGB;
 
-  // Cleanup
-  SelectObject(src_hdc, h_old_src);
-  SelectObject(dest_hdc, h_old_dest);
-  DeleteDC(src_hdc);
-  DeleteDC(dest_hdc);
+  void* bits = nullptr;
+  HBITMAP dest_bitmap = CreateDIBSection(NULL, &bi, DIB_RGB_COLORS, &bits, NULL, 0);
+  if (!dest_bitmap) return nullptr;
 
+  if (!scaleImage(pixels.data(), static_cast<std::ptrdiff_t>(src_width) * 4, src_width, src_height,
+    static_cast<uint8_t*>(bits), static_cast<std::ptrdiff_t>(new_width) * 4, new_width, new_height, options)) {
+    DeleteObject(dest_bitmap);
+    return nullptr;
+  }
   return dest_bitmap; // caller must DeleteObject()
 }
 
@@ -481,7 +707,17 @@ HBITMAP captureWindow(HWND hwnd) {
     return nullptr;
   }
 
-  HBITMAP h_bitmap = CreateCompatibleBitmap(h_dc, width, height);
+  // Top-down 32-bit DIB section, so bitmapToBGRA reads its memory instead of converting it with GetDIBits
+  BITMAPINFO bi{};
+  bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bi.bmiHeader.biWidth = width;
+  bi.bmiHeader.biHeight = -height;
+  bi.bmiHeader.biPlanes = 1;
+  bi.bmiHeader.biBitCount = 32;
+  bi.bmiHeader.biCompression = BI_RGB;
+
+  void* bits = nullptr;
+  HBITMAP h_bitmap = CreateDIBSection(h_dc, &bi, DIB_RGB_COLORS, &bits, nullptr, 0);
   if (h_bitmap == nullptr) {
     DeleteDC(h_mem_dc);
     ReleaseDC(hwnd, h_dc);
@@ -14,11 +14,24 @@
 #include <memory>
 #include <chrono>
 #include <filesystem>
+#include <unordered_map>
 #include <d3d11.h>
 #include <windows.h>
 #include <dwmapi.h>
 #include <psapi.h>
 
+#include "imgui.h"
+#include "backends/imgui_impl_dx11.h"
+
+#include "window_handle.hpp"
+#include "window_backend.hpp"
+#include "process_cache.hpp"
+#include "text_encoding.hpp"
+#include "pixel_kernels.hpp"
+#include "image_scaler.hpp"
+#include "thumbnail_mips.hpp"
+#include "texture_uploader.hpp"
+
 #pragma comment(lib, "dwmapi.lib")
 #pragma comment(lib, "psapi.lib")
 
@@ -30,7 +43,7 @@
 
 // ---------------------- Struct definitions ----------------------
 
-struct WindowInfo;
+class WindowRegistry;
 
 
 // ---------------------- Instance functions ----------------------
@@ -70,11 +83,88 @@ bool getWindowExecutablePath(HWND hwnd, std::wstring& path);
 
 
 /**
- * @brief Given an hwnd, get its HICON
+ * @brief Given a process id, find its exe in the windows filesystem
+ * @param pid: Id of a process
+ * @param path: Output variable for the path
+ * @returns bool: Success of process
+ */
+bool getProcessExecutablePath(const std::uint32_t pid, std::wstring& path);
+
+
+/**
+ * @brief Given an hwnd, get its HICON, without waiting on it for longer than a timeout
+ *
+ * NOTE: Hung windows aren't sent anything, they fail right away.
  * @param hwnd: Hanlde of a window
- * @returns HICON: Icon object
+ * @param icon: Output variable for the icon, null if the window has none
+ * @param timeout_ms: Longest wait for each WM_GETICON
+ * @returns bool: False if the window is hung or didn't answer in time
+ */
+bool getIconFromHwnd(HWND hwnd, HICON& icon, const UINT timeout_ms);
+
+
+/**
+ * @brief Draws an icon into a BGRA buffer
+ * @param icon: Icon object
+ * @param size: Size of the icon in pixels
+ * @param pixels: Resized to size * size * 4, receives the BGRA pixels, top-down
+ * @returns bool: False if the icon is null or couldn't be drawn
+ */
+bool iconToBGRA(HICON icon, const int size, std::vector<uint8_t>& pixels);
+
+
+/**
+ * @brief Creates a texture from BGRA pixels
+ * @param device: Rendering device
+ * @param pixels: width * height * 4 BGRA pixels, top-down, then the smaller mip levels back to back. Null for zeros
+ * @param width: Width in pixels
+ * @param height: Height in pixels
+ * @param mip_levels: Levels in pixels, see buildMipChain()
+ * @param updatable: Allows UpdateSubresource() on it, immutable otherwise
+ * @returns ID3D11ShaderResourceView*: DirectX11 texture, or nullptr on failure
+ */
+ID3D11ShaderResourceView* createTextureFromBGRA(ID3D11Device* device, const std::uint8_t* pixels, const int width, const int height,
+  const int mip_levels = 1, const bool updatable = false);
+
+
+/**
+ * @brief Thumbnail textures on a DirectX11 device, updated in place with UpdateSubresource()
  */
-HICON getIconFromHwnd(HWND hwnd);
+class D3D11TextureUploader : public TextureUploader {
+  private:
+    ID3D11Device* _device = nullptr;
+    ID3D11DeviceContext* _context = nullptr;
+
+  public:
+    /**
+     * @brief Sets the device textures are created on, null until there's one
+     */
+    void setDevice(ID3D11Device* device, ID3D11DeviceContext* context) {
+      _device = device;
+      _context = context;
+    }
+
+    ImTextureID create(const std::uint8_t* pixels, const int width, const int height, const int mip_levels) override;
+    bool update(const ImTextureID tex, const int level, const TileRect& rect, const std::uint8_t* first,
+      const std::ptrdiff_t stride) override;
+    bool copy(const ImTextureID from, const ImTextureID to, const int level, const TileRect& rect, const int x, const int y) override;
+};
+
+
+/**
+ * @brief Creates a trilinear sampler that reads every mip level, ImGui's default one only reads the first
+ * @param device: Rendering device
+ * @returns ID3D11SamplerState*: Sampler, or nullptr on failure. Caller must Release()
+ */
+ID3D11SamplerState* createMipSampler(ID3D11Device* device);
+
+
+/**
+ * @brief ImGui draw callback binding the sampler in its callback data, for the draws after it
+ *
+ * NOTE: Follow the draws with ImDrawCallback_ResetRenderState to go back to ImGui's sampler.
+ */
+void bindMipSampler(const ImDrawList* draw_list, const ImDrawCmd* cmd);
 
 
 /**
@@ -89,75 +179,142 @@ ID3D11ShaderResourceView* createTextureFromIcon(ID3D11Device* device, HICON icon
 
 /**
  * @brief Gets the title of a window from its handle
+ *
+ * NOTE: Never sends a message to windows of other processes, so a hung window can't block it.
  * @param hwnd: Handle of a window
- * @returns std::string: Title of the window
+ * @returns std::string: Title of the window, UTF-8
  */
 std::string getWindowTitle(HWND hwnd);
 
 
+/**
+ * @brief Gets the title of a window into a string, reusing its capacity
+ *
+ * NOTE: Titles past 65535 UTF-16 units are cut, never inside a surrogate pair.
+ * @param hwnd: Handle of a window
+ * @param title: Replaced with the title, UTF-8
+ * @returns bool: False if the window is gone
+ */
+bool getWindowTitle(HWND hwnd, std::string& title);
+
+
 /**
  * @brief Checks if a given hwnd is an alt-tab visible window
+ *
+ * NOTE: Same rule as WindowTraits::altTab(), stopping at the first check that fails.
  * @returns bool: True/False of visibility
  */
 bool isAltTabWindow(HWND hwnd);
 
 
 /**
- * @brief Adds a window to a list if its an alt-tab window.
- * @param list: List to add to
- * @param hwnd: Window handle to check
+ * @brief Reads what decides if a window shows up in alt-tab
+ *
+ * NOTE: DWM isn't asked about the cloak of windows their styles already keep out.
+ * @param hwnd: Handle of a window
+ * @param traits: Output variable for the traits
+ * @returns bool: False if the window is gone
  */
-void addWindowToAltTabList(std::vector<std::shared_ptr<WindowInfo>>& list, HWND hwnd);
+bool getWindowTraits(HWND hwnd, WindowTraits& traits);
 
 
 /**
- * @brief Removes a window from a window info list
- * @param list: List to remove from
- * @param hwnd: Handle of the window to remove
+ * @brief Icon textures of the processes in a ProcessCache, one per process.
+ *
+ * Every window of a process gets a reference to the same texture, the registry
+ * releases its reference like any other icon. Textures of processes the cache
+ * dropped are let go on the next acquire().
+ *
+ * NOTE: UI thread only.
  */
-void removeWindowFromWindowInfoList(std::vector<std::shared_ptr<WindowInfo>>& list, const HWND hwnd);
+class ProcessIconTextures {
+  private:
+    /**
+     * @brief Texture of one process, with the entry it was made from
+     */
+    struct _Texture {
+      std::shared_ptr<const ProcessInfo> info;
+      ID3D11ShaderResourceView* srv;
+    };
 
+    const ProcessCache& _processes;
+    std::unordered_map<std::uint32_t, _Texture> _textures;
+    std::uint64_t _pruned_version = 0; // Cache version the textures were last checked against
 
-/**
- * @brief Sets a new title for a window if it's present in a window info list
- * @param list: List to search
- * @param hwnd: Window handle to update
- * @returns bool: True/False of success
- */
-bool updateWindowInfoListItemTitle(std::vector<std::shared_ptr<WindowInfo>>& list, const HWND hwnd);
+  public:
+    /**
+     * @brief Creates an empty set of textures
+     * @param processes: Cache the icons come from
+     */
+    explicit ProcessIconTextures(const ProcessCache& processes)
+      : _processes(processes) {}
 
 
-/**
- * @brief Updates the stored textures for every WindowInfo object in a list
- * @param list: List to update
- * @param pd3d_device: Device used to render with
- */
-void updateWindowInfoListTextures(std::vector<std::shared_ptr<WindowInfo>>& list, ID3D11Device* pd3d_device);
+    /**
+     * @brief Releases every texture still held.
+     */
+    ~ProcessIconTextures() {
+      clear();
+    }
+
+
+    ProcessIconTextures(const ProcessIconTextures&) = delete;
+    ProcessIconTextures& operator=(const ProcessIconTextures&) = delete;
+
+
+    /**
+     * @brief Gets the icon texture of a process, creating it on first use
+     * @param pid: Process id
+     * @param device: Rendering device
+     * @returns ID3D11ShaderResourceView*: New reference the caller owns, or nullptr if the process isn't loaded yet or has no icon
+     */
+    ID3D11ShaderResourceView* acquire(const std::uint32_t pid, ID3D11Device* device);
+
+
+    /**
+     * @brief Releases every texture
+     */
+    void clear();
+};
 
 
 /**
- * @brief Updates the given hwnd's last focus time in a window info list
- * @param list: List to update in
- * @param hwnd: hwnd to update
- * @returns bool: True if the hwnd exists in the list, false otherwise.
+ * @brief Sets the icon of a window if it has none yet and its process's icon is loaded
+ *
+ * NOTE: Thumbnails come from the CapturePool, never from here.
+ * @param registry: Registry that owns the window rows
+ * @param id: Handle of the window to update, stale handles are skipped
+ * @param pd3d_device: Device used to render with
+ * @param icons: Per-process icons, windows share their process's
  */
-bool updateWindowInfoFocusTime(std::vector<std::shared_ptr<WindowInfo>>& list, const HWND hwnd);
+void updateWindowIcon(WindowRegistry& registry, const WindowId id, ID3D11Device* pd3d_device, ProcessIconTextures& icons);
+
 
 /**
  * @brief Callback for EnumWindows
  * @param hwnd: hwnd to check
- * @param lParam: parameters passed to the function
+ * @param lParam: std::vector<HWND>* the handles are appended to
  * @returns BOOL: true/false of success
  */
 BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM l_param);
 
 
 /**
- * @brief Gets all the alt-tab visible windows currently active on your computer
- * NOTE: Should probably only use on startup due to performance worries.
- * @returns std::vector<std::shared_ptr<WindowInfo>>: Info about the windows
+ * @brief Window system backed by the real desktop
  */
-std::vector<std::shared_ptr<WindowInfo>> getAllAltTabWindows();
+class Win32WindowBackend : public WindowBackend {
+  private:
+    std::vector<HWND> _handles; // Reused for every enumeration
+
+  public:
+    void enumerateAltTab(std::vector<EnumeratedWindow>& out) override;
+    bool topLevelWindows(std::vector<HWND>& out) override;
+    bool title(const HWND hwnd, std::string& title) override;
+    bool traits(const HWND hwnd, WindowTraits& traits) override;
+    std::uint32_t processId(const HWND hwnd) override;
+    bool processInfo(const HWND hwnd, ProcessInfo& info, const std::uint32_t timeout_ms) override;
+    bool capture(const HWND hwnd, std::vector<std::uint8_t>& bgra, int& width, int& height) override;
+};
 
 
 /**
@@ -169,6 +326,15 @@ void focusWindow(HWND hwnd);
 
 // --------------------- Window Capturing ---------------------
 
+/**
+ * @brief Releases a DirectX11 texture stored as an ImTextureID
+ * 
+ * NOTE: Used as the WindowRegistry's texture releaser.
+ * @param tex: Texture to release
+ */
+void releaseTexture(ImTextureID tex);
+
+
 /**
  * @brief Gets the dimensions of a DirectX11 texture
  */
@@ -185,8 +351,10 @@ void bitmapToBGRA(HBITMAP bmp, std::vector<uint8_t>& pixels);
 
 /**
  * @brief Get a BGRA vector of an HBITMAP
+ *
+ * NOTE: 32-bit DIB sections are copied straight from their memory, other bitmaps go through GetDIBits.
  * @param bmp: Bitmap
- * @param pixels: Output buffer
+ * @param pixels: Output buffer, resized to width * height * 4 and always opaque
  * @param width: Filled in with the width of the vector
  * @param height: Filled in with the height of the vector
  */
@@ -203,20 +371,20 @@ ID3D11ShaderResourceView* bitmapToShaderResourceView(HBITMAP h_bmp, ID3D11Device
 
 
 /**
- * @brief Scales a bitmap to a new size
+ * @brief Scales a bitmap to a new size, with scaleImage() instead of GDI
  * 
  * NOTE: caller must DeleteObject()
  * @param src_bitmap: Original bitmap
  * @param new_width: New width
  * @param new_height: New height
- * @returns HBITMAP: Resized bitmap
+ * @returns HBITMAP: Resized top-down 32-bit DIB section, nullptr if a size is invalid
  */
 HBITMAP scaleBitmap(HBITMAP src_bitmap, const int new_width, const int new_height);
 
 /**
  * @brief Returns a bitmap of a window, regardless of its visibility
  * @param hwnd: Window handle
- * @returns HBITMAP: bitmap
+ * @returns HBITMAP: Top-down 32-bit DIB section, caller must DeleteObject()
  */
 HBITMAP captureWindow(HWND hwnd);
 
@@ -305,31 +473,6 @@ class DwmThumbnail {
 bool buildWindowTextureFromHwnd(const HWND hwnd, ID3D11ShaderResourceView*& tex, ID3D11Device* pd3d_device, const int width = -1, const int height = -1);
 
 
-// ------------------ Structs ------------------
-
-
-/**
- * @brief Holds basic information for a Windows window
- */
-struct WindowInfo {
-  WindowInfo() = default;
-  WindowInfo(HWND h) : hwnd(h), tex(nullptr) {
-    title = getWindowTitle(hwnd);
-    last_focused = std::chrono::steady_clock::now();
-  }
-  ~WindowInfo() {
-    tex->Release();
-    icon->Release();
-  }
-
-  HWND hwnd;
-  std::string title;
-  ID3D11ShaderResourceView* tex;
-  ID3D11ShaderResourceView* icon;
-  std::chrono::steady_clock::time_point last_focused;
-};
-
-
 #endif // WIN_UTILS_HPP
 
 
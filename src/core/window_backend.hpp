@@ -0,0 +1,151 @@
+#ifndef WINDOW_BACKEND_HPP
+#define WINDOW_BACKEND_HPP
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "window_handle.hpp"
+
+
+/**
+ * @brief An alt-tab window found by an enumeration, with everything the registry needs
+ */
+struct EnumeratedWindow {
+  HWND hwnd;
+  std::string title;
+  std::uint32_t pid; // 0 if unknown
+};
+
+
+/**
+ * @brief Everything that decides if a window shows up in alt-tab
+ */
+struct WindowTraits {
+  bool visible = false;
+  bool child = false;       // WS_CHILD, never listed
+  bool tool_window = false; // WS_EX_TOOLWINDOW, small floating utility windows
+  bool app_window = false;  // WS_EX_APPWINDOW, listed even with an owner
+  bool owned = false;       // Has an owner window
+  bool cloaked = false;     // Hidden by DWM (other virtual desktop, suspended app, ...)
+
+
+  /**
+   * @brief Checks if the window shows up in alt-tab
+   * @returns bool: True/False of visibility
+   */
+  bool altTab() const {
+    return visible && !child && !tool_window && (!owned || app_window) && !cloaked;
+  }
+};
+
+
+/**
+ * @brief What every window of one process has in common
+ */
+struct ProcessInfo {
+  std::uint32_t pid = 0;
+  std::wstring exe_path;               // Empty if the process can't be opened
+  std::string name;                    // File name of the exe, UTF-8
+  std::vector<std::uint8_t> icon_bgra; // icon_size * icon_size BGRA pixels, top-down, empty if none
+  int icon_size = 0;
+  bool icon_timed_out = false;         // Window was hung or didn't answer in time, worth asking again later
+};
+
+
+/**
+ * @brief Everything the window pipeline asks the window system.
+ *
+ * Win32WindowBackend (win_utils) talks to the real desktop, SimulatedDesktop stands
+ * in for it so the registry, event and capture paths can be load-tested headlessly.
+ *
+ * NOTE: Enumeration and queries come from the event thread, captures and process queries may come
+ *       from other threads.
+ */
+class WindowBackend {
+  public:
+    virtual ~WindowBackend() = default;
+
+
+    /**
+     * @brief Lists every alt-tab window, in z-order
+     *
+     * Every window is classified once and only alt-tab windows have their title fetched.
+     * @param out: Cleared, then receives the windows
+     */
+    virtual void enumerateAltTab(std::vector<EnumeratedWindow>& out) = 0;
+
+
+    /**
+     * @brief Lists every top-level window, alt-tab or not, without querying any of them
+     * @param out: Cleared, then receives the handles
+     * @returns bool: False if the desktop couldn't be listed, out may hold part of it
+     */
+    virtual bool topLevelWindows(std::vector<HWND>& out) = 0;
+
+
+    /**
+     * @brief Gets the title of a window
+     * @param hwnd: Handle of a window
+     * @param title: Output variable for the title
+     * @returns bool: False if the window is gone
+     */
+    virtual bool title(const HWND hwnd, std::string& title) = 0;
+
+
+    /**
+     * @brief Reads what decides if a window shows up in alt-tab
+     *
+     * NOTE: Whatever can't matter anymore may be left out, a cloak check on a tool window for one.
+     * @param hwnd: Handle of a window
+     * @param traits: Output variable for the traits
+     * @returns bool: False if the window is gone
+     */
+    virtual bool traits(const HWND hwnd, WindowTraits& traits) = 0;
+
+
+    /**
+     * @brief Checks if a window is an alt-tab visible window
+     * @param hwnd: Handle of a window
+     * @returns bool: True/False of visibility
+     */
+    bool isAltTab(const HWND hwnd) {
+      WindowTraits t;
+      return traits(hwnd, t) && t.altTab();
+    }
+
+
+    /**
+     * @brief Gets the process that owns a window
+     * @param hwnd: Handle of a window
+     * @returns std::uint32_t: Process id, 0 if the window is gone
+     */
+    virtual std::uint32_t processId(const HWND hwnd) = 0;
+
+
+    /**
+     * @brief Loads the exe path, name and icon of the process that owns a window
+     *
+     * NOTE: Slow, the icon is asked from the window itself. Meant for a worker thread.
+     * @param hwnd: Handle of a window of the process, used for the icon
+     * @param info: pid is already set, receives everything else that could be loaded
+     * @param timeout_ms: Longest the window is waited on, sets info.icon_timed_out when hit
+     * @returns bool: False if nothing could be loaded
+     */
+    virtual bool processInfo(const HWND hwnd, ProcessInfo& info, const std::uint32_t timeout_ms) = 0;
+
+
+    /**
+     * @brief Captures the content of a window at full size
+     * @param hwnd: Handle of a window
+     * @param bgra: Resized to width * height * 4, receives opaque BGRA pixels, top-down
+     * @param width: Filled in with the width of the capture
+     * @param height: Filled in with the height of the capture
+     * @returns bool: False if the window is gone or can't be captured
+     */
+    virtual bool capture(const HWND hwnd, std::vector<std::uint8_t>& bgra, int& width, int& height) = 0;
+};
+
+
+#endif // WINDOW_BACKEND_HPP
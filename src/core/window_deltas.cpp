@@ -0,0 +1,223 @@
+#include "window_deltas.hpp"
+
+
+// ----------------- WindowDeltaBatch -----------------
+
+void WindowDeltaBatch::push(const WindowDelta::Type type, const HWND hwnd, const std::string_view title, const std::uint32_t pid) {
+  const std::uint32_t offset = static_cast<std::uint32_t>(_titles.size());
+  _titles.insert(_titles.end(), title.begin(), title.end());
+  _deltas.push_back(WindowDelta{ type, hwnd, offset, static_cast<std::uint32_t>(title.size()), pid });
+}
+
+
+void WindowDeltaBatch::append(const WindowDeltaBatch& other) {
+  // Titles land after ours, their offsets move with them
+  const std::uint32_t shift = static_cast<std::uint32_t>(_titles.size());
+  _titles.insert(_titles.end(), other._titles.begin(), other._titles.end());
+  _deltas.reserve(_deltas.size() + other._deltas.size());
+  for (WindowDelta delta : other._deltas) {
+    delta.title_offset += shift;
+    _deltas.push_back(delta);
+  }
+}
+
+
+// ----------------- WindowDeltaBuilder -----------------
+
+void WindowDeltaBuilder::_add(const HWND hwnd, const std::string_view title, const std::uint32_t pid, WindowDeltaBatch& out) {
+  // Added mid-sweep, the sweep may have checked it already
+  _tracked.emplace(hwnd, _Tracked{ pid, _sweep_generation });
+  if (_processes) _processes->acquire(pid, hwnd);
+  out.push(WindowDelta::ADDED, hwnd, title, pid);
+}
+
+
+void WindowDeltaBuilder::_remove(const std::unordered_map<HWND, _Tracked>::iterator it, WindowDeltaBatch& out) {
+  if (_processes) _processes->release(it->second.pid);
+  out.push(WindowDelta::REMOVED, it->first);
+  _tracked.erase(it);
+}
+
+
+bool WindowDeltaBuilder::add(const HWND hwnd, WindowDeltaBatch& out) {
+  // Already listed, or not an alt-tab window
+  if (_tracked.count(hwnd) != 0) return false;
+  if (!_alt_tab.isAltTab(hwnd)) return false;
+  if (!_backend.title(hwnd, _title)) return false;
+
+  _add(hwnd, _title, _backend.processId(hwnd), out);
+  return true;
+}
+
+
+void WindowDeltaBuilder::addAll(WindowDeltaBatch& out) {
+  _backend.enumerateAltTab(_enumerated);
+
+  out.reserve(out.size() + _enumerated.size());
+  _tracked.reserve(_tracked.size() + _enumerated.size());
+  for (EnumeratedWindow& window : _enumerated) {
+    // Already listed
+    if (_tracked.count(window.hwnd) != 0) continue;
+    _add(window.hwnd, window.title, window.pid, out);
+  }
+}
+
+
+void WindowDeltaBuilder::build(WindowEventQueue& queue, WindowDeltaBatch& out) {
+  WindowEvent event;
+  while (queue.pop(event)) {
+    switch (event.type) {
+      case WindowEvent::CREATE: {
+        add(event.hwnd, out);
+        break;
+      }
+      case WindowEvent::DESTROY: {
+        _alt_tab.update(event);
+        const auto it = _tracked.find(event.hwnd);
+        if (it != _tracked.end()) _remove(it, out);
+        break;
+      }
+      case WindowEvent::SHOW:
+      case WindowEvent::UNCLOAK: {
+        // May have been invisible when its CREATE arrived
+        _alt_tab.update(event);
+        add(event.hwnd, out);
+        break;
+      }
+      case WindowEvent::HIDE:
+      case WindowEvent::CLOAK: {
+        _alt_tab.update(event);
+        const auto it = _tracked.find(event.hwnd);
+        if (it != _tracked.end() && !_alt_tab.isAltTab(event.hwnd)) _remove(it, out);
+        break;
+      }
+      case WindowEvent::NAMECHANGE: {
+        // Only listed windows need their title
+        if (_tracked.count(event.hwnd) == 0) break;
+        if (!_backend.title(event.hwnd, _title)) break;
+
+        out.push(WindowDelta::RETITLED, event.hwnd, _title);
+        break;
+      }
+      case WindowEvent::FOREGROUND: {
+        if (_tracked.count(event.hwnd) == 0) break;
+        out.push(WindowDelta::FOCUSED, event.hwnd);
+        break;
+      }
+    }
+  }
+}
+
+
+bool WindowDeltaBuilder::reconcile(const std::chrono::microseconds budget, WindowDeltaBatch& out) {
+  // New sweep, everything listed before now has to be seen again
+  if (_sweep_next == _sweep.size()) {
+    _sweep_next = 0;
+
+    // A desktop always has windows, an empty list means listing failed. Aborted before
+    // the generation moves, so nothing is removed for missing from it
+    if (!_backend.topLevelWindows(_sweep) || _sweep.empty()) {
+      _sweep.clear();
+      _aborted_sweeps++;
+      return false;
+    }
+    _sweep_generation++;
+    _alt_tab.beginSweep();
+  }
+
+  const std::size_t before = out.size();
+  const auto deadline = std::chrono::steady_clock::now() + budget;
+  do {
+    if (_sweep_next == _sweep.size()) break;
+    const HWND hwnd = _sweep[_sweep_next++];
+
+    // Never from the cache, styles change without an event
+    const bool alt_tab = _alt_tab.refresh(hwnd);
+    const auto it = _tracked.find(hwnd);
+    if (it != _tracked.end()) {
+      // Hidden or cloaked since, no event says so
+      if (alt_tab) it->second.sweep = _sweep_generation;
+      else         _remove(it, out);
+    }
+    else if (alt_tab && _backend.title(hwnd, _title)) {
+      // Shown since, or was still invisible when its CREATE arrived
+      _add(hwnd, _title, _backend.processId(hwnd), out);
+    }
+  } while (std::chrono::steady_clock::now() < deadline);
+
+  const bool finished = _sweep_next == _sweep.size();
+  if (finished) {
+    _alt_tab.prune();
+
+    // Listed but not on the desktop anymore, their DESTROY never arrived
+    for (auto it = _tracked.begin(); it != _tracked.end();) {
+      if (it->second.sweep == _sweep_generation) {
+        ++it;
+        continue;
+      }
+      const auto gone = it++;
+      _remove(gone, out);
+    }
+  }
+
+  _corrections += out.size() - before;
+  return finished;
+}
+
+
+// ----------------- WindowDeltaChannel -----------------
+
+bool WindowDeltaChannel::publish(WindowDeltaBatch& batch) {
+  if (batch.empty()) return false;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const bool was_empty = _pending.empty();
+  if (was_empty) {
+    _pending.swap(batch);
+  }
+  else {
+    _pending.append(batch);
+  }
+  batch.clear();
+  return was_empty;
+}
+
+
+void WindowDeltaChannel::take(WindowDeltaBatch& out) {
+  out.clear();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _pending.swap(out);
+}
+
+
+// ----------------- Applying -----------------
+
+void applyWindowDeltas(WindowRegistry& registry, const WindowDeltaBatch& batch) {
+  // The startup batch lists every window at once, size the columns for it in one go
+  if (registry.size() == 0) registry.reserve(batch.size());
+
+  for (const WindowDelta& delta : batch) {
+    switch (delta.type) {
+      case WindowDelta::ADDED: {
+        if (!registry.contains(delta.hwnd)) registry.insert(delta.hwnd, batch.title(delta), delta.pid);
+        break;
+      }
+      case WindowDelta::REMOVED: {
+        // Drops it from every tab group with it, hotkey slots holding it now resolve to nothing
+        registry.erase(delta.hwnd);
+        break;
+      }
+      case WindowDelta::RETITLED: {
+        const WindowId id = registry.find(delta.hwnd);
+        if (id != INVALID_WINDOW_ID) registry.setTitle(id, batch.title(delta));
+        break;
+      }
+      case WindowDelta::FOCUSED: {
+        // Moves the window to the front of the MRU order
+        registry.touch(delta.hwnd);
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,278 @@
+#ifndef WINDOW_DELTAS_HPP
+#define WINDOW_DELTAS_HPP
+
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "window_handle.hpp"
+#include "window_events.hpp"
+#include "window_backend.hpp"
+#include "window_registry.hpp"
+#include "process_cache.hpp"
+#include "alt_tab_cache.hpp"
+
+
+/**
+ * @brief One change to apply to the registry, with everything already queried
+ */
+struct WindowDelta {
+  enum Type : std::uint8_t {
+    ADDED,    // New alt-tab window, title and pid are set
+    REMOVED,  // Window was destroyed, or stopped being an alt-tab window (hidden, cloaked)
+    RETITLED, // Title changed, title is set
+    FOCUSED   // Window was focused
+  };
+
+  Type type;
+  HWND hwnd;
+  std::uint32_t title_offset = 0; // Into the title buffer of its batch, see WindowDeltaBatch::title()
+  std::uint32_t title_length = 0;
+  std::uint32_t pid = 0;
+};
+
+
+/**
+ * @brief Deltas in order, with their titles back to back in one buffer.
+ *
+ * Clearing keeps the capacity of both, and the channel swaps batches between the
+ * threads instead of copying them, so a title change costs a copy into a buffer
+ * that's already big enough rather than a string of its own.
+ */
+class WindowDeltaBatch {
+  private:
+    std::vector<WindowDelta> _deltas;
+    std::vector<char> _titles;
+
+  public:
+    /**
+     * @brief Appends a delta
+     * @param type: What changed
+     * @param hwnd: Window it changed for
+     * @param title: Title of an ADDED or RETITLED delta, copied into the batch
+     * @param pid: Owning process of an ADDED delta
+     */
+    void push(const WindowDelta::Type type, const HWND hwnd, const std::string_view title = {}, const std::uint32_t pid = 0);
+
+
+    /**
+     * @brief Appends every delta of another batch, in order
+     * @param other: Batch to copy
+     */
+    void append(const WindowDeltaBatch& other);
+
+
+    /**
+     * @brief Gets the title of a delta of this batch
+     * @param delta: Delta of this batch
+     * @returns std::string_view: Title, only valid until the batch changes
+     */
+    std::string_view title(const WindowDelta& delta) const {
+      return std::string_view(_titles.data() + delta.title_offset, delta.title_length);
+    }
+
+
+    void reserve(const std::size_t count) { _deltas.reserve(count); }
+    void clear() { _deltas.clear(); _titles.clear(); }
+    void swap(WindowDeltaBatch& other) { _deltas.swap(other._deltas); _titles.swap(other._titles); }
+
+    bool empty() const { return _deltas.empty(); }
+    std::size_t size() const { return _deltas.size(); }
+    std::vector<WindowDelta>::const_iterator begin() const { return _deltas.begin(); }
+    std::vector<WindowDelta>::const_iterator end() const { return _deltas.end(); }
+};
+
+
+/**
+ * @brief Turns queued window events into deltas, doing every window query up front.
+ *
+ * Keeps its own set of the windows it reported as added, so events for windows
+ * that were never listed are dropped without touching the registry or the window.
+ * With a ProcessCache, listed windows are counted in it by process.
+ * Windows are classified through an AltTabCache, so the show, hide and cloak
+ * events that list and unlist windows mostly cost no query at all.
+ * Whatever the hooks still miss, reconcile() finds by sweeping the desktop a slice
+ * at a time.
+ *
+ * NOTE: Lives on the event thread, never shares state with the registry.
+ */
+class WindowDeltaBuilder {
+  private:
+    /**
+     * @brief A listed window
+     */
+    struct _Tracked {
+      std::uint32_t pid;
+      std::uint32_t sweep; // Generation of the last sweep that saw it listed, or added it
+    };
+
+    WindowBackend& _backend;
+    ProcessCache* _processes;
+    AltTabCache _alt_tab;
+    std::unordered_map<HWND, _Tracked> _tracked; // Listed windows
+    std::string _title; // Reused for every title query, copied into the batch
+    std::vector<EnumeratedWindow> _enumerated; // Reused for every enumeration
+    std::vector<HWND> _sweep; // Windows of the sweep in progress
+    std::size_t _sweep_next = 0; // First window of _sweep not checked yet
+    std::uint32_t _sweep_generation = 0;
+    std::uint64_t _corrections = 0;
+    std::uint64_t _aborted_sweeps = 0;
+
+
+    /**
+     * @brief Lists a window and reports it as added
+     */
+    void _add(const HWND hwnd, const std::string_view title, const std::uint32_t pid, WindowDeltaBatch& out);
+
+
+    /**
+     * @brief Unlists a window and reports it as removed
+     */
+    void _remove(const std::unordered_map<HWND, _Tracked>::iterator it, WindowDeltaBatch& out);
+
+  public:
+    /**
+     * @brief Creates a builder
+     * @param backend: Source of window titles and classification
+     * @param processes: Cache to count listed windows in, optional
+     */
+    explicit WindowDeltaBuilder(WindowBackend& backend, ProcessCache* processes = nullptr)
+      : _backend(backend)
+      , _processes(processes)
+      , _alt_tab(backend) {}
+
+
+    /**
+     * @brief Marks a window as already in the registry
+     *
+     * NOTE: Not counted in the process cache.
+     * @param hwnd: Handle of the window
+     */
+    void track(const HWND hwnd) {
+      _tracked.emplace(hwnd, _Tracked{ 0, _sweep_generation });
+    }
+
+
+    /**
+     * @brief Reports a window as added if it's a new alt-tab window
+     * @param hwnd: Handle of the window
+     * @param out: Delta is appended here
+     * @returns bool: True if a delta was appended
+     */
+    bool add(const HWND hwnd, WindowDeltaBatch& out);
+
+
+    /**
+     * @brief Reports every alt-tab window on the desktop that isn't listed yet as added
+     *
+     * One enumeration, each window is queried once.
+     * @param out: Deltas are appended here
+     */
+    void addAll(WindowDeltaBatch& out);
+
+
+    /**
+     * @brief Drains the queue into deltas
+     * @param queue: Events to drain
+     * @param out: Deltas are appended here
+     */
+    void build(WindowEventQueue& queue, WindowDeltaBatch& out);
+
+
+    /**
+     * @brief Checks a slice of the desktop for changes no event reported
+     *
+     * A sweep lists every top-level window once, then each call checks as many of them as
+     * fit in the budget. Alt-tab windows that aren't listed get added, listed ones that aren't
+     * alt-tab anymore (hidden, cloaked) get removed, and listed ones that are still there get
+     * stamped with the sweep's generation. Once the sweep is through, listed windows without
+     * the stamp weren't on the desktop anymore and get removed too.
+     *
+     * NOTE: A listing that failed or came back empty aborts the sweep, nothing gets removed.
+     * @param budget: Time the slice may take, at least one window is checked
+     * @param out: Corrections are appended here
+     * @returns bool: True if this call finished a sweep
+     */
+    bool reconcile(const std::chrono::microseconds budget, WindowDeltaBatch& out);
+
+
+    /**
+     * @brief Gets the amount of corrections reconcile() made so far
+     * @returns std::uint64_t: Windows added or removed by sweeps
+     */
+    std::uint64_t corrections() const {
+      return _corrections;
+    }
+
+
+    /**
+     * @brief Gets the amount of sweeps aborted so far, the listing failed or came back empty
+     * @returns std::uint64_t: Sweeps that removed nothing
+     */
+    std::uint64_t abortedSweeps() const {
+      return _aborted_sweeps;
+    }
+
+
+    /**
+     * @brief Gets the classification cache, for its counters
+     * @returns const AltTabCache&: Cache of every window seen
+     */
+    const AltTabCache& altTabCache() const {
+      return _alt_tab;
+    }
+
+
+    /**
+     * @brief Gets the amount of windows reported as added and not removed yet
+     * @returns std::size_t: Window count
+     */
+    std::size_t trackedCount() const {
+      return _tracked.size();
+    }
+};
+
+
+/**
+ * @brief Hands delta batches from the event thread to the UI thread.
+ *
+ * Batches published before the UI thread gets to them are appended to each other,
+ * and the UI takes everything in one swap, so the lock is only held for a move.
+ */
+class WindowDeltaChannel {
+  private:
+    std::mutex _mutex;
+    WindowDeltaBatch _pending;
+
+  public:
+    /**
+     * @brief Publishes a batch
+     * @param batch: Deltas to publish, left empty (its capacity is kept)
+     * @returns bool: True if nothing was pending, the consumer should be woken up
+     */
+    bool publish(WindowDeltaBatch& batch);
+
+
+    /**
+     * @brief Takes every pending delta
+     * @param out: Cleared, then receives the deltas
+     */
+    void take(WindowDeltaBatch& out);
+};
+
+
+/**
+ * @brief Applies deltas to the registry, in order
+ * @param registry: Registry to update
+ * @param batch: Deltas to apply
+ */
+void applyWindowDeltas(WindowRegistry& registry, const WindowDeltaBatch& batch);
+
+
+#endif // WINDOW_DELTAS_HPP
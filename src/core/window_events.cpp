@@ -0,0 +1,56 @@
+#include "window_events.hpp"
+
+
+bool WindowEventQueue::push(const WindowEvent& event) {
+  _stats.received++;
+
+  switch (event.type) {
+    case WindowEvent::NAMECHANGE: {
+      // Fold into the window's queued name change, the title is only read when it's applied
+      const auto it = _pending_names.find(event.hwnd);
+      if (it != _pending_names.end() && it->second >= _head) {
+        const WindowEvent& queued = _ring[it->second % CAPACITY];
+        if (event.time_ms - queued.time_ms <= _coalesce_ms) {
+          _stats.merged++;
+          return true;
+        }
+      }
+      break;
+    }
+    case WindowEvent::CREATE:
+    case WindowEvent::DESTROY: {
+      // Handles get reused, never merge across a window's lifetime
+      _pending_names.erase(event.hwnd);
+      break;
+    }
+    case WindowEvent::FOREGROUND:
+    case WindowEvent::SHOW:
+    case WindowEvent::HIDE:
+    case WindowEvent::CLOAK:
+    case WindowEvent::UNCLOAK: {
+      break;
+    }
+  }
+
+  if (size() == CAPACITY) {
+    _stats.dropped++;
+    return false;
+  }
+
+  if (event.type == WindowEvent::NAMECHANGE) _pending_names[event.hwnd] = _tail;
+  _ring[_tail % CAPACITY] = event;
+  _tail++;
+  return true;
+}
+
+
+bool WindowEventQueue::pop(WindowEvent& out) {
+  if (empty()) return false;
+
+  out = _ring[_head % CAPACITY];
+  _head++;
+
+  // Drained, every pending entry is stale now
+  if (empty()) _pending_names.clear();
+  return true;
+}
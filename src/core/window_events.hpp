@@ -0,0 +1,132 @@
+#ifndef WINDOW_EVENTS_HPP
+#define WINDOW_EVENTS_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <unordered_map>
+
+#include "window_handle.hpp"
+
+
+/**
+ * @brief One window event that passed the hook's prefilter
+ */
+struct WindowEvent {
+  enum Type : std::uint8_t {
+    CREATE,     // Window was created
+    DESTROY,    // Window was destroyed
+    NAMECHANGE, // Title changed
+    FOREGROUND, // Window was focused
+    SHOW,       // Window became visible
+    HIDE,       // Window became invisible
+    CLOAK,      // DWM hid the window (other virtual desktop, suspended app, ...)
+    UNCLOAK     // DWM shows the window again
+  };
+
+  Type type;
+  HWND hwnd;
+  std::uint32_t time_ms; // Tick count the event was generated at
+};
+
+
+/**
+ * @brief Counters of everything the hook delivered
+ */
+struct WindowEventStats {
+  std::uint64_t received = 0; // Every event the hook delivered
+  std::uint64_t filtered = 0; // Rejected by the prefilter
+  std::uint64_t dropped = 0;  // Lost because the queue was full
+  std::uint64_t merged = 0;   // Name changes folded into one already queued
+};
+
+
+/**
+ * @brief Fixed-size ring buffer between the WinEvent hook and the registry.
+ *
+ * Events are queued as they arrive and applied once per batch. A name change for
+ * a window that already has one queued within the coalescing window is folded into
+ * it, so title storms (browsers, IDEs, ...) cost one title query per batch.
+ *
+ * NOTE: Not thread-safe, out-of-context hooks are called on the thread that set them.
+ * NOTE: Doesn't depend on Win32, the hook translates events before pushing them.
+ */
+class WindowEventQueue {
+  public:
+    static constexpr std::size_t CAPACITY = 1024; // Power of two
+    static constexpr std::uint32_t DEFAULT_COALESCE_MS = 100;
+
+  private:
+    std::array<WindowEvent, CAPACITY> _ring{};
+    std::uint64_t _head = 0; // Sequence number of the oldest queued event
+    std::uint64_t _tail = 0; // Sequence number the next event gets
+    std::unordered_map<HWND, std::uint64_t> _pending_names; // Window -> sequence number of its latest name change
+    std::uint32_t _coalesce_ms;
+    WindowEventStats _stats;
+
+  public:
+    /**
+     * @brief Creates an empty queue
+     * @param coalesce_ms: Name changes of a window this close together are merged
+     */
+    explicit WindowEventQueue(const std::uint32_t coalesce_ms = DEFAULT_COALESCE_MS)
+      : _coalesce_ms(coalesce_ms) {
+      _pending_names.reserve(CAPACITY);
+    }
+
+
+    /**
+     * @brief Queues an event, merging it into a queued name change when possible
+     * @param event: Event to queue
+     * @returns bool: True if the event was queued or merged, false if it was dropped
+     */
+    bool push(const WindowEvent& event);
+
+
+    /**
+     * @brief Counts an event the prefilter rejected
+     */
+    void reject() {
+      _stats.received++;
+      _stats.filtered++;
+    }
+
+
+    /**
+     * @brief Takes the oldest queued event
+     * @param out: Receives the event
+     * @returns bool: False if the queue is empty
+     */
+    bool pop(WindowEvent& out);
+
+
+    /**
+     * @brief Checks if no event is queued
+     * @returns bool: True/False of being empty
+     */
+    bool empty() const {
+      return _head == _tail;
+    }
+
+
+    /**
+     * @brief Gets the amount of queued events
+     * @returns std::size_t: Event count
+     */
+    std::size_t size() const {
+      return static_cast<std::size_t>(_tail - _head);
+    }
+
+
+    /**
+     * @brief Gets the event counters
+     * @returns const WindowEventStats&: Counters since the queue was created
+     */
+    const WindowEventStats& stats() const {
+      return _stats;
+    }
+};
+
+
+#endif // WINDOW_EVENTS_HPP
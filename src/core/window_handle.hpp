@@ -0,0 +1,38 @@
+#ifndef WINDOW_HANDLE_HPP
+#define WINDOW_HANDLE_HPP
+
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+
+
+#include <cstdint>
+
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  // Same declaration <windows.h> uses, so the window bookkeeping also builds headless.
+  struct HWND__;
+  typedef HWND__* HWND;
+#endif // _WIN32
+
+
+/**
+ * @brief Generational handle of a WindowRegistry row.
+ *
+ * Low 16 bits are the slot index, high 16 bits the slot's generation.
+ * A handle can be stored anywhere and outlives its window safely.
+ */
+using WindowId = std::uint32_t;
+inline constexpr WindowId INVALID_WINDOW_ID = 0; // Never handed out by the registry
+
+
+/**
+ * @brief Small dense id of a tab group, used as a bit index in window membership bitsets.
+ */
+using TabGroupId = std::uint32_t;
+
+
+#endif // WINDOW_HANDLE_HPP
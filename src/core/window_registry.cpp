@@ -0,0 +1,356 @@
+#include "window_registry.hpp"
+
+#include <algorithm>
+
+
+// ----------------- Group membership -----------------
+
+namespace {
+  /**
+   * @brief Counts the set bits of a word
+   */
+  std::uint32_t popCount(std::uint64_t bits) {
+    std::uint32_t count = 0;
+    for (; bits; bits &= bits - 1) count++;
+    return count;
+  }
+}
+
+
+void WindowRegistry::_reserveGroup(const TabGroupId group) {
+  if (group >= _group_sizes.size()) _group_sizes.resize(group + 1, 0);
+
+  const std::uint32_t needed = group / _GROUP_WORD_BITS + 1;
+  if (needed <= _group_words) return;
+
+  // Restride every row, new words start empty
+  std::vector<std::uint64_t> widened(_ids.size() * needed, 0);
+  for (std::size_t r = 0; r < _ids.size(); r++) {
+    std::copy_n(_groups.begin() + r * _group_words, _group_words, widened.begin() + r * needed);
+  }
+  _groups = std::move(widened);
+  _group_words = needed;
+}
+
+
+// ----------------- MRU list -----------------
+
+void WindowRegistry::_linkFront(const WindowId id) {
+  _MruLink& link = _mru[_row(id)];
+  link.prev = INVALID_WINDOW_ID;
+  link.next = _mru_front;
+
+  if (_mru_front) _mru[_row(_mru_front)].prev = id;
+  else            _mru_back = id; // First row is both ends
+
+  _mru_front = id;
+}
+
+
+void WindowRegistry::_unlink(const WindowId id) {
+  _MruLink& link = _mru[_row(id)];
+
+  if (link.prev) _mru[_row(link.prev)].next = link.next;
+  else           _mru_front = link.next;
+
+  if (link.next) _mru[_row(link.next)].prev = link.prev;
+  else           _mru_back = link.prev;
+
+  link.prev = INVALID_WINDOW_ID;
+  link.next = INVALID_WINDOW_ID;
+}
+
+
+// ----------------- Public functions -----------------
+
+WindowRegistry::~WindowRegistry() {
+  for (std::size_t r = 0; r < _textures.size(); r++) {
+    if (!(_flags[r] & WINDOW_FLAG_SHARED_TEXTURE)) _releaseTexture(_textures[r]);
+  }
+  for (const ImTextureID icon : _icons) _releaseTexture(icon);
+}
+
+
+std::uint32_t WindowRegistry::row(const WindowId id) const {
+  const std::uint32_t slot = id & _INDEX_MASK;
+  if (id == INVALID_WINDOW_ID || slot >= _slots.size()) return NO_ROW;
+
+  // Slot was freed (and maybe reused) since the handle was made
+  if (_slots[slot].generation != (id >> _INDEX_BITS)) return NO_ROW;
+
+  return _slots[slot].row;
+}
+
+
+std::optional<WindowView> WindowRegistry::get(const WindowId id) const {
+  const std::uint32_t r = row(id);
+  if (r == NO_ROW) return std::nullopt;
+  return view(r);
+}
+
+
+WindowView WindowRegistry::view(const std::uint32_t row) const {
+  return WindowView{
+    _ids[row],
+    _hwnds[row],
+    _title_arena.view(_titles[row]),
+    _title_arena.hashOf(_titles[row]),
+    _textures[row],
+    _texture_sizes[row],
+    ImVec2(_texture_uvs[row].x, _texture_uvs[row].y),
+    ImVec2(_texture_uvs[row].z, _texture_uvs[row].w),
+    _icons[row],
+    _flags[row],
+    _last_focused[row],
+    _pids[row],
+    _groups.data() + static_cast<std::size_t>(row) * _group_words,
+    _group_words
+  };
+}
+
+
+WindowId WindowRegistry::find(const HWND hwnd) const {
+  const auto it = _index.find(hwnd);
+  if (it == _index.end()) return INVALID_WINDOW_ID;
+  return it->second;
+}
+
+
+WindowId WindowRegistry::insert(const HWND hwnd, const std::string_view title, const std::uint32_t pid) {
+  if (contains(hwnd)) return INVALID_WINDOW_ID;
+
+  // Reuse the slot freed longest ago, so generations wear evenly, or grow
+  std::uint32_t slot;
+  if (_free_head != _NO_FREE_SLOT) {
+    slot = _free_head;
+    _free_head = _slots[slot].row;
+    if (_free_head == _NO_FREE_SLOT) _free_tail = _NO_FREE_SLOT;
+  }
+  else {
+    if (_slots.size() >= _MAX_SLOTS) return INVALID_WINDOW_ID;
+    slot = static_cast<std::uint32_t>(_slots.size());
+    _slots.push_back(_Slot{1, 0}); // Generation 0 is reserved so no handle is ever 0
+  }
+
+  const std::uint32_t new_row = static_cast<std::uint32_t>(_ids.size());
+  const WindowId id = _makeId(slot, _slots[slot].generation);
+  _slots[slot].row = new_row;
+
+  _ids.push_back(id);
+  _hwnds.push_back(hwnd);
+  _last_focused.push_back(std::chrono::steady_clock::now());
+  _titles.push_back(_title_arena.intern(title));
+  _textures.push_back(ImTextureID_Invalid);
+  _flags.push_back(WINDOW_FLAG_NONE);
+  _mru.push_back(_MruLink{ INVALID_WINDOW_ID, INVALID_WINDOW_ID });
+  _texture_sizes.push_back(ImVec2(0.0f, 0.0f));
+  _texture_uvs.push_back(ImVec4(0.0f, 0.0f, 1.0f, 1.0f));
+  _icons.push_back(ImTextureID_Invalid);
+  _pids.push_back(pid);
+  _groups.resize(_groups.size() + _group_words, 0);
+
+  _index.emplace(hwnd, id);
+  _linkFront(id);
+  _version++;
+
+  return id;
+}
+
+
+bool WindowRegistry::erase(const HWND hwnd) {
+  const auto it = _index.find(hwnd);
+  if (it == _index.end()) return false;
+
+  const WindowId id = it->second;
+  const std::uint32_t slot = id & _INDEX_MASK;
+  const std::uint32_t dead = _slots[slot].row;
+  const std::uint32_t last = static_cast<std::uint32_t>(_ids.size() - 1);
+  _index.erase(it);
+  _unlink(id);
+
+  if (!(_flags[dead] & WINDOW_FLAG_SHARED_TEXTURE)) _releaseTexture(_textures[dead]);
+  _releaseTexture(_icons[dead]);
+  _title_arena.release(_titles[dead]);
+
+  // Leaving every group is just dropping the bitset
+  const std::size_t dead_groups = static_cast<std::size_t>(dead) * _group_words;
+  const std::size_t last_groups = static_cast<std::size_t>(last) * _group_words;
+  for (std::uint32_t w = 0; w < _group_words; w++) {
+    for (std::uint64_t bits = _groups[dead_groups + w]; bits; bits &= bits - 1) {
+      const std::uint32_t bit = popCount((bits & (~bits + 1)) - 1); // Index of the lowest set bit
+      _group_sizes[w * _GROUP_WORD_BITS + bit]--;
+    }
+  }
+
+  // Move the last row into the hole to keep every column dense
+  if (dead != last) {
+    _ids[dead]           = _ids[last];
+    _hwnds[dead]         = _hwnds[last];
+    _last_focused[dead]  = _last_focused[last];
+    _titles[dead]        = _titles[last];
+    _textures[dead]      = _textures[last];
+    _flags[dead]         = _flags[last];
+    _mru[dead]           = _mru[last];
+    _texture_sizes[dead] = _texture_sizes[last];
+    _texture_uvs[dead]   = _texture_uvs[last];
+    _icons[dead]         = _icons[last];
+    _pids[dead]          = _pids[last];
+    std::copy_n(_groups.begin() + last_groups, _group_words, _groups.begin() + dead_groups);
+    _slots[_ids[dead] & _INDEX_MASK].row = dead;
+  }
+  _ids.pop_back();
+  _hwnds.pop_back();
+  _last_focused.pop_back();
+  _titles.pop_back();
+  _textures.pop_back();
+  _flags.pop_back();
+  _mru.pop_back();
+  _texture_sizes.pop_back();
+  _texture_uvs.pop_back();
+  _icons.pop_back();
+  _pids.pop_back();
+  _groups.resize(_groups.size() - _group_words);
+
+  // Invalidate every handle to this slot. Once its generation runs out the slot is retired,
+  // wrapping would let a stale handle resolve to whichever window got the slot next
+  _Slot& s = _slots[slot];
+  s.generation++;
+  s.row = _NO_FREE_SLOT;
+  if (s.generation != _RETIRED_GENERATION) {
+    if (_free_tail != _NO_FREE_SLOT) _slots[_free_tail].row = slot;
+    else                             _free_head = slot;
+    _free_tail = slot;
+  }
+  _version++;
+
+  return true;
+}
+
+
+bool WindowRegistry::setTitle(const WindowId id, const std::string_view title) {
+  const std::uint32_t r = row(id);
+  if (r == NO_ROW) return false;
+
+  // Intern before releasing, an unchanged title just gets its reference back
+  const TitleRef title_ref = _title_arena.intern(title);
+  const TitleRef old_ref = _titles[r];
+  _title_arena.release(old_ref);
+  _titles[r] = title_ref;
+
+  if (title_ref == old_ref) return false;
+  _version++;
+  return true;
+}
+
+
+bool WindowRegistry::setTexture(const WindowId id, const ImTextureID tex, const ImVec2 size, const TextureRegion& region) {
+  const std::uint32_t r = row(id);
+  if (r == NO_ROW) return false;
+
+  if (_textures[r] != tex && !(_flags[r] & WINDOW_FLAG_SHARED_TEXTURE)) _releaseTexture(_textures[r]);
+  _textures[r] = tex;
+  _texture_sizes[r] = tex != ImTextureID_Invalid ? size : ImVec2(0.0f, 0.0f);
+  _texture_uvs[r] = tex != ImTextureID_Invalid ? ImVec4(region.uv0.x, region.uv0.y, region.uv1.x, region.uv1.y) : ImVec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+  if (tex != ImTextureID_Invalid) _flags[r] |= WINDOW_FLAG_HAS_THUMBNAIL;
+  else                            _flags[r] &= ~WINDOW_FLAG_HAS_THUMBNAIL;
+  if (tex != ImTextureID_Invalid && region.shared) _flags[r] |= WINDOW_FLAG_SHARED_TEXTURE;
+  else                                             _flags[r] &= ~WINDOW_FLAG_SHARED_TEXTURE;
+  _version++;
+  return true;
+}
+
+
+bool WindowRegistry::setIcon(const WindowId id, const ImTextureID icon) {
+  const std::uint32_t r = row(id);
+  if (r == NO_ROW) return false;
+
+  if (_icons[r] != icon) _releaseTexture(_icons[r]);
+  _icons[r] = icon;
+
+  if (icon != ImTextureID_Invalid) _flags[r] |= WINDOW_FLAG_HAS_ICON;
+  else                             _flags[r] &= ~WINDOW_FLAG_HAS_ICON;
+  _version++;
+  return true;
+}
+
+
+WindowId WindowRegistry::touch(const HWND hwnd) {
+  const WindowId id = find(hwnd);
+  if (id == INVALID_WINDOW_ID) return INVALID_WINDOW_ID;
+
+  _last_focused[_row(id)] = std::chrono::steady_clock::now();
+
+  // Already the most recent, nothing to relink
+  if (id != _mru_front) {
+    _unlink(id);
+    _linkFront(id);
+  }
+  _version++;
+
+  return id;
+}
+
+
+bool WindowRegistry::addToGroup(const WindowId id, const TabGroupId group) {
+  const std::uint32_t r = row(id);
+  if (r == NO_ROW) return false;
+
+  _reserveGroup(group);
+  std::uint64_t& word = _groups[static_cast<std::size_t>(r) * _group_words + group / _GROUP_WORD_BITS];
+  const std::uint64_t bit = std::uint64_t{1} << (group % _GROUP_WORD_BITS);
+  if (word & bit) return false;
+
+  word |= bit;
+  _group_sizes[group]++;
+  _version++;
+  return true;
+}
+
+
+bool WindowRegistry::removeFromGroup(const WindowId id, const TabGroupId group) {
+  if (!inGroup(id, group)) return false;
+
+  const std::uint32_t r = _row(id);
+  _groups[static_cast<std::size_t>(r) * _group_words + group / _GROUP_WORD_BITS] &= ~(std::uint64_t{1} << (group % _GROUP_WORD_BITS));
+  _group_sizes[group]--;
+  _version++;
+  return true;
+}
+
+
+bool WindowRegistry::inGroup(const WindowId id, const TabGroupId group) const {
+  const std::uint32_t r = row(id);
+  if (r == NO_ROW) return false;
+  return view(r).inGroup(group);
+}
+
+
+std::uint32_t WindowRegistry::groupCount(const WindowId id) const {
+  const std::uint32_t r = row(id);
+  if (r == NO_ROW) return 0;
+
+  std::uint32_t count = 0;
+  for (std::uint32_t w = 0; w < _group_words; w++) {
+    count += popCount(_groups[static_cast<std::size_t>(r) * _group_words + w]);
+  }
+  return count;
+}
+
+
+void WindowRegistry::reserve(const std::size_t count) {
+  _ids.reserve(count);
+  _hwnds.reserve(count);
+  _last_focused.reserve(count);
+  _titles.reserve(count);
+  _textures.reserve(count);
+  _flags.reserve(count);
+  _mru.reserve(count);
+  _texture_sizes.reserve(count);
+  _texture_uvs.reserve(count);
+  _icons.reserve(count);
+  _pids.reserve(count);
+  _groups.reserve(count * _group_words);
+  _slots.reserve(count);
+  _index.reserve(count);
+}
@@ -0,0 +1,449 @@
+#ifndef WINDOW_REGISTRY_HPP
+#define WINDOW_REGISTRY_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+#include "imgui.h"
+
+#include "window_handle.hpp"
+#include "title_arena.hpp"
+
+
+/**
+ * @brief Per-window state bits stored in the flags column
+ */
+enum WindowFlags : std::uint32_t {
+  WINDOW_FLAG_NONE           = 0,
+  WINDOW_FLAG_HAS_THUMBNAIL  = 1u << 0, // Texture column holds a thumbnail
+  WINDOW_FLAG_HAS_ICON       = 1u << 1, // Icon column holds an icon
+  WINDOW_FLAG_SHARED_TEXTURE = 1u << 2, // Thumbnail is a region of a texture owned elsewhere (an atlas page), never released here
+};
+
+
+/**
+ * @brief Where a thumbnail lies in its texture
+ */
+struct TextureRegion {
+  ImVec2 uv0 = ImVec2(0.0f, 0.0f);
+  ImVec2 uv1 = ImVec2(1.0f, 1.0f);
+  bool shared = false; // Texture is owned elsewhere, see WINDOW_FLAG_SHARED_TEXTURE
+};
+
+
+/**
+ * @brief Read-only view of one registry row, assembled from its columns
+ */
+struct WindowView {
+  WindowId id;
+  HWND hwnd;
+  std::string_view title; // NUL-terminated, valid until the next insert, erase or retitle of any window
+  std::uint64_t title_hash;
+  ImTextureID tex;
+  ImVec2 tex_size;             // Pixels of the thumbnail's largest level, 0x0 if unknown
+  ImVec2 tex_uv0;              // Region of tex the thumbnail takes, all of it unless it's shared
+  ImVec2 tex_uv1;
+  ImTextureID icon;
+  std::uint32_t flags;
+  std::chrono::steady_clock::time_point last_focused;
+  std::uint32_t pid;           // Owning process, 0 if unknown
+  const std::uint64_t* groups; // Tab group membership bitset, bit N = member of group N
+  std::uint32_t group_words;   // Length of the bitset in 64-bit words
+
+
+  /**
+   * @brief Checks if the window is a member of a tab group
+   * @param group: Id of the group
+   * @returns bool: True/False of being a member
+   */
+  bool inGroup(const TabGroupId group) const {
+    const std::uint32_t word = group / 64;
+    return word < group_words && ((groups[word] >> (group % 64)) & 1u);
+  }
+};
+
+
+/**
+ * @brief Column-oriented table of every tracked window.
+ *
+ * Each field lives in its own contiguous array indexed by a dense row, so a walk
+ * over one field (focus times, textures, flags, ...) streams through memory instead
+ * of hopping between heap records. Rows are addressed from the outside by 32-bit
+ * generational WindowIds: once a window is erased its slot generation is bumped,
+ * so every old handle resolves to "gone" instead of to whatever reused the row.
+ * Freed slots are reused oldest first, and a slot whose generation runs out is
+ * retired for good instead of wrapping, so a handle never resolves to a later
+ * window. That caps a registry at about 4 billion windows (65536 slots times 65535
+ * generations), after which insert() fails.
+ *
+ * Rows are also threaded onto an intrusive most-recently-used list, so the focus
+ * order is kept up to date in O(1) per focus change and never has to be sorted.
+ *
+ * Titles are interned in a TitleArena, the title column only stores a reference
+ * into it, so windows with the same title share one copy and a title change to the
+ * value it already has is a no-op.
+ *
+ * Every row also carries a bitset of the tab groups it belongs to, so membership
+ * checks are O(1) and dropping a window from every group is part of erasing it.
+ *
+ * NOTE: Rows are reordered by erase(), only hold on to WindowIds.
+ * NOTE: Doesn't depend on Win32, textures are released through a callback.
+ */
+class WindowRegistry {
+  public:
+    static constexpr std::uint32_t NO_ROW = UINT32_MAX;
+    using TextureReleaser = void (*)(ImTextureID tex);
+
+  private:
+    static constexpr std::uint32_t _INDEX_BITS = 16;
+    static constexpr std::uint32_t _INDEX_MASK = (1u << _INDEX_BITS) - 1;
+    static constexpr std::uint32_t _MAX_SLOTS = 1u << _INDEX_BITS; // Matches the per-session USER handle limit
+    static constexpr std::uint32_t _NO_FREE_SLOT = UINT32_MAX;
+    static constexpr std::uint16_t _RETIRED_GENERATION = UINT16_MAX; // Never handed out, the slot isn't reused
+    static constexpr std::uint32_t _GROUP_WORD_BITS = 64;
+
+    /**
+     * @brief Indirection from a handle's slot index to its row
+     */
+    struct _Slot {
+      std::uint16_t generation; // Bumped every time the slot is freed, 0 is reserved so no handle is ever 0
+      std::uint32_t row;        // Row while alive, next free slot otherwise
+    };
+
+    /**
+     * @brief Neighbours in the MRU list
+     */
+    struct _MruLink {
+      WindowId prev; // More recently focused
+      WindowId next; // Less recently focused
+    };
+
+    // ---------------- Hot columns (read every frame) ----------------
+    std::vector<WindowId> _ids;
+    std::vector<HWND> _hwnds;
+    std::vector<std::chrono::steady_clock::time_point> _last_focused;
+    std::vector<TitleRef> _titles;
+    std::vector<ImTextureID> _textures;
+    std::vector<std::uint32_t> _flags;
+    std::vector<_MruLink> _mru;
+
+    // ---------------- Cold columns ----------------
+    std::vector<ImVec2> _texture_sizes;
+    std::vector<ImVec4> _texture_uvs; // uv0 in xy, uv1 in zw
+    std::vector<ImTextureID> _icons;
+    std::vector<std::uint32_t> _pids;
+    std::vector<std::uint64_t> _groups; // Membership bitsets, _group_words words per row
+    std::uint32_t _group_words = 1;
+    std::vector<std::uint32_t> _group_sizes; // Members per group, indexed by TabGroupId
+
+    // ---------------- Lookup ----------------
+    std::vector<_Slot> _slots;
+    std::uint32_t _free_head = _NO_FREE_SLOT; // Freed longest ago, reused first
+    std::uint32_t _free_tail = _NO_FREE_SLOT;
+    std::unordered_map<HWND, WindowId> _index;
+
+    WindowId _mru_front = INVALID_WINDOW_ID; // Most recently focused window
+    WindowId _mru_back = INVALID_WINDOW_ID;  // Least recently focused window
+
+    TitleArena _title_arena;
+
+    TextureReleaser _release_texture = nullptr;
+    std::uint64_t _version = 0; // Bumped by every change
+
+
+    /**
+     * @brief Builds a handle from its parts
+     */
+    static WindowId _makeId(const std::uint32_t slot, const std::uint16_t generation) {
+      return (static_cast<WindowId>(generation) << _INDEX_BITS) | slot;
+    }
+
+
+    /**
+     * @brief Gets the row of a handle that is known to be alive
+     */
+    std::uint32_t _row(const WindowId id) const {
+      return _slots[id & _INDEX_MASK].row;
+    }
+
+
+    /**
+     * @brief Releases a texture through the releaser, if one is set
+     */
+    void _releaseTexture(const ImTextureID tex) const {
+      if (tex != ImTextureID_Invalid && _release_texture) _release_texture(tex);
+    }
+
+
+    /**
+     * @brief Widens the membership bitsets so they can hold a group
+     * @param group: Id of the group
+     */
+    void _reserveGroup(const TabGroupId group);
+
+
+    /**
+     * @brief Links a row at the front of the MRU list
+     * @param id: Handle of an unlinked row
+     */
+    void _linkFront(const WindowId id);
+
+
+    /**
+     * @brief Unlinks a row from the MRU list
+     * @param id: Handle of a linked row
+     */
+    void _unlink(const WindowId id);
+
+  public:
+    /**
+     * @brief Default constructor.
+     */
+    WindowRegistry() = default;
+
+
+    /**
+     * @brief Releases every texture still held.
+     */
+    ~WindowRegistry();
+
+
+    // Rows own their textures, so the registry itself can't be copied.
+    WindowRegistry(const WindowRegistry&) = delete;
+    WindowRegistry& operator=(const WindowRegistry&) = delete;
+
+
+    /**
+     * @brief Sets the function used to free textures that are replaced or erased
+     * @param releaser: Texture release function
+     */
+    void setTextureReleaser(const TextureReleaser releaser) {
+      _release_texture = releaser;
+    }
+
+
+    /**
+     * @brief Gets the slot index part of a handle
+     * @param id: Handle of the window
+     * @returns std::uint32_t: Slot index, stable for as long as the window lives
+     */
+    static std::uint32_t slotOf(const WindowId id) {
+      return id & _INDEX_MASK;
+    }
+
+
+    /**
+     * @brief Gets the change counter of the registry
+     *
+     * NOTE: Every change bumps it, equal versions mean equal contents.
+     * @returns std::uint64_t: Version
+     */
+    std::uint64_t version() const {
+      return _version;
+    }
+
+
+    /**
+     * @brief Resolves a handle to its row
+     * @param id: Handle of the window
+     * @returns std::uint32_t: Row, or NO_ROW if the window is gone
+     */
+    std::uint32_t row(const WindowId id) const;
+
+
+    /**
+     * @brief Resolves a handle to a view of its row
+     * @param id: Handle of the window
+     * @returns std::optional<WindowView>: View, or nullopt if the window is gone
+     */
+    std::optional<WindowView> get(const WindowId id) const;
+
+
+    /**
+     * @brief Builds a view of a row
+     * @param row: Row in [0, size())
+     * @returns WindowView: View of the row
+     */
+    WindowView view(const std::uint32_t row) const;
+
+
+    /**
+     * @brief Finds the handle for a window
+     * @param hwnd: Handle of the window
+     * @returns WindowId: Handle, or INVALID_WINDOW_ID if the window isn't tracked
+     */
+    WindowId find(const HWND hwnd) const;
+
+
+    /**
+     * @brief Checks if a window handle is tracked
+     * @param hwnd: Handle of the window
+     * @returns bool: True/False of being tracked
+     */
+    bool contains(const HWND hwnd) const {
+      return _index.find(hwnd) != _index.end();
+    }
+
+
+    /**
+     * @brief Creates a row for a window handle
+     *
+     * NOTE: New windows start at the front of the MRU list.
+     * @param hwnd: Handle of the window
+     * @param title: Title of the window
+     * @param pid: Owning process, 0 if unknown
+     * @returns WindowId: New handle, or INVALID_WINDOW_ID if the window was already tracked or no slot is left
+     */
+    WindowId insert(const HWND hwnd, const std::string_view title, const std::uint32_t pid = 0);
+
+
+    /**
+     * @brief Destroys the row for a window handle
+     *
+     * NOTE: Every WindowId of the window resolves to nothing after this call.
+     * @param hwnd: Handle of the window
+     * @returns bool: True if a row was destroyed
+     */
+    bool erase(const HWND hwnd);
+
+
+    /**
+     * @brief Replaces the title of a window
+     * @param id: Handle of the window
+     * @param title: New title
+     * @returns bool: True if the window is alive and its title actually changed
+     */
+    bool setTitle(const WindowId id, const std::string_view title);
+
+
+    /**
+     * @brief Replaces the thumbnail of a window, releasing the old one unless it was shared
+     * @param id: Handle of the window
+     * @param tex: New texture (ImTextureID_Invalid to clear)
+     * @param size: Pixels of the thumbnail's largest level, lets cells keep its aspect ratio
+     * @param region: Part of the texture the thumbnail takes, and if the texture is owned elsewhere
+     * @returns bool: True if the window is alive
+     */
+    bool setTexture(const WindowId id, const ImTextureID tex, const ImVec2 size = ImVec2(0.0f, 0.0f), const TextureRegion& region = {});
+
+
+    /**
+     * @brief Replaces the icon of a window, releasing the old one
+     * @param id: Handle of the window
+     * @param icon: New texture (ImTextureID_Invalid to clear)
+     * @returns bool: True if the window is alive
+     */
+    bool setIcon(const WindowId id, const ImTextureID icon);
+
+
+    /**
+     * @brief Marks a window as the most recently focused one
+     * @param hwnd: Handle of the window
+     * @returns WindowId: Handle that was moved, or INVALID_WINDOW_ID if the window isn't tracked
+     */
+    WindowId touch(const HWND hwnd);
+
+
+    /**
+     * @brief Gets the most recently focused window
+     *
+     * Usage  ->   for (WindowId id = registry.mruFront(); id; id = registry.mruNext(id)) { ... }
+     * @returns WindowId: Front of the MRU list, or INVALID_WINDOW_ID if empty
+     */
+    WindowId mruFront() const {
+      return _mru_front;
+    }
+
+
+    /**
+     * @brief Gets the next less recently focused window
+     * @param id: Handle of a live window
+     * @returns WindowId: Next handle, or INVALID_WINDOW_ID at the end of the list
+     */
+    WindowId mruNext(const WindowId id) const {
+      return _mru[_row(id)].next;
+    }
+
+
+    /**
+     * @brief Makes a window a member of a tab group
+     * @param id: Handle of the window
+     * @param group: Id of the group
+     * @returns bool: True if the window is alive and wasn't a member yet
+     */
+    bool addToGroup(const WindowId id, const TabGroupId group);
+
+
+    /**
+     * @brief Drops a window from a tab group
+     * @param id: Handle of the window
+     * @param group: Id of the group
+     * @returns bool: True if the window is alive and was a member
+     */
+    bool removeFromGroup(const WindowId id, const TabGroupId group);
+
+
+    /**
+     * @brief Checks if a window is a member of a tab group
+     * @param id: Handle of the window
+     * @param group: Id of the group
+     * @returns bool: True/False of being an alive member
+     */
+    bool inGroup(const WindowId id, const TabGroupId group) const;
+
+
+    /**
+     * @brief Gets the amount of tab groups a window is a member of
+     * @param id: Handle of the window
+     * @returns std::uint32_t: Group count, 0 if the window is gone
+     */
+    std::uint32_t groupCount(const WindowId id) const;
+
+
+    /**
+     * @brief Gets the amount of windows in a tab group
+     * @param group: Id of the group
+     * @returns std::uint32_t: Member count
+     */
+    std::uint32_t groupSize(const TabGroupId group) const {
+      return group < _group_sizes.size() ? _group_sizes[group] : 0;
+    }
+
+
+    // ---------------- Column access, indexed by row ----------------
+
+    const std::vector<WindowId>& ids() const { return _ids; }
+    const std::vector<HWND>& hwnds() const { return _hwnds; }
+    const std::vector<std::chrono::steady_clock::time_point>& lastFocused() const { return _last_focused; }
+    const std::vector<ImTextureID>& textures() const { return _textures; }
+    const std::vector<std::uint32_t>& flags() const { return _flags; }
+    const std::vector<std::uint32_t>& pids() const { return _pids; }
+    const std::vector<std::uint64_t>& groups() const { return _groups; } // groupWords() words per row
+    std::uint32_t groupWords() const { return _group_words; }
+    const std::vector<std::uint32_t>& groupSizes() const { return _group_sizes; }
+
+
+    /**
+     * @brief Reserves space for a number of windows
+     * @param count: Expected amount of windows
+     */
+    void reserve(const std::size_t count);
+
+
+    /**
+     * @brief Gets the amount of tracked windows
+     * @returns std::size_t: Window count
+     */
+    std::size_t size() const {
+      return _ids.size();
+    }
+};
+
+
+#endif // WINDOW_REGISTRY_HPP
@@ -0,0 +1,158 @@
+#include "window_snapshot.hpp"
+
+
+// ----------------- WindowSnapshot -----------------
+
+WindowSnapshot::_RetiredTextures::~_RetiredTextures() {
+  if (!release) return;
+  for (const ImTextureID tex : textures) {
+    if (tex != ImTextureID_Invalid) release(tex);
+  }
+}
+
+
+std::uint32_t WindowSnapshot::row(const WindowId id) const {
+  const std::uint32_t slot = WindowRegistry::slotOf(id);
+  if (id == INVALID_WINDOW_ID || slot >= _slot_ids.size()) return WindowRegistry::NO_ROW;
+
+  // Slot is empty or belongs to another generation
+  if (_slot_ids[slot] != id) return WindowRegistry::NO_ROW;
+
+  return _slot_rows[slot];
+}
+
+
+std::optional<WindowView> WindowSnapshot::get(const WindowId id) const {
+  const std::uint32_t r = row(id);
+  if (r == WindowRegistry::NO_ROW) return std::nullopt;
+  return view(r);
+}
+
+
+WindowView WindowSnapshot::view(const std::uint32_t row) const {
+  const _TitleSpan span = _titles[row];
+  return WindowView{
+    _ids[row],
+    _hwnds[row],
+    std::string_view(_title_chars.data() + span.offset, span.length),
+    _title_hashes[row],
+    _textures[row],
+    _texture_sizes[row],
+    ImVec2(_texture_uvs[row].x, _texture_uvs[row].y),
+    ImVec2(_texture_uvs[row].z, _texture_uvs[row].w),
+    _icons[row],
+    _flags[row],
+    _last_focused[row],
+    _pids[row],
+    _groups.data() + static_cast<std::size_t>(row) * _group_words,
+    _group_words
+  };
+}
+
+
+// ----------------- SnapshotPublisher -----------------
+
+SnapshotPublisher::SnapshotPublisher(const WindowRegistry::TextureReleaser releaser)
+  : _release_texture(releaser) {
+  _open_retired = std::make_shared<WindowSnapshot::_RetiredTextures>();
+  _open_retired->release = _release_texture;
+
+  WindowSnapshot* empty = _takeBuffer();
+  empty->_retired = _open_retired;
+  _current = std::shared_ptr<const WindowSnapshot>(empty, _recycle);
+}
+
+
+void SnapshotPublisher::_recycle(WindowSnapshot* snapshot) {
+  // Frees whatever was retired while it was the latest, unless an older snapshot still needs it
+  snapshot->_retired.reset();
+  snapshot->_in_use.store(false, std::memory_order_release);
+}
+
+
+WindowSnapshot* SnapshotPublisher::_takeBuffer() {
+  for (const std::unique_ptr<WindowSnapshot>& snapshot : _pool) {
+    if (!snapshot->_in_use.load(std::memory_order_acquire)) {
+      snapshot->_in_use.store(true, std::memory_order_relaxed);
+      return snapshot.get();
+    }
+  }
+
+  // Every buffer is still pinned by a reader
+  _pool.push_back(std::make_unique<WindowSnapshot>());
+  _pool.back()->_in_use.store(true, std::memory_order_relaxed);
+  return _pool.back().get();
+}
+
+
+void SnapshotPublisher::_build(WindowSnapshot& snapshot, const WindowRegistry& registry, const TabGroupMap& tab_groups) {
+  // Clearing keeps the capacity of a recycled snapshot
+  snapshot._ids.clear();
+  snapshot._hwnds.clear();
+  snapshot._titles.clear();
+  snapshot._title_hashes.clear();
+  snapshot._textures.clear();
+  snapshot._texture_sizes.clear();
+  snapshot._texture_uvs.clear();
+  snapshot._icons.clear();
+  snapshot._flags.clear();
+  snapshot._last_focused.clear();
+  snapshot._pids.clear();
+  snapshot._title_chars.clear();
+  snapshot._groups.clear();
+  snapshot._group_words = registry.groupWords();
+  snapshot._slot_ids.clear();
+  snapshot._slot_rows.clear();
+
+  // Copy rows in MRU order
+  for (WindowId id = registry.mruFront(); id != INVALID_WINDOW_ID; id = registry.mruNext(id)) {
+    const WindowView info = registry.view(registry.row(id));
+    const std::uint32_t new_row = static_cast<std::uint32_t>(snapshot._ids.size());
+
+    snapshot._ids.push_back(info.id);
+    snapshot._hwnds.push_back(info.hwnd);
+    snapshot._titles.push_back(WindowSnapshot::_TitleSpan{
+      static_cast<std::uint32_t>(snapshot._title_chars.size()),
+      static_cast<std::uint32_t>(info.title.size())
+    });
+    snapshot._title_chars.insert(snapshot._title_chars.end(), info.title.begin(), info.title.end());
+    snapshot._title_chars.push_back('\0');
+    snapshot._title_hashes.push_back(info.title_hash);
+    snapshot._textures.push_back(info.tex);
+    snapshot._texture_sizes.push_back(info.tex_size);
+    snapshot._texture_uvs.push_back(ImVec4(info.tex_uv0.x, info.tex_uv0.y, info.tex_uv1.x, info.tex_uv1.y));
+    snapshot._icons.push_back(info.icon);
+    snapshot._flags.push_back(info.flags);
+    snapshot._last_focused.push_back(info.last_focused);
+    snapshot._pids.push_back(info.pid);
+    snapshot._groups.insert(snapshot._groups.end(), info.groups, info.groups + info.group_words);
+
+    const std::uint32_t slot = WindowRegistry::slotOf(info.id);
+    if (slot >= snapshot._slot_ids.size()) {
+      snapshot._slot_ids.resize(slot + 1, INVALID_WINDOW_ID);
+      snapshot._slot_rows.resize(slot + 1, WindowRegistry::NO_ROW);
+    }
+    snapshot._slot_ids[slot] = info.id;
+    snapshot._slot_rows[slot] = new_row;
+  }
+
+  snapshot._group_sizes = registry.groupSizes();
+  snapshot._tab_groups = tab_groups;
+}
+
+
+void SnapshotPublisher::publish(const WindowRegistry& registry, const TabGroupMap& tab_groups) {
+  WindowSnapshot* next = _takeBuffer();
+  _build(*next, registry, tab_groups);
+  next->_version = ++_version;
+
+  // Textures retired from now on may still be seen by the outgoing snapshot
+  auto retired = std::make_shared<WindowSnapshot::_RetiredTextures>();
+  retired->release = _release_texture;
+  _open_retired->next = retired;
+  _open_retired = retired;
+  next->_retired = std::move(retired);
+
+  // The outgoing snapshot goes back to the pool as soon as its last reader lets go
+  std::atomic_store_explicit(&_current, std::shared_ptr<const WindowSnapshot>(next, _recycle), std::memory_order_release);
+}
@@ -0,0 +1,253 @@
+#ifndef WINDOW_SNAPSHOT_HPP
+#define WINDOW_SNAPSHOT_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "imgui.h"
+
+#include "window_handle.hpp"
+#include "window_registry.hpp"
+#include "tab_groups.hpp"
+
+
+/**
+ * @brief Immutable copy of the registry and the tab groups.
+ *
+ * Taken by a SnapshotPublisher once per batch of window events, then only ever read.
+ * Rows are stored in most-recently-focused order, so the open tabs are a straight
+ * walk over [0, size()).
+ *
+ * NOTE: Textures referenced by a snapshot stay alive for as long as it (or any older
+ *       snapshot) is held, even if the registry has replaced them since.
+ */
+class WindowSnapshot {
+  friend class SnapshotPublisher;
+
+  private:
+    /**
+     * @brief Location of a title inside the title buffer
+     */
+    struct _TitleSpan {
+      std::uint32_t offset;
+      std::uint32_t length; // Excludes the NUL terminator
+    };
+
+    /**
+     * @brief Textures retired while one snapshot was the latest.
+     *
+     * Each bag keeps the next one alive, so a bag is only released once its own
+     * snapshot and every older one are gone.
+     */
+    struct _RetiredTextures {
+      WindowRegistry::TextureReleaser release = nullptr;
+      std::vector<ImTextureID> textures;
+      std::shared_ptr<_RetiredTextures> next;
+
+      ~_RetiredTextures();
+    };
+
+    std::uint64_t _version = 0;
+
+    // ---------------- Columns, indexed by row ----------------
+    std::vector<WindowId> _ids;
+    std::vector<HWND> _hwnds;
+    std::vector<_TitleSpan> _titles;
+    std::vector<std::uint64_t> _title_hashes;
+    std::vector<ImTextureID> _textures;
+    std::vector<ImVec2> _texture_sizes;
+    std::vector<ImVec4> _texture_uvs; // uv0 in xy, uv1 in zw
+    std::vector<ImTextureID> _icons;
+    std::vector<std::uint32_t> _flags;
+    std::vector<std::chrono::steady_clock::time_point> _last_focused;
+    std::vector<std::uint32_t> _pids;
+    std::vector<char> _title_chars;
+    std::vector<std::uint64_t> _groups; // Membership bitsets, _group_words words per row
+    std::uint32_t _group_words = 1;
+    std::vector<std::uint32_t> _group_sizes;
+
+    // ---------------- Lookup, indexed by slot ----------------
+    std::vector<WindowId> _slot_ids;
+    std::vector<std::uint32_t> _slot_rows;
+
+    TabGroupMap _tab_groups;
+    std::shared_ptr<_RetiredTextures> _retired;
+    std::atomic<bool> _in_use{false}; // Cleared once the last reader lets go
+
+  public:
+    /**
+     * @brief Gets the number of the publish that produced this snapshot
+     * @returns std::uint64_t: Version, increases with every publish
+     */
+    std::uint64_t version() const {
+      return _version;
+    }
+
+
+    /**
+     * @brief Resolves a handle to its row
+     * @param id: Handle of the window
+     * @returns std::uint32_t: Row, or WindowRegistry::NO_ROW if the window wasn't alive when the snapshot was taken
+     */
+    std::uint32_t row(const WindowId id) const;
+
+
+    /**
+     * @brief Resolves a handle to a view of its row
+     * @param id: Handle of the window
+     * @returns std::optional<WindowView>: View, or nullopt if the window wasn't alive when the snapshot was taken
+     */
+    std::optional<WindowView> get(const WindowId id) const;
+
+
+    /**
+     * @brief Builds a view of a row
+     *
+     * NOTE: The view's title points into the snapshot and lives exactly as long.
+     * @param row: Row in [0, size())
+     * @returns WindowView: View of the row
+     */
+    WindowView view(const std::uint32_t row) const;
+
+
+    /**
+     * @brief Checks if a row is a member of a tab group, without building a view
+     * @param row: Row in [0, size())
+     * @param group: Id of the group
+     * @returns bool: True/False of being a member
+     */
+    bool inGroup(const std::uint32_t row, const TabGroupId group) const {
+      const std::uint32_t word = group / 64;
+      return word < _group_words && ((_groups[static_cast<std::size_t>(row) * _group_words + word] >> (group % 64)) & 1u);
+    }
+
+
+    /**
+     * @brief Gets the amount of windows in a tab group
+     * @param group: Id of the group
+     * @returns std::uint32_t: Member count
+     */
+    std::uint32_t groupSize(const TabGroupId group) const {
+      return group < _group_sizes.size() ? _group_sizes[group] : 0;
+    }
+
+
+    /**
+     * @brief Gets the tab groups as they were when the snapshot was taken
+     * @returns const TabGroupMap&: Tab groups
+     */
+    const TabGroupMap& tabGroups() const {
+      return _tab_groups;
+    }
+
+
+    /**
+     * @brief Gets the window handles, most recently focused first
+     * @returns const std::vector<WindowId>&: Handles, indexed by row
+     */
+    const std::vector<WindowId>& ids() const {
+      return _ids;
+    }
+
+
+    /**
+     * @brief Gets the amount of windows in the snapshot
+     * @returns std::size_t: Window count
+     */
+    std::size_t size() const {
+      return _ids.size();
+    }
+};
+
+
+/**
+ * @brief Publishes WindowSnapshots from one writer to any amount of readers.
+ *
+ * The writer builds the next snapshot on the side and makes it visible with a
+ * single atomic pointer swap, so a reader pinning the latest snapshot never waits
+ * on a build. Snapshot buffers are pooled: once the last reader of an old snapshot
+ * lets go it's marked free and rebuilt in place by a later publish, so in steady
+ * state only two or three buffers ever exist.
+ *
+ * NOTE: publish() and retire() must only be called by the writer, acquire() is safe from any thread.
+ * NOTE: The publisher must outlive every pinned snapshot.
+ */
+class SnapshotPublisher {
+  private:
+    std::vector<std::unique_ptr<WindowSnapshot>> _pool;              // Every snapshot buffer, declared first so it outlives _current
+    std::shared_ptr<const WindowSnapshot> _current;                  // Only accessed through std::atomic_load/store
+    std::shared_ptr<WindowSnapshot::_RetiredTextures> _open_retired; // Collects textures retired while _current is the latest
+    WindowRegistry::TextureReleaser _release_texture;
+    std::uint64_t _version = 0;
+
+
+    /**
+     * @brief Fills a snapshot from the registry and tab groups
+     */
+    static void _build(WindowSnapshot& snapshot, const WindowRegistry& registry, const TabGroupMap& tab_groups);
+
+
+    /**
+     * @brief Deleter of published snapshots, hands the buffer back to the pool
+     */
+    static void _recycle(WindowSnapshot* snapshot);
+
+
+    /**
+     * @brief Gets a free buffer from the pool, or grows it
+     */
+    WindowSnapshot* _takeBuffer();
+
+  public:
+    /**
+     * @brief Creates a publisher holding an empty snapshot
+     * @param releaser: Function used to free retired textures once no snapshot can see them
+     */
+    explicit SnapshotPublisher(const WindowRegistry::TextureReleaser releaser);
+
+
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+
+    /**
+     * @brief Takes a snapshot of the registry and tab groups and makes it the latest
+     *
+     * NOTE: Writer only.
+     * @param registry: Registry to copy
+     * @param tab_groups: Tab groups to copy
+     */
+    void publish(const WindowRegistry& registry, const TabGroupMap& tab_groups);
+
+
+    /**
+     * @brief Pins the latest snapshot
+     *
+     * Usage  ->   const auto snapshot = publisher.acquire(); // Hold for the whole frame
+     * @returns std::shared_ptr<const WindowSnapshot>: Latest snapshot, never null
+     */
+    std::shared_ptr<const WindowSnapshot> acquire() const {
+      return std::atomic_load_explicit(&_current, std::memory_order_acquire);
+    }
+
+
+    /**
+     * @brief Defers the release of a texture until no snapshot can reference it
+     *
+     * NOTE: Writer only. Meant to be the registry's texture releaser.
+     * @param tex: Texture the registry no longer uses
+     */
+    void retire(const ImTextureID tex) {
+      _open_retired->textures.push_back(tex);
+    }
+};
+
+
+#endif // WINDOW_SNAPSHOT_HPP
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string>
 #include <windows.h>
 #include "core/application.hpp"
 #include "core/config.hpp"
@@ -6,10 +7,20 @@
 
 
 // ---------------- WinMain ----------------
-int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
+int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR lpCmdLine, int) {
   // Ensure only one instance is running before proceeding.
   if (isInstanceUnique()) {
     Config::init();
+
+    // "--record-events <path>" records the window event stream for BetterAltTabReplay
+    static constexpr const char* RECORD_FLAG = "--record-events ";
+    const std::string args = lpCmdLine ? lpCmdLine : "";
+    if (args.rfind(RECORD_FLAG, 0) == 0) {
+      const std::string path = args.substr(std::char_traits<char>::length(RECORD_FLAG));
+      if (!Application::startEventRecording(path)) {
+        std::cout << "Failed to open event recording " << path << std::endl;
+      }
+    }
   
     if (Application::createApplication(hInstance)) {
       Application::runApplication();
@@ -0,0 +1,388 @@
+/*
+Packing, repacking and draw call check of the thumbnail atlas.
+
+Usage  ->   BetterAltTabAtlas [--windows N] [--steps N] [--churn N] [--resizes N]
+                              [--cell-width N] [--cell-height N] [--page N]
+                              [--max-pages N] [--moves N] [--seed N]
+
+--windows windows of random sizes are fitted into a --cell-width x --cell-height tab cell
+and placed in a ThumbnailAtlas of --page pixel pages, textures kept in memory. Then for
+--steps steps --churn windows close and as many open, and --resizes windows change size,
+the way a desktop does over a session. After every step the atlas is pruned against the
+registry and repacked by up to --moves slots, and every thumbnail is checked to be exactly
+where the registry says, at every level. Runs once without repacking and once with it,
+reports the pages used, how much of them live slots take, and the thumbnails that didn't
+fit and needed a texture of their own.
+
+Then the panel of the last step is drawn by a headless ImGui the way ImGuiUI does it, with
+a texture per window, with the atlas, and with the atlas drawn after the table, sorted by
+page. Reports the draw commands of every frame.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <algorithm>
+
+#include "imgui.h"
+
+#include "../core/window_registry.hpp"
+#include "../core/thumbnail_atlas.hpp"
+#include "../core/thumbnail_mips.hpp"
+#include "memory_textures.hpp"
+
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    std::uint32_t windows = 40;
+    std::uint32_t steps = 200;
+    std::uint32_t churn = 2;
+    std::uint32_t resizes = 1;
+    ThumbnailSize cell{ 640, 360 }; // Config::tab_groups_tab_width/height defaults
+    int page = ATLAS_PAGE_SIZE;
+    std::uint32_t max_pages = static_cast<std::uint32_t>(ATLAS_MAX_PAGES);
+    std::uint32_t moves = 8;
+    std::uint32_t seed = 1;
+  };
+
+
+  /**
+   * @brief What a run left behind
+   */
+  struct Totals {
+    std::size_t peak_pages = 0;
+    double occupancy = 0.0;       // Summed every step
+    std::uint64_t placed = 0;
+    std::uint64_t fallbacks = 0;  // Thumbnails given a texture of their own
+    std::uint64_t moves = 0;
+    std::uint64_t repacks = 0;
+    double maintenance_us = 0.0;  // Prune and repack, summed every step
+  };
+
+
+  MemoryTextureUploader* g_textures = nullptr;
+
+
+  /**
+   * @brief Registry and atlas releaser
+   */
+  void releaseTexture(const ImTextureID tex) {
+    if (g_textures) g_textures->release(tex);
+  }
+
+
+  /**
+   * @brief Fills every level of a thumbnail with a pattern only it has
+   */
+  void drawThumbnail(const ThumbnailSize size, const std::uint32_t seed, std::vector<std::uint8_t>& chain) {
+    chain.resize(mipLevelOffset(size, THUMBNAIL_MIP_LEVELS));
+    std::uint32_t state = seed * 2654435761u + 1;
+    for (std::size_t i = 0; i < chain.size(); i += 4) {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      std::memcpy(chain.data() + i, &state, 4);
+    }
+  }
+
+
+  /**
+   * @brief Thumbnail size of a random window
+   */
+  ThumbnailSize randomThumbnail(const Options& opts, std::mt19937& rng) {
+    std::uniform_int_distribution<int> width(400, 2560);
+    std::uniform_int_distribution<int> height(300, 1440);
+    return fitThumbnail(width(rng), height(rng), opts.cell.width, opts.cell.height);
+  }
+
+
+  /**
+   * @brief A simulated window, what its thumbnail holds
+   */
+  struct Window {
+    HWND hwnd;
+    WindowId id;
+    ThumbnailSize size;
+    std::uint32_t seed;
+  };
+
+
+  /**
+   * @brief Gives a window its thumbnail, in the atlas if it fits, the way _applyCaptures does
+   */
+  void upload(WindowRegistry& registry, ThumbnailAtlas& atlas, MemoryTextureUploader& textures, Window& window,
+    std::vector<std::uint8_t>& chain, Totals& totals) {
+    drawThumbnail(window.size, window.seed, chain);
+    AtlasSlot slot;
+    if (atlas.place(window.id, chain.data(), window.size, THUMBNAIL_MIP_LEVELS, slot)) {
+      registry.setTexture(window.id, slot.page, slot.size, slot.region);
+      totals.placed++;
+      return;
+    }
+    const ImTextureID tex = textures.create(chain.data(), window.size.width, window.size.height, THUMBNAIL_MIP_LEVELS);
+    registry.setTexture(window.id, tex, ImVec2(static_cast<float>(window.size.width), static_cast<float>(window.size.height)));
+    totals.fallbacks++;
+  }
+
+
+  /**
+   * @brief Checks every thumbnail is where the registry says
+   * @returns bool: False on the first one that isn't
+   */
+  bool verify(const WindowRegistry& registry, const ThumbnailAtlas& atlas, const MemoryTextureUploader& textures,
+    const std::vector<Window>& windows, const int page_size, std::vector<std::uint8_t>& chain) {
+    for (const Window& window : windows) {
+      const std::optional<WindowView> info = registry.get(window.id);
+      if (!info || !(info->flags & WINDOW_FLAG_HAS_THUMBNAIL)) return false;
+      drawThumbnail(window.size, window.seed, chain);
+
+      // A texture of its own
+      if (!(info->flags & WINDOW_FLAG_SHARED_TEXTURE)) {
+        if (textures.pixels(info->tex) != chain) return false;
+        continue;
+      }
+
+      AtlasSlot slot;
+      if (!atlas.slot(window.id, slot) || slot.page != info->tex) return false;
+      if (slot.region.uv0.x != info->tex_uv0.x || slot.region.uv0.y != info->tex_uv0.y) return false;
+      if (slot.region.uv1.x != info->tex_uv1.x || slot.region.uv1.y != info->tex_uv1.y) return false;
+
+      const ThumbnailSize page{ page_size, page_size };
+      const int x = static_cast<int>(slot.region.uv0.x * page_size + 0.5f);
+      const int y = static_cast<int>(slot.region.uv0.y * page_size + 0.5f);
+      const std::vector<std::uint8_t>& pixels = textures.pixels(info->tex);
+      for (int level = 0; level < THUMBNAIL_MIP_LEVELS; level++) {
+        const ThumbnailSize level_size = mipLevelSize(window.size, level);
+        const ThumbnailSize level_page = mipLevelSize(page, level);
+        for (int row = 0; row < level_size.height; row++) {
+          const std::uint8_t* held = pixels.data() + mipLevelOffset(page, level)
+            + ((static_cast<std::size_t>((y >> level) + row) * level_page.width) + (x >> level)) * 4;
+          const std::uint8_t* want = chain.data() + mipLevelOffset(window.size, level) + static_cast<std::size_t>(row) * level_size.width * 4;
+          if (std::memcmp(held, want, static_cast<std::size_t>(level_size.width) * 4) != 0) return false;
+        }
+      }
+    }
+    return true;
+  }
+
+
+  /**
+   * @brief Runs the desktop's session through the atlas
+   * @param moves: Most slots repacked per step, 0 never repacks
+   * @param windows: Receives the windows left at the end
+   * @returns bool: False if a thumbnail ever wasn't where the registry said
+   */
+  bool run(const Options& opts, const std::uint32_t moves, MemoryTextureUploader& textures, WindowRegistry& registry,
+    ThumbnailAtlas& atlas, std::vector<Window>& windows, Totals& totals) {
+    std::mt19937 rng(opts.seed);
+    std::vector<std::uint8_t> chain;
+    std::vector<WindowId> moved;
+    std::uintptr_t next_handle = 1;
+    std::uint32_t next_seed = 1;
+
+    const auto open = [&]() {
+      const HWND hwnd = reinterpret_cast<HWND>(next_handle++);
+      Window window{ hwnd, registry.insert(hwnd, "window"), randomThumbnail(opts, rng), next_seed++ };
+      upload(registry, atlas, textures, window, chain, totals);
+      windows.push_back(window);
+    };
+
+    for (std::uint32_t i = 0; i < opts.windows; i++) open();
+
+    for (std::uint32_t step = 0; step < opts.steps; step++) {
+      // Windows come and go, some change size
+      for (std::uint32_t i = 0; i < opts.churn && !windows.empty(); i++) {
+        const std::size_t victim = std::uniform_int_distribution<std::size_t>(0, windows.size() - 1)(rng);
+        registry.erase(windows[victim].hwnd);
+        windows[victim] = windows.back();
+        windows.pop_back();
+      }
+      for (std::uint32_t i = 0; i < opts.churn; i++) open();
+      for (std::uint32_t i = 0; i < opts.resizes && !windows.empty(); i++) {
+        Window& window = windows[std::uniform_int_distribution<std::size_t>(0, windows.size() - 1)(rng)];
+        window.size = randomThumbnail(opts, rng);
+        window.seed = next_seed++;
+        upload(registry, atlas, textures, window, chain, totals);
+      }
+
+      // What the UI thread does every frame
+      const auto start = Clock::now();
+      atlas.prune(registry);
+      atlas.defragment(moved, moves);
+      for (const WindowId id : moved) {
+        AtlasSlot slot;
+        if (atlas.slot(id, slot)) registry.setTexture(id, slot.page, slot.size, slot.region);
+      }
+      totals.maintenance_us += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+      totals.peak_pages = std::max(totals.peak_pages, atlas.pages());
+      totals.occupancy += atlas.occupancy();
+      if (!verify(registry, atlas, textures, windows, opts.page, chain)) {
+        std::cout << "MISMATCH:  step " << step << ", a thumbnail isn't where the registry says" << std::endl;
+        return false;
+      }
+    }
+    totals.moves = atlas.moves();
+    totals.repacks = atlas.repacks();
+    return true;
+  }
+
+
+  /**
+   * @brief How the panel draws the thumbnails
+   */
+  enum class DrawMode {
+    OWN_TEXTURES, // A texture per window, drawn in its cell
+    ATLAS_INLINE, // Atlas pages, drawn in their cells
+    ATLAS_SORTED, // Atlas pages, drawn after the table sorted by page
+  };
+
+
+  /**
+   * @brief Image drawn after the table
+   */
+  struct DeferredImage {
+    ImTextureID tex;
+    ImVec2 p0, p1, uv0, uv1;
+  };
+
+
+  /**
+   * @brief Draws a frame of the panel the way ImGuiUI does
+   * @returns int: Draw commands of the frame
+   */
+  int drawPanel(const WindowRegistry& registry, const Options& opts, const DrawMode mode) {
+    const ImVec2 cell = ImVec2(static_cast<float>(opts.cell.width), static_cast<float>(opts.cell.height));
+    std::vector<DeferredImage> deferred;
+
+    ImGui::NewFrame();
+    ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+    ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+    ImGui::Begin("Open Tabs", nullptr, ImGuiWindowFlags_NoDecoration);
+    const int columns = std::max(static_cast<int>(ImGui::GetContentRegionAvail().x / (cell.x + ImGui::GetStyle().ItemSpacing.x)), 1);
+    if (ImGui::BeginTable("Tab Grid", columns, ImGuiTableFlags_NoPadOuterX)) {
+      for (std::uint32_t row = 0; row < registry.size(); row++) {
+        const WindowView info = registry.view(row);
+        ImGui::TableNextColumn();
+        const ImVec2 pos = ImGui::GetCursorScreenPos();
+        const float line = ImGui::GetTextLineHeight();
+        ImGui::Dummy(ImVec2(cell.x, cell.y + line * 2.0f));
+
+        ImDrawList* dl = ImGui::GetWindowDrawList();
+        const ImVec2 image0 = ImVec2(pos.x, pos.y + line + 5.0f);
+        const ImVec2 image1 = ImVec2(image0.x + cell.x, image0.y + cell.y);
+        dl->AddText(ImVec2(pos.x, pos.y + 5.0f), IM_COL32_WHITE, "window");
+        dl->AddRectFilled(image0, image1, IM_COL32(40, 40, 40, 255));
+
+        const ImTextureID tex = mode == DrawMode::OWN_TEXTURES ? static_cast<ImTextureID>(1000000 + row) : info.tex;
+        const ImVec2 uv0 = mode == DrawMode::OWN_TEXTURES ? ImVec2(0.0f, 0.0f) : info.tex_uv0;
+        const ImVec2 uv1 = mode == DrawMode::OWN_TEXTURES ? ImVec2(1.0f, 1.0f) : info.tex_uv1;
+        if (mode == DrawMode::ATLAS_SORTED) deferred.push_back(DeferredImage{ tex, image0, image1, uv0, uv1 });
+        else                                dl->AddImage(tex, image0, image1, uv0, uv1);
+      }
+      ImGui::EndTable();
+    }
+    std::stable_sort(deferred.begin(), deferred.end(), [](const DeferredImage& a, const DeferredImage& b) { return a.tex < b.tex; });
+    for (const DeferredImage& image : deferred) {
+      ImGui::GetWindowDrawList()->AddImage(image.tex, image.p0, image.p1, image.uv0, image.uv1);
+    }
+    ImGui::End();
+    ImGui::Render();
+
+    const ImDrawData* data = ImGui::GetDrawData();
+    int commands = 0;
+    for (const ImDrawList* list : data->CmdLists) commands += list->CmdBuffer.Size;
+    return commands;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options
+  Options opts;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--windows")     opts.windows = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--steps")       opts.steps = value;
+    else if (opt == "--churn")       opts.churn = value;
+    else if (opt == "--resizes")     opts.resizes = value;
+    else if (opt == "--cell-width")  opts.cell.width = std::max(static_cast<int>(value), 16);
+    else if (opt == "--cell-height") opts.cell.height = std::max(static_cast<int>(value), 16);
+    else if (opt == "--page")        opts.page = std::max(static_cast<int>(value), 256);
+    else if (opt == "--max-pages")   opts.max_pages = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--moves")       opts.moves = value;
+    else if (opt == "--seed")        opts.seed = value;
+    else {
+      std::cout << "Unknown option " << opt << ", see the top of atlas_bench.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "desktop:   " << opts.windows << " windows, " << opts.steps << " steps of " << opts.churn << " closed and opened, "
+            << opts.resizes << " resized, " << opts.cell.width << "x" << opts.cell.height << " cells\n";
+  std::cout << "atlas:     " << opts.page << "px pages, " << opts.max_pages << " at most, "
+            << (mipLevelOffset(ThumbnailSize{ opts.page, opts.page }, THUMBNAIL_MIP_LEVELS) / (1024.0 * 1024.0)) << " MB each\n";
+
+  // Headless ImGui, draw lists only
+  ImGui::CreateContext();
+  ImGuiIO& io = ImGui::GetIO();
+  io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+  io.DeltaTime = 1.0f / 60.0f;
+  io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+  io.IniFilename = nullptr;
+
+  int own = 0, inline_atlas = 0, sorted_atlas = 0;
+  std::size_t pages = 0;
+  for (const std::uint32_t moves : { 0u, opts.moves }) {
+    MemoryTextureUploader textures;
+    g_textures = &textures;
+    std::vector<Window> windows;
+    Totals totals;
+    {
+      WindowRegistry registry;
+      registry.setTextureReleaser(releaseTexture);
+      ThumbnailAtlas atlas(textures, releaseTexture, opts.page, opts.max_pages);
+      if (!run(opts, moves, textures, registry, atlas, windows, totals)) return EXIT_FAILURE;
+
+      const double steps = std::max<std::uint32_t>(opts.steps, 1);
+      std::cout << (moves == 0 ? "no repack: " : "repack:    ") << std::fixed << std::setprecision(1)
+                << atlas.pages() << " pages (" << totals.peak_pages << " at most), "
+                << (100.0 * atlas.occupancy()) << "% taken at the end, " << (100.0 * totals.occupancy / steps) << "% on average, "
+                << totals.fallbacks << " of " << (totals.placed + totals.fallbacks) << " thumbnails on their own, "
+                << totals.moves << " moved in " << totals.repacks << " repacks, "
+                << std::setprecision(2) << (totals.maintenance_us / steps) << " us per frame copying in memory\n";
+
+      // The panel at the end of the session, with the repacked atlas
+      if (moves != 0) {
+        own = drawPanel(registry, opts, DrawMode::OWN_TEXTURES);
+        inline_atlas = drawPanel(registry, opts, DrawMode::ATLAS_INLINE);
+        sorted_atlas = drawPanel(registry, opts, DrawMode::ATLAS_SORTED);
+        pages = atlas.pages();
+      }
+    }
+    if (textures.count() != 0) {
+      std::cout << "LEAK:      " << textures.count() << " textures left after the registry and the atlas are gone" << std::endl;
+      return EXIT_FAILURE;
+    }
+    g_textures = nullptr;
+  }
+  ImGui::DestroyContext();
+
+  std::cout << "draws:     " << opts.windows << " windows, " << own << " commands with a texture each, "
+            << inline_atlas << " with the atlas drawn in the cells, " << sorted_atlas << " drawn after the table by page ("
+            << pages << " pages)\n";
+  std::cout << "checked:   every thumbnail was where the registry said after every step, at every level\n";
+  return EXIT_SUCCESS;
+}
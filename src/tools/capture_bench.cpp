@@ -0,0 +1,314 @@
+/*
+Headless benchmark of opening the tab groups panel against a simulated desktop.
+
+Usage  ->   BetterAltTabCapture [--windows N] [--workers N] [--capture-latency-us N]
+                                [--capture-width N] [--capture-height N] [--ui-frame-us N]
+                                [--budget-mb N] [--opens N] [--working-set N]
+                                [--cell-width N] [--cell-height N] [--repaint-percent N]
+                                [--ticking-percent N] [--idle-ms N]
+
+Opening the panel used to capture every window on the UI thread before the next frame.
+Now the captures are requested from a CapturePool and the UI keeps running frames,
+showing placeholders and uploading thumbnails as they come in. Reports when the first
+frame was drawn, when the first and the last thumbnail showed up, and the longest frame.
+Uploads are emulated with a copy into a per-window buffer. The pool fits captures into a
+--cell-width x --cell-height tab cell with mip levels (0 keeps them at full size), the
+memory a window's thumbnail takes is compared with its full size capture.
+
+Then the panel is opened --opens times through a ThumbnailCache of --budget-mb, switching
+between windows in between, mostly within the --working-set most recently focused ones.
+Reports how many thumbnails were still cached when the panel opened, the captures that
+had to come first, and how much memory the thumbnails held. The desktop runs for --idle-ms
+simulated milliseconds before every open: --repaint-percent of the windows repaint all the
+time, --ticking-percent only have a clock ticking in a corner, the rest change with their
+title. Captures of the size of the thumbnail held only send the tiles that changed, and
+nothing if none did, reports how many were patched or skipped and the upload bandwidth
+it saved.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <random>
+
+#include "../core/simulated_desktop.hpp"
+#include "../core/window_deltas.hpp"
+#include "../core/window_registry.hpp"
+#include "../core/capture_pool.hpp"
+#include "../core/thumbnail_cache.hpp"
+#include "../core/texture_uploader.hpp"
+#include "frame_stats.hpp"
+
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    SimulatedDesktopConfig desktop;
+    std::uint32_t workers = CapturePool::DEFAULT_WORKERS;
+    std::uint32_t ui_frame_us = 16000;
+    std::uint32_t budget_mb = 64;
+    std::uint32_t opens = 10;
+    std::uint32_t working_set = 8;
+    ThumbnailSize cell{ 640, 360 }; // Config::tab_groups_tab_width/height defaults
+    std::uint32_t idle_ms = 3000;
+  };
+
+
+  /**
+   * @brief Milliseconds since a time point
+   */
+  double msSince(const Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+
+  /**
+   * @brief Stands in for creating a texture from a capture
+   */
+  void upload(std::vector<std::uint8_t>& texture, const std::vector<std::uint8_t>& pixels) {
+    texture.resize(pixels.size());
+    std::memcpy(texture.data(), pixels.data(), texture.size());
+  }
+
+
+  /**
+   * @brief Stands in for a renderer, only hands out ids
+   */
+  class NullTextureUploader : public TextureUploader {
+    private:
+      ImTextureID _next = 1;
+
+    public:
+      ImTextureID create(const std::uint8_t*, const int, const int, const int) override { return _next++; }
+      bool update(const ImTextureID, const int, const TileRect&, const std::uint8_t*, const std::ptrdiff_t) override { return true; }
+      bool copy(const ImTextureID, const ImTextureID, const int, const TileRect&, const int, const int) override { return true; }
+  };
+
+
+  /**
+   * @brief Every capture on the UI thread, the way the tray menu used to do it
+   * @returns double: Time until the first frame with the panel, in milliseconds
+   */
+  double runSync(const WindowRegistry& registry, SimulatedDesktop& desktop) {
+    std::unordered_map<WindowId, std::vector<std::uint8_t>> textures;
+    std::vector<std::uint8_t> pixels;
+    int width, height;
+
+    const auto start = Clock::now();
+    for (const WindowId id : registry.ids()) {
+      if (desktop.capture(registry.get(id)->hwnd, pixels, width, height)) upload(textures[id], pixels);
+    }
+    return msSince(start);
+  }
+
+
+  /**
+   * @brief Captures on the pool while the UI runs frames
+   */
+  void runAsync(const Options& opts, const WindowRegistry& registry, SimulatedDesktop& desktop) {
+    std::unordered_map<WindowId, std::vector<std::uint8_t>> textures;
+    std::vector<CaptureResult> results;
+    CapturePool pool(desktop, opts.workers);
+    pool.setTargetSize(opts.cell);
+    pool.start();
+
+    // Open the panel: one request per window, in the order the panel shows them, asked twice
+    // like a second click while the first is still in flight
+    const auto start = Clock::now();
+    const std::vector<WindowId>& ids = registry.ids();
+    for (int pass = 0; pass < 2; pass++) {
+      for (std::uint32_t i = 0; i < ids.size(); i++) pool.request(ids[i], registry.get(ids[i])->hwnd, i);
+    }
+
+    FrameStats frames;
+    double first_frame_ms = -1.0;
+    double first_thumbnail_ms = -1.0;
+    double all_thumbnails_ms = -1.0;
+    auto next_frame = start;
+    while (all_thumbnails_ms < 0.0) {
+      const auto frame_start = Clock::now();
+      pool.take(results);
+      for (const CaptureResult& result : results) {
+        upload(textures[result.id], result.bgra);
+      }
+      pool.recycle(results);
+      frames.add(std::chrono::duration<double, std::micro>(Clock::now() - frame_start).count());
+
+      // Thumbnails not in yet are drawn as placeholders
+      if (first_frame_ms < 0.0) first_frame_ms = msSince(start);
+      if (first_thumbnail_ms < 0.0 && !textures.empty()) first_thumbnail_ms = msSince(start);
+      if (textures.size() + pool.failed() >= ids.size()) {
+        all_thumbnails_ms = msSince(start);
+      }
+
+      next_frame += std::chrono::microseconds(opts.ui_frame_us);
+      std::this_thread::sleep_until(next_frame);
+    }
+    pool.stop();
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "async:     first frame after " << first_frame_ms << " ms, first thumbnail after " << first_thumbnail_ms
+              << " ms, all " << textures.size() << " after " << all_thumbnails_ms << " ms\n"
+              << "pool:      " << opts.workers << " workers, " << pool.captured() << " captured, " << pool.failed()
+              << " failed, " << (2 * ids.size()) << " requests\n";
+    frames.print("ui work", "frames");
+
+    const double per_window = 1.0 / std::max<std::uint64_t>(pool.captured(), 1) / 1024.0;
+    const double full_kb = pool.sourceBytes() * per_window;
+    const double thumbnail_kb = pool.thumbnailBytes() * per_window;
+    std::cout << "memory:    " << full_kb << " KB per window at full size, " << thumbnail_kb << " KB fitted into "
+              << opts.cell.width << "x" << opts.cell.height << " with mips, " << (full_kb - thumbnail_kb)
+              << " KB saved per window (" << (100.0 * (1.0 - thumbnail_kb / std::max(full_kb, 1e-9))) << "%)\n";
+  }
+
+
+  /**
+   * @brief Opens the panel over and over through a thumbnail cache, switching windows in between
+   */
+  void runCache(const Options& opts, WindowRegistry& registry, SimulatedDesktop& desktop, WindowDeltaBuilder& builder) {
+    ThumbnailCache thumbnails(static_cast<std::size_t>(opts.budget_mb) << 20);
+    NullTextureUploader uploader;
+    std::vector<TileRect> rects;
+    WindowEventQueue queue;
+    WindowDeltaBatch batch;
+    std::vector<CaptureResult> results;
+    std::vector<WindowId> list;
+    CapturePool pool(desktop, opts.workers);
+    pool.setTargetSize(opts.cell);
+    pool.start();
+
+    std::mt19937 rng(1);
+    std::uint64_t working_hits = 0;
+    std::uint64_t working_lookups = 0;
+    std::size_t peak = 0;
+    for (std::uint32_t open = 0; open < opts.opens; open++) {
+      // Time passes, windows repaint and get new titles
+      desktop.step(opts.idle_ms, queue);
+      builder.build(queue, batch);
+      applyWindowDeltas(registry, batch);
+
+      // Switch a few times, mostly between the windows used lately
+      for (int i = 0; i < 4; i++) {
+        list.clear();
+        for (WindowId id = registry.mruFront(); id != INVALID_WINDOW_ID; id = registry.mruNext(id)) list.push_back(id);
+        const bool within = std::uniform_int_distribution<int>(0, 9)(rng) < 8;
+        const std::size_t span = within ? std::min<std::size_t>(opts.working_set, list.size()) : list.size();
+        registry.touch(registry.get(list[std::uniform_int_distribution<std::size_t>(0, span - 1)(rng)])->hwnd);
+      }
+
+      // Open the panel, listing windows in MRU order
+      list.clear();
+      for (WindowId id = registry.mruFront(); id != INVALID_WINDOW_ID; id = registry.mruNext(id)) list.push_back(id);
+      const std::uint32_t REFRESH_PRIORITY = static_cast<std::uint32_t>(list.size());
+      for (std::uint32_t i = 0; i < list.size(); i++) {
+        const bool cached = thumbnails.lookup(registry, list[i]);
+        if (i < opts.working_set) {
+          working_lookups++;
+          if (cached) working_hits++;
+        }
+        pool.request(list[i], registry.get(list[i])->hwnd, cached ? REFRESH_PRIORITY + i : i);
+      }
+
+      // Frames until every capture came in
+      do {
+        std::this_thread::sleep_for(std::chrono::microseconds(opts.ui_frame_us));
+        pool.take(results);
+        for (const CaptureResult& result : results) {
+          std::size_t sent = 0;
+          if (thumbnails.dirtyRects(registry, result.id, result.hashes, result.mip_levels, rects)
+            && uploadDirtyRects(uploader, registry.get(result.id)->tex, result.bgra.data(), ThumbnailSize{ result.width, result.height },
+              result.mip_levels, rects, sent)) {
+            thumbnails.patch(result.id, result.hashes, sent, result.bgra.size());
+            continue;
+          }
+          thumbnails.insert(registry, result.id, uploader.create(result.bgra.data(), result.width, result.height, result.mip_levels),
+            ImVec2(static_cast<float>(result.width), static_cast<float>(result.height)), result.bgra.size(), result.mip_levels, result.hashes);
+          peak = std::max(peak, thumbnails.used());
+        }
+        pool.recycle(results);
+      } while (pool.pending() != 0 || pool.captured() + pool.failed() < (open + 1) * list.size());
+    }
+    pool.stop();
+
+    const std::size_t every = static_cast<std::size_t>(pool.thumbnailBytes() / std::max<std::uint64_t>(pool.captured(), 1)) * registry.size();
+    std::cout << std::fixed << std::setprecision(1)
+              << "cache:     " << opts.opens << " opens, " << thumbnails.hits() << " hits, " << thumbnails.misses()
+              << " misses (placeholders), " << thumbnails.evictions() << " evictions\n"
+              << "working:   " << (100.0 * working_hits / std::max<std::uint64_t>(working_lookups, 1))
+              << "% of the " << opts.working_set << " most recently focused were cached when opened\n"
+              << "memory:    " << (peak / (1024.0 * 1024.0)) << " MB peak for a budget of " << opts.budget_mb
+              << " MB, every thumbnail would take " << (every / (1024.0 * 1024.0)) << " MB\n";
+
+    const std::uint64_t refreshes = std::max<std::uint64_t>(thumbnails.uploads() + thumbnails.patches() + thumbnails.skippedUploads(), 1);
+    const double total_mb = (thumbnails.uploadedBytes() + thumbnails.skippedBytes()) / (1024.0 * 1024.0);
+    std::cout << "uploads:   " << thumbnails.uploads() << " whole, " << thumbnails.patches() << " by tiles ("
+              << (100.0 * thumbnails.patches() / refreshes) << "%), " << thumbnails.skippedUploads() << " skipped unchanged ("
+              << (100.0 * thumbnails.skippedUploads() / refreshes) << "%), " << (thumbnails.skippedBytes() / (1024.0 * 1024.0))
+              << " of " << total_mb << " MB of upload bandwidth saved\n";
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options, defaults to a busy desktop of big windows
+  Options opts;
+  opts.desktop.window_count = 40;
+  opts.desktop.storm_windows = 0;
+  opts.desktop.capture_latency_us = 8000;
+  opts.desktop.churn_per_s = 0.0;         // Same windows every open
+  opts.desktop.focus_changes_per_s = 0.0; // Switched by runCache()
+  opts.desktop.title_changes_per_s = 2.0;
+  opts.desktop.repaint_ratio = 0.1;       // Videos, games, terminals scrolling
+  opts.desktop.ticking_ratio = 0.2;       // Chat and mail with a clock or a counter
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--windows")            opts.desktop.window_count = value;
+    else if (opt == "--workers")            opts.workers = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--capture-latency-us") opts.desktop.capture_latency_us = value;
+    else if (opt == "--capture-width")      opts.desktop.capture_width = static_cast<int>(value);
+    else if (opt == "--capture-height")     opts.desktop.capture_height = static_cast<int>(value);
+    else if (opt == "--ui-frame-us")        opts.ui_frame_us = value;
+    else if (opt == "--budget-mb")          opts.budget_mb = value;
+    else if (opt == "--opens")              opts.opens = value;
+    else if (opt == "--working-set")        opts.working_set = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--cell-width")         opts.cell.width = static_cast<int>(value);
+    else if (opt == "--cell-height")        opts.cell.height = static_cast<int>(value);
+    else if (opt == "--repaint-percent")    opts.desktop.repaint_ratio = value / 100.0;
+    else if (opt == "--ticking-percent")    opts.desktop.ticking_ratio = value / 100.0;
+    else if (opt == "--idle-ms")            opts.idle_ms = value;
+    else {
+      std::cout << "Unknown option " << opt << ", see the top of capture_bench.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  SimulatedDesktop desktop(opts.desktop);
+  WindowDeltaBuilder builder(desktop);
+  WindowRegistry registry;
+  WindowDeltaBatch batch;
+  builder.addAll(batch);
+  applyWindowDeltas(registry, batch);
+
+  std::cout << "desktop:   " << registry.size() << " windows of " << opts.desktop.capture_width << "x"
+            << opts.desktop.capture_height << ", " << opts.desktop.capture_latency_us << " us per capture\n";
+  const double sync_ms = runSync(registry, desktop);
+  std::cout << std::fixed << std::setprecision(1)
+            << "sync:      first frame after " << sync_ms << " ms, every thumbnail with it\n";
+  runAsync(opts, registry, desktop);
+  runCache(opts, registry, desktop, builder);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,286 @@
+/*
+Correctness and savings check of updating thumbnail textures by the tiles that changed.
+
+Usage  ->   BetterAltTabDelta [--frames N] [--width N] [--height N] [--seed N]
+
+Synthetic frame sequences of a --width x --height window (nothing moving, a ticking
+clock, a blinking cursor, typing, a video in the middle, scrolling, noise, a resize) go
+through the same steps as a capture: fitted into a tab cell with mip levels, hashed in
+tiles, diffed against the previous frame, and only the changed rectangles sent into a
+texture kept in memory. After every frame the texture has to hold exactly what a whole
+upload of that frame would, at every level. Runs at full size, in a 640x360 cell, and in
+an odd sized cell whose levels don't halve exactly. Reports the rectangles sent, the bytes
+they took against whole uploads, and the time spent diffing. Exits with a failure if a
+texture ever differs.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "../core/tile_hash.hpp"
+#include "../core/tile_diff.hpp"
+#include "../core/texture_uploader.hpp"
+#include "../core/thumbnail_mips.hpp"
+#include "memory_textures.hpp"
+
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    std::uint32_t frames = 60;
+    int width = 1280;
+    int height = 720;
+    std::uint32_t seed = 1;
+  };
+
+
+  /**
+   * @brief Window contents, drawn into for every frame
+   */
+  struct Canvas {
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> bgra;
+
+
+    void resize(const int w, const int h) {
+      width = w;
+      height = h;
+      bgra.resize(static_cast<std::size_t>(w) * h * 4);
+    }
+
+
+    /**
+     * @brief Fills a rectangle, clipped, with a pattern that depends on the seed
+     */
+    void fill(int x, int y, int w, int h, const std::uint32_t seed) {
+      const int x1 = std::min(x + w, width);
+      const int y1 = std::min(y + h, height);
+      x = std::max(x, 0);
+      y = std::max(y, 0);
+      for (int py = y; py < y1; py++) {
+        std::uint8_t* px = bgra.data() + (static_cast<std::size_t>(py) * width + x) * 4;
+        for (int pxx = x; pxx < x1; pxx++, px += 4) {
+          const std::uint32_t v = (static_cast<std::uint32_t>(pxx) * 73856093u) ^ (static_cast<std::uint32_t>(py) * 19349663u) ^ (seed * 83492791u);
+          px[0] = static_cast<std::uint8_t>(v);
+          px[1] = static_cast<std::uint8_t>(v >> 8);
+          px[2] = static_cast<std::uint8_t>(v >> 16);
+          px[3] = 255;
+        }
+      }
+    }
+
+
+    /**
+     * @brief Moves rows up by some pixels, the bottom ones are left as they were
+     */
+    void scrollUp(const int y, const int h, const int by) {
+      const std::size_t row = static_cast<std::size_t>(width) * 4;
+      std::memmove(bgra.data() + y * row, bgra.data() + (y + by) * row, (h - by) * row);
+    }
+  };
+
+
+  /**
+   * @brief A frame sequence, draws frame `frame` on top of the one before
+   */
+  struct Sequence {
+    const char* name;
+    void (*draw)(Canvas& canvas, const Options& opts, const std::uint32_t frame, std::mt19937& rng);
+  };
+
+
+  void drawBackground(Canvas& canvas, const Options& opts) {
+    canvas.resize(opts.width, opts.height);
+    canvas.fill(0, 0, canvas.width, canvas.height, 1);
+    canvas.fill(0, 0, canvas.width, 32, 2); // Title bar
+  }
+
+
+  const Sequence SEQUENCES[] = {
+    { "static", [](Canvas& canvas, const Options& opts, const std::uint32_t frame, std::mt19937&) {
+      if (frame == 0) drawBackground(canvas, opts);
+    } },
+    { "clock", [](Canvas& canvas, const Options& opts, const std::uint32_t frame, std::mt19937&) {
+      if (frame == 0) drawBackground(canvas, opts);
+      canvas.fill(canvas.width - 64, 8, 48, 16, 100 + frame);
+    } },
+    { "cursor", [](Canvas& canvas, const Options& opts, const std::uint32_t frame, std::mt19937&) {
+      if (frame == 0) drawBackground(canvas, opts);
+      canvas.fill(200, 300, 2, 16, (frame & 1) ? 1 : 7); // Blinks over the background
+    } },
+    { "typing", [](Canvas& canvas, const Options& opts, const std::uint32_t frame, std::mt19937&) {
+      if (frame == 0) drawBackground(canvas, opts);
+      const int chars_per_line = 80;
+      const int column = static_cast<int>(frame % chars_per_line);
+      const int line = static_cast<int>(frame / chars_per_line);
+      canvas.fill(40 + column * 9, 60 + line * 18, 9, 16, 200 + frame);
+    } },
+    { "video", [](Canvas& canvas, const Options& opts, const std::uint32_t frame, std::mt19937&) {
+      if (frame == 0) drawBackground(canvas, opts);
+      canvas.fill(canvas.width / 2 - 240, canvas.height / 2 - 135, 480, 270, 300 + frame);
+    } },
+    { "scroll", [](Canvas& canvas, const Options& opts, const std::uint32_t frame, std::mt19937&) {
+      if (frame == 0) drawBackground(canvas, opts);
+      canvas.scrollUp(32, canvas.height - 32, 18);
+      canvas.fill(0, canvas.height - 18, canvas.width, 18, 400 + frame);
+    } },
+    { "sparse", [](Canvas& canvas, const Options& opts, const std::uint32_t frame, std::mt19937& rng) {
+      if (frame == 0) drawBackground(canvas, opts);
+      for (int i = 0; i < 6; i++) {
+        canvas.fill(std::uniform_int_distribution<int>(0, canvas.width - 1)(rng),
+          std::uniform_int_distribution<int>(0, canvas.height - 1)(rng), 3, 3, 500 + frame * 8 + i);
+      }
+    } },
+    { "noise", [](Canvas& canvas, const Options& opts, const std::uint32_t frame, std::mt19937&) {
+      if (frame == 0) drawBackground(canvas, opts);
+      canvas.fill(0, 0, canvas.width, canvas.height, 600 + frame);
+    } },
+    { "resize", [](Canvas& canvas, const Options& opts, const std::uint32_t frame, std::mt19937&) {
+      if (frame == 0) drawBackground(canvas, opts);
+      if (frame % 16 == 15) {
+        canvas.resize(canvas.width - 8, canvas.height - 4);
+        canvas.fill(0, 0, canvas.width, canvas.height, 700 + frame);
+      }
+    } },
+  };
+
+
+  /**
+   * @brief Tab cell the frames are fitted into
+   */
+  struct Cell {
+    const char* name;
+    ThumbnailSize size; // 0x0 keeps full size captures without mips
+  };
+
+
+  /**
+   * @brief Totals of one sequence in one cell
+   */
+  struct Totals {
+    std::uint32_t creates = 0;
+    std::uint32_t patches = 0;
+    std::uint32_t skipped = 0;
+    std::uint64_t rects = 0;
+    std::uint64_t sent = 0;
+    std::uint64_t whole = 0;
+    double diff_us = 0.0;
+  };
+
+
+  /**
+   * @brief Runs a sequence through the capture steps and the uploader
+   * @returns bool: False if the texture ever differed from the frame
+   */
+  bool run(const Sequence& sequence, const Cell& cell, const Options& opts, Totals& totals) {
+    MemoryTextureUploader uploader;
+    Canvas canvas;
+    std::mt19937 rng(opts.seed);
+    std::vector<std::uint8_t> chain;
+    std::vector<TileRect> rects;
+    TileHashes held;
+    TileHashes hashes;
+    ImTextureID tex = ImTextureID_Invalid;
+    int held_levels = 0;
+    ScaleOptions fit;
+    fit.linear_light = true;
+
+    for (std::uint32_t frame = 0; frame < opts.frames; frame++) {
+      sequence.draw(canvas, opts, frame, rng);
+
+      // What the capture pool delivers
+      const ThumbnailSize size = fitThumbnail(canvas.width, canvas.height, cell.size.width, cell.size.height);
+      int levels = 1;
+      if (size.width == canvas.width && size.height == canvas.height) chain = canvas.bgra;
+      else {
+        levels = mipLevelCount(size.width, size.height, THUMBNAIL_MIP_LEVELS);
+        buildMipChain(canvas.bgra.data(), static_cast<std::ptrdiff_t>(canvas.width) * 4, canvas.width, canvas.height, size, levels, chain, fit);
+      }
+      hashTiles(chain.data(), static_cast<std::ptrdiff_t>(size.width) * 4, size.width, size.height, hashes);
+      totals.whole += chain.size();
+
+      // What _applyCaptures does with it
+      const auto start = Clock::now();
+      bool patched = false;
+      std::size_t sent = 0;
+      if (tex != ImTextureID_Invalid && held_levels == levels && diffTiles(held, hashes, rects)) {
+        patched = uploadDirtyRects(uploader, tex, chain.data(), size, levels, rects, sent);
+      }
+      totals.diff_us += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+      if (patched) {
+        totals.rects += rects.size();
+        if (sent == 0) totals.skipped++;
+        else totals.patches++;
+      }
+      else {
+        uploader.release(tex);
+        tex = uploader.create(chain.data(), size.width, size.height, levels);
+        held_levels = levels;
+        sent = chain.size();
+        totals.creates++;
+      }
+      totals.sent += sent;
+      held = hashes;
+
+      if (uploader.pixels(tex) != chain) {
+        std::cout << "MISMATCH:  " << sequence.name << " in " << cell.name << ", frame " << frame << " isn't what the texture holds" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options
+  Options opts;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--frames") opts.frames = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--width")  opts.width = std::max(static_cast<int>(value), 64);
+    else if (opt == "--height") opts.height = std::max(static_cast<int>(value), 64);
+    else if (opt == "--seed")   opts.seed = value;
+    else {
+      std::cout << "Unknown option " << opt << ", see the top of delta_bench.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const Cell cells[] = { { "full size", { 0, 0 } }, { "640x360", { 640, 360 } }, { "333x187", { 333, 187 } } };
+  std::cout << "window:    " << opts.width << "x" << opts.height << ", " << opts.frames << " frames per sequence, "
+            << HASH_TILE_SIZE << "px tiles\n";
+  for (const Cell& cell : cells) {
+    std::cout << cell.name << ":\n";
+    for (const Sequence& sequence : SEQUENCES) {
+      Totals totals;
+      if (!run(sequence, cell, opts, totals)) return EXIT_FAILURE;
+
+      const std::uint32_t refreshes = std::max<std::uint32_t>(totals.patches + totals.skipped, 1);
+      std::cout << "  " << std::left << std::setw(8) << sequence.name << std::right << std::fixed
+                << std::setw(4) << totals.creates << " whole " << std::setw(4) << totals.patches << " by tiles "
+                << std::setw(4) << totals.skipped << " unchanged  " << std::setprecision(1) << std::setw(5)
+                << (static_cast<double>(totals.rects) / refreshes) << " rects  "
+                << std::setprecision(2) << std::setw(8) << (totals.sent / (1024.0 * 1024.0)) << " of "
+                << std::setw(8) << (totals.whole / (1024.0 * 1024.0)) << " MB sent ("
+                << std::setprecision(1) << std::setw(5) << (100.0 * totals.sent / std::max<std::uint64_t>(totals.whole, 1))
+                << "%)  " << std::setprecision(1) << (totals.diff_us / opts.frames) << " us diff+send per frame\n";
+    }
+  }
+  std::cout << "checked:   every texture held exactly its latest frame, at every level\n";
+  return EXIT_SUCCESS;
+}
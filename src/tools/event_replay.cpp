@@ -0,0 +1,174 @@
+/*
+Headless replay of a window-event recording, for benchmarking the registry and event pipeline.
+
+Usage  ->   BetterAltTabReplay <recording> [--frame-ms N] [--coalesce-ms N] [--repeat N] [--threaded 1] [--ui-frame-us N]
+
+Record one with "BetterAltTab.exe --record-events <recording>".
+
+--threaded 1 builds deltas on a worker thread like the app does, while the main thread runs
+frames every --ui-frame-us and reports how long applying the deltas and publishing took.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include "../core/event_recording.hpp"
+#include "../core/window_events.hpp"
+#include "../core/window_deltas.hpp"
+#include "../core/window_registry.hpp"
+#include "../core/window_snapshot.hpp"
+#include "../core/tab_groups.hpp"
+#include "frame_stats.hpp"
+
+
+namespace {
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    std::uint32_t frame_ms = 16;
+    std::uint32_t coalesce_ms = WindowEventQueue::DEFAULT_COALESCE_MS;
+    std::uint32_t repeat = 1;
+    bool threaded = false;
+    std::uint32_t ui_frame_us = 1000;
+  };
+
+
+  /**
+   * @brief Prints the queue and registry state after a run
+   */
+  void printResults(const std::vector<RecordedEvent>& events, const WindowEventQueue& queue,
+    const EventReplayer& replayer, const WindowRegistry& registry) {
+    const WindowEventStats& stats = queue.stats();
+    const std::uint32_t span_ms = events.empty() ? 0 : events.back().event.time_ms - events.front().event.time_ms;
+    std::cout << "events:    " << events.size() << " over " << span_ms << " ms recorded\n"
+              << "queue:     " << stats.received << " received, " << stats.merged << " merged, "
+              << stats.dropped << " dropped\n"
+              << "batches:   " << replayer.batches() << "\n"
+              << "registry:  " << registry.size() << " windows, version " << registry.version() << "\n";
+  }
+
+
+  /**
+   * @brief Replays on the calling thread, applying every batch right away
+   * @returns double: Replay time in milliseconds
+   */
+  double runInline(const std::vector<RecordedEvent>& events, const Options& opts, const bool print) {
+    WindowRegistry registry;
+    WindowEventQueue queue(opts.coalesce_ms);
+    EventReplayer replayer(queue);
+
+    const auto start = std::chrono::steady_clock::now();
+    replayer.replay(events, opts.frame_ms, [&](WindowDeltaBatch& batch) { applyWindowDeltas(registry, batch); });
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (print) printResults(events, queue, replayer, registry);
+    return ms;
+  }
+
+
+  /**
+   * @brief Replays on a worker thread while this thread runs frames, like the app
+   * @returns double: Replay time in milliseconds
+   */
+  double runThreaded(const std::vector<RecordedEvent>& events, const Options& opts, const bool print) {
+    WindowRegistry registry;
+    SnapshotPublisher snapshots(nullptr);
+    const TabGroupMap tab_groups;
+    WindowEventQueue queue(opts.coalesce_ms);
+    EventReplayer replayer(queue);
+    WindowDeltaChannel channel;
+    std::atomic<bool> done{false};
+
+    const auto start = std::chrono::steady_clock::now();
+    std::thread worker([&]() {
+      replayer.replay(events, opts.frame_ms, [&](WindowDeltaBatch& batch) { channel.publish(batch); });
+      done.store(true, std::memory_order_release);
+    });
+
+    // UI frames: apply whatever was published, then snapshot
+    FrameStats frames;
+    WindowDeltaBatch batch;
+    std::uint64_t published = 0;
+    auto next_frame = start;
+    while (true) {
+      const bool last = done.load(std::memory_order_acquire);
+
+      const auto frame_start = std::chrono::steady_clock::now();
+      channel.take(batch);
+      applyWindowDeltas(registry, batch);
+      if (registry.version() != published) {
+        snapshots.publish(registry, tab_groups);
+        published = registry.version();
+      }
+      frames.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - frame_start).count());
+
+      if (last) break;
+      next_frame += std::chrono::microseconds(opts.ui_frame_us);
+      std::this_thread::sleep_until(next_frame);
+    }
+    worker.join();
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (print) {
+      printResults(events, queue, replayer, registry);
+      frames.print("ui work", "frames");
+    }
+    return ms;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cout << "Usage: " << argv[0] << " <recording> [--frame-ms N] [--coalesce-ms N] [--repeat N] [--threaded 1] [--ui-frame-us N]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Options
+  Options opts;
+  for (int i = 2; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--frame-ms")    opts.frame_ms = value;
+    else if (opt == "--coalesce-ms") opts.coalesce_ms = value;
+    else if (opt == "--repeat")      opts.repeat = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--threaded")    opts.threaded = value != 0;
+    else if (opt == "--ui-frame-us") opts.ui_frame_us = value;
+    else {
+      std::cout << "Unknown option " << opt << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<RecordedEvent> events;
+  if (!loadEventRecording(argv[1], events)) {
+    std::cout << "Failed to load recording " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Replay, a fresh registry every run. Results are the same every run, print them once
+  double best_ms = 0.0;
+  double total_ms = 0.0;
+  for (std::uint32_t run = 0; run < opts.repeat; run++) {
+    const bool print = run + 1 == opts.repeat;
+    const double ms = opts.threaded ? runThreaded(events, opts, print) : runInline(events, opts, print);
+
+    total_ms += ms;
+    if (run == 0 || ms < best_ms) best_ms = ms;
+  }
+
+  std::cout << std::fixed << std::setprecision(3)
+            << "replay:    " << best_ms << " ms best, " << (total_ms / opts.repeat) << " ms mean over " << opts.repeat << " runs\n";
+  if (best_ms > 0.0) {
+    std::cout << "rate:      " << std::setprecision(0) << (events.size() / (best_ms / 1000.0)) << " events/s" << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
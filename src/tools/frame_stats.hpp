@@ -0,0 +1,65 @@
+/*
+Timing summary shared by the headless tools.
+*/
+
+
+#ifndef FRAME_STATS_HPP
+#define FRAME_STATS_HPP
+
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Collects durations and prints their distribution
+ */
+class FrameStats {
+  private:
+    std::vector<double> _samples_us;
+
+  public:
+    /**
+     * @brief Adds a duration
+     * @param us: Duration in microseconds
+     */
+    void add(const double us) {
+      _samples_us.push_back(us);
+    }
+
+
+    /**
+     * @brief Gets the longest duration
+     * @returns double: Duration in microseconds, 0 if nothing was added
+     */
+    double max() const {
+      return _samples_us.empty() ? 0.0 : *std::max_element(_samples_us.begin(), _samples_us.end());
+    }
+
+
+    /**
+     * @brief Prints count, mean, p50, p99 and max
+     * @param label: Printed first, padded to the other tool output
+     * @param what: What one sample is
+     */
+    void print(const std::string& label, const std::string& what) {
+      if (_samples_us.empty()) return;
+
+      std::sort(_samples_us.begin(), _samples_us.end());
+      const auto pct = [&](const double p) { return _samples_us[static_cast<std::size_t>(p * (_samples_us.size() - 1))]; };
+      double sum = 0.0;
+      for (const double us : _samples_us) sum += us;
+
+      std::cout << std::fixed << std::setprecision(1)
+                << std::left << std::setw(11) << (label + ":") << std::right
+                << _samples_us.size() << " " << what << ", " << (sum / _samples_us.size()) << " us mean, "
+                << pct(0.5) << " p50, " << pct(0.99) << " p99, " << _samples_us.back() << " max\n";
+    }
+};
+
+
+#endif // FRAME_STATS_HPP
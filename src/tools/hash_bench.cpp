@@ -0,0 +1,232 @@
+/*
+Correctness and throughput check of the tile hashes that tell unchanged thumbnails apart.
+
+Usage  ->   BetterAltTabHash [--repeat N] [--fuzz N] [--seed N]
+
+Every kernel set this CPU runs (scalar, SSE2, AVX2) is checked against the scalar one on
+images of every width up to --fuzz pixels, at every byte alignment and with padded rows.
+Then a single byte is flipped in random images, which has to change the hash of the tile
+holding it and no other, and the hashes of many random tiles are checked for collisions.
+Last, hashing 1080p and 4K frames is timed against comparing them with memcmp, which
+would need the previous frame kept around. Exits with a failure if any check fails.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <unordered_set>
+
+#include "../core/tile_hash.hpp"
+
+
+namespace {
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    std::uint32_t repeat = 20;
+    std::uint32_t fuzz = 160;
+    std::uint32_t seed = 1;
+  };
+
+
+  /**
+   * @brief Frame size to time on
+   */
+  struct Frame {
+    const char* name;
+    int width;
+    int height;
+  };
+
+
+  void fillRandom(std::vector<std::uint8_t>& bytes, std::mt19937& rng) {
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (std::uint8_t& b : bytes) b = static_cast<std::uint8_t>(byte(rng));
+  }
+
+
+  /**
+   * @brief Checks a kernel set against the scalar set
+   * @returns bool: True if every hash matched
+   */
+  bool check(const TileHashKernels& kernels, const TileHashKernels& scalar, const Options& opts, std::mt19937& rng) {
+    std::vector<std::uint8_t> image;
+    TileHashes expected;
+    TileHashes actual;
+    for (std::uint32_t width = 1; width <= opts.fuzz; width++) {
+      const int height = 1 + static_cast<int>(width * 7 % 131);
+      for (std::size_t offset = 0; offset < 4; offset++) {
+        const std::ptrdiff_t stride = static_cast<std::ptrdiff_t>(width) * 4 + static_cast<std::ptrdiff_t>(offset) * 12;
+        image.resize(stride * height + offset);
+        fillRandom(image, rng);
+        hashTiles(image.data() + offset, stride, static_cast<int>(width), height, actual, &kernels);
+        hashTiles(image.data() + offset, stride, static_cast<int>(width), height, expected, &scalar);
+        if (actual != expected) return false;
+      }
+    }
+    return true;
+  }
+
+
+  /**
+   * @brief Flips single bytes and checks that only the tile holding each one changes
+   * @returns bool: True if every flip changed exactly one tile
+   */
+  bool checkLocality(const Options& opts, std::mt19937& rng) {
+    std::vector<std::uint8_t> image;
+    TileHashes before;
+    TileHashes after;
+    for (std::uint32_t i = 0; i < opts.fuzz; i++) {
+      const int width = std::uniform_int_distribution<int>(1, 400)(rng);
+      const int height = std::uniform_int_distribution<int>(1, 300)(rng);
+      const std::ptrdiff_t stride = static_cast<std::ptrdiff_t>(width) * 4;
+      image.resize(stride * height);
+      fillRandom(image, rng);
+      hashTiles(image.data(), stride, width, height, before);
+
+      const std::size_t at = std::uniform_int_distribution<std::size_t>(0, image.size() - 1)(rng);
+      image[at] ^= static_cast<std::uint8_t>(1u << std::uniform_int_distribution<int>(0, 7)(rng));
+      hashTiles(image.data(), stride, width, height, after);
+
+      const int x = static_cast<int>(at % stride) / 4;
+      const int y = static_cast<int>(at / stride);
+      const std::size_t flipped = static_cast<std::size_t>(y / HASH_TILE_SIZE) * before.columns + x / HASH_TILE_SIZE;
+      for (std::size_t t = 0; t < before.tiles.size(); t++) {
+        if ((before.tiles[t] != after.tiles[t]) != (t == flipped)) return false;
+      }
+    }
+    return true;
+  }
+
+
+  /**
+   * @brief Hashes many random and nearly blank tiles
+   * @returns std::size_t: Tiles that hashed like an earlier different one
+   */
+  std::size_t countCollisions(std::mt19937& rng) {
+    constexpr int TILES = 1 << 16;
+    std::vector<std::uint8_t> tile(HASH_TILE_SIZE * HASH_TILE_SIZE * 4);
+    std::unordered_set<std::uint64_t> seen;
+    TileHashes hashes;
+    std::size_t collisions = 0;
+    for (int i = 0; i < TILES; i++) {
+      // Half random, half blank with one pixel set, the common case of a tile that barely changed
+      if (i % 2 == 0) fillRandom(tile, rng);
+      else {
+        std::fill(tile.begin(), tile.end(), std::uint8_t(0xFF));
+        std::memcpy(tile.data() + (i / 2 % (HASH_TILE_SIZE * HASH_TILE_SIZE)) * 4, &i, 4);
+      }
+      hashTiles(tile.data(), HASH_TILE_SIZE * 4, HASH_TILE_SIZE, HASH_TILE_SIZE, hashes);
+      if (!seen.insert(hashes.tiles[0]).second) collisions++;
+    }
+    return collisions;
+  }
+
+
+  volatile std::uint64_t sink = 0;
+
+
+  /**
+   * @brief Times a function
+   * @returns double: Best run in seconds
+   */
+  template <typename Function>
+  double timeBest(const std::uint32_t repeat, Function function) {
+    double best = 0.0;
+    for (std::uint32_t r = 0; r < repeat; r++) {
+      const auto start = std::chrono::steady_clock::now();
+      sink = sink + function(); // Keeps the compiler from dropping the work
+      const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (r == 0 || s < best) best = s;
+    }
+    return best;
+  }
+
+
+  void printTime(const char* label, const char* path, const double s, const std::size_t bytes, const double baseline) {
+    std::cout << "  " << std::left << std::setw(10) << label << std::setw(8) << path << std::right << std::fixed
+              << std::setprecision(3) << std::setw(8) << (s * 1000.0) << " ms  "
+              << std::setprecision(1) << std::setw(6) << (bytes / s / 1e9) << " GB/s  "
+              << std::setprecision(2) << (baseline / s) << "x\n";
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options
+  Options opts;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--repeat") opts.repeat = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--fuzz")   opts.fuzz = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--seed")   opts.seed = value;
+    else {
+      std::cout << "Unknown option " << opt << ", see the top of hash_bench.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const std::vector<TileHashKernels>& sets = supportedTileHashKernels();
+  const TileHashKernels& scalar = sets.front();
+  std::cout << "picked:    " << tileHashKernels().name << "\n";
+
+  // Correctness
+  std::mt19937 rng(opts.seed);
+  for (const TileHashKernels& kernels : sets) {
+    if (!check(kernels, scalar, opts, rng)) {
+      std::cout << "MISMATCH:  " << kernels.name << " differs from scalar" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::cout << "checked:   " << sets.size() << " kernel sets, widths 1 to " << opts.fuzz << " at every alignment\n";
+
+  if (!checkLocality(opts, rng)) {
+    std::cout << "MISMATCH:  a flipped byte didn't change exactly the tile holding it" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "locality:  " << opts.fuzz << " flipped bytes, each changed only its own tile\n";
+
+  const std::size_t collisions = countCollisions(rng);
+  if (collisions != 0) {
+    std::cout << "COLLISION: " << collisions << " tiles hashed like another one" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "unique:    " << (1 << 16) << " random and nearly blank tiles, no collisions\n";
+
+  // Throughput
+  const Frame frames[] = { { "1080p", 1920, 1080 }, { "4k", 3840, 2160 } };
+  TileHashes hashes;
+  for (const Frame& frame : frames) {
+    const std::size_t bytes = static_cast<std::size_t>(frame.width) * frame.height * 4;
+    std::vector<std::uint8_t> current(bytes);
+    std::vector<std::uint8_t> previous(bytes);
+    fillRandom(current, rng);
+    previous = current; // Unchanged, memcmp reads the whole frame
+    std::cout << frame.name << " (" << frame.width << "x" << frame.height << ", " << (bytes >> 20) << " MB):\n";
+
+    // Keeping the previous frame and comparing it, reads twice the bytes
+    const double compare = timeBest(opts.repeat, [&]() {
+      return static_cast<std::uint64_t>(std::memcmp(current.data(), previous.data(), bytes) == 0);
+    });
+    printTime("memcmp", "libc", compare, bytes, compare);
+
+    for (const TileHashKernels& kernels : sets) {
+      const double s = timeBest(opts.repeat, [&]() {
+        hashTiles(current.data(), static_cast<std::ptrdiff_t>(frame.width) * 4, frame.width, frame.height, hashes, &kernels);
+        return hashes.tiles[0];
+      });
+      printTime("hashTiles", kernels.name, s, bytes, compare);
+    }
+    std::cout << "  " << hashes.tiles.size() << " tiles, " << (hashes.tiles.size() * 8) << " bytes of hashes instead of a "
+              << (bytes >> 20) << " MB copy\n";
+  }
+  return EXIT_SUCCESS;
+}
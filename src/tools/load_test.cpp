@@ -0,0 +1,253 @@
+/*
+Headless load test of the window pipeline against a simulated desktop.
+
+Usage  ->   BetterAltTabLoad [--seconds N] [--speed N] [--windows N] [--background N] [--churn N]
+                             [--titles N] [--focus N] [--storms N] [--storm-rate N] [--processes N]
+                             [--title-latency-us N] [--alt-tab-latency-us N] [--capture-latency-us N]
+                             [--process-latency-us N] [--hung N] [--hang-ms N] [--ui-budget-us N]
+                             [--capture-every-ms N] [--ui-frame-us N]
+                             [--silent N] [--reconcile-ms N] [--reconcile-us N] [--flicker N] [--cloak N]
+
+The simulated desktop runs on a worker thread with the delta builder, like the app's event
+thread, while the main thread runs frames: apply deltas, publish a snapshot and, every
+--capture-every-ms, request a capture of every listed window from a CapturePool like
+opening the tab groups panel does, taking the finished ones every frame.
+Processes of listed windows are loaded into a ProcessCache on its own worker, like the app,
+and every frame looks up the icon of every listed window. --hung makes the first windows
+never answer, with --ui-budget-us the run fails if any frame took longer than the budget.
+--silent changes windows without an event, the event thread runs a reconciliation slice
+every --reconcile-ms (0 never) and drift is how far the registry is off at the end.
+--flicker shows and hides tool windows and --cloak cloaks alt-tab windows, both with events,
+classify counts how many alt-tab checks the classification cache answered.
+--speed is simulated seconds per real second, 0 runs as fast as possible.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include "../core/simulated_desktop.hpp"
+#include "../core/window_events.hpp"
+#include "../core/window_deltas.hpp"
+#include "../core/window_registry.hpp"
+#include "../core/window_snapshot.hpp"
+#include "../core/tab_groups.hpp"
+#include "../core/process_cache.hpp"
+#include "../core/capture_pool.hpp"
+#include "frame_stats.hpp"
+
+
+namespace {
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    SimulatedDesktopConfig desktop;
+    double seconds = 10.0;
+    double speed = 1.0;
+    std::uint32_t tick_ms = 16;
+    std::uint32_t capture_every_ms = 0;
+    std::uint32_t ui_frame_us = 16000;
+    std::uint32_t ui_budget_us = 0;
+    std::uint32_t reconcile_ms = 100;
+    std::uint32_t reconcile_budget_us = 500;
+  };
+
+
+  /**
+   * @brief Parses one option
+   * @returns bool: False if the option is unknown
+   */
+  bool parseOption(Options& opts, const std::string& opt, const double value) {
+    SimulatedDesktopConfig& d = opts.desktop;
+    if      (opt == "--seconds")            opts.seconds = value;
+    else if (opt == "--speed")              opts.speed = value;
+    else if (opt == "--capture-every-ms")   opts.capture_every_ms = static_cast<std::uint32_t>(value);
+    else if (opt == "--ui-frame-us")        opts.ui_frame_us = static_cast<std::uint32_t>(value);
+    else if (opt == "--ui-budget-us")       opts.ui_budget_us = static_cast<std::uint32_t>(value);
+    else if (opt == "--reconcile-ms")       opts.reconcile_ms = static_cast<std::uint32_t>(value);
+    else if (opt == "--reconcile-us")       opts.reconcile_budget_us = static_cast<std::uint32_t>(value);
+    else if (opt == "--windows")            d.window_count = static_cast<std::uint32_t>(value);
+    else if (opt == "--background")         d.background_count = static_cast<std::uint32_t>(value);
+    else if (opt == "--churn")              d.churn_per_s = value;
+    else if (opt == "--titles")             d.title_changes_per_s = value;
+    else if (opt == "--focus")              d.focus_changes_per_s = value;
+    else if (opt == "--storms")             d.storm_windows = static_cast<std::uint32_t>(value);
+    else if (opt == "--storm-rate")         d.storm_changes_per_s = value;
+    else if (opt == "--processes")          d.process_count = static_cast<std::uint32_t>(value);
+    else if (opt == "--title-latency-us")   d.title_latency_us = static_cast<std::uint32_t>(value);
+    else if (opt == "--alt-tab-latency-us") d.alt_tab_latency_us = static_cast<std::uint32_t>(value);
+    else if (opt == "--capture-latency-us") d.capture_latency_us = static_cast<std::uint32_t>(value);
+    else if (opt == "--process-latency-us") d.process_latency_us = static_cast<std::uint32_t>(value);
+    else if (opt == "--hung")               d.hung_windows = static_cast<std::uint32_t>(value);
+    else if (opt == "--hang-ms")            d.hang_ms = static_cast<std::uint32_t>(value);
+    else if (opt == "--silent")             d.silent_changes_per_s = value;
+    else if (opt == "--flicker")            d.flicker_per_s = value;
+    else if (opt == "--cloak")              d.cloak_changes_per_s = value;
+    else return false;
+    return true;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options
+  Options opts;
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc || !parseOption(opts, argv[i], std::stod(argv[i + 1]))) {
+      std::cout << "Unknown option " << argv[i] << ", see the top of load_test.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  SimulatedDesktop desktop(opts.desktop);
+  WindowEventQueue queue;
+  ProcessCache processes(desktop);
+  WindowDeltaBuilder builder(desktop, &processes);
+  WindowDeltaChannel channel;
+  CapturePool capture_pool(desktop);
+  WindowRegistry registry;
+  SnapshotPublisher snapshots(nullptr);
+  const TabGroupMap tab_groups;
+
+  // Startup windows
+  processes.start();
+  capture_pool.start();
+  WindowDeltaBatch batch;
+  builder.addAll(batch);
+  channel.publish(batch);
+
+  // Event thread: advance the desktop, build and publish deltas
+  std::atomic<bool> done{false};
+  std::uint64_t events = 0;
+  FrameStats builds;
+  FrameStats reconciles;
+  std::uint64_t sweeps = 0;
+  const auto start = std::chrono::steady_clock::now();
+  std::thread worker([&]() {
+    WindowDeltaBatch out;
+    const std::uint32_t END_MS = static_cast<std::uint32_t>(opts.seconds * 1000.0);
+    std::uint32_t next_reconcile = opts.reconcile_ms;
+    while (desktop.now() < END_MS) {
+      events += desktop.step(opts.tick_ms, queue);
+
+      const auto build_start = std::chrono::steady_clock::now();
+      builder.build(queue, out);
+      channel.publish(out);
+      builds.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - build_start).count());
+
+      // A slice of the sweep, on its own timer like the app
+      if (opts.reconcile_ms != 0 && desktop.now() >= next_reconcile) {
+        next_reconcile = desktop.now() + opts.reconcile_ms;
+
+        const auto reconcile_start = std::chrono::steady_clock::now();
+        if (builder.reconcile(std::chrono::microseconds(opts.reconcile_budget_us), out)) sweeps++;
+        channel.publish(out);
+        reconciles.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - reconcile_start).count());
+      }
+
+      if (opts.speed > 0.0) {
+        std::this_thread::sleep_until(start + std::chrono::microseconds(static_cast<std::int64_t>(desktop.now() * 1000.0 / opts.speed)));
+      }
+    }
+    done.store(true, std::memory_order_release);
+  });
+
+  // UI thread: apply, publish, and capture every so often
+  FrameStats frames;
+  FrameStats captures;
+  std::vector<CaptureResult> captured;
+  std::uint64_t thumbnails = 0;
+  std::uint64_t published = 0;
+  std::size_t icons = 0;
+  auto next_frame = start;
+  auto next_capture = start;
+  while (true) {
+    const bool last = done.load(std::memory_order_acquire);
+
+    const auto frame_start = std::chrono::steady_clock::now();
+    channel.take(batch);
+    applyWindowDeltas(registry, batch);
+    if (registry.version() != published) {
+      snapshots.publish(registry, tab_groups);
+      published = registry.version();
+    }
+
+    // Icons only ever come from the cache, never from a window that may be hung
+    icons = 0;
+    for (const std::uint32_t pid : registry.pids()) {
+      const std::shared_ptr<const ProcessInfo> info = processes.find(pid);
+      if (info && !info->icon_bgra.empty()) icons++;
+    }
+
+    // Requests never wait on a capture, finished ones are taken the frame after they're done
+    if (opts.capture_every_ms != 0 && frame_start >= next_capture) {
+      next_capture = frame_start + std::chrono::milliseconds(opts.capture_every_ms);
+
+      const auto capture_start = std::chrono::steady_clock::now();
+      const std::vector<WindowId>& ids = registry.ids();
+      for (std::uint32_t i = 0; i < ids.size(); i++) {
+        capture_pool.request(ids[i], registry.get(ids[i])->hwnd, i);
+      }
+      captures.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - capture_start).count());
+    }
+    capture_pool.take(captured);
+    for (const CaptureResult& capture : captured) {
+      if (registry.get(capture.id)) thumbnails++;
+    }
+    capture_pool.recycle(captured);
+    frames.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - frame_start).count());
+
+    if (last) break;
+    next_frame += std::chrono::microseconds(opts.ui_frame_us);
+    std::this_thread::sleep_until(next_frame);
+  }
+  worker.join();
+  capture_pool.stop();
+  processes.stop();
+  const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  // Drift: listed but not alt-tab anymore, or alt-tab but not listed
+  std::vector<EnumeratedWindow> alt_tab;
+  desktop.enumerateAltTab(alt_tab);
+  std::size_t missing = 0;
+  for (const EnumeratedWindow& window : alt_tab) {
+    if (!registry.contains(window.hwnd)) missing++;
+  }
+  const std::size_t stale = registry.size() - (alt_tab.size() - missing);
+
+  // Results
+  const WindowEventStats& stats = queue.stats();
+  const AltTabCache& classes = builder.altTabCache();
+  std::cout << "simulated: " << opts.seconds << " s in " << std::fixed << std::setprecision(1) << ms << " ms\n"
+            << "events:    " << events << " generated, " << stats.merged << " merged, " << stats.dropped << " dropped\n"
+            << "registry:  " << registry.size() << " windows (desktop has " << desktop.altTabCount() << "), version "
+            << registry.version() << "\n"
+            << "processes: " << processes.size() << " with listed windows, " << processes.loads() << " loads, "
+            << processes.timeouts() << " timed out, " << icons << " windows with an icon\n"
+            << "classify:  " << classes.hits() << " cache hits, " << classes.misses() << " misses ("
+            << std::setprecision(1) << (100.0 * classes.hits() / std::max<std::uint64_t>(classes.hits() + classes.misses(), 1))
+            << "% hit rate), " << classes.refreshes() << " sweep reads, " << classes.size() << " windows cached\n"
+            << "thumbnail: " << thumbnails << " captures taken, " << capture_pool.failed() << " failed, "
+            << capture_pool.cancelled() << " cancelled\n"
+            << "reconcile: " << sweeps << " sweeps, " << builder.corrections() << " corrections\n"
+            << "drift:     " << stale << " listed windows gone or hidden, " << missing << " alt-tab windows not listed\n";
+  builds.print("builds", "batches");
+  reconciles.print("reconcile", "slices");
+  frames.print("ui work", "frames");
+  captures.print("requests", "capture passes");
+
+  if (opts.ui_budget_us != 0) {
+    const bool within = frames.max() <= opts.ui_budget_us;
+    std::cout << "budget:    " << opts.ui_budget_us << " us per frame, "
+              << (within ? "never exceeded" : "EXCEEDED") << std::endl;
+    if (!within) return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+/*
+Textures kept in memory, shared by the headless tools that check what an upload leaves in them.
+*/
+
+
+#ifndef MEMORY_TEXTURES_HPP
+#define MEMORY_TEXTURES_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "../core/texture_uploader.hpp"
+#include "../core/thumbnail_mips.hpp"
+
+
+/**
+ * @brief Textures kept in memory, updated the way a renderer would
+ */
+class MemoryTextureUploader : public TextureUploader {
+  private:
+    struct _Texture {
+      ThumbnailSize size;
+      int mip_levels;
+      std::vector<std::uint8_t> pixels; // Every level back to back
+    };
+
+    std::unordered_map<ImTextureID, _Texture> _textures;
+    ImTextureID _next = 1;
+
+
+    /**
+     * @brief Checks a rectangle lies in a level of a texture
+     */
+    static bool _inside(const _Texture& texture, const int level, const TileRect& rect) {
+      if (level >= texture.mip_levels) return false;
+      const ThumbnailSize level_size = mipLevelSize(texture.size, level);
+      return rect.x >= 0 && rect.y >= 0 && rect.x + rect.width <= level_size.width && rect.y + rect.height <= level_size.height;
+    }
+
+
+    /**
+     * @brief Gets the first pixel of a rectangle in a level of a texture
+     */
+    static std::uint8_t* _at(_Texture& texture, const int level, const int x, const int y) {
+      const ThumbnailSize level_size = mipLevelSize(texture.size, level);
+      return texture.pixels.data() + mipLevelOffset(texture.size, level) + (static_cast<std::size_t>(y) * level_size.width + x) * 4;
+    }
+
+  public:
+    ImTextureID create(const std::uint8_t* pixels, const int width, const int height, const int mip_levels) override {
+      const ThumbnailSize size{ width, height };
+      _Texture& texture = _textures[_next];
+      texture.size = size;
+      texture.mip_levels = mip_levels;
+      if (pixels) texture.pixels.assign(pixels, pixels + mipLevelOffset(size, mip_levels));
+      else        texture.pixels.assign(mipLevelOffset(size, mip_levels), 0);
+      return _next++;
+    }
+
+
+    bool update(const ImTextureID tex, const int level, const TileRect& rect, const std::uint8_t* first,
+      const std::ptrdiff_t stride) override {
+      const auto it = _textures.find(tex);
+      if (it == _textures.end() || !_inside(it->second, level, rect)) return false;
+
+      _Texture& texture = it->second;
+      const std::size_t row_bytes = static_cast<std::size_t>(mipLevelSize(texture.size, level).width) * 4;
+      std::uint8_t* row = _at(texture, level, rect.x, rect.y);
+      for (int y = 0; y < rect.height; y++, row += row_bytes, first += stride) {
+        std::memcpy(row, first, static_cast<std::size_t>(rect.width) * 4);
+      }
+      return true;
+    }
+
+
+    bool copy(const ImTextureID from, const ImTextureID to, const int level, const TileRect& rect, const int x, const int y) override {
+      const auto src = _textures.find(from);
+      const auto dst = _textures.find(to);
+      if (from == to || src == _textures.end() || dst == _textures.end()) return false;
+      if (!_inside(src->second, level, rect) || !_inside(dst->second, level, TileRect{ x, y, rect.width, rect.height })) return false;
+
+      const std::size_t src_row = static_cast<std::size_t>(mipLevelSize(src->second.size, level).width) * 4;
+      const std::size_t dst_row = static_cast<std::size_t>(mipLevelSize(dst->second.size, level).width) * 4;
+      const std::uint8_t* read = _at(src->second, level, rect.x, rect.y);
+      std::uint8_t* write = _at(dst->second, level, x, y);
+      for (int row = 0; row < rect.height; row++, read += src_row, write += dst_row) {
+        std::memcpy(write, read, static_cast<std::size_t>(rect.width) * 4);
+      }
+      return true;
+    }
+
+
+    void release(const ImTextureID tex) {
+      _textures.erase(tex);
+    }
+
+
+    const std::vector<std::uint8_t>& pixels(const ImTextureID tex) const {
+      return _textures.at(tex).pixels;
+    }
+
+
+    ThumbnailSize size(const ImTextureID tex) const {
+      return _textures.at(tex).size;
+    }
+
+
+    std::size_t count() const {
+      return _textures.size();
+    }
+};
+
+
+#endif // MEMORY_TEXTURES_HPP
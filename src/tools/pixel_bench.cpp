@@ -0,0 +1,214 @@
+/*
+Correctness and throughput check of the BGRA pixel kernels used by window captures.
+
+Usage  ->   BetterAltTabPixels [--repeat N] [--fuzz N] [--seed N]
+
+Every kernel set this CPU runs (scalar, SSE2, AVX2) is checked against the scalar one at
+every length up to a few vectors and every alignment, then timed on 1080p and 4K frames.
+The capture row copy reads a bottom-up source with padded rows, like a DIB section, and is
+compared with what the capture path did before: a plain copy then a byte loop over alpha.
+Exits with a failure if any output differs.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <algorithm>
+
+#include "../core/pixel_kernels.hpp"
+
+
+namespace {
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    std::uint32_t repeat = 20;
+    std::uint32_t fuzz = 64;
+    std::uint32_t seed = 1;
+  };
+
+
+  /**
+   * @brief Frame size to time on
+   */
+  struct Frame {
+    const char* name;
+    std::size_t width;
+    std::size_t height;
+  };
+
+
+  void fillRandom(std::vector<std::uint8_t>& bytes, std::mt19937& rng) {
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (std::uint8_t& b : bytes) b = static_cast<std::uint8_t>(byte(rng));
+  }
+
+
+  /**
+   * @brief Checks every kernel of a set against the scalar set
+   * @returns bool: True if every output matched
+   */
+  bool check(const PixelKernels& kernels, const PixelKernels& scalar, const Options& opts, std::mt19937& rng) {
+    std::vector<std::uint8_t> src;
+    std::vector<std::uint8_t> expected;
+    std::vector<std::uint8_t> actual;
+    for (std::uint32_t count = 0; count <= opts.fuzz; count++) {
+      for (std::size_t offset = 0; offset < 4; offset++) {
+        src.resize(count * 4 + offset);
+        fillRandom(src, rng);
+        expected.assign(src.size(), 0);
+        actual.assign(src.size(), 0);
+        const std::uint8_t* in = src.data() + offset;
+
+        kernels.copy_opaque(in, actual.data() + offset, count);
+        scalar.copy_opaque(in, expected.data() + offset, count);
+        if (actual != expected) return false;
+
+        kernels.swizzle(in, actual.data() + offset, count);
+        scalar.swizzle(in, expected.data() + offset, count);
+        if (actual != expected) return false;
+
+        kernels.premultiply(in, actual.data() + offset, count);
+        scalar.premultiply(in, expected.data() + offset, count);
+        if (actual != expected) return false;
+
+        // In place
+        std::copy(src.begin(), src.end(), actual.begin());
+        std::copy(src.begin(), src.end(), expected.begin());
+        kernels.fill_alpha(actual.data() + offset, count);
+        scalar.fill_alpha(expected.data() + offset, count);
+        if (actual != expected) return false;
+      }
+    }
+
+    // Every color and alpha pair, premultiplied against the exact rounded value
+    src.resize(256 * 256 * 4);
+    for (std::size_t i = 0; i < 256 * 256; i++) {
+      src[i * 4 + 0] = static_cast<std::uint8_t>(i & 0xFF);
+      src[i * 4 + 1] = static_cast<std::uint8_t>(255 - (i & 0xFF));
+      src[i * 4 + 2] = static_cast<std::uint8_t>(i & 0xFF);
+      src[i * 4 + 3] = static_cast<std::uint8_t>(i >> 8);
+    }
+    actual.resize(src.size());
+    kernels.premultiply(src.data(), actual.data(), 256 * 256);
+    for (std::size_t i = 0; i < 256 * 256; i++) {
+      for (int c = 0; c < 3; c++) {
+        const std::uint32_t exact = (src[i * 4 + c] * src[i * 4 + 3] * 2 + 255) / 510;
+        if (actual[i * 4 + c] != exact) return false;
+      }
+      if (actual[i * 4 + 3] != src[i * 4 + 3]) return false;
+    }
+    return true;
+  }
+
+
+  volatile std::uint8_t sink = 0;
+
+
+  /**
+   * @brief Times a kernel over a frame
+   * @returns double: Best run in seconds
+   */
+  template <typename Kernel>
+  double timeFrame(const std::uint32_t repeat, std::vector<std::uint8_t>& dst, Kernel kernel) {
+    double best = 0.0;
+    for (std::uint32_t r = 0; r < repeat; r++) {
+      const auto start = std::chrono::steady_clock::now();
+      kernel();
+      const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (r == 0 || s < best) best = s;
+      sink = sink + dst[r % dst.size()]; // Keeps the compiler from dropping the kernel
+    }
+    return best;
+  }
+
+
+  void printTime(const char* label, const char* path, const double s, const std::size_t bytes, const double baseline) {
+    std::cout << "  " << std::left << std::setw(12) << label << std::setw(8) << path << std::right << std::fixed
+              << std::setprecision(3) << std::setw(8) << (s * 1000.0) << " ms  "
+              << std::setprecision(1) << std::setw(6) << (bytes / s / 1e9) << " GB/s  "
+              << std::setprecision(2) << (baseline / s) << "x\n";
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options
+  Options opts;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--repeat") opts.repeat = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--fuzz")   opts.fuzz = value;
+    else if (opt == "--seed")   opts.seed = value;
+    else {
+      std::cout << "Unknown option " << opt << ", see the top of pixel_bench.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const std::vector<PixelKernels>& sets = supportedPixelKernels();
+  const PixelKernels& scalar = sets.front();
+  std::cout << "picked:    " << pixelKernels().name << "\n";
+
+  // Correctness
+  std::mt19937 rng(opts.seed);
+  for (const PixelKernels& kernels : sets) {
+    if (!check(kernels, scalar, opts, rng)) {
+      std::cout << "MISMATCH:  " << kernels.name << " differs from scalar" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::cout << "checked:   " << sets.size() << " kernel sets, lengths 0 to " << opts.fuzz << " at every alignment\n";
+
+  // Throughput
+  const Frame frames[] = { { "1080p", 1920, 1080 }, { "4k", 3840, 2160 } };
+  for (const Frame& frame : frames) {
+    const std::size_t count = frame.width * frame.height;
+    const std::size_t bytes = count * 4;
+    const std::size_t src_stride = frame.width * 4 + 64; // Padded rows, like a DIB section of an odd width
+    std::vector<std::uint8_t> src(src_stride * frame.height);
+    std::vector<std::uint8_t> dst(bytes);
+    fillRandom(src, rng);
+    std::cout << frame.name << " (" << frame.width << "x" << frame.height << ", " << (bytes >> 20) << " MB):\n";
+
+    // The capture path before: copy, then a byte loop over alpha
+    const double before = timeFrame(opts.repeat, dst, [&]() {
+      std::memcpy(dst.data(), src.data(), bytes);
+      for (std::size_t i = 0; i < bytes; i += 4) dst[i + 3] = 255;
+    });
+    printTime("copy+alpha", "bytes", before, bytes, before);
+
+    for (const PixelKernels& kernels : sets) {
+      // Bottom-up with a stride, the way a DIB section is read
+      const double copy = timeFrame(opts.repeat, dst, [&]() {
+        const std::uint8_t* row = src.data() + (frame.height - 1) * src_stride;
+        std::uint8_t* out = dst.data();
+        for (std::size_t y = 0; y < frame.height; y++, row -= src_stride, out += frame.width * 4) {
+          kernels.copy_opaque(row, out, frame.width);
+        }
+      });
+      printTime("copy_opaque", kernels.name, copy, bytes, before);
+    }
+
+    const double scalar_fill = timeFrame(opts.repeat, dst, [&]() { scalar.fill_alpha(dst.data(), count); });
+    const double scalar_swizzle = timeFrame(opts.repeat, dst, [&]() { scalar.swizzle(src.data(), dst.data(), count); });
+    const double scalar_premultiply = timeFrame(opts.repeat, dst, [&]() { scalar.premultiply(src.data(), dst.data(), count); });
+    for (const PixelKernels& kernels : sets) {
+      printTime("fill_alpha", kernels.name, timeFrame(opts.repeat, dst, [&]() { kernels.fill_alpha(dst.data(), count); }), bytes, scalar_fill);
+    }
+    for (const PixelKernels& kernels : sets) {
+      printTime("swizzle", kernels.name, timeFrame(opts.repeat, dst, [&]() { kernels.swizzle(src.data(), dst.data(), count); }), bytes, scalar_swizzle);
+    }
+    for (const PixelKernels& kernels : sets) {
+      printTime("premultiply", kernels.name, timeFrame(opts.repeat, dst, [&]() { kernels.premultiply(src.data(), dst.data(), count); }), bytes, scalar_premultiply);
+    }
+  }
+  return EXIT_SUCCESS;
+}
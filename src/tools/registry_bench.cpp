@@ -0,0 +1,542 @@
+/*
+Headless benchmark of the window registry against the list it replaced.
+
+Usage  ->   BetterAltTabRegistry [--windows N] [--events N] [--frames N] [--seed N]
+
+Window events are replayed into the vector of shared WindowInfo the app used to keep, where
+every event scans the list for its handle, and into a WindowRegistry, where it's a hash
+lookup. Runs with a tenth and a hundredth of --windows open as well, so the scaling shows.
+
+Every run replays --events events of one mix, drawn on a desktop kept at its window count:
+  browsing  Mostly title changes, half of them of windows that aren't listed (tooltips,
+            hidden windows), some focus switches and a few windows opened and closed
+  churn     Windows opened and closed all the time, like a build spawning consoles
+  storm     A few windows flooding title changes (progress bars, browser tabs)
+Both end up checked to hold the same windows with the same titles.
+
+Then --frames frames of a tab group of 50, 500 and 5000 windows are walked in focus order,
+with a focus switch every frame: sorted by focus time every frame like the panels used to,
+and walked along the registry's MRU list. Reports the time and the allocations per frame,
+both walks are checked to give the same order.
+
+Last, the walk a frame does over every window (which have a thumbnail, their textures, the
+newest focus time) at 50 to 50000 windows: over WindowInfo records allocated one by one
+between other allocations like over a session, over the same records in one array, and
+over the registry's columns. All three are checked to find the same thumbnails.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "../core/window_registry.hpp"
+
+
+// Every allocation of the tool is counted, to show which frame paths allocate
+static std::uint64_t g_allocations = 0;
+
+void* operator new(std::size_t size) {
+  g_allocations++;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+
+// Timed walks stay calls, inlined into the timing loop their cost depends on what's around them
+#if defined(_MSC_VER)
+  #define BENCH_NOINLINE __declspec(noinline)
+#else
+  #define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  volatile std::uint64_t g_sink = 0; // Keeps the walks from being optimized out
+
+
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    std::uint32_t windows = 10000;
+    std::uint32_t events = 200000;
+    std::uint32_t frames = 2000;
+    std::uint32_t seed = 1;
+  };
+
+
+  /**
+   * @brief Shares of a mix, in percent of the events
+   */
+  struct EventMix {
+    const char* name;
+    std::uint32_t churn;   // A window closed and another opened, two events
+    std::uint32_t retitle; // The rest are focus switches
+    std::uint32_t unlisted; // Of the title changes, windows that aren't listed
+    std::uint32_t hot;      // Of the title changes to listed windows, the few storming ones
+  };
+
+  constexpr EventMix MIXES[] = {
+    { "browsing", 5, 65, 50, 20 },
+    { "churn", 40, 40, 20, 10 },
+    { "storm", 1, 95, 10, 90 }
+  };
+
+
+  /**
+   * @brief A window event, as the hook delivers it
+   */
+  struct Event {
+    enum class Kind : std::uint8_t { CREATE, DESTROY, RETITLE, FOCUS };
+
+    Kind kind;
+    HWND hwnd;
+    std::uint32_t title; // Into the title pool
+  };
+
+
+  /**
+   * @brief Entry of the list the app used to keep, hot and cold fields together
+   */
+  struct LegacyWindow {
+    HWND hwnd;
+    std::string title;
+    void* tex = nullptr;
+    void* icon = nullptr;
+    Clock::time_point last_focused;
+  };
+
+  using LegacyList = std::vector<std::shared_ptr<LegacyWindow>>;
+
+
+  /**
+   * @brief Titles of every length a desktop has
+   */
+  std::vector<std::string> makeTitles() {
+    std::vector<std::string> titles;
+    for (std::uint32_t i = 0; i < 256; i++) {
+      std::string title = "Document " + std::to_string(i);
+      title.append(i % 48, '.');
+      title += " - Editor";
+      titles.push_back(std::move(title));
+    }
+    return titles;
+  }
+
+
+  /**
+   * @brief Draws the events of a mix on a desktop of a given window count
+   * @param opened: Receives the windows open at the start
+   * @param out: Receives the events
+   */
+  void makeEvents(const EventMix& mix, const std::uint32_t windows, const std::uint32_t count, const std::uint32_t seed,
+    std::vector<HWND>& opened, std::vector<Event>& out) {
+    std::mt19937 rng(seed);
+    std::uintptr_t next_handle = 0x10000;
+    std::uintptr_t next_unlisted = 0x80000000;
+
+    opened.clear();
+    for (std::uint32_t i = 0; i < windows; i++) opened.push_back(reinterpret_cast<HWND>(next_handle++));
+    std::vector<HWND> open = opened;
+
+    out.clear();
+    while (out.size() < count) {
+      const std::uint32_t roll = rng() % 100;
+      const HWND pick = open[rng() % open.size()];
+      if (roll < mix.churn) {
+        const std::size_t closed = rng() % open.size();
+        out.push_back(Event{ Event::Kind::DESTROY, open[closed], 0 });
+        open[closed] = reinterpret_cast<HWND>(next_handle++);
+        out.push_back(Event{ Event::Kind::CREATE, open[closed], static_cast<std::uint32_t>(rng() % 256) });
+      }
+      else if (roll < mix.churn + mix.retitle) {
+        HWND hwnd = pick;
+        if (rng() % 100 < mix.unlisted) hwnd = reinterpret_cast<HWND>(next_unlisted + rng() % 4096);
+        else if (rng() % 100 < mix.hot) hwnd = open[rng() % std::min<std::size_t>(open.size(), 4)];
+        out.push_back(Event{ Event::Kind::RETITLE, hwnd, static_cast<std::uint32_t>(rng() % 256) });
+      }
+      else {
+        out.push_back(Event{ Event::Kind::FOCUS, pick, 0 });
+      }
+    }
+  }
+
+
+  /**
+   * @brief Events handled the way they used to be, a scan of the list for every one
+   */
+  void replayLegacy(LegacyList& list, const std::vector<Event>& events, const std::vector<std::string>& titles) {
+    for (const Event& e : events) {
+      const HWND hwnd = e.hwnd;
+      const auto same = [hwnd](const std::shared_ptr<LegacyWindow>& w) { return w->hwnd == hwnd; };
+      switch (e.kind) {
+        case Event::Kind::CREATE:
+          if (std::none_of(list.begin(), list.end(), same)) {
+            auto window = std::make_shared<LegacyWindow>();
+            window->hwnd = hwnd;
+            window->title = titles[e.title];
+            window->last_focused = Clock::now();
+            list.push_back(std::move(window));
+          }
+          break;
+        case Event::Kind::DESTROY: {
+          const auto it = std::find_if(list.begin(), list.end(), same);
+          if (it != list.end()) list.erase(it);
+          break;
+        }
+        case Event::Kind::RETITLE: {
+          const auto it = std::find_if(list.begin(), list.end(), same);
+          if (it != list.end()) (*it)->title = titles[e.title];
+          break;
+        }
+        case Event::Kind::FOCUS:
+          for (const auto& ptr : list) {
+            if (ptr->hwnd == hwnd) {
+              ptr->last_focused = Clock::now();
+              break;
+            }
+          }
+          break;
+      }
+    }
+  }
+
+
+  /**
+   * @brief Events handled the way the app does now
+   */
+  void replayRegistry(WindowRegistry& registry, const std::vector<Event>& events, const std::vector<std::string>& titles) {
+    for (const Event& e : events) {
+      switch (e.kind) {
+        case Event::Kind::CREATE:  registry.insert(e.hwnd, titles[e.title]); break;
+        case Event::Kind::DESTROY: registry.erase(e.hwnd); break;
+        case Event::Kind::RETITLE: registry.setTitle(registry.find(e.hwnd), titles[e.title]); break;
+        case Event::Kind::FOCUS:   registry.touch(e.hwnd); break;
+      }
+    }
+  }
+
+
+  /**
+   * @brief Checks the list and the registry hold the same windows with the same titles
+   */
+  bool same(const LegacyList& list, const WindowRegistry& registry) {
+    if (list.size() != registry.size()) return false;
+    for (const auto& window : list) {
+      const std::optional<WindowView> view = registry.get(registry.find(window->hwnd));
+      if (!view || view->title != window->title) return false;
+    }
+    return true;
+  }
+
+
+  /**
+   * @brief Replays every mix at a window count, prints ns per event of both
+   * @returns bool: False if they disagree
+   */
+  bool benchEvents(const Options& opts, const std::uint32_t windows, const std::vector<std::string>& titles) {
+    std::vector<HWND> opened;
+    std::vector<Event> events;
+    for (const EventMix& mix : MIXES) {
+      makeEvents(mix, windows, opts.events, opts.seed, opened, events);
+
+      LegacyList list;
+      WindowRegistry registry;
+      registry.reserve(windows);
+      for (std::size_t i = 0; i < opened.size(); i++) {
+        auto window = std::make_shared<LegacyWindow>();
+        window->hwnd = opened[i];
+        window->title = titles[i % titles.size()];
+        list.push_back(std::move(window));
+        registry.insert(opened[i], titles[i % titles.size()]);
+      }
+
+      const auto legacy_start = Clock::now();
+      replayLegacy(list, events, titles);
+      const double legacy_ns = std::chrono::duration<double, std::nano>(Clock::now() - legacy_start).count() / events.size();
+
+      const auto registry_start = Clock::now();
+      replayRegistry(registry, events, titles);
+      const double registry_ns = std::chrono::duration<double, std::nano>(Clock::now() - registry_start).count() / events.size();
+
+      std::cout << std::left << std::setw(11) << (std::string(mix.name) + ":") << std::right
+                << std::setw(6) << windows << " windows, " << std::fixed << std::setprecision(1)
+                << std::setw(8) << legacy_ns << " ns per event scanning the list, "
+                << std::setw(6) << registry_ns << " ns in the registry, "
+                << std::setprecision(1) << (legacy_ns / registry_ns) << "x\n";
+
+      if (!same(list, registry)) {
+        std::cout << "FAIL:      the list and the registry disagree after the " << mix.name << " mix" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+
+  /**
+   * @brief Timing and allocations of a frame path
+   */
+  struct FrameCost {
+    double us = 0.0;
+    double allocations = 0.0;
+  };
+
+
+  /**
+   * @brief Walks a tab group in focus order every frame, sorted like the panels used to and along the MRU list
+   * @returns bool: False if the two orders disagree
+   */
+  bool benchFocusOrder(const Options& opts, const std::uint32_t windows, const std::vector<std::string>& titles) {
+    std::mt19937 rng(opts.seed);
+    LegacyList list;
+    WindowRegistry registry;
+    registry.reserve(windows);
+
+    // Window i was focused i microseconds before the start, the registry inserts at the MRU front
+    const Clock::time_point base = Clock::now();
+    std::vector<HWND> hwnds;
+    for (std::uint32_t i = 0; i < windows; i++) {
+      auto window = std::make_shared<LegacyWindow>();
+      window->hwnd = reinterpret_cast<HWND>(static_cast<std::uintptr_t>(0x10000 + i));
+      window->title = titles[i % titles.size()];
+      window->last_focused = base - std::chrono::microseconds(i);
+      hwnds.push_back(window->hwnd);
+      list.push_back(std::move(window));
+    }
+    for (std::uint32_t i = windows; i-- > 0;) registry.insert(hwnds[i], titles[i % titles.size()]);
+    std::vector<HWND> focused(opts.frames);
+    for (HWND& hwnd : focused) hwnd = hwnds[rng() % hwnds.size()];
+
+    // Sorted every frame, the focused window stamped first
+    std::uint64_t sink = 0;
+    std::uint64_t allocations = g_allocations;
+    auto start = Clock::now();
+    for (const HWND hwnd : focused) {
+      for (const auto& ptr : list) {
+        if (ptr->hwnd == hwnd) {
+          ptr->last_focused = Clock::now();
+          break;
+        }
+      }
+      std::sort(list.begin(), list.end(),
+        [](const std::shared_ptr<LegacyWindow>& a, const std::shared_ptr<LegacyWindow>& b) {
+          if (a == nullptr) return false;
+          if (b == nullptr) return true;
+          return a->last_focused > b->last_focused;
+        }
+      );
+      for (const auto& ptr : list) sink += ptr->title.size() + reinterpret_cast<std::uintptr_t>(ptr->tex);
+    }
+    const FrameCost sorted{
+      std::chrono::duration<double, std::micro>(Clock::now() - start).count() / focused.size(),
+      static_cast<double>(g_allocations - allocations) / focused.size()
+    };
+
+    // The focus switch moves the window to the front of the list, the walk follows it
+    allocations = g_allocations;
+    start = Clock::now();
+    for (const HWND hwnd : focused) {
+      registry.touch(hwnd);
+      for (WindowId id = registry.mruFront(); id != INVALID_WINDOW_ID; id = registry.mruNext(id)) {
+        const WindowView view = registry.view(registry.row(id));
+        sink += view.title.size() + static_cast<std::uint64_t>(view.tex);
+      }
+    }
+    const FrameCost mru{
+      std::chrono::duration<double, std::micro>(Clock::now() - start).count() / focused.size(),
+      static_cast<double>(g_allocations - allocations) / focused.size()
+    };
+
+    std::cout << "focus:     " << std::setw(6) << windows << " windows, " << std::fixed << std::setprecision(2)
+              << std::setw(8) << sorted.us << " us per frame sorting (" << std::setprecision(1) << sorted.allocations << " allocations), "
+              << std::setprecision(2) << std::setw(6) << mru.us << " us walking the MRU list (" << std::setprecision(1) << mru.allocations
+              << " allocations), " << (sorted.us / mru.us) << "x\n";
+    g_sink = sink;
+
+    // Same order both ways
+    WindowId id = registry.mruFront();
+    for (const auto& ptr : list) {
+      if (id == INVALID_WINDOW_ID || registry.view(registry.row(id)).hwnd != ptr->hwnd) {
+        std::cout << "FAIL:      the MRU list and the sorted list disagree at " << windows << " windows" << std::endl;
+        return false;
+      }
+      id = registry.mruNext(id);
+    }
+    return true;
+  }
+
+
+  /**
+   * @brief What a frame walk found
+   */
+  struct WalkResult {
+    std::uint64_t thumbnails = 0;
+    std::uint64_t textures = 0; // Sum of the ids
+    Clock::time_point newest;
+  };
+
+
+  /**
+   * @brief Walks records the way a frame used to, every field in one struct
+   *
+   * NOTE: The walks keep their results in locals, an std::max into the result makes every row wait on a store.
+   */
+  template <typename Records, typename Get>
+  WalkResult walkRecords(const Records& records, const Get get) {
+    std::uint64_t thumbnails = 0, textures = 0;
+    Clock::time_point newest;
+    for (const auto& record : records) {
+      const LegacyWindow& window = get(record);
+      if (window.tex == nullptr) continue;
+      thumbnails++;
+      textures += reinterpret_cast<std::uintptr_t>(window.tex);
+      if (window.last_focused > newest) newest = window.last_focused;
+    }
+    return WalkResult{ thumbnails, textures, newest };
+  }
+
+
+  BENCH_NOINLINE WalkResult walkHeap(const LegacyList& list) {
+    return walkRecords(list, [](const std::shared_ptr<LegacyWindow>& w) -> const LegacyWindow& { return *w; });
+  }
+
+
+  BENCH_NOINLINE WalkResult walkArray(const std::vector<LegacyWindow>& list) {
+    return walkRecords(list, [](const LegacyWindow& w) -> const LegacyWindow& { return w; });
+  }
+
+
+  /**
+   * @brief Walks the registry's columns, only the ones the frame reads
+   */
+  BENCH_NOINLINE WalkResult walkColumns(const WindowRegistry& registry) {
+    const std::vector<std::uint32_t>& flags = registry.flags();
+    const std::vector<ImTextureID>& textures = registry.textures();
+    const std::vector<Clock::time_point>& focus = registry.lastFocused();
+    std::uint64_t thumbnails = 0, sum = 0;
+    Clock::time_point newest;
+    for (std::size_t row = 0; row < flags.size(); row++) {
+      if (!(flags[row] & WINDOW_FLAG_HAS_THUMBNAIL)) continue;
+      thumbnails++;
+      sum += static_cast<std::uint64_t>(textures[row]);
+      if (focus[row] > newest) newest = focus[row];
+    }
+    return WalkResult{ thumbnails, sum, newest };
+  }
+
+
+  /**
+   * @brief Times a walk, repeated until about as many rows were walked at every window count
+   * @returns double: ns per window
+   */
+  template <typename Walk>
+  double timeWalk(const std::uint32_t windows, WalkResult& result, const Walk walk) {
+    const std::uint32_t repeat = std::max<std::uint32_t>(10000000 / windows, 1);
+    std::uint64_t sink = 0;
+    const auto start = Clock::now();
+    for (std::uint32_t i = 0; i < repeat; i++) {
+      result = walk();
+      sink += result.textures;
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    g_sink = sink;
+    return ns / (static_cast<double>(repeat) * windows);
+  }
+
+
+  /**
+   * @brief Times the frame walk over records and over columns at a window count
+   * @returns bool: False if the walks found different thumbnails
+   */
+  bool benchFrameWalk(const Options& opts, const std::uint32_t windows, const std::vector<std::string>& titles) {
+    std::mt19937 rng(opts.seed);
+    LegacyList scattered;
+    std::vector<LegacyWindow> packed(windows);
+    WindowRegistry registry;
+    registry.reserve(windows);
+
+    // Records allocated one by one, with whatever else the app allocated in between
+    std::vector<std::unique_ptr<char[]>> between;
+    const Clock::time_point base = Clock::now();
+    for (std::uint32_t i = 0; i < windows; i++) {
+      const HWND hwnd = reinterpret_cast<HWND>(static_cast<std::uintptr_t>(0x10000 + i));
+      const bool thumbnail = i % 4 != 3; // Not random, the walk would time mispredicted branches instead of memory
+      between.push_back(std::make_unique<char[]>(32 + rng() % 480));
+
+      LegacyWindow& window = packed[i];
+      window.hwnd = hwnd;
+      window.title = titles[i % titles.size()];
+      window.tex = thumbnail ? reinterpret_cast<void*>(static_cast<std::uintptr_t>(i + 1)) : nullptr;
+      window.last_focused = base - std::chrono::microseconds(i);
+      scattered.push_back(std::make_shared<LegacyWindow>(window));
+
+      const WindowId id = registry.insert(hwnd, window.title);
+      if (thumbnail) registry.setTexture(id, static_cast<ImTextureID>(i + 1));
+    }
+
+    WalkResult heap, array, columns;
+    const double heap_ns = timeWalk(windows, heap, [&]() { return walkHeap(scattered); });
+    const double array_ns = timeWalk(windows, array, [&]() { return walkArray(packed); });
+    const double columns_ns = timeWalk(windows, columns, [&]() { return walkColumns(registry); });
+
+    std::cout << "walk:      " << std::setw(6) << windows << " windows, " << std::fixed << std::setprecision(2)
+              << std::setw(6) << heap_ns << " ns per window over heap records, "
+              << std::setw(6) << array_ns << " in an array, "
+              << std::setw(6) << columns_ns << " over columns, " << (heap_ns / columns_ns) << "x\n";
+
+    if (heap.thumbnails != columns.thumbnails || heap.textures != columns.textures ||
+        array.thumbnails != columns.thumbnails || array.textures != columns.textures) {
+      std::cout << "FAIL:      the walks found different thumbnails at " << windows << " windows" << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options
+  Options opts;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--windows") opts.windows = std::clamp<std::uint32_t>(value, 100, 50000);
+    else if (opt == "--events")  opts.events = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--frames")  opts.frames = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--seed")    opts.seed = value;
+    else {
+      std::cout << "Unknown option " << opt << ", see the top of registry_bench.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const std::vector<std::string> titles = makeTitles();
+  for (const std::uint32_t windows : { opts.windows / 100, opts.windows / 10, opts.windows }) {
+    if (!benchEvents(opts, windows, titles)) return EXIT_FAILURE;
+  }
+
+  for (const std::uint32_t windows : { 50u, 500u, 5000u }) {
+    if (!benchFocusOrder(opts, windows, titles)) return EXIT_FAILURE;
+  }
+
+  for (const std::uint32_t windows : { 50u, 500u, 5000u, 50000u }) {
+    if (!benchFrameWalk(opts, windows, titles)) return EXIT_FAILURE;
+  }
+
+  std::cout << "checked:   the list and the registry held the same windows and titles after every mix, "
+               "the MRU list gave the sorted order, every walk found the same thumbnails\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,381 @@
+/*
+Quality and throughput check of the image scaler used for thumbnails.
+
+Usage  ->   BetterAltTabScale [--repeat N] [--fuzz N] [--seed N] [--width N] [--height N]
+
+Sources are synthetic window-like images: a gradient title bar, rows of 1-pixel "text"
+strokes, a checkerboard, flat panels and thin borders, the detail that aliases or blurs.
+Every kernel set this CPU runs (scalar, SSE2, AVX2) and every band split is checked to give
+the same output as the scalar set, on --fuzz random sizes including upscales.
+Quality is PSNR against a double-precision scaler: against the same filter it measures the
+fixed-point error, against Lanczos-3 in linear light it measures how close each filter gets
+to the best one, with nearest neighbour (what no filtering looks like) as a baseline.
+Throughput is timed from 1080p, 4K and 8K down to --width x --height, the thumbnail size,
+per filter and kernel set, then per thread count with the best set.
+Exits with a failure if any output differs.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+
+#include "../core/image_scaler.hpp"
+
+
+namespace {
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    std::uint32_t repeat = 3;
+    std::uint32_t fuzz = 200;
+    std::uint32_t seed = 1;
+    int width = 320;
+    int height = 180;
+  };
+
+
+  /**
+   * @brief Source size to scale from
+   */
+  struct Frame {
+    const char* name;
+    int width;
+    int height;
+  };
+
+
+  constexpr ScaleFilter FILTERS[] = { ScaleFilter::BOX, ScaleFilter::BILINEAR, ScaleFilter::LANCZOS3 };
+
+
+  void fillRect(std::vector<std::uint8_t>& img, const int width, const int x0, const int y0, const int x1, const int y1,
+    const std::uint8_t b, const std::uint8_t g, const std::uint8_t r) {
+    for (int y = y0; y < y1; y++) {
+      for (int x = x0; x < x1; x++) {
+        std::uint8_t* p = img.data() + (static_cast<std::size_t>(y) * width + x) * 4;
+        p[0] = b, p[1] = g, p[2] = r, p[3] = 255;
+      }
+    }
+  }
+
+
+  /**
+   * @brief Draws something shaped like a window: title bar, text, a checkerboard, panels
+   */
+  std::vector<std::uint8_t> makeWindow(const int width, const int height, std::mt19937& rng) {
+    std::vector<std::uint8_t> img(static_cast<std::size_t>(width) * height * 4);
+    fillRect(img, width, 0, 0, width, height, 250, 250, 250);
+
+    // Title bar gradient
+    const int bar = std::max(height / 30, 2);
+    for (int y = 0; y < bar; y++) {
+      for (int x = 0; x < width; x++) {
+        const std::uint8_t v = static_cast<std::uint8_t>(x * 255 / std::max(width - 1, 1));
+        fillRect(img, width, x, y, x + 1, y + 1, 255, v, static_cast<std::uint8_t>(255 - v));
+      }
+    }
+
+    // Text: 1-pixel strokes on every other row of a line, random runs
+    std::uniform_int_distribution<int> run(1, 6);
+    for (int line = bar + 4; line + 8 < height * 2 / 3; line += 12) {
+      for (int y = line; y < line + 8; y += 2) {
+        for (int x = 8; x < width / 2;) {
+          const int len = run(rng);
+          fillRect(img, width, x, y, std::min(x + len, width / 2), y + 1, 30, 30, 30);
+          x += len + run(rng);
+        }
+      }
+    }
+
+    // Checkerboard, single pixels
+    for (int y = height * 2 / 3; y < height; y++) {
+      for (int x = 0; x < width / 2; x++) {
+        const std::uint8_t v = ((x + y) & 1) ? 0 : 255;
+        fillRect(img, width, x, y, x + 1, y + 1, v, v, v);
+      }
+    }
+
+    // Panels with thin borders
+    std::uniform_int_distribution<int> color(0, 255);
+    for (int i = 0; i < 6; i++) {
+      const int x0 = width / 2 + i * (width / 2) / 6;
+      const int x1 = width / 2 + (i + 1) * (width / 2) / 6;
+      fillRect(img, width, x0, bar, x1, height, static_cast<std::uint8_t>(color(rng)),
+        static_cast<std::uint8_t>(color(rng)), static_cast<std::uint8_t>(color(rng)));
+      fillRect(img, width, x0, bar, x0 + 1, height, 0, 0, 0);
+    }
+    return img;
+  }
+
+
+  // ----------------- Reference -----------------
+
+  double referenceFilter(const ScaleFilter filter, const double x) {
+    if (filter == ScaleFilter::BOX) return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+    if (filter == ScaleFilter::BILINEAR) return std::max(0.0, 1.0 - std::fabs(x));
+    if (x <= -3.0 || x >= 3.0) return 0.0;
+    if (x == 0.0) return 1.0;
+    const double px = x * 3.14159265358979323846;
+    return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+  }
+
+
+  double toLinear(const double s) {
+    return s <= 0.04045 ? s / 12.92 : std::pow((s + 0.055) / 1.055, 2.4);
+  }
+
+
+  double toSrgb(const double l) {
+    return l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+  }
+
+
+  /**
+   * @brief Resamples one axis in double precision, the same way the scaler does
+   */
+  void referenceAxis(const std::vector<double>& in, const int in_size, const int lines, const std::size_t step,
+    const std::size_t line_step, std::vector<double>& out, const int out_size, const ScaleFilter filter) {
+    const double support_base = filter == ScaleFilter::BOX ? 0.5 : filter == ScaleFilter::BILINEAR ? 1.0 : 3.0;
+    const double scale = static_cast<double>(in_size) / out_size;
+    const double filter_scale = std::max(scale, 1.0);
+    const double support = support_base * filter_scale;
+    const std::size_t out_step = step == 4 ? 4 : static_cast<std::size_t>(lines) * 4;
+    const std::size_t out_line_step = step == 4 ? static_cast<std::size_t>(out_size) * 4 : 4;
+    out.assign(static_cast<std::size_t>(out_size) * lines * 4, 0.0);
+    for (int o = 0; o < out_size; o++) {
+      const double center = (o + 0.5) * scale;
+      const int first = std::max(static_cast<int>(center - support + 0.5), 0);
+      const int last = std::min(static_cast<int>(center + support + 0.5), in_size);
+      double total = 0.0;
+      for (int i = first; i < last; i++) total += referenceFilter(filter, (i - center + 0.5) / filter_scale);
+      for (int l = 0; l < lines; l++) {
+        for (int c = 0; c < 4; c++) {
+          double acc = 0.0;
+          for (int i = first; i < last; i++) {
+            acc += in[l * line_step + i * step + c] * referenceFilter(filter, (i - center + 0.5) / filter_scale);
+          }
+          out[l * out_line_step + o * out_step + c] = total != 0.0 ? acc / total : 0.0;
+        }
+      }
+    }
+  }
+
+
+  /**
+   * @brief Scales in double precision, without any fixed-point rounding
+   */
+  std::vector<std::uint8_t> referenceScale(const std::vector<std::uint8_t>& src, const int sw, const int sh,
+    const int dw, const int dh, const ScaleFilter filter, const bool linear_light) {
+    std::vector<double> in(src.size());
+    for (std::size_t i = 0; i < src.size(); i++) {
+      in[i] = src[i] / 255.0;
+      if (linear_light && i % 4 != 3) in[i] = toLinear(in[i]);
+    }
+    std::vector<double> across;
+    std::vector<double> down;
+    referenceAxis(in, sw, sh, 4, static_cast<std::size_t>(sw) * 4, across, dw, filter);
+    referenceAxis(across, sh, dw, static_cast<std::size_t>(dw) * 4, 4, down, dh, filter);
+
+    std::vector<std::uint8_t> out(down.size());
+    for (std::size_t i = 0; i < down.size(); i++) {
+      double v = std::clamp(down[i], 0.0, 1.0);
+      if (linear_light && i % 4 != 3) v = toSrgb(v);
+      out[i] = static_cast<std::uint8_t>(std::lround(v * 255.0));
+    }
+    return out;
+  }
+
+
+  std::vector<std::uint8_t> nearestScale(const std::vector<std::uint8_t>& src, const int sw, const int sh,
+    const int dw, const int dh) {
+    std::vector<std::uint8_t> out(static_cast<std::size_t>(dw) * dh * 4);
+    for (int y = 0; y < dh; y++) {
+      const int sy = static_cast<int>((y + 0.5) * sh / dh);
+      for (int x = 0; x < dw; x++) {
+        const int sx = static_cast<int>((x + 0.5) * sw / dw);
+        std::copy_n(src.data() + (static_cast<std::size_t>(sy) * sw + sx) * 4, 4, out.data() + (static_cast<std::size_t>(y) * dw + x) * 4);
+      }
+    }
+    return out;
+  }
+
+
+  /**
+   * @brief Peak signal-to-noise ratio over the color channels
+   * @returns double: In dB, 99 if identical
+   */
+  double psnr(const std::vector<std::uint8_t>& a, const std::vector<std::uint8_t>& b) {
+    double sum = 0.0;
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < a.size(); i++) {
+      if (i % 4 == 3) continue;
+      const double d = static_cast<double>(a[i]) - b[i];
+      sum += d * d;
+      n++;
+    }
+    if (sum == 0.0) return 99.0;
+    return 10.0 * std::log10(255.0 * 255.0 / (sum / n));
+  }
+
+
+  // ----------------- Checks -----------------
+
+  /**
+   * @brief Checks every kernel set and band split against the scalar set on random sizes
+   * @returns bool: True if every output matched
+   */
+  bool check(const Options& opts, std::mt19937& rng) {
+    const std::vector<ScalerKernels>& sets = supportedScalerKernels();
+    std::uniform_int_distribution<int> size(1, 300);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<std::uint8_t> expected;
+    std::vector<std::uint8_t> actual;
+    for (std::uint32_t i = 0; i < opts.fuzz; i++) {
+      const int sw = size(rng);
+      const int sh = size(rng);
+      const int dw = size(rng) / 2 + 1;
+      const int dh = size(rng) / 2 + 1;
+      std::vector<std::uint8_t> src = (i % 2) ? makeWindow(sw, sh, rng) : std::vector<std::uint8_t>(static_cast<std::size_t>(sw) * sh * 4);
+      if (i % 2 == 0) for (std::uint8_t& b : src) b = static_cast<std::uint8_t>(byte(rng));
+
+      ScaleOptions options;
+      options.filter = FILTERS[i % 3];
+      options.linear_light = (i / 3) % 2;
+      options.kernels = &sets.front();
+      scaleImage(src, sw, sh, expected, dw, dh, options);
+      for (const ScalerKernels& kernels : sets) {
+        for (const unsigned threads : { 1u, 3u }) {
+          options.kernels = &kernels;
+          options.threads = threads;
+          scaleImage(src, sw, sh, actual, dw, dh, options);
+          if (actual != expected) {
+            std::cout << "MISMATCH:  " << kernels.name << ", " << threads << " threads, " << scaleFilterName(options.filter)
+                      << (options.linear_light ? " linear" : "") << ", " << sw << "x" << sh << " to " << dw << "x" << dh << std::endl;
+            return false;
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+
+  volatile std::uint8_t sink = 0;
+
+
+  /**
+   * @brief Times a scale
+   * @returns double: Best run in seconds
+   */
+  double timeScale(const std::uint32_t repeat, const std::vector<std::uint8_t>& src, const Frame& frame,
+    std::vector<std::uint8_t>& dst, const Options& opts, const ScaleOptions& options) {
+    double best = 0.0;
+    for (std::uint32_t r = 0; r < repeat; r++) {
+      const auto start = std::chrono::steady_clock::now();
+      scaleImage(src, frame.width, frame.height, dst, opts.width, opts.height, options);
+      const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (r == 0 || s < best) best = s;
+      sink = sink + dst[r % dst.size()]; // Keeps the compiler from dropping the scale
+    }
+    return best;
+  }
+
+
+  void printTime(const std::string& label, const char* path, const double s, const Frame& frame, const double baseline) {
+    std::cout << "  " << std::left << std::setw(16) << label << std::setw(8) << path << std::right << std::fixed
+              << std::setprecision(2) << std::setw(9) << (s * 1000.0) << " ms  "
+              << std::setprecision(0) << std::setw(6) << (static_cast<double>(frame.width) * frame.height / s / 1e6) << " Mpx/s  "
+              << std::setprecision(2) << (baseline / s) << "x\n";
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options
+  Options opts;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--repeat") opts.repeat = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--fuzz")   opts.fuzz = value;
+    else if (opt == "--seed")   opts.seed = value;
+    else if (opt == "--width")  opts.width = std::max<int>(static_cast<int>(value), 1);
+    else if (opt == "--height") opts.height = std::max<int>(static_cast<int>(value), 1);
+    else {
+      std::cout << "Unknown option " << opt << ", see the top of scale_bench.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const std::vector<ScalerKernels>& sets = supportedScalerKernels();
+  std::cout << "picked:    " << sets.back().name << ", " << std::thread::hardware_concurrency() << " cores\n";
+
+  // Correctness
+  std::mt19937 rng(opts.seed);
+  if (!check(opts, rng)) return EXIT_FAILURE;
+  std::cout << "checked:   " << sets.size() << " kernel sets, 1 and 3 bands, " << opts.fuzz << " random sizes\n";
+
+  // Quality, on a 1080p window down to the thumbnail size
+  {
+    const Frame frame{ "1080p", 1920, 1080 };
+    const std::vector<std::uint8_t> src = makeWindow(frame.width, frame.height, rng);
+    const std::vector<std::uint8_t> best = referenceScale(src, frame.width, frame.height, opts.width, opts.height, ScaleFilter::LANCZOS3, true);
+    std::cout << "quality:   " << frame.name << " to " << opts.width << "x" << opts.height
+              << ", PSNR dB against the exact filter / against exact linear-light lanczos3\n";
+    std::cout << "  " << std::left << std::setw(18) << "nearest" << std::right << std::fixed << std::setprecision(1)
+              << std::setw(6) << "-" << "  " << std::setw(6) << psnr(nearestScale(src, frame.width, frame.height, opts.width, opts.height), best) << "\n";
+    for (const bool linear_light : { false, true }) {
+      for (const ScaleFilter filter : FILTERS) {
+        ScaleOptions options;
+        options.filter = filter;
+        options.linear_light = linear_light;
+        std::vector<std::uint8_t> dst;
+        scaleImage(src, frame.width, frame.height, dst, opts.width, opts.height, options);
+        const std::vector<std::uint8_t> exact = referenceScale(src, frame.width, frame.height, opts.width, opts.height, filter, linear_light);
+        std::cout << "  " << std::left << std::setw(18) << (std::string(scaleFilterName(filter)) + (linear_light ? " linear" : ""))
+                  << std::right << std::setw(6) << psnr(dst, exact) << "  " << std::setw(6) << psnr(dst, best) << "\n";
+      }
+    }
+  }
+
+  // Throughput
+  const Frame frames[] = { { "1080p", 1920, 1080 }, { "4k", 3840, 2160 }, { "8k", 7680, 4320 } };
+  std::vector<std::uint8_t> dst;
+  for (const Frame& frame : frames) {
+    const std::vector<std::uint8_t> src = makeWindow(frame.width, frame.height, rng);
+    std::cout << frame.name << " (" << frame.width << "x" << frame.height << ") to " << opts.width << "x" << opts.height << ":\n";
+
+    for (const ScaleFilter filter : FILTERS) {
+      ScaleOptions options;
+      options.filter = filter;
+      options.kernels = &sets.front();
+      const double scalar = timeScale(opts.repeat, src, frame, dst, opts, options);
+      for (const ScalerKernels& kernels : sets) {
+        options.kernels = &kernels;
+        const double s = &kernels == &sets.front() ? scalar : timeScale(opts.repeat, src, frame, dst, opts, options);
+        printTime(scaleFilterName(filter), kernels.name, s, frame, scalar);
+      }
+      options.kernels = nullptr;
+      options.linear_light = true;
+      printTime(std::string(scaleFilterName(filter)) + " linear", sets.back().name,
+        timeScale(opts.repeat, src, frame, dst, opts, options), frame, scalar);
+    }
+
+    // Bands, with the default filter
+    ScaleOptions options;
+    const double one = timeScale(opts.repeat, src, frame, dst, opts, options);
+    for (const unsigned threads : { 1u, 2u, 4u, 0u }) {
+      options.threads = threads;
+      const std::string label = "box, " + (threads == 0 ? std::string("per core") : std::to_string(threads) + " threads");
+      printTime(label, sets.back().name, threads == 1 ? one : timeScale(opts.repeat, src, frame, dst, opts, options), frame, one);
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,274 @@
+/*
+Stress test of the snapshot publisher and its deferred texture releases.
+
+Usage  ->   BetterAltTabSnapshot [--publishes N] [--windows N] [--changes N] [--readers N]
+                                 [--hold N] [--seed N]
+
+The main thread is the writer: for --publishes rounds it makes --changes random changes to
+a registry of about --windows windows (opened, closed, retitled, focused, given a new
+thumbnail), then publishes a snapshot. Every texture the registry lets go of is retired
+into the publisher, like the app does, and only released once no snapshot can see it.
+
+--readers threads acquire the latest snapshot over and over and walk every row, pinning
+the textures it shows. Each keeps up to --hold snapshots pinned at once and lets go of a
+random one, so old snapshots outlive newer ones and the retired bags are freed out of order.
+
+Fails if a texture is released while a reader pins it, released twice, or never released
+once the registry and the publisher are gone.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <memory>
+#include <algorithm>
+
+#include "../core/window_registry.hpp"
+#include "../core/window_snapshot.hpp"
+#include "../core/tab_groups.hpp"
+
+
+namespace {
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    std::uint32_t publishes = 20000;
+    std::uint32_t windows = 200;
+    std::uint32_t changes = 8;
+    std::uint32_t readers = 2;
+    std::uint32_t hold = 4;
+    std::uint32_t seed = 1;
+  };
+
+
+  /**
+   * @brief What happened to a texture, indexed by its id
+   */
+  struct TextureState {
+    std::atomic<std::uint32_t> pins{0};   // Held snapshots of readers showing it
+    std::atomic<bool> released{false};
+  };
+
+
+  std::vector<TextureState>* g_textures = nullptr;
+  SnapshotPublisher* g_publisher = nullptr;
+  std::atomic<std::uint64_t> g_released{0};
+  std::atomic<std::uint64_t> g_released_pinned{0}; // Released while a reader pinned it
+  std::atomic<std::uint64_t> g_released_twice{0};
+  std::atomic<std::uint64_t> g_seen_released{0};   // Shown by a snapshot after it was released
+
+
+  /**
+   * @brief Publisher releaser, runs on whichever thread lets go of the last snapshot that could see the texture
+   */
+  void releaseTexture(const ImTextureID tex) {
+    TextureState& state = (*g_textures)[static_cast<std::size_t>(tex)];
+    if (state.released.exchange(true)) g_released_twice++;
+    if (state.pins.load() != 0) g_released_pinned++;
+    g_released++;
+  }
+
+
+  /**
+   * @brief Registry releaser, defers to the publisher
+   */
+  void retireTexture(const ImTextureID tex) {
+    g_publisher->retire(tex);
+  }
+
+
+  /**
+   * @brief Pins or unpins every texture a snapshot shows
+   * @param snapshot: Snapshot held by the reader
+   * @param pin: True to pin, false to let go
+   * @returns std::uint32_t: Rows walked
+   */
+  std::uint32_t pinTextures(const WindowSnapshot& snapshot, const bool pin) {
+    const std::uint32_t rows = static_cast<std::uint32_t>(snapshot.size());
+    for (std::uint32_t row = 0; row < rows; row++) {
+      const WindowView view = snapshot.view(row);
+      if (view.tex == ImTextureID_Invalid) continue;
+
+      // Pinned before checking, the releaser checks the other way around, so one of them sees the other
+      TextureState& state = (*g_textures)[static_cast<std::size_t>(view.tex)];
+      if (!pin) {
+        state.pins.fetch_sub(1);
+        continue;
+      }
+      state.pins.fetch_add(1);
+      if (state.released.load()) g_seen_released++;
+    }
+    return rows;
+  }
+
+
+  /**
+   * @brief Makes one random change to the registry
+   * @returns bool: False if no texture id is left
+   */
+  bool change(WindowRegistry& registry, std::vector<HWND>& open, std::uintptr_t& next_handle, ImTextureID& next_texture,
+    const Options& opts, std::mt19937& rng) {
+    const std::size_t capacity = g_textures->size();
+    const std::uint32_t roll = rng() % 100;
+    const bool grow = open.size() < opts.windows;
+
+    // Open, with a thumbnail right away
+    if (open.empty() || (roll < 15 && grow) || (roll < 5)) {
+      if (next_texture >= capacity) return false;
+      const HWND hwnd = reinterpret_cast<HWND>(next_handle++);
+      const WindowId id = registry.insert(hwnd, "Window " + std::to_string(next_handle));
+      registry.setTexture(id, next_texture++, ImVec2(320.0f, 180.0f));
+      open.push_back(hwnd);
+      return true;
+    }
+
+    const std::size_t pick = rng() % open.size();
+    const HWND hwnd = open[pick];
+    if (roll < 30) {
+      // Close, its texture is retired
+      registry.erase(hwnd);
+      open[pick] = open.back();
+      open.pop_back();
+    }
+    else if (roll < 70) {
+      // New capture, the old texture is retired
+      if (next_texture >= capacity) return false;
+      registry.setTexture(registry.find(hwnd), next_texture++, ImVec2(320.0f, 180.0f));
+    }
+    else if (roll < 85) {
+      registry.setTitle(registry.find(hwnd), "Retitled " + std::to_string(rng() % 1000));
+    }
+    else {
+      registry.touch(hwnd);
+    }
+    return true;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options
+  Options opts;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--publishes") opts.publishes = value;
+    else if (opt == "--windows")   opts.windows = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--changes")   opts.changes = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--readers")   opts.readers = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--hold")      opts.hold = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--seed")      opts.seed = value;
+    else {
+      std::cout << "Unknown option " << opt << ", see the top of snapshot_stress.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Every texture id ever handed out gets its own state, 0 is ImTextureID_Invalid
+  std::vector<TextureState> textures(static_cast<std::size_t>(opts.windows) + static_cast<std::size_t>(opts.publishes) * opts.changes + 1);
+  g_textures = &textures;
+  ImTextureID next_texture = 1;
+
+  std::atomic<bool> done{false};
+  std::atomic<std::uint64_t> acquires{0};
+  std::atomic<std::uint64_t> rows{0};
+  std::atomic<std::uint64_t> stale_rows{0}; // Rows whose handle doesn't resolve back to them
+
+  const auto start = std::chrono::steady_clock::now();
+  {
+    SnapshotPublisher publisher(releaseTexture);
+    g_publisher = &publisher;
+    {
+      WindowRegistry registry;
+      registry.setTextureReleaser(retireTexture);
+      const TabGroupMap tab_groups;
+
+      // Readers: pin the latest snapshot, walk it, let go of a random held one
+      std::vector<std::thread> readers;
+      for (std::uint32_t r = 0; r < opts.readers; r++) {
+        readers.emplace_back([&, r]() {
+          std::mt19937 rng(opts.seed * 31 + r);
+          std::vector<std::shared_ptr<const WindowSnapshot>> held;
+          std::uint64_t local_acquires = 0, local_rows = 0, local_stale = 0;
+          while (!done.load(std::memory_order_relaxed)) {
+            held.push_back(publisher.acquire());
+            const WindowSnapshot& snapshot = *held.back();
+            local_rows += pinTextures(snapshot, true);
+            for (std::uint32_t row = 0; row < snapshot.size(); row++) {
+              if (snapshot.row(snapshot.ids()[row]) != row) local_stale++;
+            }
+            local_acquires++;
+
+            if (held.size() >= opts.hold) {
+              const std::size_t drop = rng() % held.size();
+              pinTextures(*held[drop], false);
+              held.erase(held.begin() + static_cast<std::ptrdiff_t>(drop));
+            }
+          }
+          for (const auto& snapshot : held) pinTextures(*snapshot, false);
+          acquires += local_acquires;
+          rows += local_rows;
+          stale_rows += local_stale;
+        });
+      }
+
+      // Writer
+      std::mt19937 rng(opts.seed);
+      std::vector<HWND> open;
+      std::uintptr_t next_handle = 0x1000;
+      std::uint32_t published = 0;
+      bool exhausted = false;
+      for (; published < opts.publishes && !exhausted; published++) {
+        for (std::uint32_t c = 0; c < opts.changes && !exhausted; c++) {
+          exhausted = !change(registry, open, next_handle, next_texture, opts, rng);
+        }
+        publisher.publish(registry, tab_groups);
+      }
+
+      done = true;
+      for (std::thread& reader : readers) reader.join();
+      opts.publishes = published;
+    }
+    // Registry gone, its textures are retired. The publisher going releases every bag
+  }
+  g_publisher = nullptr;
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  const std::uint64_t created = static_cast<std::uint64_t>(next_texture) - 1;
+  std::cout << "writer:    " << opts.publishes << " publishes of " << opts.changes << " changes, "
+            << created << " textures created, " << std::fixed << std::setprecision(2) << seconds << " s\n";
+  std::cout << "readers:   " << opts.readers << " threads holding up to " << opts.hold << " snapshots, "
+            << acquires.load() << " acquires, " << rows.load() << " rows walked\n";
+  std::cout << "released:  " << g_released.load() << " textures, " << g_released_pinned.load() << " while pinned, "
+            << g_released_twice.load() << " twice, " << g_seen_released.load() << " shown after release\n";
+
+  bool ok = true;
+  if (g_released_pinned != 0 || g_seen_released != 0) {
+    std::cout << "FAIL:      a retired texture was released while a reader still pinned a snapshot showing it" << std::endl;
+    ok = false;
+  }
+  if (g_released_twice != 0) {
+    std::cout << "FAIL:      a texture was released twice" << std::endl;
+    ok = false;
+  }
+  if (g_released != created) {
+    std::cout << "LEAK:      " << (created - g_released) << " textures never released" << std::endl;
+    ok = false;
+  }
+  if (stale_rows != 0) {
+    std::cout << "FAIL:      " << stale_rows.load() << " snapshot rows didn't resolve back to themselves" << std::endl;
+    ok = false;
+  }
+  g_textures = nullptr;
+  if (!ok) return EXIT_FAILURE;
+
+  std::cout << "checked:   no texture was released while a snapshot showing it was pinned, every one was released once\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/*
+Headless benchmark of the startup enumeration against a simulated desktop.
+
+Usage  ->   BetterAltTabStartup [--windows N] [--background N] [--repeat N]
+                                [--title-latency-us N] [--alt-tab-latency-us N]
+
+Compares the per-window path the app used to take on startup (check, fetch the title for
+nothing, scan the whole list for duplicates, fetch the title again) with the single pass of
+WindowDeltaBuilder::addAll, applied to a registry sized for it up front.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "../core/simulated_desktop.hpp"
+#include "../core/window_deltas.hpp"
+#include "../core/window_registry.hpp"
+
+
+namespace {
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    SimulatedDesktopConfig desktop;
+    std::uint32_t repeat = 5;
+  };
+
+
+  /**
+   * @brief Result of one startup
+   */
+  struct Run {
+    double ms;
+    std::uint64_t title_queries;
+    std::uint64_t alt_tab_queries;
+    std::size_t windows;
+  };
+
+
+  /**
+   * @brief Startup the way it used to be, one window at a time
+   */
+  Run runPerWindow(const SimulatedDesktopConfig& config) {
+    SimulatedDesktop desktop(config);
+    WindowRegistry registry;
+    std::vector<HWND> handles;
+    std::vector<HWND> listed;
+    std::string title;
+
+    const auto start = std::chrono::steady_clock::now();
+    desktop.topLevelWindows(handles);
+    for (const HWND hwnd : handles) {
+      // The alt-tab check fetched the title and threw it away
+      if (!desktop.isAltTab(hwnd)) continue;
+      desktop.title(hwnd, title);
+
+      // Duplicate check over everything listed so far
+      if (std::find(listed.begin(), listed.end(), hwnd) != listed.end()) continue;
+      if (!desktop.title(hwnd, title)) continue;
+
+      listed.push_back(hwnd);
+      registry.insert(hwnd, title);
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return Run{ ms, desktop.titleQueries(), desktop.altTabQueries(), registry.size() };
+  }
+
+
+  /**
+   * @brief Startup the way the app does it now
+   */
+  Run runSinglePass(const SimulatedDesktopConfig& config) {
+    SimulatedDesktop desktop(config);
+    WindowDeltaBuilder builder(desktop);
+    WindowRegistry registry;
+    WindowDeltaBatch batch;
+
+    const auto start = std::chrono::steady_clock::now();
+    builder.addAll(batch);
+    applyWindowDeltas(registry, batch);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return Run{ ms, desktop.titleQueries(), desktop.altTabQueries(), registry.size() };
+  }
+
+
+  /**
+   * @brief Runs a path a few times and prints its best run
+   * @returns double: Best time in milliseconds
+   */
+  double bench(const char* label, Run (*run)(const SimulatedDesktopConfig&), const Options& opts) {
+    Run best{};
+    for (std::uint32_t i = 0; i < opts.repeat; i++) {
+      const Run r = run(opts.desktop);
+      if (i == 0 || r.ms < best.ms) best = r;
+    }
+
+    std::cout << std::left << std::setw(13) << label << std::right << std::fixed << std::setprecision(3)
+              << best.ms << " ms, " << best.windows << " windows, " << best.alt_tab_queries << " alt-tab checks, "
+              << best.title_queries << " title queries\n";
+    return best.ms;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options, defaults to a busy desktop
+  Options opts;
+  opts.desktop.window_count = 1000;
+  opts.desktop.background_count = 2000;
+  opts.desktop.storm_windows = 0;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--windows")            opts.desktop.window_count = value;
+    else if (opt == "--background")         opts.desktop.background_count = value;
+    else if (opt == "--repeat")             opts.repeat = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--title-latency-us")   opts.desktop.title_latency_us = value;
+    else if (opt == "--alt-tab-latency-us") opts.desktop.alt_tab_latency_us = value;
+    else {
+      std::cout << "Unknown option " << opt << ", see the top of startup_bench.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "desktop:    " << opts.desktop.window_count << " alt-tab windows, "
+            << opts.desktop.background_count << " background, best of " << opts.repeat << " runs\n";
+  const double before = bench("per-window:", runPerWindow, opts);
+  const double after = bench("single pass:", runSinglePass, opts);
+  if (after > 0.0) {
+    std::cout << "speedup:    " << std::setprecision(1) << (before / after) << "x" << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,249 @@
+/*
+Correctness and throughput check of the UTF-16 -> UTF-8 title transcoder.
+
+Usage  ->   BetterAltTabTranscode [--titles N] [--repeat N] [--fuzz N] [--seed N]
+
+Every corpus (ASCII, Latin, Cyrillic, Greek, CJK, emoji, mixed, broken surrogates) is
+transcoded with the vector path and the scalar loop, both are checked against an
+independent decoder, then timed. Exits with a failure if any output differs.
+*/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "../core/text_encoding.hpp"
+
+
+namespace {
+  /**
+   * @brief Options from the command line
+   */
+  struct Options {
+    std::uint32_t titles = 20000;
+    std::uint32_t repeat = 20;
+    std::uint32_t fuzz = 200000;
+    std::uint32_t seed = 1;
+  };
+
+
+  /**
+   * @brief Titles built from one script
+   */
+  struct Corpus {
+    std::string name;
+    std::vector<std::u16string> titles;
+  };
+
+
+  /**
+   * @brief Appends a code point as UTF-16
+   */
+  void pushCodePoint(std::u16string& out, const std::uint32_t cp) {
+    if (cp < 0x10000) {
+      out.push_back(static_cast<char16_t>(cp));
+      return;
+    }
+    out.push_back(static_cast<char16_t>(0xD800 + ((cp - 0x10000) >> 10)));
+    out.push_back(static_cast<char16_t>(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+  }
+
+
+  /**
+   * @brief Builds titles of words drawn from code point ranges, separated by spaces
+   * @param ranges: Pairs of first and last code point
+   * @param spaces: Put spaces between words, some scripts don't
+   */
+  Corpus makeCorpus(const std::string& name, const std::vector<std::pair<std::uint32_t, std::uint32_t>>& ranges,
+    const bool spaces, const std::uint32_t count, std::mt19937& rng) {
+    Corpus corpus{ name, {} };
+    corpus.titles.reserve(count);
+
+    std::uniform_int_distribution<std::size_t> pick_range(0, ranges.size() - 1);
+    std::uniform_int_distribution<int> word_count(2, 8);
+    std::uniform_int_distribution<int> word_length(2, 10);
+    for (std::uint32_t t = 0; t < count; t++) {
+      std::u16string title;
+      const int words = word_count(rng);
+      for (int w = 0; w < words; w++) {
+        if (w != 0 && spaces) title.push_back(u' ');
+        const auto& [first, last] = ranges[pick_range(rng)];
+        std::uniform_int_distribution<std::uint32_t> pick_cp(first, last);
+        for (int c = word_length(rng); c > 0; c--) pushCodePoint(title, pick_cp(rng));
+      }
+      corpus.titles.push_back(std::move(title));
+    }
+    return corpus;
+  }
+
+
+  /**
+   * @brief Decodes UTF-16 to code points, unpaired surrogates become U+FFFD
+   */
+  std::vector<std::uint32_t> decodeUtf16(const std::u16string& str) {
+    std::vector<std::uint32_t> out;
+    for (std::size_t i = 0; i < str.size(); i++) {
+      const std::uint32_t c = str[i];
+      if (c >= 0xD800 && c <= 0xDBFF && i + 1 < str.size() && str[i + 1] >= 0xDC00 && str[i + 1] <= 0xDFFF) {
+        out.push_back(0x10000 + ((c - 0xD800) << 10) + (str[i + 1] - 0xDC00));
+        i++;
+      }
+      else if (c >= 0xD800 && c <= 0xDFFF) out.push_back(0xFFFD);
+      else                                 out.push_back(c);
+    }
+    return out;
+  }
+
+
+  /**
+   * @brief Decodes UTF-8 to code points, strictly
+   * @returns bool: False if the bytes aren't shortest-form, valid UTF-8
+   */
+  bool decodeUtf8(const std::string& str, std::vector<std::uint32_t>& out) {
+    out.clear();
+    for (std::size_t i = 0; i < str.size();) {
+      const std::uint8_t b = static_cast<std::uint8_t>(str[i]);
+      const int n = b < 0x80 ? 1 : (b >> 5) == 0x6 ? 2 : (b >> 4) == 0xE ? 3 : (b >> 3) == 0x1E ? 4 : 0;
+      if (n == 0 || i + n > str.size()) return false;
+
+      std::uint32_t cp = n == 1 ? b : b & (0x7F >> n);
+      for (int k = 1; k < n; k++) {
+        const std::uint8_t cont = static_cast<std::uint8_t>(str[i + k]);
+        if ((cont & 0xC0) != 0x80) return false;
+        cp = (cp << 6) | (cont & 0x3F);
+      }
+
+      static constexpr std::uint32_t MIN[] = { 0, 0, 0x80, 0x800, 0x10000 };
+      if (cp < MIN[n] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+      out.push_back(cp);
+      i += n;
+    }
+    return true;
+  }
+
+
+  /**
+   * @brief Checks one string with both paths
+   * @returns bool: True if both are valid UTF-8 of the right code points and identical
+   */
+  bool check(const std::u16string& src, std::string& vector_out, std::string& scalar_out, std::vector<std::uint32_t>& decoded) {
+    utf16ToUtf8(src, vector_out);
+    scalar_out.resize(src.size() * UTF8_BYTES_PER_UTF16_UNIT);
+    scalar_out.resize(utf16ToUtf8Scalar(src.data(), src.size(), scalar_out.data()));
+
+    if (vector_out != scalar_out) return false;
+    return decodeUtf8(vector_out, decoded) && decoded == decodeUtf16(src);
+  }
+
+
+  volatile std::size_t sink = 0;
+
+
+  /**
+   * @brief Times transcoding a whole corpus
+   * @returns double: Best run in seconds
+   */
+  template <typename Transcode>
+  double timeCorpus(const Corpus& corpus, const std::uint32_t repeat, std::vector<char>& out, Transcode transcode) {
+    double best = 0.0;
+    for (std::uint32_t r = 0; r < repeat; r++) {
+      std::size_t bytes = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (const std::u16string& title : corpus.titles) {
+        bytes += transcode(title.data(), title.size(), out.data());
+      }
+      const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (r == 0 || s < best) best = s;
+      sink = sink + bytes; // Keeps the compiler from dropping the loop
+    }
+    return best;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  // Options
+  Options opts;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string opt = argv[i];
+    const std::uint32_t value = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+    if      (opt == "--titles") opts.titles = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--repeat") opts.repeat = std::max<std::uint32_t>(value, 1);
+    else if (opt == "--fuzz")   opts.fuzz = value;
+    else if (opt == "--seed")   opts.seed = value;
+    else {
+      std::cout << "Unknown option " << opt << ", see the top of transcode_bench.cpp" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::mt19937 rng(opts.seed);
+  const std::vector<Corpus> corpora = {
+    makeCorpus("ascii",    {{ 'a', 'z' }, { 'A', 'Z' }, { '0', '9' }},                        true,  opts.titles, rng),
+    makeCorpus("latin",    {{ 'a', 'z' }, { 0xE0, 0xFF }, { 0x100, 0x17F }},                  true,  opts.titles, rng),
+    makeCorpus("cyrillic", {{ 0x410, 0x44F }},                                                true,  opts.titles, rng),
+    makeCorpus("greek",    {{ 0x3B1, 0x3C9 }},                                                false, opts.titles, rng),
+    makeCorpus("cjk",      {{ 0x4E00, 0x9FFF }, { 0x3041, 0x3096 }},                          false, opts.titles, rng),
+    makeCorpus("emoji",    {{ 0x1F300, 0x1F5FF }, { 0x1F600, 0x1F64F }},                      true,  opts.titles, rng),
+    makeCorpus("mixed",    {{ 'a', 'z' }, { 0x410, 0x44F }, { 0x4E00, 0x9FFF }, { 0x1F600, 0x1F64F }, { 0x5D0, 0x5EA }}, true, opts.titles, rng),
+    makeCorpus("broken",   {{ 'a', 'z' }, { 0xD800, 0xDFFF }},                                true,  opts.titles, rng)
+  };
+
+  // Correctness, every corpus then random units at every length and alignment
+  std::string vector_out;
+  std::string scalar_out;
+  std::vector<std::uint32_t> decoded;
+  std::size_t failures = 0;
+  for (const Corpus& corpus : corpora) {
+    for (const std::u16string& title : corpus.titles) {
+      if (!check(title, vector_out, scalar_out, decoded)) failures++;
+    }
+  }
+
+  // Units biased towards the boundaries between 1, 2, 3 byte characters and surrogates
+  static constexpr char16_t EDGES[] = { 0x0000, 0x007F, 0x0080, 0x07FF, 0x0800, 0xD7FF, 0xD800, 0xDBFF, 0xDC00, 0xDFFF, 0xE000, 0xFFFD, 0xFFFF };
+  std::uniform_int_distribution<int> length(0, 70);
+  std::uniform_int_distribution<int> kind(0, 3);
+  std::uniform_int_distribution<std::uint32_t> unit(0, 0xFFFF);
+  std::uniform_int_distribution<std::size_t> edge(0, std::size(EDGES) - 1);
+  for (std::uint32_t f = 0; f < opts.fuzz; f++) {
+    std::u16string src;
+    for (int n = length(rng); n > 0; n--) {
+      switch (kind(rng)) {
+        case 0:  src.push_back(static_cast<char16_t>(unit(rng) & 0x7F)); break;
+        case 1:  src.push_back(static_cast<char16_t>(0x80 + unit(rng) % 0x780)); break;
+        case 2:  src.push_back(EDGES[edge(rng)]); break;
+        default: src.push_back(static_cast<char16_t>(unit(rng))); break;
+      }
+    }
+    if (!check(src, vector_out, scalar_out, decoded)) failures++;
+  }
+
+  std::cout << "path:      " << utf16ToUtf8Path() << "\n"
+            << "checked:   " << corpora.size() << " corpora of " << opts.titles << " titles, "
+            << opts.fuzz << " random strings, " << failures << " failures\n";
+
+  // Throughput, in UTF-16 input
+  std::vector<char> out(4096 * UTF8_BYTES_PER_UTF16_UNIT);
+  for (const Corpus& corpus : corpora) {
+    std::size_t units = 0;
+    for (const std::u16string& title : corpus.titles) {
+      units += title.size();
+      if (title.size() * UTF8_BYTES_PER_UTF16_UNIT > out.size()) out.resize(title.size() * UTF8_BYTES_PER_UTF16_UNIT);
+    }
+
+    const double vector_s = timeCorpus(corpus, opts.repeat, out, [](const char16_t* s, std::size_t n, char* d) { return utf16ToUtf8(s, n, d); });
+    const double scalar_s = timeCorpus(corpus, opts.repeat, out, [](const char16_t* s, std::size_t n, char* d) { return utf16ToUtf8Scalar(s, n, d); });
+    const double mb = units * 2.0 / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(11) << (corpus.name + ":") << std::right << std::fixed << std::setprecision(0)
+              << std::setw(6) << (mb / vector_s) << " MB/s, scalar " << std::setw(6) << (mb / scalar_s) << " MB/s, "
+              << std::setprecision(2) << (scalar_s / vector_s) << "x\n";
+  }
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}